@@ -6,6 +6,7 @@
 
 #include "stdafx.h"
 #include <strsafe.h>
+#include <stdio.h>
 #include <cmath>
 #include "DepthBasics.h"
 #include "resource.h"
@@ -27,6 +28,11 @@
 
 #define BYTES_PER_PIXEL_DEPTH sizeof(NUI_DEPTH_IMAGE_PIXEL)
 
+#define HEADLESS_LOG_FILE           L"DepthBasics.log"
+#define HEADLESS_STOP_EVENT         L"DepthBasicsHeadlessStop"
+#define HEADLESS_FRAME_TIMEOUT      2000    // Milliseconds without a frame before it is logged
+#define METRICS_INTERVAL_SECONDS    5
+
 const BYTE CDepthBasics::m_intensityShiftR[] = { 0, 2, 0, 2, 0, 0, 2 };
 const BYTE CDepthBasics::m_intensityShiftG[] = { 0, 2, 2, 0, 2, 0, 0 };
 const BYTE CDepthBasics::m_intensityShiftB[] = { 0, 0, 2, 2, 0, 2, 0 };
@@ -42,7 +48,14 @@ const BYTE CDepthBasics::m_intensityShiftB[] = { 0, 0, 2, 2, 0, 2, 0 };
 int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLine, int nCmdShow)
 {
     CDepthBasics application;
-    application.Run(hInstance, nCmdShow);
+
+    // -headless processes depth without any UI, -colorize keeps the RGBX conversion for a consumer
+    if (NULL != wcsstr(lpCmdLine, L"-headless"))
+    {
+        return application.RunHeadless(NULL != wcsstr(lpCmdLine, L"-colorize"));
+    }
+
+    return application.Run(hInstance, nCmdShow);
 }
 
 /// <summary>
@@ -55,6 +68,17 @@ CDepthBasics::CDepthBasics() :
     m_pDepthStreamHandle(INVALID_HANDLE_VALUE),
     m_bNearMode(false),
     m_pNuiSensor(NULL),
+    m_hWnd(NULL),
+    m_bHeadless(false),
+    m_bColorize(true),
+    m_pLog(NULL),
+    m_lastFrameNumber(0),
+    m_frameCount(0),
+    m_droppedFrames(0),
+    m_processTicks(0),
+    m_maxProcessTicks(0),
+    m_metricsStartTicks(0),
+    m_ticksPerSecond(1),
 	m_depthTreatment(CLAMP_UNRELIABLE_DEPTHS),
 	m_nearMode(false)
 {
@@ -89,6 +113,11 @@ CDepthBasics::~CDepthBasics()
     SafeRelease(m_pD2DFactory);
 
     SafeRelease(m_pNuiSensor);
+
+    if (m_pLog)
+    {
+        fclose(m_pLog);
+    }
 }
 
 /// <summary>
@@ -160,6 +189,66 @@ int CDepthBasics::Run(HINSTANCE hInstance, int nCmdShow)
     return static_cast<int>(msg.wParam);
 }
 
+/// <summary>
+/// Processes depth frames without a window or Direct2D, until the stop event is signaled
+/// </summary>
+/// <param name="colorize">true to still convert depth to RGBX for a consumer of the image</param>
+/// <returns>exit code</returns>
+int CDepthBasics::RunHeadless(bool colorize)
+{
+    m_bHeadless = true;
+    m_bColorize = colorize;
+
+    // Without a log file the status still reaches an attached debugger
+    _wfopen_s(&m_pLog, HEADLESS_LOG_FILE, L"a");
+
+    if (FAILED(CreateFirstConnected()))
+    {
+        return 1;
+    }
+
+    // A supervisor ends the loop by signaling this named event
+    HANDLE hStopEvent = CreateEventW(NULL, TRUE, FALSE, HEADLESS_STOP_EVENT);
+
+    LARGE_INTEGER ticks;
+    QueryPerformanceFrequency(&ticks);
+    m_ticksPerSecond = ticks.QuadPart;
+    QueryPerformanceCounter(&ticks);
+    m_metricsStartTicks = ticks.QuadPart;
+
+    SetStatusMessage(m_bColorize ? L"Headless processing started with colorization" : L"Headless processing started");
+
+    HANDLE hEvents[2] = { m_hNextDepthFrameEvent, hStopEvent };
+    const DWORD eventCount = (NULL != hStopEvent) ? 2 : 1;
+
+    // The frame event wakes the loop directly, there is no message pump in between
+    for (;;)
+    {
+        DWORD result = WaitForMultipleObjects(eventCount, hEvents, FALSE, HEADLESS_FRAME_TIMEOUT);
+        if (WAIT_TIMEOUT == result)
+        {
+            SetStatusMessage(L"No depth frame received");
+            continue;
+        }
+
+        if (WAIT_OBJECT_0 != result)
+        {
+            break;
+        }
+
+        ProcessDepth();
+    }
+
+    SetStatusMessage(L"Headless processing stopped");
+
+    if (NULL != hStopEvent)
+    {
+        CloseHandle(hStopEvent);
+    }
+
+    return 0;
+}
+
 /// <summary>
 /// Main processing function
 /// </summary>
@@ -344,6 +433,8 @@ void CDepthBasics::ProcessDepth()
 {
     HRESULT hr;
     NUI_IMAGE_FRAME imageFrame;
+    LARGE_INTEGER startTicks;
+    LARGE_INTEGER endTicks;
 
     // Attempt to get the depth frame
     hr = m_pNuiSensor->NuiImageStreamGetNextFrame(m_pDepthStreamHandle, 0, &imageFrame);
@@ -352,6 +443,8 @@ void CDepthBasics::ProcessDepth()
         return;
     }
 
+    QueryPerformanceCounter(&startTicks);
+
     BOOL nearMode;
     INuiFrameTexture* pTexture;
 
@@ -368,93 +461,16 @@ void CDepthBasics::ProcessDepth()
     // Lock the frame data so the Kinect knows not to modify it while we're reading it
     pTexture->LockRect(0, &LockedRect, NULL, 0);
 
-    // Make sure we've received valid data
-    if (LockedRect.Pitch != 0)
+    // Make sure we've received valid data, colorization is only paid for when the image is used
+    if (LockedRect.Pitch != 0 && m_bColorize)
     {
-        // Get the min and max reliable depth for the current frame
-        int minDepth = (nearMode ? NUI_IMAGE_DEPTH_MINIMUM_NEAR_MODE : NUI_IMAGE_DEPTH_MINIMUM) >> NUI_IMAGE_PLAYER_INDEX_SHIFT;
-        int maxDepth = (nearMode ? NUI_IMAGE_DEPTH_MAXIMUM_NEAR_MODE : NUI_IMAGE_DEPTH_MAXIMUM) >> NUI_IMAGE_PLAYER_INDEX_SHIFT;
-
-        BYTE * rgbrun = m_depthRGBX;
-		
-		const NUI_DEPTH_IMAGE_PIXEL * pBufferRun = reinterpret_cast<const NUI_DEPTH_IMAGE_PIXEL *>(LockedRect.pBits);
-
-        // end pixel is start + width*height - 1
-        const NUI_DEPTH_IMAGE_PIXEL * pBufferEnd = pBufferRun + (cDepthWidth * cDepthHeight);
+        ColorizeDepth(reinterpret_cast<const NUI_DEPTH_IMAGE_PIXEL *>(LockedRect.pBits));
 
-		USHORT minReliableDepth = (m_nearMode ? NUI_IMAGE_DEPTH_MINIMUM_NEAR_MODE : NUI_IMAGE_DEPTH_MINIMUM) >> NUI_IMAGE_PLAYER_INDEX_SHIFT;
-		USHORT maxReliableDepth = (m_nearMode ? NUI_IMAGE_DEPTH_MAXIMUM_NEAR_MODE : NUI_IMAGE_DEPTH_MAXIMUM) >> NUI_IMAGE_PLAYER_INDEX_SHIFT;
-
-        while ( pBufferRun < pBufferEnd )
+        // Draw the data with Direct2D
+        if (m_pDrawDepth)
         {
-            // discard the portion of the depth that contains only the player index
-            USHORT depth = pBufferRun->depth;
-			USHORT index = pBufferRun->playerIndex;
-
-			//USHORT depth = NuiDepthPixelToDepth(pBufferRun->depth);
-			//USHORT index = NuiDepthPixelToPlayerIndex(pBufferRun->depth);
-            // To convert to a byte, we're discarding the most-significant
-            // rather than least-significant bits.
-            // We're preserving detail, although the intensity will "wrap."
-            // Values outside the reliable depth range are mapped to 0 (black).
-
-            // Note: Using conditionals in this loop could degrade performance.
-            // Consider using a lookup table instead when writing production code.
-            //BYTE intensity = static_cast<BYTE>(depth >= minDepth && depth <= maxDepth ? depth % 256 : 0);
-			BYTE r;
-			BYTE g;
-			BYTE b;
-			if (index == 0 && depth == 0) {
-				//Unknown Depth
-				r = 63;
-				g = 63;
-				b = 7;
-			} else  if (index == 0 && depth < minReliableDepth) {
-				//Too Near
-				r = 31;
-				g = 127;
-				b = 255;
-			} else if (index == 0 && depth > maxReliableDepth && depth <= USHRT_MAX) {
-				//Too Far
-				r = 127;
-				g = 15;
-				b = 63;
-			} else {
-				BYTE intensity = GetIntensity(depth);
-				r = intensity >> m_intensityShiftR[index];
-				g = intensity >> m_intensityShiftG[index];
-				b = intensity >> m_intensityShiftB[index];
-			}
-			//BYTE *
-            // Write out blue byte
-            //*(rgbrun++) = intensity;
-			*(rgbrun++) = b;
-            
-			// Write out green byte
-            //*(rgbrun++) = intensity;
-			*(rgbrun++) = g;
-          
-			// Write out red byte
-            //*(rgbrun++) = intensity;
-			*(rgbrun++) = r;
-			
-			//*rgbrun = m_depthColorTable[index][depth];
-			//rgbrun++;
-			//rgbrun++;
-			//rgbrun++;
-			
-
-            // We're outputting BGR, the last byte in the 32 bits is unused so skip it
-            // If we were outputting BGRA, we would write alpha here.
-            //*(rgbrun++) = 1;
-			++rgbrun;
-
-            // Increment our index into the Kinect's depth buffer
-            ++pBufferRun;
+            m_pDrawDepth->Draw(m_depthRGBX, cDepthWidth * cDepthHeight * cBytesPerPixel);
         }
-
-        // Draw the data with Direct2D
-        m_pDrawDepth->Draw(m_depthRGBX, cDepthWidth * cDepthHeight * cBytesPerPixel);
     }
 
     // We're done with the texture so unlock it
@@ -465,17 +481,177 @@ void CDepthBasics::ProcessDepth()
 ReleaseFrame:
     // Release the frame
     m_pNuiSensor->NuiImageStreamReleaseFrame(m_pDepthStreamHandle, &imageFrame);
+
+    if (m_bHeadless)
+    {
+        QueryPerformanceCounter(&endTicks);
+        UpdateMetrics(imageFrame.dwFrameNumber, endTicks.QuadPart - startTicks.QuadPart);
+    }
+}
+
+/// <summary>
+/// Convert depth pixels to RGBX
+/// </summary>
+/// <param name="pBufferRun">depth pixels of one frame</param>
+void CDepthBasics::ColorizeDepth(const NUI_DEPTH_IMAGE_PIXEL* pBufferRun)
+{
+    BYTE * rgbrun = m_depthRGBX;
+
+    // end pixel is start + width*height - 1
+    const NUI_DEPTH_IMAGE_PIXEL * pBufferEnd = pBufferRun + (cDepthWidth * cDepthHeight);
+
+    USHORT minReliableDepth = (m_nearMode ? NUI_IMAGE_DEPTH_MINIMUM_NEAR_MODE : NUI_IMAGE_DEPTH_MINIMUM) >> NUI_IMAGE_PLAYER_INDEX_SHIFT;
+    USHORT maxReliableDepth = (m_nearMode ? NUI_IMAGE_DEPTH_MAXIMUM_NEAR_MODE : NUI_IMAGE_DEPTH_MAXIMUM) >> NUI_IMAGE_PLAYER_INDEX_SHIFT;
+
+    while ( pBufferRun < pBufferEnd )
+    {
+        // discard the portion of the depth that contains only the player index
+        USHORT depth = pBufferRun->depth;
+        USHORT index = pBufferRun->playerIndex;
+
+        //USHORT depth = NuiDepthPixelToDepth(pBufferRun->depth);
+        //USHORT index = NuiDepthPixelToPlayerIndex(pBufferRun->depth);
+        // To convert to a byte, we're discarding the most-significant
+        // rather than least-significant bits.
+        // We're preserving detail, although the intensity will "wrap."
+        // Values outside the reliable depth range are mapped to 0 (black).
+
+        // Note: Using conditionals in this loop could degrade performance.
+        // Consider using a lookup table instead when writing production code.
+        //BYTE intensity = static_cast<BYTE>(depth >= minDepth && depth <= maxDepth ? depth % 256 : 0);
+        BYTE r;
+        BYTE g;
+        BYTE b;
+        if (index == 0 && depth == 0) {
+            //Unknown Depth
+            r = 63;
+            g = 63;
+            b = 7;
+        } else  if (index == 0 && depth < minReliableDepth) {
+            //Too Near
+            r = 31;
+            g = 127;
+            b = 255;
+        } else if (index == 0 && depth > maxReliableDepth && depth <= USHRT_MAX) {
+            //Too Far
+            r = 127;
+            g = 15;
+            b = 63;
+        } else {
+            BYTE intensity = GetIntensity(depth);
+            r = intensity >> m_intensityShiftR[index];
+            g = intensity >> m_intensityShiftG[index];
+            b = intensity >> m_intensityShiftB[index];
+        }
+        //BYTE *
+        // Write out blue byte
+        //*(rgbrun++) = intensity;
+        *(rgbrun++) = b;
+
+        // Write out green byte
+        //*(rgbrun++) = intensity;
+        *(rgbrun++) = g;
+
+        // Write out red byte
+        //*(rgbrun++) = intensity;
+        *(rgbrun++) = r;
+
+        //*rgbrun = m_depthColorTable[index][depth];
+        //rgbrun++;
+        //rgbrun++;
+        //rgbrun++;
+
+
+        // We're outputting BGR, the last byte in the 32 bits is unused so skip it
+        // If we were outputting BGRA, we would write alpha here.
+        //*(rgbrun++) = 1;
+        ++rgbrun;
+
+        // Increment our index into the Kinect's depth buffer
+        ++pBufferRun;
+    }
 }
 
 /// <summary>
 /// Set the status bar message
 /// </summary>
 /// <param name="szMessage">message to display</param>
-void CDepthBasics::SetStatusMessage(WCHAR * szMessage)
+void CDepthBasics::SetStatusMessage(const WCHAR * szMessage)
 {
+    // Without a window the status goes to the log
+    if (m_bHeadless)
+    {
+        LogMessage(szMessage);
+        return;
+    }
+
     SendDlgItemMessageW(m_hWnd, IDC_STATUS, WM_SETTEXT, 0, (LPARAM)szMessage);
 }
 
+/// <summary>
+/// Count a processed frame and log the metrics once per interval
+/// </summary>
+/// <param name="frameNumber">sensor frame number</param>
+/// <param name="processTicks">processing time in performance counter ticks</param>
+void CDepthBasics::UpdateMetrics(DWORD frameNumber, LONGLONG processTicks)
+{
+    // Frame numbers advance by one per sensor frame, a larger step means frames were missed
+    if (0 != m_lastFrameNumber && frameNumber > m_lastFrameNumber + 1)
+    {
+        m_droppedFrames += frameNumber - m_lastFrameNumber - 1;
+    }
+    m_lastFrameNumber = frameNumber;
+
+    ++m_frameCount;
+    m_processTicks += processTicks;
+    m_maxProcessTicks = max(m_maxProcessTicks, processTicks);
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+
+    LONGLONG elapsed = now.QuadPart - m_metricsStartTicks;
+    if (elapsed < m_ticksPerSecond * METRICS_INTERVAL_SECONDS)
+    {
+        return;
+    }
+
+    WCHAR szMessage[cStatusMessageMaxLen];
+    StringCchPrintfW(szMessage, _countof(szMessage), L"%u frames, %.1f fps, %u dropped, processing %.2f ms mean %.2f ms max",
+        m_frameCount,
+        m_frameCount * (double)m_ticksPerSecond / elapsed,
+        m_droppedFrames,
+        1000.0 * m_processTicks / m_ticksPerSecond / m_frameCount,
+        1000.0 * m_maxProcessTicks / m_ticksPerSecond);
+    SetStatusMessage(szMessage);
+
+    m_frameCount        = 0;
+    m_droppedFrames     = 0;
+    m_processTicks      = 0;
+    m_maxProcessTicks   = 0;
+    m_metricsStartTicks = now.QuadPart;
+}
+
+/// <summary>
+/// Append a time stamped line to the log
+/// </summary>
+/// <param name="szMessage">message to log</param>
+void CDepthBasics::LogMessage(const WCHAR* szMessage)
+{
+    SYSTEMTIME time;
+    GetLocalTime(&time);
+
+    WCHAR szLine[cStatusMessageMaxLen + 32];
+    StringCchPrintfW(szLine, _countof(szLine), L"%02u:%02u:%02u.%03u %s\n", time.wHour, time.wMinute, time.wSecond, time.wMilliseconds, szMessage);
+
+    OutputDebugStringW(szLine);
+
+    if (m_pLog)
+    {
+        fputws(szLine, m_pLog);
+        fflush(m_pLog);
+    }
+}
+
 
 
 /// <summary>
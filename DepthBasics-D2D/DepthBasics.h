@@ -65,9 +65,28 @@ public:
     /// <param name="nCmdShow"></param>
     int                     Run(HINSTANCE hInstance, int nCmdShow);
 
+    /// <summary>
+    /// Processes depth frames without a window or Direct2D, until the stop event is signaled
+    /// </summary>
+    /// <param name="colorize">true to still convert depth to RGBX for a consumer of the image</param>
+    /// <returns>exit code</returns>
+    int                     RunHeadless(bool colorize);
+
 private:
     HWND                    m_hWnd;
 
+    // Headless mode logs status and per-interval metrics instead of showing them
+    bool                    m_bHeadless;
+    bool                    m_bColorize;
+    FILE*                   m_pLog;
+    DWORD                   m_lastFrameNumber;
+    UINT                    m_frameCount;
+    UINT                    m_droppedFrames;
+    LONGLONG                m_processTicks;
+    LONGLONG                m_maxProcessTicks;
+    LONGLONG                m_metricsStartTicks;
+    LONGLONG                m_ticksPerSecond;
+
     bool                    m_bNearMode;
 
     // Current Kinect
@@ -126,11 +145,30 @@ private:
     /// </summary>
     void                    ProcessDepth();
 
+    /// <summary>
+    /// Convert depth pixels to RGBX
+    /// </summary>
+    /// <param name="pBufferRun">depth pixels of one frame</param>
+    void                    ColorizeDepth(const NUI_DEPTH_IMAGE_PIXEL* pBufferRun);
+
+    /// <summary>
+    /// Count a processed frame and log the metrics once per interval
+    /// </summary>
+    /// <param name="frameNumber">sensor frame number</param>
+    /// <param name="processTicks">processing time in performance counter ticks</param>
+    void                    UpdateMetrics(DWORD frameNumber, LONGLONG processTicks);
+
+    /// <summary>
+    /// Append a time stamped line to the log
+    /// </summary>
+    /// <param name="szMessage">message to log</param>
+    void                    LogMessage(const WCHAR* szMessage);
+
     /// <summary>
     /// Set the status bar message
     /// </summary>
     /// <param name="szMessage">message to display</param>
-    void                    SetStatusMessage(WCHAR* szMessage);
+    void                    SetStatusMessage(const WCHAR* szMessage);
 
 private:
 	static const BYTE    m_intensityShiftR[MAX_PLAYER_INDEX + 1];
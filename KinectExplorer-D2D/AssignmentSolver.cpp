@@ -0,0 +1,138 @@
+//------------------------------------------------------------------------------
+// <copyright file="AssignmentSolver.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include <cfloat>
+#include "AssignmentSolver.h"
+
+#define NO_ROW  0   // Rows and columns are numbered from one, zero is the virtual start
+
+/// <summary>
+/// Constructor
+/// </summary>
+AssignmentSolver::AssignmentSolver()
+{
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+AssignmentSolver::~AssignmentSolver()
+{
+}
+
+/// <summary>
+/// Solve an assignment problem. A pair costing unassignedCost or more is never assigned
+/// </summary>
+/// <param name="pCost">Row major cost matrix</param>
+/// <param name="rows">Number of rows</param>
+/// <param name="columns">Number of columns</param>
+/// <param name="unassignedCost">Cost of leaving a row or column unassigned</param>
+/// <param name="rowToColumn">Receives the column of each row, or UNASSIGNED</param>
+/// <returns>Number of assigned rows</returns>
+UINT AssignmentSolver::Solve(const FLOAT* pCost, UINT rows, UINT columns, FLOAT unassignedCost, std::vector<int>& rowToColumn)
+{
+    rowToColumn.assign(rows, UNASSIGNED);
+    if (0 == rows || 0 == columns)
+    {
+        return 0;
+    }
+
+    // Pad to a square matrix. Dummy cells and gated pairs cost the same as leaving a row unassigned
+    UINT n = rows > columns ? rows : columns;
+    m_cost.assign(n * n, unassignedCost);
+    for (UINT r = 0; r < rows; r++)
+    {
+        for (UINT c = 0; c < columns; c++)
+        {
+            FLOAT cost = pCost[r * columns + c];
+            m_cost[r * n + c] = cost < unassignedCost ? cost : unassignedCost;
+        }
+    }
+
+    m_rowPotential.assign(n + 1, 0.0f);
+    m_columnPotential.assign(n + 1, 0.0f);
+    m_columnToRow.assign(n + 1, NO_ROW);
+    m_previousColumn.assign(n + 1, 0);
+    m_minSlack.resize(n + 1);
+    m_visited.resize(n + 1);
+
+    // Add rows one at a time, each along a shortest augmenting path
+    for (UINT row = 1; row <= n; row++)
+    {
+        m_columnToRow[0] = row;
+        UINT column = 0;
+
+        m_minSlack.assign(n + 1, FLT_MAX);
+        m_visited.assign(n + 1, 0);
+
+        do
+        {
+            m_visited[column] = 1;
+
+            UINT  currentRow = m_columnToRow[column];
+            FLOAT delta      = FLT_MAX;
+            UINT  next       = 0;
+
+            for (UINT c = 1; c <= n; c++)
+            {
+                if (m_visited[c])
+                {
+                    continue;
+                }
+
+                FLOAT slack = m_cost[(currentRow - 1) * n + (c - 1)] - m_rowPotential[currentRow] - m_columnPotential[c];
+                if (slack < m_minSlack[c])
+                {
+                    m_minSlack[c]       = slack;
+                    m_previousColumn[c] = column;
+                }
+                if (m_minSlack[c] < delta)
+                {
+                    delta = m_minSlack[c];
+                    next  = c;
+                }
+            }
+
+            for (UINT c = 0; c <= n; c++)
+            {
+                if (m_visited[c])
+                {
+                    m_rowPotential[m_columnToRow[c]] += delta;
+                    m_columnPotential[c]             -= delta;
+                }
+                else
+                {
+                    m_minSlack[c] -= delta;
+                }
+            }
+
+            column = next;
+        }
+        while (NO_ROW != m_columnToRow[column]);
+
+        // Flip the augmenting path
+        do
+        {
+            UINT previous = m_previousColumn[column];
+            m_columnToRow[column] = m_columnToRow[previous];
+            column = previous;
+        }
+        while (0 != column);
+    }
+
+    UINT assigned = 0;
+    for (UINT c = 1; c <= n; c++)
+    {
+        UINT r = m_columnToRow[c] - 1;
+        if (r < rows && c - 1 < columns && m_cost[r * n + (c - 1)] < unassignedCost)
+        {
+            rowToColumn[r] = (int)(c - 1);
+            ++assigned;
+        }
+    }
+
+    return assigned;
+}
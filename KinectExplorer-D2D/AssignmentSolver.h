@@ -0,0 +1,53 @@
+//------------------------------------------------------------------------------
+// <copyright file="AssignmentSolver.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include "NuiTypes.h"
+
+#define UNASSIGNED  (-1)
+
+/// <summary>
+/// Minimum cost assignment of rows to columns with the Hungarian method, using
+/// shortest augmenting paths with row and column potentials. Cost is O(n^3) for
+/// n = max(rows, columns), a few microseconds for dozens of rows. Buffers are
+/// kept between calls so solving a frame does not allocate.
+/// </summary>
+class AssignmentSolver
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    AssignmentSolver();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~AssignmentSolver();
+
+public:
+    /// <summary>
+    /// Solve an assignment problem. A pair costing unassignedCost or more is never assigned
+    /// </summary>
+    /// <param name="pCost">Row major cost matrix</param>
+    /// <param name="rows">Number of rows</param>
+    /// <param name="columns">Number of columns</param>
+    /// <param name="unassignedCost">Cost of leaving a row or column unassigned</param>
+    /// <param name="rowToColumn">Receives the column of each row, or UNASSIGNED</param>
+    /// <returns>Number of assigned rows</returns>
+    UINT Solve(const FLOAT* pCost, UINT rows, UINT columns, FLOAT unassignedCost, std::vector<int>& rowToColumn);
+
+private:
+    std::vector<FLOAT>  m_cost;         // Square matrix padded with the unassigned cost
+    std::vector<FLOAT>  m_rowPotential;
+    std::vector<FLOAT>  m_columnPotential;
+    std::vector<FLOAT>  m_minSlack;
+    std::vector<UINT>   m_columnToRow;
+    std::vector<UINT>   m_previousColumn;
+    std::vector<BYTE>   m_visited;
+};
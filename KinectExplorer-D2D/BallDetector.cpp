@@ -0,0 +1,393 @@
+//------------------------------------------------------------------------------
+// <copyright file="BallDetector.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "BallDetector.h"
+
+#define DEPTH_GATE_BUDGET       200     // Microseconds per frame
+#define SIZE_GATE_BUDGET        200
+#define COLOR_GATE_BUDGET       2000
+#define OPENING_DEPTH           4000    // Millimeters, the far end of the range, where balls are smallest
+#define OPENING_FRACTION        0.05f   // Opening radius over the ball radius at that depth
+#define DEPTH_WINDOW_FACTOR     2.0f    // Keep points within this many radii of the blob mean depth
+#define MILLIMETERS_TO_METERS   0.001f
+
+/// <summary>
+/// Constructor
+/// </summary>
+BallDetector::BallDetector()
+    : m_circleSearch(true)
+    , m_maskOpening(true)
+    , m_pFloor(nullptr)
+{
+    m_scaleTable.SetBallRadius(m_sphereFitter.GetRadius());
+
+    // Labeling and the circle search run one after the other, so they take turns on one pool
+    m_blobLabeler.SetParallelBands(&m_parallel);
+    m_circleDetector.SetParallelBands(&m_parallel);
+
+    // Cheapest first. A late color check is skipped rather than holding up the frame
+    m_cascade.AddStage(&m_depthGate, DEPTH_GATE_BUDGET, CASCADE_OVERRUN_REJECT);
+    m_cascade.AddStage(&m_sizeGate,  SIZE_GATE_BUDGET,  CASCADE_OVERRUN_REJECT);
+    m_cascade.AddStage(&m_colorGate, COLOR_GATE_BUDGET, CASCADE_OVERRUN_PASS);
+
+    m_circleCascade.AddStage(&m_colorGate, COLOR_GATE_BUDGET, CASCADE_OVERRUN_PASS);
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+BallDetector::~BallDetector()
+{
+}
+
+/// <summary>
+/// Select the depth image resolution
+/// </summary>
+/// <param name="resolution">Depth image resolution</param>
+/// <returns>Indicates success or failure</returns>
+HRESULT BallDetector::SetResolution(NUI_IMAGE_RESOLUTION resolution)
+{
+    HRESULT hr = m_pointCloud.SetResolution(resolution);
+    if (SUCCEEDED(hr))
+    {
+        m_scaleTable.SetResolution(resolution);
+
+        UINT count = m_pointCloud.GetWidth() * m_pointCloud.GetHeight();
+        m_candidateX.resize(count);
+        m_candidateY.resize(count);
+        m_candidateZ.resize(count);
+    }
+
+    return hr;
+}
+
+/// <summary>
+/// Set the radius of the ball
+/// </summary>
+/// <param name="radius">Radius in meters</param>
+void BallDetector::SetBallRadius(FLOAT radius)
+{
+    m_sphereFitter.SetRadius(radius);
+    m_scaleTable.SetBallRadius(radius);
+}
+
+/// <summary>
+/// Enable or disable the circle search for partly hidden balls
+/// </summary>
+/// <param name="enable">True to run the circle search after the blob search</param>
+void BallDetector::EnableCircleSearch(bool enable)
+{
+    m_circleSearch = enable;
+}
+
+/// <summary>
+/// Get pixels per meter at one meter distance for the selected resolution
+/// </summary>
+FLOAT BallDetector::GetFocalLength() const
+{
+    // The nominal focal length is given for 320x240
+    return m_pointCloud.GetWidth() / (320.0f * NUI_CAMERA_DEPTH_NOMINAL_INVERSE_FOCAL_LENGTH_IN_PIXELS);
+}
+
+/// <summary>
+/// Project a ball center to the depth image
+/// </summary>
+/// <param name="position">Center in the point cloud output frame, meters</param>
+/// <param name="x">Receives the column</param>
+/// <param name="y">Receives the row</param>
+/// <param name="radius">Receives the ball radius in pixels</param>
+/// <returns>False if the center is not in front of the camera</returns>
+bool BallDetector::ProjectToImage(const Vector4& position, FLOAT& x, FLOAT& y, FLOAT& radius) const
+{
+    Vector4 camera = m_pointCloud.ToCamera(position);
+    if (camera.z <= 0.0f)
+    {
+        return false;
+    }
+
+    // Same model as the ray table
+    FLOAT scale = GetFocalLength() / camera.z;
+
+    x      = m_pointCloud.GetWidth()  / 2.0f + camera.x * scale;
+    y      = m_pointCloud.GetHeight() / 2.0f - camera.y * scale;
+    radius = m_sphereFitter.GetRadius() * scale;
+    return true;
+}
+
+/// <summary>
+/// Detect balls in a depth frame
+/// </summary>
+/// <param name="mask">Foreground mask of the frame</param>
+/// <param name="pDepth">The pointer to depth pixels</param>
+/// <returns>Number of balls found</returns>
+UINT BallDetector::Detect(const PackedBitmask& mask, const NUI_DEPTH_IMAGE_PIXEL* pDepth)
+{
+    m_detections.clear();
+
+    if (!pDepth || mask.GetWidth() != m_pointCloud.GetWidth() || mask.GetHeight() != m_pointCloud.GetHeight())
+    {
+        return 0;
+    }
+
+    // Floor and speckle would split or grow blobs, remove them before labeling
+    const PackedBitmask& foreground = CleanMask(RejectFloor(mask, pDepth));
+
+    m_blobLabeler.Label(foreground, pDepth);
+    BuildCandidates();
+
+    CascadeFrame frame;
+    frame.pMask       = &foreground;
+    frame.pDepth      = pDepth;
+    frame.width       = mask.GetWidth();
+    frame.height      = mask.GetHeight();
+    frame.focalLength = GetFocalLength();
+    frame.ballRadius  = m_sphereFitter.GetRadius();
+
+    m_cascade.Run(frame, m_candidates);
+
+    for (size_t i = 0; i < m_candidates.size(); i++)
+    {
+        FitBlob(foreground, pDepth, m_candidates[i].blob);
+    }
+
+    if (m_circleSearch)
+    {
+        FitCircles(frame);
+    }
+
+    return (UINT)m_detections.size();
+}
+
+/// <summary>
+/// Detect balls only inside some windows of a depth frame
+/// </summary>
+/// <param name="mask">Foreground mask of the frame</param>
+/// <param name="pDepth">The pointer to depth pixels</param>
+/// <param name="windows">Windows to search</param>
+/// <returns>Number of balls found</returns>
+UINT BallDetector::Detect(const PackedBitmask& mask, const NUI_DEPTH_IMAGE_PIXEL* pDepth, const std::vector<ImageWindow>& windows)
+{
+    // Foreground outside the windows is dropped, so labeling skips it word by word
+    m_windowMask.Resize(mask.GetWidth(), mask.GetHeight());
+    m_windowMask.Clear();
+
+    for (size_t i = 0; i < windows.size(); i++)
+    {
+        m_windowMask.CopyRect(mask, windows[i].left, windows[i].top, windows[i].right, windows[i].bottom);
+    }
+
+    return Detect(m_windowMask, pDepth);
+}
+
+/// <summary>
+/// Enable or disable opening of the foreground mask before labeling
+/// </summary>
+/// <param name="enable">True to remove speckle from the mask</param>
+void BallDetector::EnableMaskOpening(bool enable)
+{
+    m_maskOpening = enable;
+}
+
+/// <summary>
+/// Set the rotation from camera space to the frame of ball positions
+/// </summary>
+/// <param name="rotation">Row major rotation matrix, output = rotation * camera</param>
+void BallDetector::SetRotation(const FLOAT rotation[3][3])
+{
+    m_pointCloud.SetRotation(rotation);
+}
+
+/// <summary>
+/// Set the floor whose pixels are removed from the foreground before detection
+/// </summary>
+/// <param name="pFloor">The pointer to floor estimator, or nullptr for none</param>
+void BallDetector::SetFloorEstimator(const FloorEstimator* pFloor)
+{
+    m_pFloor = pFloor;
+}
+
+/// <summary>
+/// Remove pixels on or below the floor from the foreground mask
+/// </summary>
+/// <param name="mask">Foreground mask of the frame</param>
+/// <param name="pDepth">The pointer to depth pixels</param>
+/// <returns>The mask without floor, or the input if no floor is known</returns>
+const PackedBitmask& BallDetector::RejectFloor(const PackedBitmask& mask, const NUI_DEPTH_IMAGE_PIXEL* pDepth)
+{
+    if (!m_pFloor || !m_pFloor->IsValid())
+    {
+        return mask;
+    }
+
+    m_floorMask.CopyFrom(mask);
+    m_pFloor->RejectFloor(m_floorMask, pDepth, m_pointCloud);
+    return m_floorMask;
+}
+
+/// <summary>
+/// Open the foreground mask with a disc small enough to keep the farthest ball
+/// </summary>
+/// <param name="mask">Foreground mask of the frame</param>
+/// <returns>The opened mask, or the input if opening is disabled or too small to matter</returns>
+const PackedBitmask& BallDetector::CleanMask(const PackedBitmask& mask)
+{
+    // The scale table gives the kernel for the resolution, a radius of one pixel at 320x240 and two
+    // at 640x480. The 3 or 5 pixel disc removes speckle but keeps thin limbs and the rims of partly
+    // hidden balls, which the circle search votes with. The opening runs before labeling, so there
+    // are no regions yet to size it by. One kernel sized for the smallest ball in range is kept
+    UINT radius = (UINT)(m_scaleTable.GetRadius(OPENING_DEPTH) * OPENING_FRACTION + 0.5f);
+    if (!m_maskOpening || 0 == radius)
+    {
+        return mask;
+    }
+
+    m_morphology.Open(mask, m_cleanMask, MORPHOLOGY_DISC, radius, radius);
+    return m_cleanMask;
+}
+
+/// <summary>
+/// Turn the labeled blobs into cascade candidates
+/// </summary>
+void BallDetector::BuildCandidates()
+{
+    const std::vector<DepthBlob>& blobs = m_blobLabeler.GetBlobs();
+
+    m_candidates.clear();
+    for (size_t i = 0; i < blobs.size(); i++)
+    {
+        if (blobs[i].depthMean <= 0.0f)
+        {
+            continue;
+        }
+
+        BallCandidate candidate;
+        candidate.blob        = blobs[i];
+        candidate.imageRadius = m_scaleTable.GetRadius((USHORT)(blobs[i].depthMean + 0.5f));
+        candidate.colorRatio  = -1.0f;
+
+        m_candidates.push_back(candidate);
+    }
+}
+
+/// <summary>
+/// Fit spheres to circles that no blob detection explains
+/// </summary>
+/// <param name="frame">Frame data shared with the blob cascade</param>
+void BallDetector::FitCircles(const CascadeFrame& frame)
+{
+    m_circleDetector.Detect(*frame.pMask, frame.pDepth, m_scaleTable);
+
+    const std::vector<CircleDetection>& circles = m_circleDetector.GetCircles();
+    size_t blobDetections = m_detections.size();
+
+    m_candidates.clear();
+    for (size_t i = 0; i < circles.size(); i++)
+    {
+        const CircleDetection& circle = circles[i];
+
+        bool explained = false;
+        for (size_t j = 0; j < blobDetections && !explained; j++)
+        {
+            FLOAT dx = circle.imageX - m_detections[j].imageX;
+            FLOAT dy = circle.imageY - m_detections[j].imageY;
+            explained = dx * dx + dy * dy < circle.imageRadius * circle.imageRadius;
+        }
+
+        if (explained)
+        {
+            continue;
+        }
+
+        // Box around the circle at the implied depth. Depth windows of later checks drop the occluder
+        FLOAT left   = circle.imageX - circle.imageRadius;
+        FLOAT top    = circle.imageY - circle.imageRadius;
+        FLOAT right  = circle.imageX + circle.imageRadius;
+        FLOAT bottom = circle.imageY + circle.imageRadius;
+
+        BallCandidate candidate;
+        ZeroMemory(&candidate, sizeof(candidate));
+
+        DepthBlob& blob = candidate.blob;
+        blob.left      = left > 0.0f ? (UINT)left : 0;
+        blob.top       = top  > 0.0f ? (UINT)top  : 0;
+        blob.right     = right  < frame.width  - 1 ? (UINT)right  : frame.width  - 1;
+        blob.bottom    = bottom < frame.height - 1 ? (UINT)bottom : frame.height - 1;
+        blob.centroidX = circle.imageX;
+        blob.centroidY = circle.imageY;
+        blob.depthMean = circle.depth;
+
+        candidate.imageRadius = circle.imageRadius;
+        candidate.colorRatio  = -1.0f;
+
+        m_candidates.push_back(candidate);
+    }
+
+    // Circles have no blob statistics, only the color stage applies
+    m_circleCascade.Run(frame, m_candidates);
+
+    for (size_t i = 0; i < m_candidates.size(); i++)
+    {
+        FitBlob(*frame.pMask, frame.pDepth, m_candidates[i].blob);
+    }
+}
+
+/// <summary>
+/// Fit a sphere to a blob and append a detection on success
+/// </summary>
+/// <param name="mask">Foreground mask of the frame</param>
+/// <param name="pDepth">The pointer to depth pixels</param>
+/// <param name="blob">Candidate blob</param>
+void BallDetector::FitBlob(const PackedBitmask& mask, const NUI_DEPTH_IMAGE_PIXEL* pDepth, const DepthBlob& blob)
+{
+    UINT count = m_pointCloud.BuildMasked(pDepth, mask, blob.left, blob.top, blob.right, blob.bottom);
+
+    // The bounding box may hold pixels of other blobs, keep the ones near the blob depth.
+    // Points may be rotated out of camera space, so compare the depth of their pixels
+    const FLOAT* pX     = m_pointCloud.GetX();
+    const FLOAT* pY     = m_pointCloud.GetY();
+    const FLOAT* pZ     = m_pointCloud.GetZ();
+    const UINT*  pIndex = m_pointCloud.GetPixelIndex();
+
+    FLOAT meanZ  = blob.depthMean * MILLIMETERS_TO_METERS;
+    FLOAT window = m_sphereFitter.GetRadius() * DEPTH_WINDOW_FACTOR;
+    UINT  kept   = 0;
+
+    for (UINT i = 0; i < count; i++)
+    {
+        FLOAT offset = pDepth[pIndex[i]].depth * MILLIMETERS_TO_METERS - meanZ;
+        if (offset > -window && offset < window)
+        {
+            m_candidateX[kept] = pX[i];
+            m_candidateY[kept] = pY[i];
+            m_candidateZ[kept] = pZ[i];
+            ++kept;
+        }
+    }
+
+    if (0 == kept)
+    {
+        return;
+    }
+
+    SphereFit fit;
+    if (!m_sphereFitter.Fit(&m_candidateX[0], &m_candidateY[0], &m_candidateZ[0], kept, fit))
+    {
+        return;
+    }
+
+    BallDetection detection;
+    if (!ProjectToImage(fit.center, detection.imageX, detection.imageY, detection.imageRadius))
+    {
+        return;
+    }
+
+    detection.position    = fit.center;
+    detection.inlierRatio = fit.inlierRatio;
+    detection.residual    = fit.residual;
+    detection.area        = blob.area;
+
+    m_detections.push_back(detection);
+}
@@ -0,0 +1,277 @@
+//------------------------------------------------------------------------------
+// <copyright file="BallDetector.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include "NuiTypes.h"
+#include "BlobLabeler.h"
+#include "PointCloudBuilder.h"
+#include "SphereFitter.h"
+#include "BallScaleTable.h"
+#include "HoughCircleDetector.h"
+#include "MaskMorphology.h"
+#include "DetectionCascade.h"
+#include "CascadeStages.h"
+#include "FloorEstimator.h"
+
+/// <summary>
+/// Ball found in a depth frame
+/// </summary>
+struct BallDetection
+{
+    FLOAT   imageX;         // Projected center, pixels
+    FLOAT   imageY;
+    FLOAT   imageRadius;    // Projected radius, pixels
+    Vector4 position;       // Center in the point cloud output frame, meters
+    FLOAT   inlierRatio;
+    FLOAT   residual;       // Meters
+    UINT    area;           // Pixels of the source blob, zero if found by the circle search
+};
+
+/// <summary>
+/// Rectangle of the depth image to search, inclusive bounds
+/// </summary>
+struct ImageWindow
+{
+    UINT    left;
+    UINT    top;
+    UINT    right;
+    UINT    bottom;
+};
+
+/// <summary>
+/// Finds balls of a known radius in the foreground of a depth frame. Foreground
+/// blobs run through a cascade of cheap depth, size and color tests, and only the
+/// blobs passing every stage are converted to points and fitted with a sphere.
+/// A circle search on depth edges then finds balls whose blob was merged with or
+/// cut by an occluding object. Pixels on a known floor never reach the labeler.
+/// </summary>
+class BallDetector
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    BallDetector();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~BallDetector();
+
+public:
+    /// <summary>
+    /// Select the depth image resolution
+    /// </summary>
+    /// <param name="resolution">Depth image resolution</param>
+    /// <returns>Indicates success or failure</returns>
+    HRESULT SetResolution(NUI_IMAGE_RESOLUTION resolution);
+
+    /// <summary>
+    /// Detect balls in a depth frame
+    /// </summary>
+    /// <param name="mask">Foreground mask of the frame</param>
+    /// <param name="pDepth">The pointer to depth pixels</param>
+    /// <returns>Number of balls found</returns>
+    UINT Detect(const PackedBitmask& mask, const NUI_DEPTH_IMAGE_PIXEL* pDepth);
+
+    /// <summary>
+    /// Detect balls only inside some windows of a depth frame
+    /// </summary>
+    /// <param name="mask">Foreground mask of the frame</param>
+    /// <param name="pDepth">The pointer to depth pixels</param>
+    /// <param name="windows">Windows to search</param>
+    /// <returns>Number of balls found</returns>
+    UINT Detect(const PackedBitmask& mask, const NUI_DEPTH_IMAGE_PIXEL* pDepth, const std::vector<ImageWindow>& windows);
+
+    /// <summary>
+    /// Set the radius of the ball
+    /// </summary>
+    /// <param name="radius">Radius in meters</param>
+    void SetBallRadius(FLOAT radius);
+
+    /// <summary>
+    /// Get pixels per meter at one meter distance for the selected resolution
+    /// </summary>
+    FLOAT GetFocalLength() const;
+
+    /// <summary>
+    /// Project a ball center to the depth image
+    /// </summary>
+    /// <param name="position">Center in the point cloud output frame, meters</param>
+    /// <param name="x">Receives the column</param>
+    /// <param name="y">Receives the row</param>
+    /// <param name="radius">Receives the ball radius in pixels</param>
+    /// <returns>False if the center is not in front of the camera</returns>
+    bool ProjectToImage(const Vector4& position, FLOAT& x, FLOAT& y, FLOAT& radius) const;
+
+    /// <summary>
+    /// Get the sphere fitter to tune its parameters
+    /// </summary>
+    SphereFitter& GetSphereFitter()
+    {
+        return m_sphereFitter;
+    }
+
+    /// <summary>
+    /// Enable or disable the circle search for partly hidden balls
+    /// </summary>
+    /// <param name="enable">True to run the circle search after the blob search</param>
+    void EnableCircleSearch(bool enable);
+
+    /// <summary>
+    /// Enable or disable opening of the foreground mask before labeling
+    /// </summary>
+    /// <param name="enable">True to remove speckle from the mask</param>
+    void EnableMaskOpening(bool enable);
+
+    /// <summary>
+    /// Get the circle detector to tune its parameters or read its circles
+    /// </summary>
+    HoughCircleDetector& GetCircleDetector()
+    {
+        return m_circleDetector;
+    }
+
+    /// <summary>
+    /// Get the projected ball radius of every depth at the selected resolution
+    /// </summary>
+    const BallScaleTable& GetScaleTable() const
+    {
+        return m_scaleTable;
+    }
+
+    /// <summary>
+    /// Get the candidate cascade to add stages, tune budgets or read statistics
+    /// </summary>
+    DetectionCascade& GetCascade()
+    {
+        return m_cascade;
+    }
+
+    /// <summary>
+    /// Get the candidate cascade to read statistics
+    /// </summary>
+    const DetectionCascade& GetCascade() const
+    {
+        return m_cascade;
+    }
+
+    /// <summary>
+    /// Get the cascade checking circles found by the circle search
+    /// </summary>
+    DetectionCascade& GetCircleCascade()
+    {
+        return m_circleCascade;
+    }
+
+    /// <summary>
+    /// Get the color stage to supply color frames and the ball color
+    /// </summary>
+    ColorGateStage& GetColorGate()
+    {
+        return m_colorGate;
+    }
+
+    /// <summary>
+    /// Set the rotation from camera space to the frame of ball positions
+    /// </summary>
+    /// <param name="rotation">Row major rotation matrix, output = rotation * camera</param>
+    void SetRotation(const FLOAT rotation[3][3]);
+
+    /// <summary>
+    /// Set the floor whose pixels are removed from the foreground before detection
+    /// </summary>
+    /// <param name="pFloor">The pointer to floor estimator, or nullptr for none</param>
+    void SetFloorEstimator(const FloorEstimator* pFloor);
+
+    /// <summary>
+    /// Get the point cloud builder of the selected resolution
+    /// </summary>
+    const PointCloudBuilder& GetPointCloud() const
+    {
+        return m_pointCloud;
+    }
+
+    /// <summary>
+    /// Get the balls found by the last call to Detect
+    /// </summary>
+    const std::vector<BallDetection>& GetDetections() const
+    {
+        return m_detections;
+    }
+
+    /// <summary>
+    /// Get the foreground blobs found by the last call to Detect
+    /// </summary>
+    const std::vector<DepthBlob>& GetBlobs() const
+    {
+        return m_blobLabeler.GetBlobs();
+    }
+
+private:
+    /// <summary>
+    /// Remove pixels on or below the floor from the foreground mask
+    /// </summary>
+    /// <param name="mask">Foreground mask of the frame</param>
+    /// <param name="pDepth">The pointer to depth pixels</param>
+    /// <returns>The mask without floor, or the input if no floor is known</returns>
+    const PackedBitmask& RejectFloor(const PackedBitmask& mask, const NUI_DEPTH_IMAGE_PIXEL* pDepth);
+
+    /// <summary>
+    /// Open the foreground mask with a disc small enough to keep the farthest ball
+    /// </summary>
+    /// <param name="mask">Foreground mask of the frame</param>
+    /// <returns>The opened mask, or the input if opening is disabled or too small to matter</returns>
+    const PackedBitmask& CleanMask(const PackedBitmask& mask);
+
+    /// <summary>
+    /// Turn the labeled blobs into cascade candidates
+    /// </summary>
+    void BuildCandidates();
+
+    /// <summary>
+    /// Fit spheres to circles that no blob detection explains
+    /// </summary>
+    /// <param name="frame">Frame data shared with the blob cascade</param>
+    void FitCircles(const CascadeFrame& frame);
+
+    /// <summary>
+    /// Fit a sphere to a blob and append a detection on success
+    /// </summary>
+    /// <param name="mask">Foreground mask of the frame</param>
+    /// <param name="pDepth">The pointer to depth pixels</param>
+    /// <param name="blob">Candidate blob</param>
+    void FitBlob(const PackedBitmask& mask, const NUI_DEPTH_IMAGE_PIXEL* pDepth, const DepthBlob& blob);
+
+private:
+    ParallelBands               m_parallel;             // Worker threads shared by the labeler and the circle search
+    BlobLabeler                 m_blobLabeler;
+    PointCloudBuilder           m_pointCloud;
+    SphereFitter                m_sphereFitter;
+    BallScaleTable              m_scaleTable;
+    HoughCircleDetector         m_circleDetector;
+    bool                        m_circleSearch;
+    MaskMorphology              m_morphology;
+    PackedBitmask               m_cleanMask;
+    bool                        m_maskOpening;
+    PackedBitmask               m_windowMask;
+    PackedBitmask               m_floorMask;
+    const FloorEstimator*       m_pFloor;
+
+    DetectionCascade            m_cascade;
+    DetectionCascade            m_circleCascade;
+    DepthGateStage              m_depthGate;
+    SizeGateStage               m_sizeGate;
+    ColorGateStage              m_colorGate;
+    std::vector<BallCandidate>  m_candidates;
+
+    std::vector<FLOAT>          m_candidateX;
+    std::vector<FLOAT>          m_candidateY;
+    std::vector<FLOAT>          m_candidateZ;
+    std::vector<BallDetection>  m_detections;
+};
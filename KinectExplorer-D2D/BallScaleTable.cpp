@@ -0,0 +1,101 @@
+//------------------------------------------------------------------------------
+// <copyright file="BallScaleTable.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "BallScaleTable.h"
+#include "SphereFitter.h"
+
+#define MILLIMETERS_TO_METERS   0.001f
+
+/// <summary>
+/// Constructor
+/// </summary>
+BallScaleTable::BallScaleTable()
+    : m_pRadii(nullptr)
+    , m_resolution(NUI_IMAGE_RESOLUTION_INVALID)
+    , m_ballRadius(DEFAULT_BALL_RADIUS)
+    , m_focalLength(0.0f)
+{
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+BallScaleTable::~BallScaleTable()
+{
+}
+
+/// <summary>
+/// Select the depth image resolution. The table is built on first use
+/// </summary>
+/// <param name="resolution">Depth image resolution</param>
+/// <returns>Indicates success or failure</returns>
+HRESULT BallScaleTable::SetResolution(NUI_IMAGE_RESOLUTION resolution)
+{
+    if (resolution < NUI_IMAGE_RESOLUTION_80x60 || resolution > NUI_IMAGE_RESOLUTION_1280x960)
+    {
+        return E_INVALIDARG;
+    }
+
+    DWORD width, height;
+    NuiImageResolutionToSize(resolution, width, height);
+
+    // The nominal focal length is given for 320x240
+    m_focalLength = width / (320.0f * NUI_CAMERA_DEPTH_NOMINAL_INVERSE_FOCAL_LENGTH_IN_PIXELS);
+    m_resolution  = resolution;
+
+    std::vector<FLOAT>& table = m_tables[resolution];
+    if (table.empty())
+    {
+        BuildTable(table, m_focalLength);
+    }
+
+    m_pRadii = &table;
+    return S_OK;
+}
+
+/// <summary>
+/// Set the radius of the ball
+/// </summary>
+/// <param name="radius">Radius in meters</param>
+void BallScaleTable::SetBallRadius(FLOAT radius)
+{
+    if (radius <= 0.0f || radius == m_ballRadius)
+    {
+        return;
+    }
+
+    m_ballRadius = radius;
+
+    for (UINT i = 0; i < SCALE_TABLE_COUNT; i++)
+    {
+        m_tables[i].clear();
+    }
+
+    m_pRadii = nullptr;
+    if (NUI_IMAGE_RESOLUTION_INVALID != m_resolution)
+    {
+        SetResolution(m_resolution);
+    }
+}
+
+/// <summary>
+/// Fill the radius table of a resolution
+/// </summary>
+/// <param name="table">Table to fill</param>
+/// <param name="focalLength">Pixels per meter at one meter</param>
+void BallScaleTable::BuildTable(std::vector<FLOAT>& table, FLOAT focalLength) const
+{
+    table.resize(SCALE_TABLE_DEPTHS);
+
+    // Unknown depth has no scale
+    table[0] = 0.0f;
+
+    FLOAT pixelRadius = m_ballRadius * focalLength / MILLIMETERS_TO_METERS;
+    for (UINT depth = 1; depth < SCALE_TABLE_DEPTHS; depth++)
+    {
+        table[depth] = pixelRadius / depth;
+    }
+}
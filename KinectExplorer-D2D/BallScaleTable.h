@@ -0,0 +1,106 @@
+//------------------------------------------------------------------------------
+// <copyright file="BallScaleTable.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include "NuiTypes.h"
+
+#define SCALE_TABLE_COUNT   4       // One table per depth image resolution
+#define SCALE_TABLE_DEPTHS  8192    // Millimeters covered, deeper pixels use the last entry
+
+/// <summary>
+/// Projected radius in pixels of a ball of known size at every depth in millimeters.
+/// A ball's image size is fixed by its depth and the focal length, so searches look
+/// the scale up instead of trying every radius. One table is built per resolution
+/// on first use and all tables are dropped when the ball radius changes.
+/// </summary>
+class BallScaleTable
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    BallScaleTable();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~BallScaleTable();
+
+public:
+    /// <summary>
+    /// Select the depth image resolution. The table is built on first use
+    /// </summary>
+    /// <param name="resolution">Depth image resolution</param>
+    /// <returns>Indicates success or failure</returns>
+    HRESULT SetResolution(NUI_IMAGE_RESOLUTION resolution);
+
+    /// <summary>
+    /// Set the radius of the ball
+    /// </summary>
+    /// <param name="radius">Radius in meters</param>
+    void SetBallRadius(FLOAT radius);
+
+    /// <summary>
+    /// Get the radius of the ball
+    /// </summary>
+    FLOAT GetBallRadius() const
+    {
+        return m_ballRadius;
+    }
+
+    /// <summary>
+    /// Get pixels per meter at one meter distance for the selected resolution
+    /// </summary>
+    FLOAT GetFocalLength() const
+    {
+        return m_focalLength;
+    }
+
+    /// <summary>
+    /// Get the projected ball radius at a depth
+    /// </summary>
+    /// <param name="depth">Depth in millimeters</param>
+    /// <returns>Radius in pixels, zero for unknown depth or before a resolution is selected</returns>
+    FLOAT GetRadius(USHORT depth) const
+    {
+        if (!m_pRadii)
+        {
+            return 0.0f;
+        }
+
+        return (*m_pRadii)[depth < SCALE_TABLE_DEPTHS ? depth : SCALE_TABLE_DEPTHS - 1];
+    }
+
+    /// <summary>
+    /// Get the projected ball radii over a depth range
+    /// </summary>
+    /// <param name="nearDepth">Nearest depth in millimeters</param>
+    /// <param name="farDepth">Farthest depth in millimeters</param>
+    /// <param name="minimumRadius">Receives the radius at the far end in pixels</param>
+    /// <param name="maximumRadius">Receives the radius at the near end in pixels</param>
+    void GetRadiusRange(USHORT nearDepth, USHORT farDepth, FLOAT& minimumRadius, FLOAT& maximumRadius) const
+    {
+        minimumRadius = GetRadius(farDepth);
+        maximumRadius = GetRadius(nearDepth);
+    }
+
+private:
+    /// <summary>
+    /// Fill the radius table of a resolution
+    /// </summary>
+    /// <param name="table">Table to fill</param>
+    /// <param name="focalLength">Pixels per meter at one meter</param>
+    void BuildTable(std::vector<FLOAT>& table, FLOAT focalLength) const;
+
+private:
+    std::vector<FLOAT>          m_tables[SCALE_TABLE_COUNT];
+    const std::vector<FLOAT>*   m_pRadii;
+    NUI_IMAGE_RESOLUTION        m_resolution;
+    FLOAT                       m_ballRadius;
+    FLOAT                       m_focalLength;
+};
@@ -0,0 +1,477 @@
+//------------------------------------------------------------------------------
+// <copyright file="BallTracker.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include "BallTracker.h"
+
+#define DEFAULT_FULL_FRAME_INTERVAL 30      // Frames, once a second at 30 fps
+#define DEFAULT_WINDOW_MARGIN       16      // Pixels
+#define DEFAULT_COAST_FRAMES        15      // Half a second at 30 fps
+#define DEFAULT_FRAME_INTERVAL      (1.0f / 30.0f)
+#define MAX_FRAME_INTERVAL          0.5f    // Seconds, longer gaps are clamped
+#define CONFIRM_HITS                3
+#define TENTATIVE_MAX_MISSED        1
+#define WINDOW_RADIUS_FACTOR        1.5f    // Window half size in predicted radii
+#define WINDOW_SIGMAS               3.0f
+#define GATE_DISTANCE               11.34f  // Chi-square, three degrees of freedom, 99%
+#define JERK_NOISE                  200.0f  // Spectral density, m^2/s^5. Covers bounces and catches
+#define MEASUREMENT_NOISE           4.0e-4f // Square meters, 2 cm
+#define INITIAL_VELOCITY_VARIANCE   25.0f   // (m/s)^2
+#define INITIAL_ACCEL_VARIANCE      100.0f  // (m/s^2)^2
+#define FULL_FRAME_TIME_SMOOTHING   0.1f
+
+/// <summary>
+/// Constructor
+/// </summary>
+BallTracker::BallTracker()
+    : m_nextId(1)
+    , m_fullFrameInterval(DEFAULT_FULL_FRAME_INTERVAL)
+    , m_framesSinceFullFrame(0)
+    , m_windowMargin(DEFAULT_WINDOW_MARGIN)
+    , m_coastFrames(DEFAULT_COAST_FRAMES)
+    , m_trackLost(false)
+    , m_lastTimestamp(0)
+{
+    ZeroMemory(&m_metrics, sizeof(m_metrics));
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+BallTracker::~BallTracker()
+{
+}
+
+/// <summary>
+/// Drop all tracks and search the whole next frame
+/// </summary>
+void BallTracker::Reset()
+{
+    m_tracks.clear();
+    m_framesSinceFullFrame = 0;
+    m_trackLost            = false;
+    m_lastTimestamp        = 0;
+}
+
+/// <summary>
+/// Set the number of frames between periodic full frame searches
+/// </summary>
+/// <param name="frames">Number of frames</param>
+void BallTracker::SetFullFrameInterval(UINT frames)
+{
+    m_fullFrameInterval = frames;
+}
+
+/// <summary>
+/// Set the margin added around predicted balls
+/// </summary>
+/// <param name="pixels">Margin in pixels</param>
+void BallTracker::SetWindowMargin(UINT pixels)
+{
+    m_windowMargin = pixels;
+}
+
+/// <summary>
+/// Set the number of frames a confirmed track survives without detections
+/// </summary>
+/// <param name="frames">Number of frames</param>
+void BallTracker::SetCoastFrames(UINT frames)
+{
+    m_coastFrames = frames;
+}
+
+/// <summary>
+/// Detect balls in a depth frame and update tracks
+/// </summary>
+/// <param name="detector">Detector to run</param>
+/// <param name="mask">Foreground mask of the frame</param>
+/// <param name="pDepth">The pointer to depth pixels</param>
+/// <param name="timestamp">Frame time in milliseconds</param>
+/// <returns>Number of tracks</returns>
+UINT BallTracker::Update(BallDetector& detector, const PackedBitmask& mask, const NUI_DEPTH_IMAGE_PIXEL* pDepth, LONGLONG timestamp)
+{
+    UINT width  = mask.GetWidth();
+    UINT height = mask.GetHeight();
+
+    // Time step from frame timestamps, nominal frame rate for the first frame
+    FLOAT dt = DEFAULT_FRAME_INTERVAL;
+    if (0 != m_lastTimestamp && timestamp > m_lastTimestamp)
+    {
+        dt = (timestamp - m_lastTimestamp) / 1000.0f;
+        if (dt > MAX_FRAME_INTERVAL)
+        {
+            dt = MAX_FRAME_INTERVAL;
+        }
+    }
+    m_lastTimestamp = timestamp;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    Predict(dt);
+
+    // Search everything when there is nothing to predict from, a ball was lost, or periodically for new balls
+    bool fullFrame = m_tracks.empty() || m_trackLost || m_framesSinceFullFrame + 1 >= m_fullFrameInterval;
+
+    std::chrono::steady_clock::time_point detectStart = std::chrono::steady_clock::now();
+
+    if (fullFrame)
+    {
+        detector.Detect(mask, pDepth);
+        m_framesSinceFullFrame    = 0;
+        m_metrics.windowCount     = 0;
+        m_metrics.pixelsProcessed = width * height;
+    }
+    else
+    {
+        BuildWindows(detector, width, height);
+        detector.Detect(mask, pDepth, m_windows);
+        ++m_framesSinceFullFrame;
+
+        m_metrics.windowCount     = (UINT)m_windows.size();
+        m_metrics.pixelsProcessed = CountWindowPixels();
+    }
+
+    std::chrono::steady_clock::time_point detectEnd = std::chrono::steady_clock::now();
+
+    Associate(detector);
+
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    FLOAT elapsed = std::chrono::duration<FLOAT, std::milli>(detectEnd - detectStart).count();
+
+    m_metrics.fullFrame          = fullFrame;
+    m_metrics.pixelsTotal        = width * height;
+    m_metrics.candidateCount     = (UINT)detector.GetDetections().size();
+    m_metrics.detectMilliseconds = elapsed;
+    m_metrics.trackMilliseconds  = std::chrono::duration<FLOAT, std::milli>((detectStart - start) + (end - detectEnd)).count();
+
+    if (fullFrame)
+    {
+        // Running average of the full frame cost, the baseline for the time saved by windows
+        m_metrics.fullFrameMilliseconds = (0.0f == m_metrics.fullFrameMilliseconds) ? elapsed :
+            m_metrics.fullFrameMilliseconds + FULL_FRAME_TIME_SMOOTHING * (elapsed - m_metrics.fullFrameMilliseconds);
+        m_metrics.savedMilliseconds = 0.0f;
+    }
+    else
+    {
+        FLOAT saved = m_metrics.fullFrameMilliseconds - elapsed;
+        m_metrics.savedMilliseconds = saved > 0.0f ? saved : 0.0f;
+    }
+
+    return (UINT)m_tracks.size();
+}
+
+/// <summary>
+/// Advance the filters of all tracks
+/// </summary>
+/// <param name="dt">Time step in seconds</param>
+void BallTracker::Predict(FLOAT dt)
+{
+    FLOAT dt2 = dt * dt;
+    FLOAT dt3 = dt2 * dt;
+
+    // Transition of a constant acceleration axis
+    const FLOAT f[TRACK_STATE_SIZE][TRACK_STATE_SIZE] =
+    {
+        {1.0f, dt,   0.5f * dt2},
+        {0.0f, 1.0f, dt},
+        {0.0f, 0.0f, 1.0f}
+    };
+
+    // Process noise of white jerk
+    const FLOAT q[TRACK_STATE_SIZE][TRACK_STATE_SIZE] =
+    {
+        {JERK_NOISE * dt3 * dt2 / 20.0f, JERK_NOISE * dt2 * dt2 / 8.0f, JERK_NOISE * dt3 / 6.0f},
+        {JERK_NOISE * dt2 * dt2 / 8.0f,  JERK_NOISE * dt3 / 3.0f,       JERK_NOISE * dt2 / 2.0f},
+        {JERK_NOISE * dt3 / 6.0f,        JERK_NOISE * dt2 / 2.0f,       JERK_NOISE * dt}
+    };
+
+    for (size_t i = 0; i < m_tracks.size(); i++)
+    {
+        BallTrack& track = m_tracks[i];
+
+        for (int axis = 0; axis < TRACK_AXIS_COUNT; axis++)
+        {
+            FLOAT* s = track.state[axis];
+            s[0] += s[1] * dt + 0.5f * s[2] * dt2;
+            s[1] += s[2] * dt;
+
+            // P = F P F' + Q
+            FLOAT (*p)[TRACK_STATE_SIZE] = track.covariance[axis];
+            FLOAT fp[TRACK_STATE_SIZE][TRACK_STATE_SIZE];
+
+            for (int r = 0; r < TRACK_STATE_SIZE; r++)
+            {
+                for (int c = 0; c < TRACK_STATE_SIZE; c++)
+                {
+                    fp[r][c] = f[r][0] * p[0][c] + f[r][1] * p[1][c] + f[r][2] * p[2][c];
+                }
+            }
+
+            for (int r = 0; r < TRACK_STATE_SIZE; r++)
+            {
+                for (int c = 0; c < TRACK_STATE_SIZE; c++)
+                {
+                    p[r][c] = fp[r][0] * f[c][0] + fp[r][1] * f[c][1] + fp[r][2] * f[c][2] + q[r][c];
+                }
+            }
+        }
+
+        ++track.age;
+        track.updated = false;
+    }
+}
+
+/// <summary>
+/// Build search windows around predicted tracks
+/// </summary>
+/// <param name="detector">Detector used for projection</param>
+/// <param name="width">Frame width</param>
+/// <param name="height">Frame height</param>
+void BallTracker::BuildWindows(const BallDetector& detector, UINT width, UINT height)
+{
+    m_windows.clear();
+
+    for (size_t i = 0; i < m_tracks.size(); i++)
+    {
+        const BallTrack& track = m_tracks[i];
+
+        Vector4 predicted = {track.state[0][0], track.state[1][0], track.state[2][0], 1.0f};
+        FLOAT   x, y, radius;
+        if (!detector.ProjectToImage(predicted, x, y, radius))
+        {
+            continue;
+        }
+
+        // Cover the ball, the margin, and the prediction uncertainty projected at the predicted depth
+        FLOAT pixelsPerMeter = detector.GetFocalLength() / detector.GetPointCloud().ToCamera(predicted).z;
+        FLOAT halfX = radius * WINDOW_RADIUS_FACTOR + m_windowMargin + WINDOW_SIGMAS * pixelsPerMeter * sqrtf(track.covariance[0][0][0]);
+        FLOAT halfY = radius * WINDOW_RADIUS_FACTOR + m_windowMargin + WINDOW_SIGMAS * pixelsPerMeter * sqrtf(track.covariance[1][0][0]);
+
+        FLOAT left   = x - halfX;
+        FLOAT top    = y - halfY;
+        FLOAT right  = x + halfX;
+        FLOAT bottom = y + halfY;
+
+        if (right < 0.0f || bottom < 0.0f || left >= width || top >= height)
+        {
+            continue;   // Predicted out of view
+        }
+
+        ImageWindow window;
+        window.left   = left   > 0.0f            ? (UINT)left   : 0;
+        window.top    = top    > 0.0f            ? (UINT)top    : 0;
+        window.right  = right  < width  - 1.0f   ? (UINT)right  : width  - 1;
+        window.bottom = bottom < height - 1.0f   ? (UINT)bottom : height - 1;
+
+        m_windows.push_back(window);
+    }
+
+    // Sorted by left edge, the pixel count merges each row in one pass
+    std::sort(m_windows.begin(), m_windows.end(), [](const ImageWindow& a, const ImageWindow& b) { return a.left < b.left; });
+}
+
+/// <summary>
+/// Count the pixels covered by the windows, overlapping windows counted once
+/// </summary>
+/// <returns>Number of pixels</returns>
+UINT BallTracker::CountWindowPixels() const
+{
+    UINT top    = UINT_MAX;
+    UINT bottom = 0;
+    for (size_t i = 0; i < m_windows.size(); i++)
+    {
+        top    = m_windows[i].top    < top    ? m_windows[i].top    : top;
+        bottom = m_windows[i].bottom > bottom ? m_windows[i].bottom : bottom;
+    }
+
+    UINT pixels = 0;
+    for (UINT y = top; y <= bottom && !m_windows.empty(); y++)
+    {
+        // Windows come in order of their left edges, so spans covering this row merge as they come
+        bool spanOpen  = false;
+        UINT spanLeft  = 0;
+        UINT spanRight = 0;
+        for (size_t i = 0; i < m_windows.size(); i++)
+        {
+            const ImageWindow& window = m_windows[i];
+            if (y < window.top || y > window.bottom)
+            {
+                continue;
+            }
+
+            if (spanOpen && window.left <= spanRight + 1)
+            {
+                spanRight = window.right > spanRight ? window.right : spanRight;
+                continue;
+            }
+
+            pixels   += spanOpen ? spanRight - spanLeft + 1 : 0;
+            spanOpen  = true;
+            spanLeft  = window.left;
+            spanRight = window.right;
+        }
+
+        pixels += spanOpen ? spanRight - spanLeft + 1 : 0;
+    }
+
+    return pixels;
+}
+
+/// <summary>
+/// Correct the filters of a track with a measured center
+/// </summary>
+void BallTracker::Correct(BallTrack& track, const Vector4& measured) const
+{
+    const FLOAT z[TRACK_AXIS_COUNT] = {measured.x, measured.y, measured.z};
+
+    for (int axis = 0; axis < TRACK_AXIS_COUNT; axis++)
+    {
+        FLOAT* s = track.state[axis];
+        FLOAT (*p)[TRACK_STATE_SIZE] = track.covariance[axis];
+
+        // Only the position is measured, so the gain is the first column of P over its innovation variance
+        FLOAT innovation = z[axis] - s[0];
+        FLOAT variance   = p[0][0] + MEASUREMENT_NOISE;
+        FLOAT gain[TRACK_STATE_SIZE] = {p[0][0] / variance, p[1][0] / variance, p[2][0] / variance};
+        FLOAT row[TRACK_STATE_SIZE]  = {p[0][0], p[0][1], p[0][2]};
+
+        for (int r = 0; r < TRACK_STATE_SIZE; r++)
+        {
+            s[r] += gain[r] * innovation;
+            for (int c = 0; c < TRACK_STATE_SIZE; c++)
+            {
+                p[r][c] -= gain[r] * row[c];
+            }
+        }
+    }
+}
+
+/// <summary>
+/// Start a tentative track at a detection
+/// </summary>
+void BallTracker::StartTrack(const BallDetection& detection)
+{
+    BallTrack track;
+    ZeroMemory(&track, sizeof(track));
+
+    const FLOAT position[TRACK_AXIS_COUNT] = {detection.position.x, detection.position.y, detection.position.z};
+    for (int axis = 0; axis < TRACK_AXIS_COUNT; axis++)
+    {
+        track.state[axis][0]         = position[axis];
+        track.covariance[axis][0][0] = MEASUREMENT_NOISE;
+        track.covariance[axis][1][1] = INITIAL_VELOCITY_VARIANCE;
+        track.covariance[axis][2][2] = INITIAL_ACCEL_VARIANCE;
+    }
+
+    track.updated     = true;
+    track.measurement = detection.position;
+    track.imageX      = detection.imageX;
+    track.imageY      = detection.imageY;
+    track.imageRadius = detection.imageRadius;
+    track.hits        = 1;
+
+    m_tracks.push_back(track);
+}
+
+/// <summary>
+/// Assign detections to tracks, update matched tracks, and handle track birth and death
+/// </summary>
+/// <param name="detector">Detector holding the detections of this frame</param>
+void BallTracker::Associate(const BallDetector& detector)
+{
+    const std::vector<BallDetection>& detections = detector.GetDetections();
+
+    UINT trackCount     = (UINT)m_tracks.size();
+    UINT detectionCount = (UINT)detections.size();
+
+    // Squared Mahalanobis distance of each detection to each predicted track
+    m_cost.resize(trackCount * detectionCount);
+    for (UINT t = 0; t < trackCount; t++)
+    {
+        const BallTrack& track = m_tracks[t];
+
+        FLOAT inverseVariance[TRACK_AXIS_COUNT];
+        for (int axis = 0; axis < TRACK_AXIS_COUNT; axis++)
+        {
+            inverseVariance[axis] = 1.0f / (track.covariance[axis][0][0] + MEASUREMENT_NOISE);
+        }
+
+        for (UINT d = 0; d < detectionCount; d++)
+        {
+            const Vector4& position = detections[d].position;
+            FLOAT dx = position.x - track.state[0][0];
+            FLOAT dy = position.y - track.state[1][0];
+            FLOAT dz = position.z - track.state[2][0];
+
+            m_cost[t * detectionCount + d] = dx * dx * inverseVariance[0] + dy * dy * inverseVariance[1] + dz * dz * inverseVariance[2];
+        }
+    }
+
+    // Globally optimal assignment. Pairs outside the gate are never matched
+    m_solver.Solve(m_cost.empty() ? nullptr : &m_cost[0], trackCount, detectionCount, GATE_DISTANCE, m_assignment);
+
+    m_used.assign(detectionCount, false);
+
+    for (UINT t = 0; t < trackCount; t++)
+    {
+        BallTrack& track = m_tracks[t];
+        int        match = m_assignment[t];
+
+        if (UNASSIGNED == match)
+        {
+            ++track.missed;
+        }
+        else
+        {
+            const BallDetection& detection = detections[match];
+            m_used[match] = true;
+
+            Correct(track, detection.position);
+
+            track.updated     = true;
+            track.measurement = detection.position;
+            track.missed      = 0;
+            ++track.hits;
+
+            // Stable ID is handed out only once the track proved itself
+            if (!track.confirmed && track.hits >= CONFIRM_HITS)
+            {
+                track.confirmed = true;
+                track.id        = m_nextId++;
+            }
+        }
+
+        Vector4 filtered = {track.state[0][0], track.state[1][0], track.state[2][0], 1.0f};
+        detector.ProjectToImage(filtered, track.imageX, track.imageY, track.imageRadius);
+    }
+
+    // Drop tracks that missed too often. Losing a confirmed ball forces a full frame search next
+    m_trackLost = false;
+    for (size_t i = m_tracks.size(); i-- > 0;)
+    {
+        const BallTrack& track = m_tracks[i];
+        UINT allowed = track.confirmed ? m_coastFrames : TENTATIVE_MAX_MISSED;
+
+        if (track.missed > allowed || track.state[2][0] <= 0.0f)
+        {
+            m_trackLost = m_trackLost || track.confirmed;
+            m_tracks.erase(m_tracks.begin() + i);
+        }
+    }
+
+    // Unmatched detections start tentative tracks
+    for (UINT d = 0; d < detectionCount; d++)
+    {
+        if (!m_used[d])
+        {
+            StartTrack(detections[d]);
+        }
+    }
+}
@@ -0,0 +1,181 @@
+//------------------------------------------------------------------------------
+// <copyright file="BallTracker.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include "NuiTypes.h"
+#include "AssignmentSolver.h"
+#include "BallDetector.h"
+
+#define TRACK_AXIS_COUNT    3   // x, y and z in the point cloud output frame
+#define TRACK_STATE_SIZE    3   // Position, velocity and acceleration of one axis
+
+/// <summary>
+/// Ball followed across depth frames
+/// </summary>
+struct BallTrack
+{
+    UINT    id;                 // Stable ID, zero until the track is confirmed
+    bool    confirmed;
+    bool    updated;            // True if a detection was assigned in the last frame
+    FLOAT   state[TRACK_AXIS_COUNT][TRACK_STATE_SIZE];                          // Meters, m/s, m/s^2
+    FLOAT   covariance[TRACK_AXIS_COUNT][TRACK_STATE_SIZE][TRACK_STATE_SIZE];
+    Vector4 measurement;        // Last detected center in the point cloud output frame, meters
+    FLOAT   imageX;             // Projected filtered center, pixels
+    FLOAT   imageY;
+    FLOAT   imageRadius;
+    UINT    age;                // Frames since the track started
+    UINT    hits;               // Frames with an assigned detection
+    UINT    missed;             // Consecutive frames without a detection
+};
+
+/// <summary>
+/// Per-frame cost of detection and tracking
+/// </summary>
+struct BallTrackerMetrics
+{
+    bool    fullFrame;              // True if the whole frame was searched
+    UINT    windowCount;
+    UINT    pixelsProcessed;        // Pixels inside the union of the searched windows, overlaps counted once
+    UINT    pixelsTotal;            // Pixels of the whole frame
+    UINT    candidateCount;         // Detections offered to the tracker
+    FLOAT   detectMilliseconds;     // Detector time of this frame
+    FLOAT   fullFrameMilliseconds;  // Running average detector time of full frame searches
+    FLOAT   savedMilliseconds;      // Full frame average minus this frame as measured, zero for full frame searches
+    FLOAT   trackMilliseconds;      // Prediction, assignment and filter update time
+};
+
+/// <summary>
+/// Follows several balls at once. Each track has a constant acceleration Kalman
+/// filter per output frame axis. Every frame the tracks are predicted, and the
+/// detector only searches windows around their projections. Detections are matched
+/// to tracks by a globally optimal assignment over gated Mahalanobis distances, so
+/// crossing balls keep their identities. A track is confirmed, and gets its stable
+/// ID, after a few consecutive hits, and coasts on its prediction through short
+/// occlusions before it is dropped. The whole frame is searched when nothing is
+/// tracked, after a confirmed track is lost, and periodically to pick up new balls.
+/// Windows only cut the stages which visit foreground pixels: labeling, floor
+/// rejection and the circle votes. Mask cleanup still passes over the whole frame,
+/// so the metrics report the time saved as measured, not in proportion to the area.
+/// </summary>
+class BallTracker
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    BallTracker();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~BallTracker();
+
+public:
+    /// <summary>
+    /// Detect balls in a depth frame and update tracks
+    /// </summary>
+    /// <param name="detector">Detector to run</param>
+    /// <param name="mask">Foreground mask of the frame</param>
+    /// <param name="pDepth">The pointer to depth pixels</param>
+    /// <param name="timestamp">Frame time in milliseconds</param>
+    /// <returns>Number of tracks</returns>
+    UINT Update(BallDetector& detector, const PackedBitmask& mask, const NUI_DEPTH_IMAGE_PIXEL* pDepth, LONGLONG timestamp);
+
+    /// <summary>
+    /// Drop all tracks and search the whole next frame
+    /// </summary>
+    void Reset();
+
+    /// <summary>
+    /// Set the number of frames between periodic full frame searches
+    /// </summary>
+    /// <param name="frames">Number of frames</param>
+    void SetFullFrameInterval(UINT frames);
+
+    /// <summary>
+    /// Set the margin added around predicted balls
+    /// </summary>
+    /// <param name="pixels">Margin in pixels</param>
+    void SetWindowMargin(UINT pixels);
+
+    /// <summary>
+    /// Set the number of frames a confirmed track survives without detections
+    /// </summary>
+    /// <param name="frames">Number of frames</param>
+    void SetCoastFrames(UINT frames);
+
+    /// <summary>
+    /// Get current tracks, including unconfirmed ones
+    /// </summary>
+    const std::vector<BallTrack>& GetTracks() const
+    {
+        return m_tracks;
+    }
+
+    /// <summary>
+    /// Get the cost of the last frame
+    /// </summary>
+    const BallTrackerMetrics& GetMetrics() const
+    {
+        return m_metrics;
+    }
+
+private:
+    /// <summary>
+    /// Advance the filters of all tracks
+    /// </summary>
+    /// <param name="dt">Time step in seconds</param>
+    void Predict(FLOAT dt);
+
+    /// <summary>
+    /// Build search windows around predicted tracks
+    /// </summary>
+    /// <param name="detector">Detector used for projection</param>
+    /// <param name="width">Frame width</param>
+    /// <param name="height">Frame height</param>
+    void BuildWindows(const BallDetector& detector, UINT width, UINT height);
+
+    /// <summary>
+    /// Count the pixels covered by the windows, overlapping windows counted once
+    /// </summary>
+    /// <returns>Number of pixels</returns>
+    UINT CountWindowPixels() const;
+
+    /// <summary>
+    /// Assign detections to tracks, update matched tracks, and handle track birth and death
+    /// </summary>
+    /// <param name="detector">Detector holding the detections of this frame</param>
+    void Associate(const BallDetector& detector);
+
+    /// <summary>
+    /// Start a tentative track at a detection
+    /// </summary>
+    void StartTrack(const BallDetection& detection);
+
+    /// <summary>
+    /// Correct the filters of a track with a measured center
+    /// </summary>
+    void Correct(BallTrack& track, const Vector4& measured) const;
+
+private:
+    std::vector<BallTrack>      m_tracks;
+    std::vector<ImageWindow>    m_windows;
+    std::vector<FLOAT>          m_cost;
+    std::vector<int>            m_assignment;
+    std::vector<bool>           m_used;
+    AssignmentSolver            m_solver;
+    BallTrackerMetrics          m_metrics;
+
+    UINT        m_nextId;
+    UINT        m_fullFrameInterval;
+    UINT        m_framesSinceFullFrame;
+    UINT        m_windowMargin;
+    UINT        m_coastFrames;
+    bool        m_trackLost;
+    LONGLONG    m_lastTimestamp;
+};
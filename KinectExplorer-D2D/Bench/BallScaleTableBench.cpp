@@ -0,0 +1,208 @@
+//------------------------------------------------------------------------------
+// <copyright file="BallScaleTableBench.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+// Times the circle search on synthetic 640x480 depth frames of balls in front of a
+// wall. The detector casts one vote per edge pixel at the radius the scale table
+// gives for its depth. The multi-scale search it replaced does not know the radius,
+// so every edge pixel votes once per radius the balls can have over the working
+// depth range, into one accumulator per radius. Only its voting is timed, its peak
+// search would add to that.
+
+#include "BenchTimer.h"
+#include "BallScaleTable.h"
+#include "HoughCircleDetector.h"
+#include "PackedBitmask.h"
+#include <climits>
+#include <cmath>
+#include <stdio.h>
+
+#define FRAME_WIDTH         640
+#define FRAME_HEIGHT        480
+#define BALL_RADIUS         0.3175f     // Meters, the fitter default
+#define WALL_DEPTH          4500        // Millimeters
+#define NEAR_DEPTH          800         // Millimeters, the sensor range the search covers
+#define FAR_DEPTH           4000
+#define EDGE_STEP           40          // Millimeters, the detector default
+#define UNKNOWN_DEPTH       8000        // Millimeters, as the detector treats missing depth
+#define CELL_SHIFT          1           // Accumulator cells of 2x2 pixels, as the detector
+#define TIMED_RUNS          21
+
+/// <summary>
+/// Small deterministic generator, so every run sees the same balls
+/// </summary>
+static FLOAT NextUniform(UINT& state)
+{
+    state = state * 1664525u + 1013904223u;
+    return (state >> 8) / 16777216.0f;
+}
+
+/// <summary>
+/// Draw balls in front of a wall and mark everything nearer than the wall as foreground
+/// </summary>
+static void DrawFrame(UINT ballCount, const BallScaleTable& table, UINT& state, std::vector<NUI_DEPTH_IMAGE_PIXEL>& depth, PackedBitmask& mask)
+{
+    NUI_DEPTH_IMAGE_PIXEL wall = {0, WALL_DEPTH};
+    depth.assign(FRAME_WIDTH * FRAME_HEIGHT, wall);
+    mask.Resize(FRAME_WIDTH, FRAME_HEIGHT);
+    mask.Clear();
+
+    FLOAT focalLength = table.GetFocalLength();
+    for (UINT i = 0; i < ballCount; i++)
+    {
+        FLOAT centerDepth = 1200.0f + 2500.0f * NextUniform(state);
+        FLOAT radius      = table.GetRadius((USHORT)centerDepth);
+        FLOAT centerX     = radius + (FRAME_WIDTH  - 2.0f * radius) * NextUniform(state);
+        FLOAT centerY     = radius + (FRAME_HEIGHT - 2.0f * radius) * NextUniform(state);
+
+        for (int y = (int)(centerY - radius); y <= (int)(centerY + radius); y++)
+        {
+            for (int x = (int)(centerX - radius); x <= (int)(centerX + radius); x++)
+            {
+                if (x < 0 || y < 0 || x >= FRAME_WIDTH || y >= FRAME_HEIGHT)
+                {
+                    continue;
+                }
+
+                // Distance from the axis in millimeters at the depth of the center
+                FLOAT dx = (x - centerX) * centerDepth / focalLength;
+                FLOAT dy = (y - centerY) * centerDepth / focalLength;
+                FLOAT rim = BALL_RADIUS * 1000.0f;
+                FLOAT squared = rim * rim - dx * dx - dy * dy;
+                if (squared < 0.0f)
+                {
+                    continue;
+                }
+
+                USHORT surface = (USHORT)(centerDepth - sqrtf(squared));
+                NUI_DEPTH_IMAGE_PIXEL& pixel = depth[y * FRAME_WIDTH + x];
+                if (surface < pixel.depth)
+                {
+                    pixel.depth = surface;
+                    mask.Set(x, y);
+                }
+            }
+        }
+    }
+}
+
+/// <summary>
+/// Vote once per radius of the range for every near side edge pixel, as a search that
+/// does not know the ball size from depth has to
+/// </summary>
+/// <returns>Votes cast</returns>
+static UINT VoteAllRadii(const PackedBitmask& mask, const NUI_DEPTH_IMAGE_PIXEL* pDepth, UINT minimumRadius, UINT maximumRadius, std::vector<USHORT>& votes)
+{
+    UINT cellsX = (FRAME_WIDTH  + (1 << CELL_SHIFT) - 1) >> CELL_SHIFT;
+    UINT cellsY = (FRAME_HEIGHT + (1 << CELL_SHIFT) - 1) >> CELL_SHIFT;
+    UINT layer  = cellsX * cellsY;
+    votes.assign(layer * (maximumRadius - minimumRadius + 1), 0);
+
+    int  thresholdSq = 16 * EDGE_STEP * EDGE_STEP;
+    UINT voteCount   = 0;
+
+    for (UINT y = 1; y < FRAME_HEIGHT - 1; y++)
+    {
+        for (UINT x = 1; x < FRAME_WIDTH - 1; x++)
+        {
+            if (!mask.Test(x, y))
+            {
+                continue;
+            }
+
+            int d[9];
+            for (int i = 0; i < 3; i++)
+            {
+                d[i]     = pDepth[(y - 1) * FRAME_WIDTH + x - 1 + i].depth;
+                d[3 + i] = pDepth[y * FRAME_WIDTH + x - 1 + i].depth;
+                d[6 + i] = pDepth[(y + 1) * FRAME_WIDTH + x - 1 + i].depth;
+            }
+
+            int lowest  = INT_MAX;
+            int highest = 0;
+            for (int i = 0; i < 9; i++)
+            {
+                if (0 == d[i])
+                {
+                    d[i] = UNKNOWN_DEPTH;
+                }
+                lowest  = d[i] < lowest  ? d[i] : lowest;
+                highest = d[i] > highest ? d[i] : highest;
+            }
+
+            int gx = (d[2] + 2 * d[5] + d[8]) - (d[0] + 2 * d[3] + d[6]);
+            int gy = (d[6] + 2 * d[7] + d[8]) - (d[0] + 2 * d[1] + d[2]);
+            int magnitudeSq = gx * gx + gy * gy;
+            if (magnitudeSq < thresholdSq || 2 * d[4] > lowest + highest)
+            {
+                continue;
+            }
+
+            FLOAT inverse = 1.0f / sqrtf((FLOAT)magnitudeSq);
+            for (UINT radius = minimumRadius; radius <= maximumRadius; radius++)
+            {
+                FLOAT centerX = x - gx * inverse * radius;
+                FLOAT centerY = y - gy * inverse * radius;
+                if (centerX < 0.0f || centerY < 0.0f || centerX >= FRAME_WIDTH || centerY >= FRAME_HEIGHT)
+                {
+                    continue;
+                }
+
+                UINT index = (radius - minimumRadius) * layer + ((UINT)centerY >> CELL_SHIFT) * cellsX + ((UINT)centerX >> CELL_SHIFT);
+                if (votes[index] < USHRT_MAX)
+                {
+                    ++votes[index];
+                }
+                ++voteCount;
+            }
+        }
+    }
+
+    return voteCount;
+}
+
+/// <summary>
+/// Time both searches on one frame
+/// </summary>
+static void RunCase(UINT ballCount, const BallScaleTable& table, UINT minimumRadius, UINT maximumRadius)
+{
+    UINT state = 2024 + ballCount;
+    std::vector<NUI_DEPTH_IMAGE_PIXEL> depth;
+    PackedBitmask mask;
+    DrawFrame(ballCount, table, state, depth, mask);
+
+    HoughCircleDetector detector;
+    UINT   circles    = 0;
+    double tableTime  = MedianMilliseconds(TIMED_RUNS, [&] { circles = detector.Detect(mask, &depth[0], table); });
+    UINT   tableVotes = detector.GetVoteCount();
+
+    std::vector<USHORT> votes;
+    UINT   scaleVotes = 0;
+    double scaleTime  = MedianMilliseconds(TIMED_RUNS, [&] { scaleVotes = VoteAllRadii(mask, &depth[0], minimumRadius, maximumRadius, votes); });
+
+    printf("balls %u  table: %2u circles %7u votes %7.2f ms  multi-scale voting: %9u votes %8.2f ms  %5.0fx votes %5.1fx time\n",
+        ballCount, circles, tableVotes, tableTime, scaleVotes, scaleTime,
+        tableVotes ? (double)scaleVotes / tableVotes : 0.0, tableTime > 0.0 ? scaleTime / tableTime : 0.0);
+}
+
+int main()
+{
+    BallScaleTable table;
+    table.SetResolution(NUI_IMAGE_RESOLUTION_640x480);
+    table.SetBallRadius(BALL_RADIUS);
+
+    FLOAT minimumRadius, maximumRadius;
+    table.GetRadiusRange(NEAR_DEPTH, FAR_DEPTH, minimumRadius, maximumRadius);
+    printf("%ux%u, ball radius %.4f m, multi-scale radii %u..%u pixels for %u..%u mm, single thread\n",
+        FRAME_WIDTH, FRAME_HEIGHT, BALL_RADIUS, (UINT)minimumRadius, (UINT)maximumRadius, NEAR_DEPTH, FAR_DEPTH);
+
+    const UINT ballCounts[] = {1, 3, 6};
+    for (UINT i = 0; i < sizeof(ballCounts) / sizeof(ballCounts[0]); i++)
+    {
+        RunCase(ballCounts[i], table, (UINT)minimumRadius, (UINT)maximumRadius);
+    }
+
+    return 0;
+}
@@ -0,0 +1,40 @@
+//------------------------------------------------------------------------------
+// <copyright file="BenchTimer.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#define BENCH_WARMUP_RUNS   3
+
+/// <summary>
+/// Run a task repeatedly and get the median time of one run. A few runs first warm
+/// the caches and let pools start their threads
+/// </summary>
+/// <param name="runs">Timed runs</param>
+/// <param name="task">Task to time</param>
+/// <returns>Median milliseconds per run</returns>
+template <typename Task>
+double MedianMilliseconds(unsigned runs, Task task)
+{
+    for (unsigned i = 0; i < BENCH_WARMUP_RUNS; i++)
+    {
+        task();
+    }
+
+    std::vector<double> times(runs < 1 ? 1 : runs);
+    for (size_t i = 0; i < times.size(); i++)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        task();
+        times[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
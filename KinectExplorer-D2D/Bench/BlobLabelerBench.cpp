@@ -0,0 +1,198 @@
+//------------------------------------------------------------------------------
+// <copyright file="BlobLabelerBench.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+// Times the run-length blob labeler, on the calling thread and on a pool, against
+// a naive flood fill with the same depth continuity rule on synthetic 640x480
+// foreground masks, and checks that both find the same blobs.
+
+#include "BenchTimer.h"
+#include "BlobLabeler.h"
+#include <cmath>
+#include <stdio.h>
+
+#define WIDTH               640
+#define HEIGHT              480
+#define RUNS                50
+#define DEPTH_CONTINUITY    60          // Millimeters, the labeler default
+#define MINIMUM_AREA        20          // Pixels, the labeler default
+#define BALL_COUNT          8
+#define NOISE_PERCENT       2
+
+/// <summary>
+/// Small deterministic generator, so every run sees the same scene
+/// </summary>
+static UINT NextRandom(UINT& state)
+{
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+/// <summary>
+/// Draw a scene: a person shaped slab, balls at several depths with one held in
+/// front of the slab, and optionally salt noise at random depths
+/// </summary>
+static void DrawScene(bool noise, PackedBitmask& mask, std::vector<NUI_DEPTH_IMAGE_PIXEL>& depth)
+{
+    mask.Resize(WIDTH, HEIGHT);
+    mask.Clear();
+    depth.assign(WIDTH * HEIGHT, NUI_DEPTH_IMAGE_PIXEL());
+
+    for (UINT y = 120; y < HEIGHT; y++)
+    {
+        for (UINT x = 260; x < 380; x++)
+        {
+            mask.Set(x, y);
+            depth[y * WIDTH + x].depth = 2500;
+        }
+    }
+
+    for (UINT ball = 0; ball < BALL_COUNT; ball++)
+    {
+        int   centerX = 50 + ball * 75;
+        int   centerY = 0 == ball % 2 ? 100 : 300;
+        FLOAT centerZ = 1500.0f + 250.0f * ball;
+        int   radius  = (int)(0.12f * 285.63f * 2.0f * 1000.0f / centerZ);
+
+        for (int dy = -radius; dy <= radius; dy++)
+        {
+            for (int dx = -radius; dx <= radius; dx++)
+            {
+                int x = centerX + dx;
+                int y = centerY + dy;
+                if (x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT || dx * dx + dy * dy > radius * radius)
+                {
+                    continue;
+                }
+
+                // Front surface of the sphere, nearer toward the middle
+                FLOAT surface = sqrtf((FLOAT)(radius * radius - dx * dx - dy * dy)) / radius;
+                mask.Set(x, y);
+                depth[y * WIDTH + x].depth = (USHORT)(centerZ - 120.0f * surface);
+            }
+        }
+    }
+
+    if (!noise)
+    {
+        return;
+    }
+
+    UINT state = 12345;
+    for (UINT i = 0; i < WIDTH * HEIGHT * NOISE_PERCENT / 100; i++)
+    {
+        UINT x = NextRandom(state) % WIDTH;
+        UINT y = NextRandom(state) % HEIGHT;
+        mask.Set(x, y);
+        depth[y * WIDTH + x].depth = (USHORT)(800 + NextRandom(state) % 3200);
+    }
+}
+
+/// <summary>
+/// Label by flood filling every unvisited foreground pixel through its four neighbours
+/// </summary>
+/// <returns>Number of blobs of at least MINIMUM_AREA pixels, total area in pixelArea</returns>
+static UINT FloodFill(const PackedBitmask& mask, const NUI_DEPTH_IMAGE_PIXEL* pDepth, std::vector<int>& labels, std::vector<UINT>& stack, UINT& pixelArea)
+{
+    labels.assign(WIDTH * HEIGHT, 0);
+    UINT blobs = 0;
+    pixelArea  = 0;
+
+    for (UINT start = 0; start < WIDTH * HEIGHT; start++)
+    {
+        if (labels[start] || 0 == pDepth[start].depth || !mask.Test(start % WIDTH, start / WIDTH))
+        {
+            continue;
+        }
+
+        labels[start] = 1;
+        stack.assign(1, start);
+
+        UINT area = 0;
+        while (!stack.empty())
+        {
+            UINT pixel = stack.back();
+            stack.pop_back();
+            ++area;
+
+            UINT x = pixel % WIDTH;
+            UINT y = pixel / WIDTH;
+            const UINT neighbours[4] = {pixel - 1, pixel + 1, pixel - WIDTH, pixel + WIDTH};
+            const bool inside[4]     = {x > 0, x + 1 < WIDTH, y > 0, y + 1 < HEIGHT};
+
+            for (int i = 0; i < 4; i++)
+            {
+                UINT next = neighbours[i];
+                if (!inside[i] || labels[next] || 0 == pDepth[next].depth || !mask.Test(next % WIDTH, next / WIDTH))
+                {
+                    continue;
+                }
+
+                int delta = (int)pDepth[next].depth - (int)pDepth[pixel].depth;
+                if (delta > DEPTH_CONTINUITY || delta < -DEPTH_CONTINUITY)
+                {
+                    continue;
+                }
+
+                labels[next] = 1;
+                stack.push_back(next);
+            }
+        }
+
+        if (area >= MINIMUM_AREA)
+        {
+            ++blobs;
+            pixelArea += area;
+        }
+    }
+
+    return blobs;
+}
+
+/// <summary>
+/// Time both labelers on one scene
+/// </summary>
+static void RunScene(const char* name, bool noise, ParallelBands& pool)
+{
+    PackedBitmask                      mask;
+    std::vector<NUI_DEPTH_IMAGE_PIXEL> depth;
+    DrawScene(noise, mask, depth);
+
+    BlobLabeler labeler;
+    labeler.SetDepthContinuity(DEPTH_CONTINUITY);
+    labeler.SetMinimumArea(MINIMUM_AREA);
+
+    double single = MedianMilliseconds(RUNS, [&] { labeler.Label(mask, &depth[0]); });
+
+    labeler.SetParallelBands(&pool);
+    double parallel = MedianMilliseconds(RUNS, [&] { labeler.Label(mask, &depth[0]); });
+
+    UINT labelerArea = 0;
+    const std::vector<DepthBlob>& blobs = labeler.GetBlobs();
+    for (size_t i = 0; i < blobs.size(); i++)
+    {
+        labelerArea += blobs[i].area;
+    }
+
+    std::vector<int>  labels;
+    std::vector<UINT> stack;
+    UINT floodBlobs = 0;
+    UINT floodArea  = 0;
+    double flood = MedianMilliseconds(RUNS, [&] { floodBlobs = FloodFill(mask, &depth[0], labels, stack, floodArea); });
+
+    bool same = floodBlobs == blobs.size() && floodArea == labelerArea;
+    printf("%-8s foreground %6u  blobs %3u  labeler %6.3f ms  %u threads %6.3f ms  flood fill %6.3f ms  %s\n",
+        name, mask.CountSet(), (UINT)blobs.size(), single, pool.GetThreadCount(), parallel, flood, same ? "same blobs" : "BLOBS DIFFER");
+}
+
+int main()
+{
+    ParallelBands pool;
+
+    RunScene("clean", false, pool);
+    RunScene("noisy", true, pool);
+
+    return 0;
+}
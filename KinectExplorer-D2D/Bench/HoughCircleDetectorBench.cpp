@@ -0,0 +1,174 @@
+//------------------------------------------------------------------------------
+// <copyright file="HoughCircleDetectorBench.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+// Times the circle detector, on the calling thread and on a pool, on synthetic
+// 640x480 depth frames of balls in front of a wall, some of them half hidden behind
+// a nearer box, and prints how many of the drawn balls it found.
+
+#include "BenchTimer.h"
+#include "HoughCircleDetector.h"
+#include "SphereFitter.h"
+#include <cmath>
+#include <stdio.h>
+
+#define FRAME_WIDTH         640
+#define FRAME_HEIGHT        480
+#define WALL_DEPTH          4500        // Millimeters
+#define OCCLUDER_DEPTH      900         // Millimeters, nearer than every ball
+#define FOUND_DISTANCE      0.2f        // Share of the radius a circle may be off the ball
+#define TIMED_RUNS          51
+
+struct Ball
+{
+    FLOAT   x;
+    FLOAT   y;
+    FLOAT   radius;
+};
+
+/// <summary>
+/// Small deterministic generator, so every run sees the same balls
+/// </summary>
+static FLOAT NextUniform(UINT& state)
+{
+    state = state * 1664525u + 1013904223u;
+    return (state >> 8) / 16777216.0f;
+}
+
+/// <summary>
+/// Draw balls in front of a wall, with a box hiding the left half of every second ball
+/// if asked. Everything nearer than the wall is foreground
+/// </summary>
+static void DrawFrame(UINT ballCount, bool occluded, const BallScaleTable& table, std::vector<NUI_DEPTH_IMAGE_PIXEL>& depth, PackedBitmask& mask, std::vector<Ball>& balls)
+{
+    NUI_DEPTH_IMAGE_PIXEL wall = {0, WALL_DEPTH};
+    depth.assign(FRAME_WIDTH * FRAME_HEIGHT, wall);
+    mask.Resize(FRAME_WIDTH, FRAME_HEIGHT);
+    mask.Clear();
+    balls.clear();
+
+    UINT  state       = 37 + ballCount;
+    FLOAT focalLength = table.GetFocalLength();
+    FLOAT rim         = DEFAULT_BALL_RADIUS * 1000.0f;
+
+    for (UINT i = 0; i < ballCount; i++)
+    {
+        FLOAT centerDepth = 1200.0f + 2500.0f * NextUniform(state);
+        Ball  ball;
+        ball.radius = table.GetRadius((USHORT)centerDepth);
+        ball.x      = ball.radius + (FRAME_WIDTH  - 2.0f * ball.radius) * NextUniform(state);
+        ball.y      = ball.radius + (FRAME_HEIGHT - 2.0f * ball.radius) * NextUniform(state);
+        balls.push_back(ball);
+
+        for (int y = (int)(ball.y - ball.radius); y <= (int)(ball.y + ball.radius); y++)
+        {
+            for (int x = (int)(ball.x - ball.radius); x <= (int)(ball.x + ball.radius); x++)
+            {
+                if (x < 0 || y < 0 || x >= FRAME_WIDTH || y >= FRAME_HEIGHT)
+                {
+                    continue;
+                }
+
+                // Distance from the axis in millimeters at the depth of the center
+                FLOAT dx = (x - ball.x) * centerDepth / focalLength;
+                FLOAT dy = (y - ball.y) * centerDepth / focalLength;
+                FLOAT squared = rim * rim - dx * dx - dy * dy;
+                if (squared < 0.0f)
+                {
+                    continue;
+                }
+
+                USHORT surface = (USHORT)(centerDepth - sqrtf(squared));
+                NUI_DEPTH_IMAGE_PIXEL& pixel = depth[y * FRAME_WIDTH + x];
+                if (surface < pixel.depth)
+                {
+                    pixel.depth = surface;
+                    mask.Set(x, y);
+                }
+            }
+        }
+    }
+
+    for (UINT i = 1; occluded && i < balls.size(); i += 2)
+    {
+        const Ball& ball = balls[i];
+        for (int y = (int)(ball.y - ball.radius) - 4; y <= (int)(ball.y + ball.radius) + 4; y++)
+        {
+            for (int x = (int)(ball.x - ball.radius) - 8; x < (int)ball.x; x++)
+            {
+                if (x >= 0 && y >= 0 && x < FRAME_WIDTH && y < FRAME_HEIGHT)
+                {
+                    depth[y * FRAME_WIDTH + x].depth = OCCLUDER_DEPTH;
+                    mask.Set(x, y);
+                }
+            }
+        }
+    }
+}
+
+/// <summary>
+/// Count the drawn balls with a circle near their center
+/// </summary>
+static UINT CountFound(const std::vector<Ball>& balls, const std::vector<CircleDetection>& circles)
+{
+    UINT found = 0;
+    for (size_t i = 0; i < balls.size(); i++)
+    {
+        FLOAT limit = FOUND_DISTANCE * balls[i].radius;
+        for (size_t j = 0; j < circles.size(); j++)
+        {
+            FLOAT dx = circles[j].imageX - balls[i].x;
+            FLOAT dy = circles[j].imageY - balls[i].y;
+            if (dx * dx + dy * dy < limit * limit)
+            {
+                ++found;
+                break;
+            }
+        }
+    }
+
+    return found;
+}
+
+/// <summary>
+/// Time the detector on one frame
+/// </summary>
+static void RunCase(UINT ballCount, bool occluded, const BallScaleTable& table, ParallelBands& pool)
+{
+    std::vector<NUI_DEPTH_IMAGE_PIXEL> depth;
+    std::vector<Ball> balls;
+    PackedBitmask mask;
+    DrawFrame(ballCount, occluded, table, depth, mask, balls);
+
+    HoughCircleDetector detector;
+    double single = MedianMilliseconds(TIMED_RUNS, [&] { detector.Detect(mask, &depth[0], table); });
+
+    detector.SetParallelBands(&pool);
+    double parallel = MedianMilliseconds(TIMED_RUNS, [&] { detector.Detect(mask, &depth[0], table); });
+
+    printf("balls %u %-11s foreground %6u  votes %6u  circles %2u  found %u/%u  single %6.3f ms  %u threads %6.3f ms\n",
+        ballCount, occluded ? "half hidden" : "visible", mask.CountSet(), detector.GetVoteCount(), (UINT)detector.GetCircles().size(),
+        CountFound(balls, detector.GetCircles()), ballCount, single, pool.GetThreadCount(), parallel);
+}
+
+int main()
+{
+    BallScaleTable table;
+    table.SetResolution(NUI_IMAGE_RESOLUTION_640x480);
+    table.SetBallRadius(DEFAULT_BALL_RADIUS);
+
+    ParallelBands pool;
+    printf("%ux%u, ball radius %.4f m\n", FRAME_WIDTH, FRAME_HEIGHT, DEFAULT_BALL_RADIUS);
+
+    const UINT ballCounts[] = {0, 1, 3, 6};
+    for (UINT i = 0; i < sizeof(ballCounts) / sizeof(ballCounts[0]); i++)
+    {
+        RunCase(ballCounts[i], false, table, pool);
+    }
+
+    RunCase(6, true, table, pool);
+
+    return 0;
+}
@@ -0,0 +1,165 @@
+//------------------------------------------------------------------------------
+// <copyright file="OverlayCompositorBench.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+// Times the overlay compositor drawing a busy preview overlay, two tracked and two
+// position only skeletons, ball detections and labelled tracks, into BGRX frames of
+// the depth and preview sizes. A checksum of the first drawn frame lets builds with
+// and without SSE2 be compared for identical output.
+
+#include "BenchTimer.h"
+#include "OverlayCompositor.h"
+#include "OverlayList.h"
+#include "SkeletonStore.h"
+#include <stdio.h>
+#include <string.h>
+
+#define SOURCE_WIDTH        640         // Overlay items are in depth image pixels
+#define SOURCE_HEIGHT       480
+#define BALL_COUNT          3
+#define TIMED_RUNS          101
+
+// Joints of a person standing upright, in meters from the skeleton position
+static const FLOAT StandingJoints[NUI_SKELETON_POSITION_COUNT][2] =
+{
+    { 0.00f,  0.00f},   // Hip center
+    { 0.00f,  0.10f},
+    { 0.00f,  0.45f},   // Shoulder center
+    { 0.00f,  0.65f},
+    {-0.20f,  0.40f},   // Left arm
+    {-0.30f,  0.15f},
+    {-0.35f, -0.10f},
+    {-0.37f, -0.18f},
+    { 0.20f,  0.40f},   // Right arm, raised
+    { 0.38f,  0.55f},
+    { 0.45f,  0.80f},
+    { 0.47f,  0.88f},
+    {-0.10f, -0.05f},   // Left leg
+    {-0.12f, -0.50f},
+    {-0.13f, -0.90f},
+    {-0.13f, -0.97f},
+    { 0.10f, -0.05f},   // Right leg
+    { 0.12f, -0.50f},
+    { 0.13f, -0.90f},
+    { 0.13f, -0.97f},
+};
+
+/// <summary>
+/// Place skeletons in front of the camera, the first two tracked and the next two
+/// known by their position only
+/// </summary>
+static void BuildSkeletons(SkeletonStore& skeletons)
+{
+    NUI_SKELETON_FRAME frame;
+    memset(&frame, 0, sizeof(frame));
+
+    for (UINT i = 0; i < 4; i++)
+    {
+        NUI_SKELETON_DATA& skeleton = frame.SkeletonData[i];
+        skeleton.eTrackingState = i < 2 ? NUI_SKELETON_TRACKED : NUI_SKELETON_POSITION_ONLY;
+        skeleton.dwTrackingID   = i + 1;
+        skeleton.Position.x     = -1.2f + 0.8f * i;
+        skeleton.Position.y     = 0.0f;
+        skeleton.Position.z     = 2.5f + 0.3f * i;
+        skeleton.Position.w     = 1.0f;
+
+        for (UINT joint = 0; joint < NUI_SKELETON_POSITION_COUNT; joint++)
+        {
+            skeleton.SkeletonPositions[joint].x = skeleton.Position.x + StandingJoints[joint][0];
+            skeleton.SkeletonPositions[joint].y = skeleton.Position.y + StandingJoints[joint][1];
+            skeleton.SkeletonPositions[joint].z = skeleton.Position.z;
+            skeleton.SkeletonPositions[joint].w = 1.0f;
+
+            // Hands are often only inferred
+            bool hand = NUI_SKELETON_POSITION_HAND_LEFT == joint || NUI_SKELETON_POSITION_HAND_RIGHT == joint;
+            skeleton.eSkeletonPositionTrackingState[joint] = hand ? NUI_SKELETON_POSITION_INFERRED : NUI_SKELETON_POSITION_TRACKED;
+        }
+    }
+
+    skeletons.Update(frame, nullptr);
+}
+
+/// <summary>
+/// Build the overlay the preview stream draws for a frame with skeletons and balls
+/// </summary>
+static void BuildOverlay(const SkeletonStore& skeletons, OverlayList& overlay)
+{
+    std::vector<BallDetection> detections(BALL_COUNT);
+    std::vector<BallTrack>     tracks(BALL_COUNT);
+
+    for (UINT i = 0; i < BALL_COUNT; i++)
+    {
+        memset(&detections[i], 0, sizeof(detections[i]));
+        detections[i].imageX      = 120.0f + 190.0f * i;
+        detections[i].imageY      = 140.0f + 60.0f * i;
+        detections[i].imageRadius = 25.0f + 15.0f * i;
+
+        memset(&tracks[i], 0, sizeof(tracks[i]));
+        tracks[i].id          = 100 + i;
+        tracks[i].confirmed   = true;
+        tracks[i].updated     = i != 1;
+        tracks[i].imageX      = detections[i].imageX + 3.0f;
+        tracks[i].imageY      = detections[i].imageY - 2.0f;
+        tracks[i].imageRadius = detections[i].imageRadius;
+    }
+
+    overlay.Clear();
+    overlay.SetSourceSize(SOURCE_WIDTH, SOURCE_HEIGHT);
+    overlay.AddSkeletons(skeletons);
+    overlay.AddDetections(detections);
+    overlay.AddTracks(tracks);
+}
+
+/// <summary>
+/// Time drawing the overlay into a frame of one size
+/// </summary>
+static void RunCase(const OverlayList& overlay, UINT width, UINT height)
+{
+    std::vector<UINT> pixels(width * height);
+    for (UINT i = 0; i < width * height; i++)
+    {
+        BYTE gray = (BYTE)(i % width * 255 / width);
+        pixels[i] = gray | gray << 8 | gray << 16;
+    }
+
+    OverlayCompositor compositor;
+    compositor.BeginFrame(&pixels[0], width, height);
+    compositor.Draw(overlay);
+
+    UINT checksum = 0;
+    for (UINT i = 0; i < width * height; i++)
+    {
+        checksum = checksum * 31 + pixels[i];
+    }
+
+    OverlayRect bounds = compositor.GetDirtyBounds();
+    UINT        rects  = (UINT)compositor.GetDirtyRects().size();
+
+    // Drawing again over the same pixels costs the same, blending does not skip any
+    double time = MedianMilliseconds(TIMED_RUNS, [&] { compositor.BeginFrame(&pixels[0], width, height); compositor.Draw(overlay); });
+
+    printf("%3ux%3u  %2u dirty rects, bounds %3d,%3d-%3d,%3d  %6.3f ms  checksum %08x\n",
+        width, height, rects, bounds.left, bounds.top, bounds.right, bounds.bottom, time, checksum);
+}
+
+int main()
+{
+    SkeletonStore skeletons;
+    BuildSkeletons(skeletons);
+
+    OverlayList overlay;
+    BuildOverlay(skeletons, overlay);
+
+#ifdef NUI_USE_SSE2
+    printf("%u overlay items, SSE2\n", (UINT)overlay.GetItems().size());
+#else
+    printf("%u overlay items, scalar\n", (UINT)overlay.GetItems().size());
+#endif
+
+    RunCase(overlay, 640, 480);
+    RunCase(overlay, 320, 240);
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+//------------------------------------------------------------------------------
+// <copyright file="SphereFitterBench.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+// Times the RANSAC sphere fitter on the visible caps of synthetic noisy balls, with
+// more points for nearer balls and a share of outliers, and reports the center
+// error, the hypotheses drawn, the slowest fit and the fits over the time budget.
+
+#include "BenchTimer.h"
+#include "SphereFitter.h"
+#include <cmath>
+#include <stdio.h>
+
+#define BALL_RADIUS         0.3175f     // Meters, the fitter default
+#define NOISE_SIGMA         0.005f      // Meters
+#define OUTLIER_SPREAD      0.5f        // Meters around the center
+#define TIME_BUDGET         500         // Microseconds, the fitter default
+#define TRIALS              200         // Balls per case
+#define PI                  3.14159265f
+
+/// <summary>
+/// Small deterministic generator, so every run sees the same balls
+/// </summary>
+static FLOAT NextUniform(UINT& state)
+{
+    state = state * 1664525u + 1013904223u;
+    return (state >> 8) / 16777216.0f;
+}
+
+/// <summary>
+/// Draw a normally distributed number by the Box-Muller transform
+/// </summary>
+static FLOAT NextNormal(UINT& state)
+{
+    FLOAT u = NextUniform(state) + 1.0e-7f;
+    FLOAT v = NextUniform(state);
+    return sqrtf(-2.0f * logf(u)) * cosf(2.0f * PI * v);
+}
+
+/// <summary>
+/// Sample the cap of a ball facing the camera at the origin, with noise and outliers
+/// </summary>
+static void DrawBall(const FLOAT center[3], UINT count, FLOAT outlierShare, UINT& state, std::vector<FLOAT>& x, std::vector<FLOAT>& y, std::vector<FLOAT>& z)
+{
+    x.resize(count);
+    y.resize(count);
+    z.resize(count);
+
+    for (UINT i = 0; i < count; i++)
+    {
+        if (NextUniform(state) < outlierShare)
+        {
+            x[i] = center[0] + OUTLIER_SPREAD * (2.0f * NextUniform(state) - 1.0f);
+            y[i] = center[1] + OUTLIER_SPREAD * (2.0f * NextUniform(state) - 1.0f);
+            z[i] = center[2] + OUTLIER_SPREAD * (2.0f * NextUniform(state) - 1.0f);
+            continue;
+        }
+
+        // Directions toward the camera side, as the sensor only sees that cap
+        FLOAT n[3];
+        do
+        {
+            n[0] = NextNormal(state);
+            n[1] = NextNormal(state);
+            n[2] = -fabsf(NextNormal(state));
+        } while (n[2] > -0.3f * sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]));
+
+        FLOAT length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        FLOAT r      = BALL_RADIUS + NOISE_SIGMA * NextNormal(state);
+        x[i] = center[0] + r * n[0] / length;
+        y[i] = center[1] + r * n[1] / length;
+        z[i] = center[2] + r * n[2] / length;
+    }
+}
+
+/// <summary>
+/// Fit many balls of one size and outlier share
+/// </summary>
+static void RunCase(UINT count, FLOAT outlierShare)
+{
+    SphereFitter fitter;
+    fitter.SetRadius(BALL_RADIUS);
+    fitter.SetTimeBudget(TIME_BUDGET);
+
+    std::vector<FLOAT> x, y, z;
+    std::vector<double> times;
+    UINT   state      = 2024;
+    UINT   found      = 0;
+    UINT   iterations = 0;
+    double errorSum   = 0.0;
+
+    for (UINT trial = 0; trial < TRIALS; trial++)
+    {
+        FLOAT center[3] = {2.0f * NextUniform(state) - 1.0f, 2.0f * NextUniform(state) - 1.0f, 1.5f + 2.5f * NextUniform(state)};
+        DrawBall(center, count, outlierShare, state, x, y, z);
+
+        SphereFit fit;
+        bool      valid = false;
+        times.push_back(MedianMilliseconds(1, [&] { valid = fitter.Fit(&x[0], &y[0], &z[0], count, fit); }));
+
+        if (valid)
+        {
+            FLOAT dx = fit.center.x - center[0];
+            FLOAT dy = fit.center.y - center[1];
+            FLOAT dz = fit.center.z - center[2];
+            errorSum   += sqrtf(dx * dx + dy * dy + dz * dz);
+            iterations += fit.iterations;
+            ++found;
+        }
+    }
+
+    std::sort(times.begin(), times.end());
+    UINT overruns = 0;
+    for (size_t i = 0; i < times.size(); i++)
+    {
+        overruns += times[i] * 1000.0 > TIME_BUDGET ? 1 : 0;
+    }
+
+    printf("points %4u  outliers %2.0f%%  found %3u/%u  center error %5.1f mm  hypotheses %5.1f  median %6.1f us  slowest %6.1f us  over budget %3u/%u\n",
+        count, outlierShare * 100.0f, found, TRIALS, found ? errorSum / found * 1000.0 : 0.0,
+        found ? (double)iterations / found : 0.0, times[times.size() / 2] * 1000.0, times.back() * 1000.0, overruns, TRIALS);
+}
+
+int main()
+{
+    printf("Time budget %u us per fit\n", TIME_BUDGET);
+
+    const UINT  counts[]   = {100, 1000, 4000, 20000};
+    const FLOAT outliers[] = {0.0f, 0.2f, 0.4f};
+    for (UINT i = 0; i < sizeof(counts) / sizeof(counts[0]); i++)
+    {
+        for (UINT j = 0; j < sizeof(outliers) / sizeof(outliers[0]); j++)
+        {
+            RunCase(counts[i], outliers[j]);
+        }
+    }
+
+    return 0;
+}
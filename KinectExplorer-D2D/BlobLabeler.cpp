@@ -0,0 +1,408 @@
+//------------------------------------------------------------------------------
+// <copyright file="BlobLabeler.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include <climits>
+#include "BlobLabeler.h"
+
+#define DEFAULT_DEPTH_CONTINUITY    60      // Millimeters
+#define DEFAULT_MINIMUM_AREA        20      // Pixels
+#define MINIMUM_ROWS_PER_BAND       16
+#define NO_BLOB                     UINT_MAX
+
+struct BlobAccumulator
+{
+    UINT        area;
+    double      sumX;
+    double      sumY;
+    ULONGLONG   sumDepth;
+    ULONGLONG   sumDepthSq;
+    UINT        left;
+    UINT        top;
+    UINT        right;
+    UINT        bottom;
+};
+
+/// <summary>
+/// Constructor
+/// </summary>
+BlobLabeler::BlobLabeler()
+    : m_depthContinuity(DEFAULT_DEPTH_CONTINUITY)
+    , m_minimumArea(DEFAULT_MINIMUM_AREA)
+    , m_pMask(nullptr)
+    , m_pDepth(nullptr)
+    , m_width(0)
+    , m_height(0)
+    , m_bandCount(0)
+    , m_rowsPerBand(0)
+    , m_pParallel(nullptr)
+{
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+BlobLabeler::~BlobLabeler()
+{
+}
+
+/// <summary>
+/// Set the largest depth step between neighbouring pixels of the same blob
+/// </summary>
+/// <param name="step">Depth step in millimeters</param>
+void BlobLabeler::SetDepthContinuity(USHORT step)
+{
+    m_depthContinuity = step;
+}
+
+/// <summary>
+/// Set the smallest area of reported blobs
+/// </summary>
+/// <param name="area">Area in pixels</param>
+void BlobLabeler::SetMinimumArea(UINT area)
+{
+    m_minimumArea = area;
+}
+
+/// <summary>
+/// Set the pool the bands are labeled on
+/// </summary>
+/// <param name="pParallel">The pointer to the pool shared with other stages, nullptr to label on the calling thread</param>
+void BlobLabeler::SetParallelBands(ParallelBands* pParallel)
+{
+    m_pParallel = pParallel;
+}
+
+/// <summary>
+/// Label the foreground mask and compute blob moments
+/// </summary>
+/// <param name="mask">Foreground mask</param>
+/// <param name="pDepth">The pointer to depth pixels of the same size as the mask</param>
+/// <returns>Number of blobs found</returns>
+UINT BlobLabeler::Label(const PackedBitmask& mask, const NUI_DEPTH_IMAGE_PIXEL* pDepth)
+{
+    m_blobs.clear();
+
+    m_pMask  = &mask;
+    m_pDepth = pDepth;
+    m_width  = mask.GetWidth();
+    m_height = mask.GetHeight();
+
+    if (!pDepth || 0 == m_width || 0 == m_height)
+    {
+        return 0;
+    }
+
+    // Split rows into bands, at least a few rows each so the seam work stays small
+    m_bandCount = ParallelBands::GetThreadCount(m_pParallel);
+    if (m_bandCount * MINIMUM_ROWS_PER_BAND > m_height)
+    {
+        m_bandCount = (m_height + MINIMUM_ROWS_PER_BAND - 1) / MINIMUM_ROWS_PER_BAND;
+    }
+    m_rowsPerBand = (m_height + m_bandCount - 1) / m_bandCount;
+
+    m_bandRuns.resize(m_bandCount);
+    m_bandRowStart.resize(m_bandCount);
+
+    // Run-length encode bands in parallel
+    ParallelBands::Run(m_pParallel, m_bandCount, [this](UINT band) { EncodeBand(band); });
+
+    // Concatenate band runs into a single array indexed by global run number
+    m_bandOffset.resize(m_bandCount);
+    m_rowStart.resize(m_height + 1);
+
+    UINT total = 0;
+    for (UINT band = 0; band < m_bandCount; band++)
+    {
+        m_bandOffset[band] = total;
+
+        UINT firstRow = band * m_rowsPerBand;
+        for (size_t row = 0; row < m_bandRowStart[band].size(); row++)
+        {
+            m_rowStart[firstRow + row] = total + m_bandRowStart[band][row];
+        }
+
+        total += (UINT)m_bandRuns[band].size();
+    }
+    m_rowStart[m_height] = total;
+
+    m_runs.resize(total);
+    for (UINT band = 0; band < m_bandCount; band++)
+    {
+        const std::vector<DepthRun>& runs = m_bandRuns[band];
+        for (size_t i = 0; i < runs.size(); i++)
+        {
+            UINT index = m_bandOffset[band] + (UINT)i;
+            m_runs[index]        = runs[i];
+            m_runs[index].parent = index;
+        }
+    }
+
+    // Union runs inside each band in parallel. Bands own disjoint run ranges
+    ParallelBands::Run(m_pParallel, m_bandCount, [this](UINT band) { MergeBand(band); });
+
+    // Join bands at their seams
+    for (UINT band = 1; band < m_bandCount; band++)
+    {
+        UINT y = band * m_rowsPerBand;
+        if (y < m_height)
+        {
+            MergeRows(m_rowStart[y - 1], m_rowStart[y], m_rowStart[y], m_rowStart[y + 1]);
+        }
+    }
+
+    CollectBlobs();
+
+    return (UINT)m_blobs.size();
+}
+
+/// <summary>
+/// Run-length encode the rows of one band
+/// </summary>
+/// <param name="band">Band index</param>
+void BlobLabeler::EncodeBand(UINT band)
+{
+    std::vector<DepthRun>& runs     = m_bandRuns[band];
+    std::vector<UINT>&     rowStart = m_bandRowStart[band];
+
+    runs.clear();
+    rowStart.clear();
+
+    UINT firstRow = band * m_rowsPerBand;
+    UINT endRow   = firstRow + m_rowsPerBand < m_height ? firstRow + m_rowsPerBand : m_height;
+    UINT words    = m_pMask->GetWordsPerRow();
+    int  step     = m_depthContinuity;
+
+    for (UINT y = firstRow; y < endRow; y++)
+    {
+        rowStart.push_back((UINT)runs.size());
+
+        const ULONGLONG*             pMaskRow  = m_pMask->GetRow(y);
+        const NUI_DEPTH_IMAGE_PIXEL* pDepthRow = m_pDepth + y * m_width;
+
+        DepthRun run;
+        bool     open      = false;
+        int      prevDepth = 0;
+
+        for (UINT w = 0; w < words; w++)
+        {
+            ULONGLONG bits = pMaskRow[w];
+
+            // Skip empty words
+            if (0 == bits)
+            {
+                if (open)
+                {
+                    runs.push_back(run);
+                    open = false;
+                }
+                continue;
+            }
+
+            UINT base  = w * BITS_PER_MASK_WORD;
+            UINT count = m_width - base < BITS_PER_MASK_WORD ? m_width - base : BITS_PER_MASK_WORD;
+
+            for (UINT b = 0; b < count; b++)
+            {
+                int depth = ((bits >> b) & 1) ? pDepthRow[base + b].depth : 0;
+
+                // Unknown depth, background, or a depth jump close the current run
+                if (open && (0 == depth || depth - prevDepth > step || prevDepth - depth > step))
+                {
+                    runs.push_back(run);
+                    open = false;
+                }
+
+                if (0 == depth)
+                {
+                    continue;
+                }
+
+                if (!open)
+                {
+                    run.y          = (USHORT)y;
+                    run.start      = (USHORT)(base + b);
+                    run.parent     = 0;
+                    run.sumDepth   = 0;
+                    run.sumDepthSq = 0;
+                    open           = true;
+                }
+
+                run.end         = (USHORT)(base + b + 1);
+                run.sumDepth   += depth;
+                run.sumDepthSq += (ULONGLONG)(depth * depth);
+                prevDepth       = depth;
+            }
+        }
+
+        if (open)
+        {
+            runs.push_back(run);
+        }
+    }
+}
+
+/// <summary>
+/// Union runs of adjacent rows inside one band
+/// </summary>
+/// <param name="band">Band index</param>
+void BlobLabeler::MergeBand(UINT band)
+{
+    UINT firstRow = band * m_rowsPerBand;
+    UINT endRow   = firstRow + m_rowsPerBand < m_height ? firstRow + m_rowsPerBand : m_height;
+
+    for (UINT y = firstRow + 1; y < endRow; y++)
+    {
+        MergeRows(m_rowStart[y - 1], m_rowStart[y], m_rowStart[y], m_rowStart[y + 1]);
+    }
+}
+
+/// <summary>
+/// Union the runs of two adjacent rows which overlap with continuous depth
+/// </summary>
+/// <param name="upperFirst">Index of first run of the upper row</param>
+/// <param name="upperEnd">One past the last run of the upper row</param>
+/// <param name="lowerFirst">Index of first run of the lower row</param>
+/// <param name="lowerEnd">One past the last run of the lower row</param>
+void BlobLabeler::MergeRows(UINT upperFirst, UINT upperEnd, UINT lowerFirst, UINT lowerEnd)
+{
+    UINT i = upperFirst;
+    UINT j = lowerFirst;
+
+    // Both rows are sorted by column. Walk them together like a merge
+    while (i < upperEnd && j < lowerEnd)
+    {
+        if (RunsConnect(m_runs[i], m_runs[j]))
+        {
+            Union(i, j);
+        }
+
+        if (m_runs[i].end < m_runs[j].end)
+        {
+            ++i;
+        }
+        else
+        {
+            ++j;
+        }
+    }
+}
+
+/// <summary>
+/// Check if two vertically adjacent runs touch with continuous depth
+/// </summary>
+bool BlobLabeler::RunsConnect(const DepthRun& upper, const DepthRun& lower) const
+{
+    UINT start = upper.start > lower.start ? upper.start : lower.start;
+    UINT end   = upper.end   < lower.end   ? upper.end   : lower.end;
+
+    const NUI_DEPTH_IMAGE_PIXEL* pUpper = m_pDepth + upper.y * m_width;
+    const NUI_DEPTH_IMAGE_PIXEL* pLower = m_pDepth + lower.y * m_width;
+    int step = m_depthContinuity;
+
+    // Any column of the overlap with a small depth step joins the runs
+    for (UINT x = start; x < end; x++)
+    {
+        int delta = (int)pUpper[x].depth - (int)pLower[x].depth;
+        if (delta <= step && delta >= -step)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/// <summary>
+/// Find root of a run with path halving
+/// </summary>
+UINT BlobLabeler::FindRoot(UINT run)
+{
+    while (m_runs[run].parent != run)
+    {
+        m_runs[run].parent = m_runs[m_runs[run].parent].parent;
+        run = m_runs[run].parent;
+    }
+    return run;
+}
+
+/// <summary>
+/// Union two runs, the lower index becomes root
+/// </summary>
+void BlobLabeler::Union(UINT a, UINT b)
+{
+    UINT rootA = FindRoot(a);
+    UINT rootB = FindRoot(b);
+
+    if (rootA < rootB)
+    {
+        m_runs[rootB].parent = rootA;
+    }
+    else if (rootB < rootA)
+    {
+        m_runs[rootA].parent = rootB;
+    }
+}
+
+/// <summary>
+/// Compute blob moments from the labeled runs
+/// </summary>
+void BlobLabeler::CollectBlobs()
+{
+    std::vector<UINT>            rootToBlob(m_runs.size(), NO_BLOB);
+    std::vector<BlobAccumulator> accumulators;
+
+    for (UINT i = 0; i < (UINT)m_runs.size(); i++)
+    {
+        const DepthRun& run  = m_runs[i];
+        UINT            root = FindRoot(i);
+
+        if (NO_BLOB == rootToBlob[root])
+        {
+            BlobAccumulator fresh = {0, 0.0, 0.0, 0, 0, run.start, run.y, run.end - 1u, run.y};
+            rootToBlob[root] = (UINT)accumulators.size();
+            accumulators.push_back(fresh);
+        }
+
+        BlobAccumulator& acc = accumulators[rootToBlob[root]];
+        UINT length = run.end - run.start;
+
+        acc.area       += length;
+        acc.sumX       += 0.5 * (double)(run.start + run.end - 1) * length;
+        acc.sumY       += (double)run.y * length;
+        acc.sumDepth   += run.sumDepth;
+        acc.sumDepthSq += run.sumDepthSq;
+
+        if (run.start < acc.left)        acc.left   = run.start;
+        if (run.end - 1u > acc.right)    acc.right  = run.end - 1u;
+        if (run.y < acc.top)             acc.top    = run.y;
+        if (run.y > acc.bottom)          acc.bottom = run.y;
+    }
+
+    for (size_t i = 0; i < accumulators.size(); i++)
+    {
+        const BlobAccumulator& acc = accumulators[i];
+        if (acc.area < m_minimumArea)
+        {
+            continue;
+        }
+
+        double mean     = (double)acc.sumDepth / acc.area;
+        double variance = (double)acc.sumDepthSq / acc.area - mean * mean;
+
+        DepthBlob blob;
+        blob.area          = acc.area;
+        blob.centroidX     = (FLOAT)(acc.sumX / acc.area);
+        blob.centroidY     = (FLOAT)(acc.sumY / acc.area);
+        blob.left          = acc.left;
+        blob.top           = acc.top;
+        blob.right         = acc.right;
+        blob.bottom        = acc.bottom;
+        blob.depthMean     = (FLOAT)mean;
+        blob.depthVariance = (FLOAT)(variance > 0.0 ? variance : 0.0);
+
+        m_blobs.push_back(blob);
+    }
+}
@@ -0,0 +1,159 @@
+//------------------------------------------------------------------------------
+// <copyright file="BlobLabeler.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include "NuiTypes.h"
+#include "PackedBitmask.h"
+#include "ParallelBands.h"
+
+/// <summary>
+/// Connected region of foreground depth pixels with its moments
+/// </summary>
+struct DepthBlob
+{
+    UINT    area;               // Number of pixels
+    FLOAT   centroidX;          // Mean column
+    FLOAT   centroidY;          // Mean row
+    UINT    left;               // Bounding box, inclusive
+    UINT    top;
+    UINT    right;
+    UINT    bottom;
+    FLOAT   depthMean;          // Millimeters
+    FLOAT   depthVariance;      // Square millimeters
+};
+
+/// <summary>
+/// Horizontal run of foreground pixels with continuous depth
+/// </summary>
+struct DepthRun
+{
+    USHORT      y;
+    USHORT      start;          // First column
+    USHORT      end;            // One past the last column
+    UINT        parent;         // Union-find parent, global run index
+    ULONGLONG   sumDepth;
+    ULONGLONG   sumDepthSq;
+};
+
+/// <summary>
+/// Connected component labeling of a foreground mask. Rows are run-length encoded
+/// and runs are split where the depth jumps, so touching objects at different
+/// distances end up in different blobs. Horizontal bands of the image are encoded
+/// and merged in parallel on a shared pool, then joined at the band seams. Blob moments are
+/// accumulated from per-run sums, so every pixel is read only once.
+/// </summary>
+class BlobLabeler
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    BlobLabeler();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~BlobLabeler();
+
+public:
+    /// <summary>
+    /// Label the foreground mask and compute blob moments
+    /// </summary>
+    /// <param name="mask">Foreground mask</param>
+    /// <param name="pDepth">The pointer to depth pixels of the same size as the mask</param>
+    /// <returns>Number of blobs found</returns>
+    UINT Label(const PackedBitmask& mask, const NUI_DEPTH_IMAGE_PIXEL* pDepth);
+
+    /// <summary>
+    /// Get the blobs found by the last call to Label
+    /// </summary>
+    const std::vector<DepthBlob>& GetBlobs() const
+    {
+        return m_blobs;
+    }
+
+    /// <summary>
+    /// Set the largest depth step between neighbouring pixels of the same blob
+    /// </summary>
+    /// <param name="step">Depth step in millimeters</param>
+    void SetDepthContinuity(USHORT step);
+
+    /// <summary>
+    /// Set the smallest area of reported blobs
+    /// </summary>
+    /// <param name="area">Area in pixels</param>
+    void SetMinimumArea(UINT area);
+
+    /// <summary>
+    /// Set the pool the bands are labeled on
+    /// </summary>
+    /// <param name="pParallel">The pointer to the pool shared with other stages, nullptr to label on the calling thread</param>
+    void SetParallelBands(ParallelBands* pParallel);
+
+private:
+    /// <summary>
+    /// Run-length encode the rows of one band
+    /// </summary>
+    /// <param name="band">Band index</param>
+    void EncodeBand(UINT band);
+
+    /// <summary>
+    /// Union runs of adjacent rows inside one band
+    /// </summary>
+    /// <param name="band">Band index</param>
+    void MergeBand(UINT band);
+
+    /// <summary>
+    /// Union the runs of two adjacent rows which overlap with continuous depth
+    /// </summary>
+    /// <param name="upperFirst">Index of first run of the upper row</param>
+    /// <param name="upperEnd">One past the last run of the upper row</param>
+    /// <param name="lowerFirst">Index of first run of the lower row</param>
+    /// <param name="lowerEnd">One past the last run of the lower row</param>
+    void MergeRows(UINT upperFirst, UINT upperEnd, UINT lowerFirst, UINT lowerEnd);
+
+    /// <summary>
+    /// Check if two vertically adjacent runs touch with continuous depth
+    /// </summary>
+    bool RunsConnect(const DepthRun& upper, const DepthRun& lower) const;
+
+    /// <summary>
+    /// Find root of a run with path halving
+    /// </summary>
+    UINT FindRoot(UINT run);
+
+    /// <summary>
+    /// Union two runs, the lower index becomes root
+    /// </summary>
+    void Union(UINT a, UINT b);
+
+    /// <summary>
+    /// Compute blob moments from the labeled runs
+    /// </summary>
+    void CollectBlobs();
+
+private:
+    USHORT                          m_depthContinuity;
+    UINT                            m_minimumArea;
+
+    const PackedBitmask*            m_pMask;
+    const NUI_DEPTH_IMAGE_PIXEL*    m_pDepth;
+    UINT                            m_width;
+    UINT                            m_height;
+    UINT                            m_bandCount;
+    UINT                            m_rowsPerBand;
+
+    std::vector<std::vector<DepthRun> > m_bandRuns;     // Runs of each band while encoding
+    std::vector<std::vector<UINT> >     m_bandRowStart; // Local index of first run of each row of a band
+    std::vector<UINT>                   m_bandOffset;   // Global index of first run of each band
+    std::vector<DepthRun>               m_runs;         // All runs in row order
+    std::vector<UINT>                   m_rowStart;     // Global index of first run of each row, plus end marker
+    std::vector<DepthBlob>              m_blobs;
+
+    ParallelBands*                  m_pParallel;    // Shared pool, nullptr to label on the calling thread
+};
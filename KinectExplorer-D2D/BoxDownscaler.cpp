@@ -0,0 +1,104 @@
+//------------------------------------------------------------------------------
+// <copyright file="BoxDownscaler.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "BoxDownscaler.h"
+
+#define BYTES_PER_PIXEL     4
+
+/// <summary>
+/// Constructor
+/// </summary>
+BoxDownscaler::BoxDownscaler()
+    : m_outputWidth(0)
+    , m_scale(1)
+    , m_weight(65536)
+{
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+BoxDownscaler::~BoxDownscaler()
+{
+}
+
+/// <summary>
+/// Start shrinking an image
+/// </summary>
+/// <param name="outputWidth">Width of the shrunk image</param>
+/// <param name="scale">Shrink factor, source pixels per shrunk pixel in each direction</param>
+void BoxDownscaler::Reset(UINT outputWidth, UINT scale)
+{
+    m_outputWidth = outputWidth;
+    m_scale       = scale < 1 ? 1 : scale;
+
+    // Sums of a box reach 255 * m_scale * m_scale, so the weighted sum stays within 32 bits
+    m_weight = 65536 / (m_scale * m_scale);
+    m_sums.assign(m_outputWidth * BYTES_PER_PIXEL, 0);
+}
+
+/// <summary>
+/// Add a source row, and write the shrunk row once all of its source rows are added
+/// </summary>
+/// <param name="pRow">The pointer to the source row, at least outputWidth times scale pixels</param>
+/// <param name="y">Source row, rows are added in order</param>
+/// <param name="pOutputRow">The pointer to the shrunk row the boxes of the source row belong to</param>
+/// <returns>True if the shrunk row was written</returns>
+bool BoxDownscaler::AddRow(const UINT* pRow, UINT y, UINT* pOutputRow)
+{
+    if (m_sums.empty())
+    {
+        return false;
+    }
+
+    // Columns past the last whole box are dropped, the caller drops rows past the last whole box
+    const BYTE* pPixel = (const BYTE*)pRow;
+    UINT*       pSums  = &m_sums[0];
+    for (UINT x = 0; x < m_outputWidth; x++, pSums += BYTES_PER_PIXEL)
+    {
+        for (UINT i = 0; i < m_scale; i++, pPixel += BYTES_PER_PIXEL)
+        {
+            pSums[0] += pPixel[0];
+            pSums[1] += pPixel[1];
+            pSums[2] += pPixel[2];
+            pSums[3] += pPixel[3];
+        }
+    }
+
+    if (m_scale - 1 != y % m_scale)
+    {
+        return false;
+    }
+
+    // All rows of the boxes are in, write their averages and start the next boxes
+    BYTE* pOutput = (BYTE*)pOutputRow;
+    for (UINT i = 0; i < m_outputWidth * BYTES_PER_PIXEL; i++)
+    {
+        pOutput[i] = (BYTE)((m_sums[i] * m_weight + 32768) >> 16);
+        m_sums[i]  = 0;
+    }
+
+    return true;
+}
+
+/// <summary>
+/// Shrink a whole image
+/// </summary>
+/// <param name="pSource">The pointer to the source image</param>
+/// <param name="width">Source width</param>
+/// <param name="height">Source height</param>
+/// <param name="scale">Shrink factor</param>
+/// <param name="pOutput">The pointer to the shrunk image, which may be the source image</param>
+void BoxDownscaler::Shrink(const UINT* pSource, UINT width, UINT height, UINT scale, UINT* pOutput)
+{
+    Reset(width / (scale < 1 ? 1 : scale), scale);
+
+    UINT outputHeight = height / m_scale;
+    for (UINT y = 0; y < outputHeight * m_scale; y++)
+    {
+        AddRow(pSource + y * width, y, pOutput + (y / m_scale) * m_outputWidth);
+    }
+}
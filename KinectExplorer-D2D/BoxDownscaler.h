@@ -0,0 +1,72 @@
+//------------------------------------------------------------------------------
+// <copyright file="BoxDownscaler.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include "NuiTypes.h"
+#include <vector>
+
+/// <summary>
+/// Shrinks a BGRX image by a whole factor, one source row at a time, writing the
+/// average of each box of factor by factor pixels. Unlike taking every n-th pixel,
+/// thin edges and fine patterns do not alias into moire or flicker. A shrunk row
+/// never lies past the source rows still to be added, so the image may be shrunk
+/// in place.
+/// </summary>
+class BoxDownscaler
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    BoxDownscaler();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~BoxDownscaler();
+
+public:
+    /// <summary>
+    /// Start shrinking an image
+    /// </summary>
+    /// <param name="outputWidth">Width of the shrunk image</param>
+    /// <param name="scale">Shrink factor, source pixels per shrunk pixel in each direction</param>
+    void Reset(UINT outputWidth, UINT scale);
+
+    /// <summary>
+    /// Add a source row, and write the shrunk row once all of its source rows are added
+    /// </summary>
+    /// <param name="pRow">The pointer to the source row, at least outputWidth times scale pixels</param>
+    /// <param name="y">Source row, rows are added in order</param>
+    /// <param name="pOutputRow">The pointer to the shrunk row the boxes of the source row belong to</param>
+    /// <returns>True if the shrunk row was written</returns>
+    bool AddRow(const UINT* pRow, UINT y, UINT* pOutputRow);
+
+    /// <summary>
+    /// Shrink a whole image
+    /// </summary>
+    /// <param name="pSource">The pointer to the source image</param>
+    /// <param name="width">Source width</param>
+    /// <param name="height">Source height</param>
+    /// <param name="scale">Shrink factor</param>
+    /// <param name="pOutput">The pointer to the shrunk image, which may be the source image</param>
+    void Shrink(const UINT* pSource, UINT width, UINT height, UINT scale, UINT* pOutput);
+
+    /// <summary>
+    /// Get the shrink factor
+    /// </summary>
+    UINT GetScale() const
+    {
+        return m_scale;
+    }
+
+private:
+    UINT                m_outputWidth;
+    UINT                m_scale;
+    UINT                m_weight;       // 65536 divided by the pixels in a box
+    std::vector<UINT>   m_sums;         // Channel sums of the boxes of the current shrunk row
+};
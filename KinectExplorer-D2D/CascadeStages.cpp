@@ -0,0 +1,228 @@
+//------------------------------------------------------------------------------
+// <copyright file="CascadeStages.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "CascadeStages.h"
+
+#define DEFAULT_MINIMUM_DEPTH       400.0f  // Millimeters
+#define DEFAULT_MAXIMUM_DEPTH       4000.0f
+#define DEFAULT_MINIMUM_AREA        8       // Pixels
+#define DEPTH_SPREAD_FACTOR         0.5f    // Largest depth standard deviation in ball radii
+#define DEPTH_NOISE                 10.0f   // Millimeters added to the allowed spread
+#define MINIMUM_AREA_FACTOR         0.25f   // Partly occluded or clipped balls
+#define MAXIMUM_AREA_FACTOR         2.0f    // Ball touching a small object at the same depth
+#define MAXIMUM_ASPECT              2.5f    // Bounding box, long side over short side
+#define MINIMUM_FILL                0.4f    // Blob area over bounding box area, a disc fills 0.79
+#define MINIMUM_COLOR_SAMPLES       4       // Fewer mapped pixels tell nothing about color
+#define COLOR_DEPTH_WINDOW          2.0f    // Count pixels within this many ball radii of the blob depth
+#define DEFAULT_COLOR_RATIO         0.3f
+#define MILLIMETERS_TO_METERS       0.001f
+#define PI                          3.14159265f
+
+/// <summary>
+/// Constructor
+/// </summary>
+DepthGateStage::DepthGateStage()
+    : m_minimumDepth(DEFAULT_MINIMUM_DEPTH)
+    , m_maximumDepth(DEFAULT_MAXIMUM_DEPTH)
+    , m_minimumArea(DEFAULT_MINIMUM_AREA)
+{
+}
+
+/// <summary>
+/// Set the accepted depth range
+/// </summary>
+/// <param name="minimumDepth">Nearest blob mean depth in millimeters</param>
+/// <param name="maximumDepth">Farthest blob mean depth in millimeters</param>
+void DepthGateStage::SetDepthRange(FLOAT minimumDepth, FLOAT maximumDepth)
+{
+    m_minimumDepth = minimumDepth;
+    m_maximumDepth = maximumDepth;
+}
+
+/// <summary>
+/// Set the smallest blob area
+/// </summary>
+/// <param name="area">Area in pixels</param>
+void DepthGateStage::SetMinimumArea(UINT area)
+{
+    m_minimumArea = area;
+}
+
+/// <summary>
+/// Test a candidate
+/// </summary>
+/// <param name="frame">Frame data</param>
+/// <param name="candidate">Candidate to test</param>
+/// <returns>True to keep the candidate</returns>
+bool DepthGateStage::Test(const CascadeFrame& frame, BallCandidate& candidate)
+{
+    const DepthBlob& blob = candidate.blob;
+
+    if (blob.area < m_minimumArea || blob.depthMean < m_minimumDepth || blob.depthMean > m_maximumDepth)
+    {
+        return false;
+    }
+
+    // The visible half of a sphere spans one radius of depth, most of it near the front
+    FLOAT spread = frame.ballRadius * DEPTH_SPREAD_FACTOR / MILLIMETERS_TO_METERS + DEPTH_NOISE;
+    return blob.depthVariance <= spread * spread;
+}
+
+/// <summary>
+/// Constructor
+/// </summary>
+SizeGateStage::SizeGateStage()
+    : m_minimumAreaFactor(MINIMUM_AREA_FACTOR)
+    , m_maximumAreaFactor(MAXIMUM_AREA_FACTOR)
+{
+}
+
+/// <summary>
+/// Set the accepted range of blob area over expected ball area
+/// </summary>
+/// <param name="minimumFactor">Smallest ratio, below one for occluded or clipped balls</param>
+/// <param name="maximumFactor">Largest ratio</param>
+void SizeGateStage::SetAreaFactors(FLOAT minimumFactor, FLOAT maximumFactor)
+{
+    m_minimumAreaFactor = minimumFactor;
+    m_maximumAreaFactor = maximumFactor;
+}
+
+/// <summary>
+/// Test a candidate
+/// </summary>
+/// <param name="frame">Frame data</param>
+/// <param name="candidate">Candidate to test</param>
+/// <returns>True to keep the candidate</returns>
+bool SizeGateStage::Test(const CascadeFrame& /*frame*/, BallCandidate& candidate)
+{
+    const DepthBlob& blob = candidate.blob;
+
+    FLOAT expectedArea = PI * candidate.imageRadius * candidate.imageRadius;
+    if (blob.area < expectedArea * m_minimumAreaFactor || blob.area > expectedArea * m_maximumAreaFactor)
+    {
+        return false;
+    }
+
+    FLOAT boxWidth  = (FLOAT)(blob.right - blob.left + 1);
+    FLOAT boxHeight = (FLOAT)(blob.bottom - blob.top + 1);
+
+    if (boxWidth > boxHeight * MAXIMUM_ASPECT || boxHeight > boxWidth * MAXIMUM_ASPECT)
+    {
+        return false;
+    }
+
+    return blob.area >= boxWidth * boxHeight * MINIMUM_FILL;
+}
+
+/// <summary>
+/// Constructor
+/// </summary>
+ColorGateStage::ColorGateStage()
+    : m_pPixels(nullptr)
+    , m_pRegistration(nullptr)
+    , m_classBit(1)
+    , m_minimumRatio(DEFAULT_COLOR_RATIO)
+{
+}
+
+/// <summary>
+/// Set the color frame matching the next depth frame
+/// </summary>
+/// <param name="pPixels">BGRX pixels of the registration color resolution, or nullptr for none</param>
+/// <param name="pRegistration">Depth to color registration</param>
+void ColorGateStage::SetColorFrame(const UINT* pPixels, const RegistrationTable* pRegistration)
+{
+    m_pPixels       = pPixels;
+    m_pRegistration = pRegistration;
+}
+
+/// <summary>
+/// Set the class table and the class of the ball
+/// </summary>
+/// <param name="pTable">Class table, or nullptr for none</param>
+/// <param name="colorClass">Class index of the ball color</param>
+void ColorGateStage::SetColorClass(const std::shared_ptr<const ColorClassTable>& pTable, UINT colorClass)
+{
+    m_pTable   = pTable;
+    m_classBit = colorClass < COLOR_CLASS_COUNT ? 1u << colorClass : 0;
+}
+
+/// <summary>
+/// Set the smallest share of ball colored pixels
+/// </summary>
+/// <param name="ratio">Ratio between 0 and 1</param>
+void ColorGateStage::SetMinimumRatio(FLOAT ratio)
+{
+    m_minimumRatio = ratio;
+}
+
+/// <summary>
+/// Check if a color frame, registration and class table are set
+/// </summary>
+bool ColorGateStage::IsReady() const
+{
+    return m_pPixels && m_pRegistration && m_pRegistration->IsValid() && m_pTable && 0 != m_classBit;
+}
+
+/// <summary>
+/// Test a candidate
+/// </summary>
+/// <param name="frame">Frame data</param>
+/// <param name="candidate">Candidate to test, receives its color ratio</param>
+/// <returns>True to keep the candidate</returns>
+bool ColorGateStage::Test(const CascadeFrame& frame, BallCandidate& candidate)
+{
+    const DepthBlob& blob = candidate.blob;
+
+    UINT patchWidth = blob.right - blob.left + 1;
+    UINT patchSize  = patchWidth * (blob.bottom - blob.top + 1);
+    if (m_patch.size() < patchSize)
+    {
+        m_patch.resize(patchSize);
+    }
+
+    UINT* pPatch = &m_patch[0];
+    if (0 == m_pRegistration->GatherColor(frame.pDepth, m_pPixels, blob.left, blob.top, blob.right, blob.bottom, (USHORT)blob.depthMean, pPatch))
+    {
+        // Not mapped, color cannot decide
+        return true;
+    }
+
+    // Only foreground near the blob depth counts, the box may hold other objects and background
+    int  window  = (int)(frame.ballRadius * COLOR_DEPTH_WINDOW / MILLIMETERS_TO_METERS);
+    int  center  = (int)blob.depthMean;
+    UINT mapped  = 0;
+    UINT matched = 0;
+
+    for (UINT y = blob.top; y <= blob.bottom; y++)
+    {
+        const UINT* pRow = pPatch + (y - blob.top) * patchWidth;
+        const NUI_DEPTH_IMAGE_PIXEL* pDepthRow = frame.pDepth + y * frame.width;
+
+        for (UINT x = blob.left; x <= blob.right; x++)
+        {
+            UINT pixel  = pRow[x - blob.left];
+            int  offset = (int)pDepthRow[x].depth - center;
+            if (REGISTRATION_UNMAPPED != pixel && offset > -window && offset < window && frame.pMask->Test(x, y))
+            {
+                ++mapped;
+                if (m_pTable->Lookup(pixel) & m_classBit)
+                {
+                    ++matched;
+                }
+            }
+        }
+    }
+
+    if (mapped < MINIMUM_COLOR_SAMPLES)
+    {
+        return true;
+    }
+
+    candidate.colorRatio = (FLOAT)matched / mapped;
+    return candidate.colorRatio >= m_minimumRatio;
+}
@@ -0,0 +1,163 @@
+//------------------------------------------------------------------------------
+// <copyright file="CascadeStages.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "DetectionCascade.h"
+#include "RegistrationTable.h"
+#include "ColorClassTable.h"
+
+/// <summary>
+/// Cheap first stage. Rejects blobs that are too small, outside the working depth
+/// range, or spread over more depth than the visible half of a ball can cover.
+/// </summary>
+class DepthGateStage : public CascadeStage
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    DepthGateStage();
+
+    /// <summary>
+    /// Get a short name for statistics
+    /// </summary>
+    virtual const char* GetName() const
+    {
+        return "Depth";
+    }
+
+    /// <summary>
+    /// Test a candidate
+    /// </summary>
+    /// <param name="frame">Frame data</param>
+    /// <param name="candidate">Candidate to test</param>
+    /// <returns>True to keep the candidate</returns>
+    virtual bool Test(const CascadeFrame& frame, BallCandidate& candidate);
+
+    /// <summary>
+    /// Set the accepted depth range
+    /// </summary>
+    /// <param name="minimumDepth">Nearest blob mean depth in millimeters</param>
+    /// <param name="maximumDepth">Farthest blob mean depth in millimeters</param>
+    void SetDepthRange(FLOAT minimumDepth, FLOAT maximumDepth);
+
+    /// <summary>
+    /// Set the smallest blob area
+    /// </summary>
+    /// <param name="area">Area in pixels</param>
+    void SetMinimumArea(UINT area);
+
+private:
+    FLOAT   m_minimumDepth;
+    FLOAT   m_maximumDepth;
+    UINT    m_minimumArea;
+};
+
+/// <summary>
+/// Second stage. Compares the blob area and shape with the disc a ball projects to
+/// at the blob depth.
+/// </summary>
+class SizeGateStage : public CascadeStage
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    SizeGateStage();
+
+    /// <summary>
+    /// Get a short name for statistics
+    /// </summary>
+    virtual const char* GetName() const
+    {
+        return "Size";
+    }
+
+    /// <summary>
+    /// Test a candidate
+    /// </summary>
+    /// <param name="frame">Frame data</param>
+    /// <param name="candidate">Candidate to test</param>
+    /// <returns>True to keep the candidate</returns>
+    virtual bool Test(const CascadeFrame& frame, BallCandidate& candidate);
+
+    /// <summary>
+    /// Set the accepted range of blob area over expected ball area
+    /// </summary>
+    /// <param name="minimumFactor">Smallest ratio, below one for occluded or clipped balls</param>
+    /// <param name="maximumFactor">Largest ratio</param>
+    void SetAreaFactors(FLOAT minimumFactor, FLOAT maximumFactor);
+
+private:
+    FLOAT   m_minimumAreaFactor;
+    FLOAT   m_maximumAreaFactor;
+};
+
+/// <summary>
+/// Last stage. Maps the blob pixels to the color frame and keeps blobs with enough
+/// pixels of the ball color class. Bypassed while no color frame, registration or
+/// class table is available.
+/// </summary>
+class ColorGateStage : public CascadeStage
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    ColorGateStage();
+
+    /// <summary>
+    /// Get a short name for statistics
+    /// </summary>
+    virtual const char* GetName() const
+    {
+        return "Color";
+    }
+
+    /// <summary>
+    /// Check if a color frame, registration and class table are set
+    /// </summary>
+    virtual bool IsReady() const;
+
+    /// <summary>
+    /// Test a candidate
+    /// </summary>
+    /// <param name="frame">Frame data</param>
+    /// <param name="candidate">Candidate to test, receives its color ratio</param>
+    /// <returns>True to keep the candidate</returns>
+    virtual bool Test(const CascadeFrame& frame, BallCandidate& candidate);
+
+    /// <summary>
+    /// Set the color frame matching the next depth frame
+    /// </summary>
+    /// <param name="pPixels">BGRX pixels of the registration color resolution, or nullptr for none</param>
+    /// <param name="pRegistration">Depth to color registration</param>
+    void SetColorFrame(const UINT* pPixels, const RegistrationTable* pRegistration);
+
+    /// <summary>
+    /// Set the class table and the class of the ball
+    /// </summary>
+    /// <param name="pTable">Class table, or nullptr for none</param>
+    /// <param name="colorClass">Class index of the ball color</param>
+    void SetColorClass(const std::shared_ptr<const ColorClassTable>& pTable, UINT colorClass);
+
+    /// <summary>
+    /// Set the smallest share of ball colored pixels
+    /// </summary>
+    /// <param name="ratio">Ratio between 0 and 1</param>
+    void SetMinimumRatio(FLOAT ratio);
+
+private:
+    const UINT*                             m_pPixels;
+    const RegistrationTable*                m_pRegistration;
+    std::shared_ptr<const ColorClassTable>  m_pTable;
+    UINT                                    m_classBit;
+    FLOAT                                   m_minimumRatio;
+    std::vector<UINT>                       m_patch;
+};
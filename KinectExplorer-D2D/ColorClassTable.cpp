@@ -0,0 +1,263 @@
+//------------------------------------------------------------------------------
+// <copyright file="ColorClassTable.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include <cmath>
+#include <fstream>
+#include "ColorClassTable.h"
+
+#define LABEL_COUNT             (COLOR_CLASS_COUNT + 1)    // Classes and the negative label
+#define COLOR_FILE_MAGIC        0x4C43434B  // "KCCL"
+#define COLOR_FILE_VERSION      1
+
+struct ColorFileHeader
+{
+    DWORD magic;
+    DWORD version;
+    DWORD tableBits;
+};
+
+/// <summary>
+/// Constructor
+/// </summary>
+ColorClassTable::ColorClassTable()
+{
+    ZeroMemory(m_bins, sizeof(m_bins));
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+ColorClassTable::~ColorClassTable()
+{
+}
+
+/// <summary>
+/// Discard training samples
+/// </summary>
+void ColorClassTable::ClearSamples()
+{
+    m_counts.clear();
+}
+
+/// <summary>
+/// Add one labeled training pixel
+/// </summary>
+/// <param name="pixel">BGRX pixel</param>
+/// <param name="colorClass">Class index, or COLOR_CLASS_NONE for a negative sample</param>
+void ColorClassTable::AddSample(UINT pixel, UINT colorClass)
+{
+    if (colorClass >= LABEL_COUNT)
+    {
+        return;
+    }
+
+    if (m_counts.empty())
+    {
+        m_counts.assign(COLOR_TABLE_SIZE * LABEL_COUNT, 0);
+    }
+
+    ++m_counts[GetBin(pixel) * LABEL_COUNT + colorClass];
+}
+
+/// <summary>
+/// Add the pixels of an image selected by a mask as training samples of one class
+/// </summary>
+/// <param name="pPixels">The pointer to the BGRX image</param>
+/// <param name="mask">Mask of the image size selecting the samples</param>
+/// <param name="colorClass">Class index, or COLOR_CLASS_NONE for negative samples</param>
+/// <returns>Number of samples added</returns>
+UINT ColorClassTable::AddSamples(const UINT* pPixels, const PackedBitmask& mask, UINT colorClass)
+{
+    if (!pPixels || colorClass >= LABEL_COUNT)
+    {
+        return 0;
+    }
+
+    UINT width = mask.GetWidth();
+    UINT added = 0;
+
+    for (UINT y = 0; y < mask.GetHeight(); y++)
+    {
+        const ULONGLONG* pRow = mask.GetRow(y);
+
+        for (UINT w = 0; w < mask.GetWordsPerRow(); w++)
+        {
+            // Visit set bits only
+            for (ULONGLONG bits = pRow[w]; 0 != bits; bits &= bits - 1)
+            {
+                UINT bit = 0;
+                while (0 == ((bits >> bit) & 1))
+                {
+                    ++bit;
+                }
+
+                AddSample(pPixels[y * width + w * BITS_PER_MASK_WORD + bit], colorClass);
+                ++added;
+            }
+        }
+    }
+
+    return added;
+}
+
+/// <summary>
+/// Fill the table from the training samples
+/// </summary>
+/// <param name="minimumSamples">Fewest samples of the winning class in a bin</param>
+/// <param name="minimumProbability">Smallest share of the winning class among the samples of a bin</param>
+/// <returns>Number of bins assigned to a class</returns>
+UINT ColorClassTable::Build(UINT minimumSamples, FLOAT minimumProbability)
+{
+    ZeroMemory(m_bins, sizeof(m_bins));
+    if (m_counts.empty())
+    {
+        return 0;
+    }
+
+    UINT assigned = 0;
+    for (UINT bin = 0; bin < COLOR_TABLE_SIZE; bin++)
+    {
+        const UINT* pCounts = &m_counts[bin * LABEL_COUNT];
+
+        // Negative samples count toward the total but never win
+        UINT total = pCounts[COLOR_CLASS_NONE];
+        UINT best  = 0;
+        for (UINT c = 0; c < COLOR_CLASS_COUNT; c++)
+        {
+            total += pCounts[c];
+            if (pCounts[c] > pCounts[best])
+            {
+                best = c;
+            }
+        }
+
+        if (pCounts[best] >= minimumSamples && pCounts[best] > 0 && pCounts[best] >= minimumProbability * total)
+        {
+            m_bins[bin] = (BYTE)(1 << best);
+            ++assigned;
+        }
+    }
+
+    return assigned;
+}
+
+/// <summary>
+/// Add a class to every bin whose center color lies in a hue, saturation and value
+/// range. Gives a usable table before any samples were labeled
+/// </summary>
+/// <param name="colorClass">Class index</param>
+/// <param name="minimumHue">Lowest hue in degrees</param>
+/// <param name="maximumHue">Highest hue in degrees, below the lowest to wrap through red</param>
+/// <param name="minimumSaturation">Lowest saturation from 0 to 1</param>
+/// <param name="minimumValue">Lowest value from 0 to 1</param>
+/// <returns>Number of bins in the range</returns>
+UINT ColorClassTable::AddRange(UINT colorClass, FLOAT minimumHue, FLOAT maximumHue, FLOAT minimumSaturation, FLOAT minimumValue)
+{
+    if (colorClass >= COLOR_CLASS_COUNT)
+    {
+        return 0;
+    }
+
+    const UINT  levels    = 1 << COLOR_TABLE_BITS;
+    const FLOAT binCenter = 0.5f / levels;
+    UINT added = 0;
+
+    for (UINT bin = 0; bin < COLOR_TABLE_SIZE; bin++)
+    {
+        FLOAT red   = (FLOAT)(bin >> (2 * COLOR_TABLE_BITS))        / levels + binCenter;
+        FLOAT green = (FLOAT)((bin >> COLOR_TABLE_BITS) % levels)   / levels + binCenter;
+        FLOAT blue  = (FLOAT)(bin % levels)                         / levels + binCenter;
+
+        FLOAT value  = fmaxf(red, fmaxf(green, blue));
+        FLOAT chroma = value - fminf(red, fminf(green, blue));
+        if (value < minimumValue || chroma < minimumSaturation * value || 0.0f == chroma)
+        {
+            continue;
+        }
+
+        FLOAT hue;
+        if (value == red)
+        {
+            hue = 60.0f * (green - blue) / chroma;
+        }
+        else if (value == green)
+        {
+            hue = 60.0f * (blue - red) / chroma + 120.0f;
+        }
+        else
+        {
+            hue = 60.0f * (red - green) / chroma + 240.0f;
+        }
+        if (hue < 0.0f)
+        {
+            hue += 360.0f;
+        }
+
+        bool inside = minimumHue <= maximumHue ? (hue >= minimumHue && hue <= maximumHue)
+                                               : (hue >= minimumHue || hue <= maximumHue);
+        if (inside)
+        {
+            m_bins[bin] |= (BYTE)(1 << colorClass);
+            ++added;
+        }
+    }
+
+    return added;
+}
+
+/// <summary>
+/// Save table to file
+/// </summary>
+/// <param name="path">Path of file to write</param>
+/// <returns>Indicates success or failure</returns>
+HRESULT ColorClassTable::Save(const char* path) const
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        return E_FAIL;
+    }
+
+    ColorFileHeader header = {COLOR_FILE_MAGIC, COLOR_FILE_VERSION, COLOR_TABLE_BITS};
+
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)m_bins, sizeof(m_bins));
+
+    return file ? S_OK : E_FAIL;
+}
+
+/// <summary>
+/// Load table from file
+/// </summary>
+/// <param name="path">Path of file to read</param>
+/// <returns>Indicates success or failure</returns>
+HRESULT ColorClassTable::Load(const char* path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return E_FAIL;
+    }
+
+    ColorFileHeader header;
+    if (!file.read((char*)&header, sizeof(header)))
+    {
+        return E_FAIL;
+    }
+
+    if (COLOR_FILE_MAGIC != header.magic || COLOR_FILE_VERSION != header.version || COLOR_TABLE_BITS != header.tableBits)
+    {
+        return E_FAIL;
+    }
+
+    if (!file.read((char*)m_bins, sizeof(m_bins)))
+    {
+        ZeroMemory(m_bins, sizeof(m_bins));
+        return E_FAIL;
+    }
+
+    return S_OK;
+}
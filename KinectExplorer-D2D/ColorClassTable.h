@@ -0,0 +1,120 @@
+//------------------------------------------------------------------------------
+// <copyright file="ColorClassTable.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include "NuiTypes.h"
+#include "PackedBitmask.h"
+
+#define COLOR_CLASS_COUNT       8                                   // One bit per class in a table entry
+#define COLOR_CLASS_NONE        COLOR_CLASS_COUNT                   // Label of negative training samples
+#define COLOR_TABLE_BITS        5                                   // Bits kept per channel
+#define COLOR_TABLE_SIZE        (1 << (3 * COLOR_TABLE_BITS))       // 32 x 32 x 32 bins
+
+/// <summary>
+/// Maps a BGRX color to a class with one table read. The top five bits of red,
+/// green and blue select one of 32^3 bins, and each bin holds a bit per class, or
+/// zero for none. The table is trained from labeled sample pixels: every bin takes
+/// the class most of its samples belong to, if that class is frequent enough.
+/// </summary>
+class ColorClassTable
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    ColorClassTable();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~ColorClassTable();
+
+public:
+    /// <summary>
+    /// Get the bin index of a BGRX pixel
+    /// </summary>
+    static UINT GetBin(UINT pixel)
+    {
+        return ((pixel >> 9) & 0x7C00) | ((pixel >> 6) & 0x03E0) | ((pixel >> 3) & 0x001F);
+    }
+
+    /// <summary>
+    /// Look up the class bits of a BGRX pixel
+    /// </summary>
+    BYTE Lookup(UINT pixel) const
+    {
+        return m_bins[GetBin(pixel)];
+    }
+
+    /// <summary>
+    /// Get the table entries, one per bin
+    /// </summary>
+    const BYTE* GetBins() const
+    {
+        return m_bins;
+    }
+
+    /// <summary>
+    /// Discard training samples
+    /// </summary>
+    void ClearSamples();
+
+    /// <summary>
+    /// Add one labeled training pixel
+    /// </summary>
+    /// <param name="pixel">BGRX pixel</param>
+    /// <param name="colorClass">Class index, or COLOR_CLASS_NONE for a negative sample</param>
+    void AddSample(UINT pixel, UINT colorClass);
+
+    /// <summary>
+    /// Add the pixels of an image selected by a mask as training samples of one class
+    /// </summary>
+    /// <param name="pPixels">The pointer to the BGRX image</param>
+    /// <param name="mask">Mask of the image size selecting the samples</param>
+    /// <param name="colorClass">Class index, or COLOR_CLASS_NONE for negative samples</param>
+    /// <returns>Number of samples added</returns>
+    UINT AddSamples(const UINT* pPixels, const PackedBitmask& mask, UINT colorClass);
+
+    /// <summary>
+    /// Fill the table from the training samples
+    /// </summary>
+    /// <param name="minimumSamples">Fewest samples of the winning class in a bin</param>
+    /// <param name="minimumProbability">Smallest share of the winning class among the samples of a bin</param>
+    /// <returns>Number of bins assigned to a class</returns>
+    UINT Build(UINT minimumSamples, FLOAT minimumProbability);
+
+    /// <summary>
+    /// Add a class to every bin whose center color lies in a hue, saturation and value
+    /// range. Gives a usable table before any samples were labeled
+    /// </summary>
+    /// <param name="colorClass">Class index</param>
+    /// <param name="minimumHue">Lowest hue in degrees</param>
+    /// <param name="maximumHue">Highest hue in degrees, below the lowest to wrap through red</param>
+    /// <param name="minimumSaturation">Lowest saturation from 0 to 1</param>
+    /// <param name="minimumValue">Lowest value from 0 to 1</param>
+    /// <returns>Number of bins in the range</returns>
+    UINT AddRange(UINT colorClass, FLOAT minimumHue, FLOAT maximumHue, FLOAT minimumSaturation, FLOAT minimumValue);
+
+    /// <summary>
+    /// Save table to file
+    /// </summary>
+    /// <param name="path">Path of file to write</param>
+    /// <returns>Indicates success or failure</returns>
+    HRESULT Save(const char* path) const;
+
+    /// <summary>
+    /// Load table from file
+    /// </summary>
+    /// <param name="path">Path of file to read</param>
+    /// <returns>Indicates success or failure</returns>
+    HRESULT Load(const char* path);
+
+private:
+    BYTE                m_bins[COLOR_TABLE_SIZE];
+    std::vector<UINT>   m_counts;   // Training samples per bin and label, allocated on first sample
+};
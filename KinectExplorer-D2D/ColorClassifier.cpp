@@ -0,0 +1,162 @@
+//------------------------------------------------------------------------------
+// <copyright file="ColorClassifier.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "ColorClassifier.h"
+
+/// <summary>
+/// Constructor
+/// </summary>
+ColorClassifier::ColorClassifier()
+    : m_tableClasses(0)
+    , m_activeClasses(0)
+{
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+ColorClassifier::~ColorClassifier()
+{
+}
+
+/// <summary>
+/// Replace the class table. Safe to call while a frame is being classified
+/// </summary>
+/// <param name="pTable">New table, or nullptr to stop classifying</param>
+void ColorClassifier::SetTable(const std::shared_ptr<const ColorClassTable>& pTable)
+{
+    // Collect the classes the table can produce so absent classes cost nothing per frame
+    UINT classes = 0;
+    if (pTable)
+    {
+        const BYTE* pBins = pTable->GetBins();
+        for (UINT i = 0; i < COLOR_TABLE_SIZE; i++)
+        {
+            classes |= pBins[i];
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_tableLock);
+    m_pTable       = pTable;
+    m_tableClasses = classes;
+}
+
+/// <summary>
+/// Get the current class table
+/// </summary>
+std::shared_ptr<const ColorClassTable> ColorClassifier::GetTable() const
+{
+    std::lock_guard<std::mutex> lock(m_tableLock);
+    return m_pTable;
+}
+
+/// <summary>
+/// Classify a BGRX frame
+/// </summary>
+/// <param name="pPixels">The pointer to the pixels</param>
+/// <param name="width">Frame width</param>
+/// <param name="height">Frame height</param>
+/// <returns>False if no table is set</returns>
+bool ColorClassifier::Classify(const UINT* pPixels, UINT width, UINT height)
+{
+    // Hold a reference for the whole frame so a concurrent swap cannot free the table
+    std::shared_ptr<const ColorClassTable> pTable;
+    {
+        std::lock_guard<std::mutex> lock(m_tableLock);
+        pTable          = m_pTable;
+        m_activeClasses = m_tableClasses;
+    }
+
+    if (!pTable || !pPixels)
+    {
+        m_activeClasses = 0;
+        return false;
+    }
+
+    for (UINT c = 0; c < COLOR_CLASS_COUNT; c++)
+    {
+        if ((m_activeClasses >> c) & 1)
+        {
+            m_masks[c].Resize(width, height);
+        }
+    }
+
+    const BYTE* pBins = pTable->GetBins();
+    for (UINT y = 0; y < height; y++)
+    {
+        ClassifyRow(pBins, pPixels + y * width, width, y);
+    }
+
+    return true;
+}
+
+/// <summary>
+/// Classify one row of pixels into the rows of the class masks
+/// </summary>
+void ColorClassifier::ClassifyRow(const BYTE* pBins, const UINT* pPixels, UINT width, UINT y)
+{
+    ULONGLONG* pRows[COLOR_CLASS_COUNT] = {nullptr};
+    for (UINT c = 0; c < COLOR_CLASS_COUNT; c++)
+    {
+        if ((m_activeClasses >> c) & 1)
+        {
+            pRows[c] = m_masks[c].GetRow(y);
+        }
+    }
+
+    for (UINT base = 0; base < width; base += BITS_PER_MASK_WORD)
+    {
+        UINT count = width - base < BITS_PER_MASK_WORD ? width - base : BITS_PER_MASK_WORD;
+        const UINT* pWord = pPixels + base;
+
+        // Bin indices of the 64 pixels of this mask word
+        UINT bins[BITS_PER_MASK_WORD];
+        UINT x = 0;
+
+#ifdef NUI_USE_SSE2
+        const __m128i redMask   = _mm_set1_epi32(0x7C00);
+        const __m128i greenMask = _mm_set1_epi32(0x03E0);
+        const __m128i blueMask  = _mm_set1_epi32(0x001F);
+
+        for (; x + 4 <= count; x += 4)
+        {
+            __m128i pixels = _mm_loadu_si128((const __m128i*)(pWord + x));
+            __m128i index  = _mm_and_si128(_mm_srli_epi32(pixels, 9), redMask);
+            index = _mm_or_si128(index, _mm_and_si128(_mm_srli_epi32(pixels, 6), greenMask));
+            index = _mm_or_si128(index, _mm_and_si128(_mm_srli_epi32(pixels, 3), blueMask));
+            _mm_storeu_si128((__m128i*)(bins + x), index);
+        }
+#endif
+
+        for (; x < count; x++)
+        {
+            bins[x] = ColorClassTable::GetBin(pWord[x]);
+        }
+
+        // Spread the class bits of each pixel over the class words
+        ULONGLONG words[COLOR_CLASS_COUNT] = {0};
+        for (x = 0; x < count; x++)
+        {
+            for (UINT entry = pBins[bins[x]]; 0 != entry; entry &= entry - 1)
+            {
+                UINT c = 0;
+                while (0 == ((entry >> c) & 1))
+                {
+                    ++c;
+                }
+                words[c] |= 1ULL << x;
+            }
+        }
+
+        for (UINT c = 0; c < COLOR_CLASS_COUNT; c++)
+        {
+            if (pRows[c])
+            {
+                pRows[c][base / BITS_PER_MASK_WORD] = words[c];
+            }
+        }
+    }
+}
@@ -0,0 +1,84 @@
+//------------------------------------------------------------------------------
+// <copyright file="ColorClassifier.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include "NuiTypes.h"
+#include "PackedBitmask.h"
+#include "ColorClassTable.h"
+
+/// <summary>
+/// Classifies every pixel of a BGRX color frame through a ColorClassTable and writes
+/// one mask per class in a single pass. The table is shared and may be replaced by
+/// another thread at any time; a frame always uses the table current when it started.
+/// </summary>
+class ColorClassifier
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    ColorClassifier();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~ColorClassifier();
+
+public:
+    /// <summary>
+    /// Replace the class table. Safe to call while a frame is being classified
+    /// </summary>
+    /// <param name="pTable">New table, or nullptr to stop classifying</param>
+    void SetTable(const std::shared_ptr<const ColorClassTable>& pTable);
+
+    /// <summary>
+    /// Get the current class table
+    /// </summary>
+    std::shared_ptr<const ColorClassTable> GetTable() const;
+
+    /// <summary>
+    /// Classify a BGRX frame
+    /// </summary>
+    /// <param name="pPixels">The pointer to the pixels</param>
+    /// <param name="width">Frame width</param>
+    /// <param name="height">Frame height</param>
+    /// <returns>False if no table is set</returns>
+    bool Classify(const UINT* pPixels, UINT width, UINT height);
+
+    /// <summary>
+    /// Get the mask of a class from the last classified frame
+    /// </summary>
+    /// <param name="colorClass">Class index</param>
+    const PackedBitmask& GetMask(UINT colorClass) const
+    {
+        return m_masks[colorClass < COLOR_CLASS_COUNT ? colorClass : 0];
+    }
+
+    /// <summary>
+    /// Get the bits of the classes present in the table used by the last frame
+    /// </summary>
+    UINT GetActiveClasses() const
+    {
+        return m_activeClasses;
+    }
+
+private:
+    /// <summary>
+    /// Classify one row of pixels into the rows of the class masks
+    /// </summary>
+    void ClassifyRow(const BYTE* pBins, const UINT* pPixels, UINT width, UINT y);
+
+private:
+    mutable std::mutex                      m_tableLock;
+    std::shared_ptr<const ColorClassTable>  m_pTable;
+    UINT                                    m_tableClasses;     // Classes present in m_pTable
+
+    PackedBitmask                           m_masks[COLOR_CLASS_COUNT];
+    UINT                                    m_activeClasses;
+};
@@ -0,0 +1,386 @@
+//------------------------------------------------------------------------------
+// <copyright file="DepthBackgroundModel.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include <climits>
+#include <fstream>
+#include "DepthBackgroundModel.h"
+
+#define MODEL_FRACTION_BITS         2       // Background and deviation are stored as depth * 4
+#define MODEL_MAX_DEPTH             8191    // Keeps depth * 4 inside a signed 16-bit lane
+#define DEFAULT_LEARNING_SHIFT      5       // 1/32 per frame, about a second at 30 FPS
+#define FOREGROUND_EXTRA_SHIFT      4       // Foreground pixels are absorbed 16 times slower
+#define WARMUP_LEARNING_SHIFT       2
+#define WARMUP_FRAMES               30
+#define DEFAULT_MINIMUM_BAND        30      // Millimeters
+#define INITIAL_DEVIATION           (10 << MODEL_FRACTION_BITS)
+#define BAND_DEVIATION_SCALE        3
+
+#define BACKGROUND_FILE_MAGIC       0x4D47424B  // "KBGM"
+#define BACKGROUND_FILE_VERSION     1
+
+struct BackgroundFileHeader
+{
+    DWORD magic;
+    DWORD version;
+    DWORD width;
+    DWORD height;
+};
+
+/// <summary>
+/// Constructor
+/// </summary>
+DepthBackgroundModel::DepthBackgroundModel()
+    : m_width(0)
+    , m_height(0)
+    , m_frameCount(0)
+    , m_learningShift(DEFAULT_LEARNING_SHIFT)
+    , m_activeShift(WARMUP_LEARNING_SHIFT)
+    , m_minimumBand(DEFAULT_MINIMUM_BAND)
+    , m_pBackground(nullptr)
+    , m_pDeviation(nullptr)
+{
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+DepthBackgroundModel::~DepthBackgroundModel()
+{
+    delete[] m_pBackground;
+    delete[] m_pDeviation;
+}
+
+/// <summary>
+/// Allocate state arrays for a frame size
+/// </summary>
+/// <param name="width">Width of depth frame</param>
+/// <param name="height">Height of depth frame</param>
+void DepthBackgroundModel::Allocate(UINT width, UINT height)
+{
+    delete[] m_pBackground;
+    delete[] m_pDeviation;
+
+    m_width       = width;
+    m_height      = height;
+    m_pBackground = new USHORT[width * height];
+    m_pDeviation  = new USHORT[width * height];
+
+    m_foreground.Resize(width, height);
+    Reset();
+}
+
+/// <summary>
+/// Forget the learned background
+/// </summary>
+void DepthBackgroundModel::Reset()
+{
+    if (m_pBackground)
+    {
+        ZeroMemory(m_pBackground, m_width * m_height * sizeof(USHORT));
+        ZeroMemory(m_pDeviation,  m_width * m_height * sizeof(USHORT));
+    }
+
+    m_foreground.Clear();
+    m_frameCount = 0;
+}
+
+/// <summary>
+/// Prepare the model for a new frame. The learned state is reset if the frame size changed
+/// </summary>
+/// <param name="width">Width of depth frame</param>
+/// <param name="height">Height of depth frame</param>
+void DepthBackgroundModel::BeginFrame(UINT width, UINT height)
+{
+    if (width != m_width || height != m_height || !m_pBackground)
+    {
+        Allocate(width, height);
+    }
+
+    // Learn quickly until the model has settled
+    m_activeShift = IsWarmedUp() ? m_learningShift : WARMUP_LEARNING_SHIFT;
+}
+
+/// <summary>
+/// Finish processing of the current frame
+/// </summary>
+void DepthBackgroundModel::EndFrame()
+{
+    if (m_frameCount < UINT_MAX)
+    {
+        ++m_frameCount;
+    }
+}
+
+/// <summary>
+/// Update the model with a whole depth frame
+/// </summary>
+/// <param name="pPixels">The pointer to depth pixels</param>
+/// <param name="width">Width of depth frame</param>
+/// <param name="height">Height of depth frame</param>
+void DepthBackgroundModel::ProcessFrame(const NUI_DEPTH_IMAGE_PIXEL* pPixels, UINT width, UINT height)
+{
+    BeginFrame(width, height);
+
+    for (UINT y = 0; y < height; y++)
+    {
+        ProcessRow(pPixels + y * width, y);
+    }
+
+    EndFrame();
+}
+
+/// <summary>
+/// Update the model with one row of depth pixels and write the row's foreground bits
+/// </summary>
+/// <param name="pRow">The pointer to the first depth pixel of the row</param>
+/// <param name="y">Row index</param>
+void DepthBackgroundModel::ProcessRow(const NUI_DEPTH_IMAGE_PIXEL* pRow, UINT y)
+{
+    USHORT*    pBackground = m_pBackground + y * m_width;
+    USHORT*    pDeviation  = m_pDeviation  + y * m_width;
+    ULONGLONG* pMaskRow    = m_foreground.GetRow(y);
+
+    ZeroMemory(pMaskRow, m_foreground.GetWordsPerRow() * sizeof(ULONGLONG));
+
+    UINT x = 0;
+
+#ifdef NUI_USE_SSE2
+    const __m128i zero        = _mm_setzero_si128();
+    const __m128i maxDepth    = _mm_set1_epi16(MODEL_MAX_DEPTH);
+    const __m128i minBand     = _mm_set1_epi16((short)(m_minimumBand << MODEL_FRACTION_BITS));
+    const __m128i initialDev  = _mm_set1_epi16(INITIAL_DEVIATION);
+    const __m128i fastShift   = _mm_cvtsi32_si128(m_activeShift);
+    const __m128i slowShift   = _mm_cvtsi32_si128(m_activeShift + FOREGROUND_EXTRA_SHIFT);
+
+    // 16 pixels per iteration, processed as two groups of eight 16-bit lanes
+    for (; x + 16 <= m_width; x += 16)
+    {
+        __m128i foreground[2];
+
+        for (int half = 0; half < 2; half++)
+        {
+            UINT offset = x + half * 8;
+
+            // Extract the depth words from the interleaved player index/depth pixels
+            __m128i p0    = _mm_loadu_si128((const __m128i*)(pRow + offset));
+            __m128i p1    = _mm_loadu_si128((const __m128i*)(pRow + offset + 4));
+            __m128i depth = _mm_packs_epi32(_mm_srli_epi32(p0, 16), _mm_srli_epi32(p1, 16));
+            depth         = _mm_min_epi16(depth, maxDepth);
+
+            __m128i sample = _mm_slli_epi16(depth, MODEL_FRACTION_BITS);
+            __m128i bg     = _mm_loadu_si128((const __m128i*)(pBackground + offset));
+            __m128i dev    = _mm_loadu_si128((const __m128i*)(pDeviation + offset));
+
+            __m128i valid   = _mm_andnot_si128(_mm_cmpeq_epi16(depth, zero), _mm_set1_epi16(-1));
+            __m128i learned = _mm_andnot_si128(_mm_cmpeq_epi16(bg, zero), valid);
+
+            // Foreground if nearer than background by more than max(minimum band, scale * deviation)
+            __m128i band   = _mm_max_epi16(minBand, _mm_adds_epi16(dev, _mm_adds_epi16(dev, dev)));
+            __m128i fg     = _mm_and_si128(learned, _mm_cmpgt_epi16(_mm_sub_epi16(bg, sample), band));
+
+            // Exponential update. Foreground pixels use the slow rate
+            __m128i diff    = _mm_sub_epi16(sample, bg);
+            __m128i absDiff = _mm_max_epi16(diff, _mm_sub_epi16(zero, diff));
+            __m128i devDiff = _mm_sub_epi16(absDiff, dev);
+
+            __m128i bgStep  = _mm_or_si128(_mm_and_si128(fg, _mm_sra_epi16(diff, slowShift)),
+                                           _mm_andnot_si128(fg, _mm_sra_epi16(diff, fastShift)));
+            __m128i devStep = _mm_or_si128(_mm_and_si128(fg, _mm_sra_epi16(devDiff, slowShift)),
+                                           _mm_andnot_si128(fg, _mm_sra_epi16(devDiff, fastShift)));
+
+            __m128i newBg  = _mm_add_epi16(bg, bgStep);
+            __m128i newDev = _mm_add_epi16(dev, devStep);
+
+            // Pixels seen for the first time take the sample directly
+            __m128i fresh = _mm_andnot_si128(learned, valid);
+            newBg  = _mm_or_si128(_mm_and_si128(fresh, sample),     _mm_andnot_si128(fresh, newBg));
+            newDev = _mm_or_si128(_mm_and_si128(fresh, initialDev), _mm_andnot_si128(fresh, newDev));
+
+            // Unknown depth leaves the state untouched
+            newBg  = _mm_or_si128(_mm_and_si128(valid, newBg),  _mm_andnot_si128(valid, bg));
+            newDev = _mm_or_si128(_mm_and_si128(valid, newDev), _mm_andnot_si128(valid, dev));
+
+            _mm_storeu_si128((__m128i*)(pBackground + offset), newBg);
+            _mm_storeu_si128((__m128i*)(pDeviation + offset), newDev);
+
+            foreground[half] = fg;
+        }
+
+        ULONGLONG bits = (ULONGLONG)(UINT)_mm_movemask_epi8(_mm_packs_epi16(foreground[0], foreground[1]));
+        pMaskRow[x / BITS_PER_MASK_WORD] |= bits << (x % BITS_PER_MASK_WORD);
+    }
+#endif
+
+    ProcessSpan(pRow, pBackground, pDeviation, pMaskRow, x, m_width);
+}
+
+/// <summary>
+/// Update a span of pixels without SIMD
+/// </summary>
+/// <param name="pRow">The pointer to the depth pixels of the row</param>
+/// <param name="pBackground">The pointer to background state of the row</param>
+/// <param name="pDeviation">The pointer to deviation state of the row</param>
+/// <param name="pMaskRow">The pointer to the mask words of the row</param>
+/// <param name="start">First column to process</param>
+/// <param name="end">One past the last column to process</param>
+void DepthBackgroundModel::ProcessSpan(const NUI_DEPTH_IMAGE_PIXEL* pRow, USHORT* pBackground, USHORT* pDeviation, ULONGLONG* pMaskRow, UINT start, UINT end)
+{
+    const int minBand = m_minimumBand << MODEL_FRACTION_BITS;
+
+    for (UINT x = start; x < end; x++)
+    {
+        int depth = pRow[x].depth;
+        if (0 == depth)
+        {
+            continue;
+        }
+
+        if (depth > MODEL_MAX_DEPTH)
+        {
+            depth = MODEL_MAX_DEPTH;
+        }
+
+        int sample = depth << MODEL_FRACTION_BITS;
+        int bg     = pBackground[x];
+        int dev    = pDeviation[x];
+
+        if (0 == bg)
+        {
+            pBackground[x] = (USHORT)sample;
+            pDeviation[x]  = INITIAL_DEVIATION;
+            continue;
+        }
+
+        int band = BAND_DEVIATION_SCALE * dev;
+        if (band < minBand)
+        {
+            band = minBand;
+        }
+
+        bool fg    = (bg - sample > band);
+        UINT shift = fg ? m_activeShift + FOREGROUND_EXTRA_SHIFT : m_activeShift;
+
+        int diff    = sample - bg;
+        int absDiff = diff < 0 ? -diff : diff;
+
+        pBackground[x] = (USHORT)(bg + (diff >> shift));
+        pDeviation[x]  = (USHORT)(dev + ((absDiff - dev) >> shift));
+
+        if (fg)
+        {
+            pMaskRow[x / BITS_PER_MASK_WORD] |= 1ULL << (x % BITS_PER_MASK_WORD);
+        }
+    }
+}
+
+/// <summary>
+/// Get the learned background depth of a pixel in millimeters
+/// </summary>
+/// <param name="x">Column of pixel</param>
+/// <param name="y">Row of pixel</param>
+/// <returns>Background depth, zero if not learned yet</returns>
+USHORT DepthBackgroundModel::GetBackgroundDepth(UINT x, UINT y) const
+{
+    if (!m_pBackground || x >= m_width || y >= m_height)
+    {
+        return 0;
+    }
+
+    return m_pBackground[y * m_width + x] >> MODEL_FRACTION_BITS;
+}
+
+/// <summary>
+/// Indicates whether enough frames have been seen for the foreground mask to be reliable
+/// </summary>
+bool DepthBackgroundModel::IsWarmedUp() const
+{
+    return m_frameCount >= WARMUP_FRAMES;
+}
+
+/// <summary>
+/// Set the learning rate. Each frame the background moves 1/2^shift of the way toward the new sample
+/// </summary>
+/// <param name="shift">Learning rate shift</param>
+void DepthBackgroundModel::SetLearningShift(UINT shift)
+{
+    // Keep room for the extra foreground shift inside a 16-bit lane
+    m_learningShift = shift < 1 ? 1 : (shift > 10 ? 10 : shift);
+}
+
+/// <summary>
+/// Set the minimum distance in front of the background for a pixel to be foreground
+/// </summary>
+/// <param name="band">Distance in millimeters</param>
+void DepthBackgroundModel::SetMinimumBand(USHORT band)
+{
+    m_minimumBand = band > MODEL_MAX_DEPTH ? MODEL_MAX_DEPTH : band;
+}
+
+/// <summary>
+/// Save the learned background to file
+/// </summary>
+/// <param name="path">Path of file to write</param>
+/// <returns>Indicates success or failure</returns>
+HRESULT DepthBackgroundModel::Save(const char* path) const
+{
+    if (!m_pBackground || !IsWarmedUp())
+    {
+        return E_FAIL;
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        return E_FAIL;
+    }
+
+    BackgroundFileHeader header = {BACKGROUND_FILE_MAGIC, BACKGROUND_FILE_VERSION, m_width, m_height};
+    std::streamsize arraySize = (std::streamsize)(m_width * m_height * sizeof(USHORT));
+
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)m_pBackground, arraySize);
+    file.write((const char*)m_pDeviation, arraySize);
+
+    return file ? S_OK : E_FAIL;
+}
+
+/// <summary>
+/// Load a previously saved background from file. The model is considered warmed up afterwards
+/// </summary>
+/// <param name="path">Path of file to read</param>
+/// <returns>Indicates success or failure</returns>
+HRESULT DepthBackgroundModel::Load(const char* path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return E_FAIL;
+    }
+
+    BackgroundFileHeader header;
+    if (!file.read((char*)&header, sizeof(header)))
+    {
+        return E_FAIL;
+    }
+
+    if (BACKGROUND_FILE_MAGIC != header.magic || BACKGROUND_FILE_VERSION != header.version
+        || 0 == header.width || 0 == header.height || header.width > 1280 || header.height > 960)
+    {
+        return E_FAIL;
+    }
+
+    Allocate(header.width, header.height);
+
+    std::streamsize arraySize = (std::streamsize)(m_width * m_height * sizeof(USHORT));
+    if (!file.read((char*)m_pBackground, arraySize) || !file.read((char*)m_pDeviation, arraySize))
+    {
+        Reset();
+        return E_FAIL;
+    }
+
+    m_frameCount = WARMUP_FRAMES;
+    return S_OK;
+}
@@ -0,0 +1,149 @@
+//------------------------------------------------------------------------------
+// <copyright file="DepthBackgroundModel.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include "NuiTypes.h"
+#include "PackedBitmask.h"
+
+/// <summary>
+/// Per-pixel running background model of the depth stream. Every pixel keeps an
+/// exponentially weighted mean depth and mean absolute deviation. Pixels which are
+/// nearer than the background by more than the deviation band are reported as
+/// foreground in a packed bitmask. The model is updated row by row so it can be
+/// fused into the loop which reads the depth frame.
+/// </summary>
+class DepthBackgroundModel
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    DepthBackgroundModel();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~DepthBackgroundModel();
+
+private:
+    /// <summary>
+    /// Not copyable, the model owns its statistics buffers
+    /// </summary>
+    DepthBackgroundModel(const DepthBackgroundModel&) = delete;
+    DepthBackgroundModel& operator=(const DepthBackgroundModel&) = delete;
+
+public:
+    /// <summary>
+    /// Prepare the model for a new frame. The learned state is reset if the frame size changed
+    /// </summary>
+    /// <param name="width">Width of depth frame</param>
+    /// <param name="height">Height of depth frame</param>
+    void BeginFrame(UINT width, UINT height);
+
+    /// <summary>
+    /// Update the model with one row of depth pixels and write the row's foreground bits
+    /// </summary>
+    /// <param name="pRow">The pointer to the first depth pixel of the row</param>
+    /// <param name="y">Row index</param>
+    void ProcessRow(const NUI_DEPTH_IMAGE_PIXEL* pRow, UINT y);
+
+    /// <summary>
+    /// Finish processing of the current frame
+    /// </summary>
+    void EndFrame();
+
+    /// <summary>
+    /// Update the model with a whole depth frame
+    /// </summary>
+    /// <param name="pPixels">The pointer to depth pixels</param>
+    /// <param name="width">Width of depth frame</param>
+    /// <param name="height">Height of depth frame</param>
+    void ProcessFrame(const NUI_DEPTH_IMAGE_PIXEL* pPixels, UINT width, UINT height);
+
+    /// <summary>
+    /// Forget the learned background
+    /// </summary>
+    void Reset();
+
+    /// <summary>
+    /// Get the foreground mask produced by the last processed frame
+    /// </summary>
+    const PackedBitmask& GetForegroundMask() const
+    {
+        return m_foreground;
+    }
+
+    /// <summary>
+    /// Get the learned background depth of a pixel in millimeters
+    /// </summary>
+    /// <param name="x">Column of pixel</param>
+    /// <param name="y">Row of pixel</param>
+    /// <returns>Background depth, zero if not learned yet</returns>
+    USHORT GetBackgroundDepth(UINT x, UINT y) const;
+
+    /// <summary>
+    /// Indicates whether enough frames have been seen for the foreground mask to be reliable
+    /// </summary>
+    bool IsWarmedUp() const;
+
+    /// <summary>
+    /// Set the learning rate. Each frame the background moves 1/2^shift of the way toward the new sample
+    /// </summary>
+    /// <param name="shift">Learning rate shift</param>
+    void SetLearningShift(UINT shift);
+
+    /// <summary>
+    /// Set the minimum distance in front of the background for a pixel to be foreground
+    /// </summary>
+    /// <param name="band">Distance in millimeters</param>
+    void SetMinimumBand(USHORT band);
+
+    /// <summary>
+    /// Save the learned background to file
+    /// </summary>
+    /// <param name="path">Path of file to write</param>
+    /// <returns>Indicates success or failure</returns>
+    HRESULT Save(const char* path) const;
+
+    /// <summary>
+    /// Load a previously saved background from file. The model is considered warmed up afterwards
+    /// </summary>
+    /// <param name="path">Path of file to read</param>
+    /// <returns>Indicates success or failure</returns>
+    HRESULT Load(const char* path);
+
+private:
+    /// <summary>
+    /// Allocate state arrays for a frame size
+    /// </summary>
+    /// <param name="width">Width of depth frame</param>
+    /// <param name="height">Height of depth frame</param>
+    void Allocate(UINT width, UINT height);
+
+    /// <summary>
+    /// Update a span of pixels without SIMD
+    /// </summary>
+    /// <param name="pRow">The pointer to the depth pixels of the row</param>
+    /// <param name="pBackground">The pointer to background state of the row</param>
+    /// <param name="pDeviation">The pointer to deviation state of the row</param>
+    /// <param name="pMaskRow">The pointer to the mask words of the row</param>
+    /// <param name="start">First column to process</param>
+    /// <param name="end">One past the last column to process</param>
+    void ProcessSpan(const NUI_DEPTH_IMAGE_PIXEL* pRow, USHORT* pBackground, USHORT* pDeviation, ULONGLONG* pMaskRow, UINT start, UINT end);
+
+private:
+    UINT            m_width;
+    UINT            m_height;
+    UINT            m_frameCount;
+    UINT            m_learningShift;
+    UINT            m_activeShift;
+    USHORT          m_minimumBand;
+
+    USHORT*         m_pBackground;  // Mean depth, two fractional bits
+    USHORT*         m_pDeviation;   // Mean absolute deviation, two fractional bits
+    PackedBitmask   m_foreground;
+};
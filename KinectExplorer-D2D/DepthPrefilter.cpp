@@ -0,0 +1,365 @@
+//------------------------------------------------------------------------------
+// <copyright file="DepthPrefilter.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include "DepthPrefilter.h"
+
+#define TOLERANCE_SHIFT     5       // Depth steps above depth / 32 (about 3%) are edges
+#define TOLERANCE_BASE      16      // Millimeters added to the tolerance for quantization noise
+
+/// <summary>
+/// Absolute difference of two depths
+/// </summary>
+static inline USHORT AbsDiff(USHORT a, USHORT b)
+{
+    return a > b ? a - b : b - a;
+}
+
+/// <summary>
+/// Largest depth difference of two pixels on the same surface at a depth
+/// </summary>
+static inline USHORT Tolerance(USHORT depth)
+{
+    return (USHORT)((depth >> TOLERANCE_SHIFT) + TOLERANCE_BASE);
+}
+
+/// <summary>
+/// Check whether two depths are known and lie on the same surface
+/// </summary>
+static inline bool Agree(USHORT a, USHORT b)
+{
+    return 0 != a && 0 != b && AbsDiff(a, b) <= Tolerance(a);
+}
+
+/// <summary>
+/// Filter a single pixel. Reference for the vectorized row loop
+/// </summary>
+/// <param name="center">Depth of the pixel</param>
+/// <param name="left">Depth of the left neighbour</param>
+/// <param name="right">Depth of the right neighbour</param>
+/// <param name="up">Depth of the upper neighbour</param>
+/// <param name="down">Depth of the lower neighbour</param>
+/// <param name="previous">Filtered depth of the pixel in the previous frame</param>
+/// <param name="holeFill">True to fill unknown pixels</param>
+/// <param name="flyingPixelRemoval">True to clear flying pixels</param>
+/// <returns>Filtered depth</returns>
+static inline USHORT FilterPixel(USHORT center, USHORT left, USHORT right, USHORT up, USHORT down, USHORT previous,
+                                 bool holeFill, bool flyingPixelRemoval)
+{
+    if (0 != center)
+    {
+        if (flyingPixelRemoval)
+        {
+            // A flying pixel steps away from both neighbours on one axis
+            USHORT tolerance  = Tolerance(center);
+            bool   horizontal = AbsDiff(center, left) > tolerance && AbsDiff(center, right) > tolerance;
+            bool   vertical   = AbsDiff(center, up)   > tolerance && AbsDiff(center, down)  > tolerance;
+            if (horizontal || vertical)
+            {
+                return 0;
+            }
+        }
+
+        return center;
+    }
+
+    if (!holeFill)
+    {
+        return 0;
+    }
+
+    // Interpolate only between neighbours on the same surface, so holes at an edge stay open
+    if (Agree(left, right))
+    {
+        return (USHORT)((left + right + 1) >> 1);
+    }
+    if (Agree(up, down))
+    {
+        return (USHORT)((up + down + 1) >> 1);
+    }
+
+    // The previous frame is trusted where it continues a neighbouring surface
+    if (Agree(previous, left) || Agree(previous, right) || Agree(previous, up) || Agree(previous, down))
+    {
+        return previous;
+    }
+
+    return 0;
+}
+
+#ifdef NUI_USE_SSE2
+/// <summary>
+/// Per-lane a > b for unsigned 16-bit values
+/// </summary>
+static inline __m128i GreaterEpu16(__m128i a, __m128i b)
+{
+    return _mm_xor_si128(_mm_cmpeq_epi16(_mm_subs_epu16(a, b), _mm_setzero_si128()), _mm_set1_epi16(-1));
+}
+
+/// <summary>
+/// Per-lane absolute difference of unsigned 16-bit values
+/// </summary>
+static inline __m128i AbsDiffEpu16(__m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_subs_epu16(a, b), _mm_subs_epu16(b, a));
+}
+
+/// <summary>
+/// Per-lane tolerance of depths
+/// </summary>
+static inline __m128i ToleranceEpu16(__m128i depth)
+{
+    return _mm_add_epi16(_mm_srli_epi16(depth, TOLERANCE_SHIFT), _mm_set1_epi16(TOLERANCE_BASE));
+}
+
+/// <summary>
+/// Per-lane check whether two depths are known and lie on the same surface
+/// </summary>
+static inline __m128i AgreeEpu16(__m128i a, __m128i b)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    __m128i unknown = _mm_or_si128(_mm_cmpeq_epi16(a, zero), _mm_cmpeq_epi16(b, zero));
+    return _mm_andnot_si128(_mm_or_si128(unknown, GreaterEpu16(AbsDiffEpu16(a, b), ToleranceEpu16(a))), _mm_set1_epi16(-1));
+}
+
+/// <summary>
+/// Per-lane select of a where mask is set and b elsewhere
+/// </summary>
+static inline __m128i Select(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+#endif
+
+/// <summary>
+/// Constructor
+/// </summary>
+DepthPrefilter::DepthPrefilter()
+    : m_holeFill(true)
+    , m_flyingPixelRemoval(true)
+    , m_width(0)
+    , m_height(0)
+    , m_pTemporalFilter(nullptr)
+{
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+DepthPrefilter::~DepthPrefilter()
+{
+}
+
+/// <summary>
+/// Select the depth image resolution. The previous frame is dropped when the size changes
+/// </summary>
+/// <param name="resolution">Depth image resolution</param>
+/// <returns>Indicates success or failure</returns>
+HRESULT DepthPrefilter::SetResolution(NUI_IMAGE_RESOLUTION resolution)
+{
+    if (resolution < NUI_IMAGE_RESOLUTION_80x60 || resolution > NUI_IMAGE_RESOLUTION_1280x960)
+    {
+        return E_INVALIDARG;
+    }
+
+    DWORD width, height;
+    NuiImageResolutionToSize(resolution, width, height);
+
+    if (m_width != width || m_height != height)
+    {
+        m_width  = width;
+        m_height = height;
+
+        m_depth.assign(width * height, 0);
+        m_previous.assign(width * height, 0);
+    }
+
+    return S_OK;
+}
+
+/// <summary>
+/// Forget the previous frame
+/// </summary>
+void DepthPrefilter::Reset()
+{
+    std::fill(m_previous.begin(), m_previous.end(), (USHORT)0);
+}
+
+/// <summary>
+/// Enable or disable filling of unknown pixels
+/// </summary>
+/// <param name="enable">True to fill holes</param>
+void DepthPrefilter::EnableHoleFill(bool enable)
+{
+    m_holeFill = enable;
+}
+
+/// <summary>
+/// Enable or disable removal of flying pixels
+/// </summary>
+/// <param name="enable">True to remove flying pixels</param>
+void DepthPrefilter::EnableFlyingPixelRemoval(bool enable)
+{
+    m_flyingPixelRemoval = enable;
+}
+
+/// <summary>
+/// Attach a temporal filter which runs in the same pass as the prefilter
+/// </summary>
+/// <param name="pFilter">The pointer to temporal filter. nullptr to detach</param>
+void DepthPrefilter::SetTemporalFilter(DepthTemporalFilter* pFilter)
+{
+    m_pTemporalFilter = pFilter;
+}
+
+/// <summary>
+/// Filter a depth frame in place
+/// </summary>
+/// <param name="pPixels">The pointer to depth pixels</param>
+/// <param name="size">Size of the frame in bytes</param>
+void DepthPrefilter::Process(NUI_DEPTH_IMAGE_PIXEL* pPixels, UINT size)
+{
+    if (0 == m_width || size < m_width * m_height * sizeof(NUI_DEPTH_IMAGE_PIXEL))
+    {
+        return;
+    }
+
+    bool clean = m_holeFill || m_flyingPixelRemoval;
+
+    if (m_pTemporalFilter)
+    {
+        m_pTemporalFilter->BeginFrame(m_width, m_height);
+    }
+
+    // The unfiltered plane runs one row ahead, so every row reads unfiltered neighbours
+    if (clean)
+    {
+        ExtractRow(pPixels, 0);
+    }
+
+    for (UINT y = 0; y < m_height; y++)
+    {
+        NUI_DEPTH_IMAGE_PIXEL* pRow = pPixels + y * m_width;
+
+        if (clean)
+        {
+            if (y + 1 < m_height)
+            {
+                ExtractRow(pRow + m_width, y + 1);
+            }
+
+            FilterRow(pRow, y);
+        }
+
+        // Smooth the cleaned row while it is still in cache
+        if (m_pTemporalFilter)
+        {
+            m_pTemporalFilter->ProcessRow(pRow, y);
+        }
+    }
+}
+
+/// <summary>
+/// Copy the depth words of one row into the unfiltered depth plane
+/// </summary>
+/// <param name="pRow">The pointer to the first depth pixel of the row</param>
+/// <param name="y">Row index</param>
+void DepthPrefilter::ExtractRow(const NUI_DEPTH_IMAGE_PIXEL* pRow, UINT y)
+{
+    USHORT* pDepth = &m_depth[y * m_width];
+    UINT    x      = 0;
+
+#ifdef NUI_USE_SSE2
+    // Arithmetic shift keeps depths above 32767 exact through the signed pack
+    for (; x + 8 <= m_width; x += 8)
+    {
+        __m128i p0 = _mm_loadu_si128((const __m128i*)(pRow + x));
+        __m128i p1 = _mm_loadu_si128((const __m128i*)(pRow + x + 4));
+        _mm_storeu_si128((__m128i*)(pDepth + x), _mm_packs_epi32(_mm_srai_epi32(p0, 16), _mm_srai_epi32(p1, 16)));
+    }
+#endif
+
+    for (; x < m_width; x++)
+    {
+        pDepth[x] = pRow[x].depth;
+    }
+}
+
+/// <summary>
+/// Filter one row and write its depth back to the pixels
+/// </summary>
+/// <param name="pRow">The pointer to the first depth pixel of the row</param>
+/// <param name="y">Row index</param>
+void DepthPrefilter::FilterRow(NUI_DEPTH_IMAGE_PIXEL* pRow, UINT y)
+{
+    // Border rows and columns see themselves as neighbours, which is never an edge and never fills
+    const USHORT* pCenter   = &m_depth[y * m_width];
+    const USHORT* pUp       = y > 0             ? pCenter - m_width : pCenter;
+    const USHORT* pDown     = y + 1 < m_height  ? pCenter + m_width : pCenter;
+    USHORT*       pPrevious = &m_previous[y * m_width];
+
+    UINT lastX = m_width - 1;
+
+    // First pixel is done by the scalar path, so the vector loop can read x - 1
+    pRow[0].depth = pPrevious[0] = FilterPixel(pCenter[0], pCenter[0], pCenter[lastX > 0 ? 1 : 0], pUp[0], pDown[0], pPrevious[0],
+                                               m_holeFill, m_flyingPixelRemoval);
+    UINT x = 1;
+
+#ifdef NUI_USE_SSE2
+    const __m128i zero       = _mm_setzero_si128();
+    const __m128i fillMask   = _mm_set1_epi16(m_holeFill ? -1 : 0);
+    const __m128i removeMask = _mm_set1_epi16(m_flyingPixelRemoval ? -1 : 0);
+    const __m128i indexMask  = _mm_set1_epi32(0x0000FFFF);
+
+    for (; x + 8 < m_width; x += 8)
+    {
+        __m128i center   = _mm_loadu_si128((const __m128i*)(pCenter + x));
+        __m128i left     = _mm_loadu_si128((const __m128i*)(pCenter + x - 1));
+        __m128i right    = _mm_loadu_si128((const __m128i*)(pCenter + x + 1));
+        __m128i up       = _mm_loadu_si128((const __m128i*)(pUp + x));
+        __m128i down     = _mm_loadu_si128((const __m128i*)(pDown + x));
+        __m128i previous = _mm_loadu_si128((const __m128i*)(pPrevious + x));
+
+        // Flying pixels step away from both neighbours on one axis
+        __m128i tolerance  = ToleranceEpu16(center);
+        __m128i horizontal = _mm_and_si128(GreaterEpu16(AbsDiffEpu16(center, left), tolerance),
+                                           GreaterEpu16(AbsDiffEpu16(center, right), tolerance));
+        __m128i vertical   = _mm_and_si128(GreaterEpu16(AbsDiffEpu16(center, up), tolerance),
+                                           GreaterEpu16(AbsDiffEpu16(center, down), tolerance));
+        __m128i flying     = _mm_and_si128(removeMask, _mm_or_si128(horizontal, vertical));
+
+        // Hole candidates in the order of the scalar path, the first agreeing one wins
+        __m128i agreeX = AgreeEpu16(left, right);
+        __m128i agreeY = AgreeEpu16(up, down);
+        __m128i agreeT = _mm_or_si128(_mm_or_si128(AgreeEpu16(previous, left), AgreeEpu16(previous, right)),
+                                      _mm_or_si128(AgreeEpu16(previous, up), AgreeEpu16(previous, down)));
+
+        __m128i fill = _mm_and_si128(agreeT, previous);
+        fill = Select(agreeY, _mm_avg_epu16(up, down), fill);
+        fill = Select(agreeX, _mm_avg_epu16(left, right), fill);
+        fill = _mm_and_si128(fillMask, fill);
+
+        __m128i hole   = _mm_cmpeq_epi16(center, zero);
+        __m128i result = Select(hole, fill, _mm_andnot_si128(flying, center));
+
+        _mm_storeu_si128((__m128i*)(pPrevious + x), result);
+
+        // Write the depth words back next to the untouched player index words
+        __m128i* pOut = (__m128i*)(pRow + x);
+        __m128i  p0   = _mm_loadu_si128(pOut);
+        __m128i  p1   = _mm_loadu_si128(pOut + 1);
+        _mm_storeu_si128(pOut,     _mm_or_si128(_mm_and_si128(p0, indexMask), _mm_unpacklo_epi16(zero, result)));
+        _mm_storeu_si128(pOut + 1, _mm_or_si128(_mm_and_si128(p1, indexMask), _mm_unpackhi_epi16(zero, result)));
+    }
+#endif
+
+    for (; x < m_width; x++)
+    {
+        pRow[x].depth = pPrevious[x] = FilterPixel(pCenter[x], pCenter[x - 1], pCenter[x < lastX ? x + 1 : x], pUp[x], pDown[x], pPrevious[x],
+                                                   m_holeFill, m_flyingPixelRemoval);
+    }
+}
@@ -0,0 +1,97 @@
+//------------------------------------------------------------------------------
+// <copyright file="DepthPrefilter.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include "NuiTypes.h"
+#include "DepthTemporalFilter.h"
+
+/// <summary>
+/// Cleans a depth frame in place before any other stage reads it. Flying pixels,
+/// which sit on a depth step to both sides, are cleared to unknown depth. Unknown
+/// pixels are filled from a pair of agreeing neighbours or from the previous frame
+/// when it agrees with a neighbour, so holes are never filled across an edge.
+/// Only the depth of a pixel is written, the player index is kept. An attached
+/// temporal filter smooths each row right after it is cleaned.
+/// </summary>
+class DepthPrefilter
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    DepthPrefilter();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~DepthPrefilter();
+
+public:
+    /// <summary>
+    /// Select the depth image resolution. The previous frame is dropped when the size changes
+    /// </summary>
+    /// <param name="resolution">Depth image resolution</param>
+    /// <returns>Indicates success or failure</returns>
+    HRESULT SetResolution(NUI_IMAGE_RESOLUTION resolution);
+
+    /// <summary>
+    /// Forget the previous frame
+    /// </summary>
+    void Reset();
+
+    /// <summary>
+    /// Enable or disable filling of unknown pixels
+    /// </summary>
+    /// <param name="enable">True to fill holes</param>
+    void EnableHoleFill(bool enable);
+
+    /// <summary>
+    /// Enable or disable removal of flying pixels
+    /// </summary>
+    /// <param name="enable">True to remove flying pixels</param>
+    void EnableFlyingPixelRemoval(bool enable);
+
+    /// <summary>
+    /// Attach a temporal filter which runs in the same pass as the prefilter
+    /// </summary>
+    /// <param name="pFilter">The pointer to temporal filter. nullptr to detach</param>
+    void SetTemporalFilter(DepthTemporalFilter* pFilter);
+
+    /// <summary>
+    /// Filter a depth frame in place
+    /// </summary>
+    /// <param name="pPixels">The pointer to depth pixels</param>
+    /// <param name="size">Size of the frame in bytes</param>
+    void Process(NUI_DEPTH_IMAGE_PIXEL* pPixels, UINT size);
+
+private:
+    /// <summary>
+    /// Copy the depth words of one row into the unfiltered depth plane
+    /// </summary>
+    /// <param name="pRow">The pointer to the first depth pixel of the row</param>
+    /// <param name="y">Row index</param>
+    void ExtractRow(const NUI_DEPTH_IMAGE_PIXEL* pRow, UINT y);
+
+    /// <summary>
+    /// Filter one row and write its depth back to the pixels
+    /// </summary>
+    /// <param name="pRow">The pointer to the first depth pixel of the row</param>
+    /// <param name="y">Row index</param>
+    void FilterRow(NUI_DEPTH_IMAGE_PIXEL* pRow, UINT y);
+
+private:
+    bool                m_holeFill;
+    bool                m_flyingPixelRemoval;
+    UINT                m_width;
+    UINT                m_height;
+
+    std::vector<USHORT> m_depth;
+    std::vector<USHORT> m_previous;
+
+    DepthTemporalFilter* m_pTemporalFilter;
+};
@@ -0,0 +1,231 @@
+//------------------------------------------------------------------------------
+// <copyright file="DepthTemporalFilter.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "DepthTemporalFilter.h"
+
+#define VALUE_FRACTION_BITS         3       // Filtered depth is stored as depth * 8
+#define VALUE_MAX_DEPTH             8191    // Keeps depth * 8 inside an unsigned 16-bit lane
+#define DEFAULT_MAXIMUM_CONFIDENCE  4       // Steady pixels take 1/16 of a new sample
+#define CONFIDENCE_LIMIT            8
+#define NOISE_BAND_SHIFT            18      // Noise band grows with depth squared, 95 mm at 5 m
+#define NOISE_BAND_BASE             8       // Millimeters
+
+/// <summary>
+/// Largest difference between a sample and the filtered depth that is taken as noise
+/// </summary>
+static inline USHORT NoiseBand(USHORT depth)
+{
+    return (USHORT)(((UINT)depth * depth >> NOISE_BAND_SHIFT) + NOISE_BAND_BASE);
+}
+
+/// <summary>
+/// Constructor
+/// </summary>
+DepthTemporalFilter::DepthTemporalFilter()
+    : m_width(0)
+    , m_height(0)
+    , m_maximumConfidence(DEFAULT_MAXIMUM_CONFIDENCE)
+    , m_pValue(nullptr)
+    , m_pConfidence(nullptr)
+{
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+DepthTemporalFilter::~DepthTemporalFilter()
+{
+    delete[] m_pValue;
+    delete[] m_pConfidence;
+}
+
+/// <summary>
+/// Allocate state arrays for a frame size
+/// </summary>
+/// <param name="width">Width of depth frame</param>
+/// <param name="height">Height of depth frame</param>
+void DepthTemporalFilter::Allocate(UINT width, UINT height)
+{
+    delete[] m_pValue;
+    delete[] m_pConfidence;
+
+    m_width       = width;
+    m_height      = height;
+    m_pValue      = new USHORT[width * height];
+    m_pConfidence = new BYTE[width * height];
+
+    Reset();
+}
+
+/// <summary>
+/// Forget the filtered depth of all pixels
+/// </summary>
+void DepthTemporalFilter::Reset()
+{
+    if (m_pValue)
+    {
+        ZeroMemory(m_pValue,      m_width * m_height * sizeof(USHORT));
+        ZeroMemory(m_pConfidence, m_width * m_height * sizeof(BYTE));
+    }
+}
+
+/// <summary>
+/// Set the highest confidence. Steady pixels blend new samples with a weight of 1/2^confidence
+/// </summary>
+/// <param name="confidence">Highest confidence</param>
+void DepthTemporalFilter::SetMaximumConfidence(BYTE confidence)
+{
+    m_maximumConfidence = confidence < CONFIDENCE_LIMIT ? confidence : CONFIDENCE_LIMIT;
+}
+
+/// <summary>
+/// Prepare the filter for a new frame. The state is reset if the frame size changed
+/// </summary>
+/// <param name="width">Width of depth frame</param>
+/// <param name="height">Height of depth frame</param>
+void DepthTemporalFilter::BeginFrame(UINT width, UINT height)
+{
+    if (width != m_width || height != m_height || !m_pValue)
+    {
+        Allocate(width, height);
+    }
+}
+
+/// <summary>
+/// Filter one row of depth pixels in place. The player index is kept
+/// </summary>
+/// <param name="pRow">The pointer to the first depth pixel of the row</param>
+/// <param name="y">Row index</param>
+void DepthTemporalFilter::ProcessRow(NUI_DEPTH_IMAGE_PIXEL* pRow, UINT y)
+{
+    USHORT* pValue      = m_pValue      + y * m_width;
+    BYTE*   pConfidence = m_pConfidence + y * m_width;
+
+    UINT x = 0;
+
+#ifdef NUI_USE_SSE2
+    const __m128i zero          = _mm_setzero_si128();
+    const __m128i allSet        = _mm_set1_epi16(-1);
+    const __m128i ones          = _mm_set1_epi16(1);
+    const __m128i maxDepth      = _mm_set1_epi16(VALUE_MAX_DEPTH);
+    const __m128i maxConfidence = _mm_set1_epi16(m_maximumConfidence);
+    const __m128i bandBase      = _mm_set1_epi16(NOISE_BAND_BASE);
+    const __m128i rounding      = _mm_set1_epi16(1 << (VALUE_FRACTION_BITS - 1));
+    const __m128i indexMask     = _mm_set1_epi32(0x0000FFFF);
+
+    for (; x + 8 <= m_width; x += 8)
+    {
+        // Extract the depth words from the interleaved player index/depth pixels
+        __m128i* pPixels = (__m128i*)(pRow + x);
+        __m128i  p0      = _mm_loadu_si128(pPixels);
+        __m128i  p1      = _mm_loadu_si128(pPixels + 1);
+        __m128i  sample  = _mm_packs_epi32(_mm_srai_epi32(p0, 16), _mm_srai_epi32(p1, 16));
+
+        __m128i value      = _mm_loadu_si128((const __m128i*)(pValue + x));
+        __m128i confidence = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(pConfidence + x)), zero);
+
+        __m128i clamped = _mm_sub_epi16(sample, _mm_subs_epu16(sample, maxDepth));
+        __m128i fixed   = _mm_slli_epi16(clamped, VALUE_FRACTION_BITS);
+
+        // Distance of the sample from the filtered depth in millimeters
+        __m128i diff = _mm_srli_epi16(_mm_or_si128(_mm_subs_epu16(fixed, value), _mm_subs_epu16(value, fixed)), VALUE_FRACTION_BITS);
+        __m128i band = _mm_add_epi16(_mm_srli_epi16(_mm_mulhi_epu16(clamped, clamped), NOISE_BAND_SHIFT - 16), bandBase);
+
+        __m128i hole   = _mm_cmpeq_epi16(sample, zero);
+        __m128i moved  = _mm_xor_si128(_mm_cmpeq_epi16(_mm_subs_epu16(diff, band), zero), allSet);
+        __m128i unsure = _mm_xor_si128(_mm_cmpeq_epi16(_mm_subs_epu16(diff, _mm_srli_epi16(band, 1)), zero), allSet);
+
+        // Samples near the edge of the band halve the confidence, others raise it
+        __m128i raised  = _mm_min_epi16(_mm_add_epi16(confidence, ones), maxConfidence);
+        __m128i updated = _mm_or_si128(_mm_and_si128(unsure, _mm_srli_epi16(confidence, 1)), _mm_andnot_si128(unsure, raised));
+
+        // Blend with a weight of 1/2^confidence by halving the step once per confidence level
+        __m128i step = _mm_sub_epi16(fixed, value);
+        for (int level = 0; level < m_maximumConfidence; level++)
+        {
+            __m128i halve = _mm_cmpgt_epi16(updated, _mm_set1_epi16((short)level));
+            step = _mm_or_si128(_mm_and_si128(halve, _mm_srai_epi16(step, 1)), _mm_andnot_si128(halve, step));
+        }
+
+        // Motion restarts the pixel, holes keep the filtered depth and lose confidence
+        __m128i newValue      = _mm_or_si128(_mm_and_si128(moved, fixed), _mm_andnot_si128(moved, _mm_add_epi16(value, step)));
+        __m128i newConfidence = _mm_andnot_si128(moved, updated);
+        newValue      = _mm_or_si128(_mm_and_si128(hole, value), _mm_andnot_si128(hole, newValue));
+        newConfidence = _mm_or_si128(_mm_and_si128(hole, _mm_subs_epu16(confidence, ones)), _mm_andnot_si128(hole, newConfidence));
+
+        _mm_storeu_si128((__m128i*)(pValue + x), newValue);
+        _mm_storel_epi64((__m128i*)(pConfidence + x), _mm_packus_epi16(newConfidence, zero));
+
+        // Restarted pixels and holes pass the sample through
+        __m128i passed = _mm_or_si128(hole, moved);
+        __m128i output = _mm_srli_epi16(_mm_add_epi16(newValue, rounding), VALUE_FRACTION_BITS);
+        output         = _mm_or_si128(_mm_and_si128(passed, sample), _mm_andnot_si128(passed, output));
+
+        // Write the depth words back next to the untouched player index words
+        _mm_storeu_si128(pPixels,     _mm_or_si128(_mm_and_si128(p0, indexMask), _mm_unpacklo_epi16(zero, output)));
+        _mm_storeu_si128(pPixels + 1, _mm_or_si128(_mm_and_si128(p1, indexMask), _mm_unpackhi_epi16(zero, output)));
+    }
+#endif
+
+    // Remaining pixels, or all of them without SIMD
+    ProcessSpan(pRow, pValue, pConfidence, x, m_width);
+}
+
+/// <summary>
+/// Filter a span of pixels without SIMD
+/// </summary>
+/// <param name="pRow">The pointer to the depth pixels of the row</param>
+/// <param name="pValue">The pointer to filtered depth state of the row</param>
+/// <param name="pConfidence">The pointer to confidence state of the row</param>
+/// <param name="start">First column to process</param>
+/// <param name="end">One past the last column to process</param>
+void DepthTemporalFilter::ProcessSpan(NUI_DEPTH_IMAGE_PIXEL* pRow, USHORT* pValue, BYTE* pConfidence, UINT start, UINT end)
+{
+    for (UINT x = start; x < end; x++)
+    {
+        USHORT sample = pRow[x].depth;
+
+        // Holes keep the filtered depth and lose confidence
+        if (0 == sample)
+        {
+            if (pConfidence[x] > 0)
+            {
+                --pConfidence[x];
+            }
+            continue;
+        }
+
+        USHORT clamped = sample < VALUE_MAX_DEPTH ? sample : VALUE_MAX_DEPTH;
+        USHORT fixed   = (USHORT)(clamped << VALUE_FRACTION_BITS);
+        USHORT diff    = (USHORT)((fixed > pValue[x] ? fixed - pValue[x] : pValue[x] - fixed) >> VALUE_FRACTION_BITS);
+        USHORT band    = NoiseBand(clamped);
+
+        // Motion restarts the pixel and passes the sample through
+        if (diff > band)
+        {
+            pValue[x]      = fixed;
+            pConfidence[x] = 0;
+            continue;
+        }
+
+        // Samples near the edge of the band halve the confidence, others raise it
+        BYTE confidence = pConfidence[x];
+        if (diff > (band >> 1))
+        {
+            confidence >>= 1;
+        }
+        else if (confidence < m_maximumConfidence)
+        {
+            ++confidence;
+        }
+
+        int step = ((int)fixed - (int)pValue[x]) >> confidence;
+
+        pValue[x]      = (USHORT)(pValue[x] + step);
+        pConfidence[x] = confidence;
+        pRow[x].depth  = (USHORT)((pValue[x] + (1 << (VALUE_FRACTION_BITS - 1))) >> VALUE_FRACTION_BITS);
+    }
+}
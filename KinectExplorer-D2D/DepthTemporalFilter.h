@@ -0,0 +1,90 @@
+//------------------------------------------------------------------------------
+// <copyright file="DepthTemporalFilter.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include "NuiTypes.h"
+
+/// <summary>
+/// Per-pixel temporal smoothing of depth. Every pixel keeps its filtered depth and
+/// a confidence in separate arrays. A sample inside the noise band of the filtered
+/// depth is blended in with a weight of 1/2^confidence and raises the confidence. A
+/// sample far outside the band is taken as motion and restarts the pixel, so moving
+/// objects are not smeared. The filter writes depth in place row by row so it can be
+/// fused into the loop which reads the depth frame.
+/// </summary>
+class DepthTemporalFilter
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    DepthTemporalFilter();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~DepthTemporalFilter();
+
+private:
+    /// <summary>
+    /// Not copyable, the filter owns its state buffers
+    /// </summary>
+    DepthTemporalFilter(const DepthTemporalFilter&) = delete;
+    DepthTemporalFilter& operator=(const DepthTemporalFilter&) = delete;
+
+public:
+    /// <summary>
+    /// Prepare the filter for a new frame. The state is reset if the frame size changed
+    /// </summary>
+    /// <param name="width">Width of depth frame</param>
+    /// <param name="height">Height of depth frame</param>
+    void BeginFrame(UINT width, UINT height);
+
+    /// <summary>
+    /// Filter one row of depth pixels in place. The player index is kept
+    /// </summary>
+    /// <param name="pRow">The pointer to the first depth pixel of the row</param>
+    /// <param name="y">Row index</param>
+    void ProcessRow(NUI_DEPTH_IMAGE_PIXEL* pRow, UINT y);
+
+    /// <summary>
+    /// Forget the filtered depth of all pixels
+    /// </summary>
+    void Reset();
+
+    /// <summary>
+    /// Set the highest confidence. Steady pixels blend new samples with a weight of 1/2^confidence
+    /// </summary>
+    /// <param name="confidence">Highest confidence</param>
+    void SetMaximumConfidence(BYTE confidence);
+
+private:
+    /// <summary>
+    /// Allocate state arrays for a frame size
+    /// </summary>
+    /// <param name="width">Width of depth frame</param>
+    /// <param name="height">Height of depth frame</param>
+    void Allocate(UINT width, UINT height);
+
+    /// <summary>
+    /// Filter a span of pixels without SIMD
+    /// </summary>
+    /// <param name="pRow">The pointer to the depth pixels of the row</param>
+    /// <param name="pValue">The pointer to filtered depth state of the row</param>
+    /// <param name="pConfidence">The pointer to confidence state of the row</param>
+    /// <param name="start">First column to process</param>
+    /// <param name="end">One past the last column to process</param>
+    void ProcessSpan(NUI_DEPTH_IMAGE_PIXEL* pRow, USHORT* pValue, BYTE* pConfidence, UINT start, UINT end);
+
+private:
+    UINT            m_width;
+    UINT            m_height;
+    BYTE            m_maximumConfidence;
+
+    USHORT*         m_pValue;       // Filtered depth, three fractional bits
+    BYTE*           m_pConfidence;  // Number of halvings of the blend weight
+};
@@ -0,0 +1,164 @@
+//------------------------------------------------------------------------------
+// <copyright file="DetectionCascade.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include <chrono>
+#include "DetectionCascade.h"
+
+/// <summary>
+/// Constructor
+/// </summary>
+DetectionCascade::DetectionCascade()
+{
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+DetectionCascade::~DetectionCascade()
+{
+}
+
+/// <summary>
+/// Append a stage. The stage must outlive the cascade
+/// </summary>
+/// <param name="pStage">Stage to append</param>
+/// <param name="budget">Time budget per frame in microseconds, zero for none</param>
+/// <param name="overrun">What to do with candidates left when the budget is spent</param>
+void DetectionCascade::AddStage(CascadeStage* pStage, UINT budget, CASCADE_OVERRUN overrun)
+{
+    if (!pStage)
+    {
+        return;
+    }
+
+    StageEntry entry;
+    ZeroMemory(&entry.stats, sizeof(entry.stats));
+
+    entry.pStage     = pStage;
+    entry.budget     = budget;
+    entry.overrun    = overrun;
+    entry.enabled    = true;
+    entry.stats.name = pStage->GetName();
+
+    m_stages.push_back(entry);
+}
+
+/// <summary>
+/// Change the time budget of a stage
+/// </summary>
+/// <param name="stage">Stage index</param>
+/// <param name="budget">Time budget per frame in microseconds, zero for none</param>
+void DetectionCascade::SetBudget(UINT stage, UINT budget)
+{
+    if (stage < m_stages.size())
+    {
+        m_stages[stage].budget = budget;
+    }
+}
+
+/// <summary>
+/// Enable or disable a stage without removing it
+/// </summary>
+/// <param name="stage">Stage index</param>
+/// <param name="enabled">True to run the stage</param>
+void DetectionCascade::EnableStage(UINT stage, bool enabled)
+{
+    if (stage < m_stages.size())
+    {
+        m_stages[stage].enabled = enabled;
+    }
+}
+
+/// <summary>
+/// Clear the accumulated statistics
+/// </summary>
+void DetectionCascade::ResetStats()
+{
+    for (size_t i = 0; i < m_stages.size(); i++)
+    {
+        const char* name = m_stages[i].stats.name;
+        ZeroMemory(&m_stages[i].stats, sizeof(m_stages[i].stats));
+        m_stages[i].stats.name = name;
+    }
+}
+
+/// <summary>
+/// Run every stage over the candidates
+/// </summary>
+/// <param name="frame">Frame data</param>
+/// <param name="candidates">Candidates, reduced in place to the accepted ones</param>
+/// <returns>Number of accepted candidates</returns>
+UINT DetectionCascade::Run(const CascadeFrame& frame, std::vector<BallCandidate>& candidates)
+{
+    for (size_t i = 0; i < m_stages.size(); i++)
+    {
+        StageEntry& entry = m_stages[i];
+
+        entry.stats.tested       = 0;
+        entry.stats.rejected     = 0;
+        entry.stats.overrun      = 0;
+        entry.stats.milliseconds = 0.0f;
+
+        if (entry.enabled && entry.pStage->IsReady() && !candidates.empty())
+        {
+            RunStage(entry, frame, candidates);
+        }
+    }
+
+    return (UINT)candidates.size();
+}
+
+/// <summary>
+/// Run one stage over the candidates
+/// </summary>
+void DetectionCascade::RunStage(StageEntry& entry, const CascadeFrame& frame, std::vector<BallCandidate>& candidates)
+{
+    std::chrono::steady_clock::time_point start    = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point deadline = start + std::chrono::microseconds(entry.budget);
+
+    size_t kept = 0;
+    size_t i    = 0;
+
+    for (; i < candidates.size(); i++)
+    {
+        if (0 != entry.budget && std::chrono::steady_clock::now() >= deadline)
+        {
+            break;
+        }
+
+        ++entry.stats.tested;
+        if (entry.pStage->Test(frame, candidates[i]))
+        {
+            candidates[kept++] = candidates[i];
+        }
+        else
+        {
+            ++entry.stats.rejected;
+        }
+    }
+
+    // Budget spent, apply the overrun policy to the rest
+    if (i < candidates.size())
+    {
+        entry.stats.overrun = (UINT)(candidates.size() - i);
+        ++entry.stats.overrunFrames;
+
+        if (CASCADE_OVERRUN_PASS == entry.overrun)
+        {
+            for (; i < candidates.size(); i++)
+            {
+                candidates[kept++] = candidates[i];
+            }
+        }
+    }
+
+    candidates.resize(kept);
+
+    entry.stats.milliseconds   = std::chrono::duration<FLOAT, std::milli>(std::chrono::steady_clock::now() - start).count();
+    entry.stats.totalTested   += entry.stats.tested;
+    entry.stats.totalRejected += entry.stats.rejected;
+    entry.stats.totalOverrun  += entry.stats.overrun;
+}
@@ -0,0 +1,187 @@
+//------------------------------------------------------------------------------
+// <copyright file="DetectionCascade.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include "NuiTypes.h"
+#include "PackedBitmask.h"
+#include "BlobLabeler.h"
+
+/// <summary>
+/// Foreground blob that may be a ball
+/// </summary>
+struct BallCandidate
+{
+    DepthBlob   blob;
+    FLOAT       imageRadius;    // Expected ball radius at the blob depth, pixels
+    FLOAT       colorRatio;     // Share of blob pixels of the ball color, negative if not checked
+};
+
+/// <summary>
+/// Data of the frame shared by all stages
+/// </summary>
+struct CascadeFrame
+{
+    const PackedBitmask*            pMask;
+    const NUI_DEPTH_IMAGE_PIXEL*    pDepth;
+    UINT                            width;
+    UINT                            height;
+    FLOAT                           focalLength;    // Pixels per meter at one meter
+    FLOAT                           ballRadius;     // Meters
+};
+
+/// <summary>
+/// What a stage does with the candidates left when its time budget is spent
+/// </summary>
+enum CASCADE_OVERRUN
+{
+    CASCADE_OVERRUN_PASS,       // Hand them to the next stage untested
+    CASCADE_OVERRUN_REJECT,     // Drop them
+};
+
+/// <summary>
+/// Rejection statistics of one stage
+/// </summary>
+struct CascadeStageStats
+{
+    const char* name;
+    UINT        tested;             // Candidates tested in the last frame
+    UINT        rejected;           // Candidates rejected in the last frame
+    UINT        overrun;            // Candidates left untested in the last frame because of the budget
+    FLOAT       milliseconds;       // Time spent in the last frame
+    ULONGLONG   totalTested;        // Since the last reset
+    ULONGLONG   totalRejected;
+    ULONGLONG   totalOverrun;
+    UINT        overrunFrames;      // Frames in which the budget ran out
+};
+
+/// <summary>
+/// One test of the cascade. Stages see only candidates every earlier stage accepted,
+/// so cheap tests should come first.
+/// </summary>
+class CascadeStage
+{
+public:
+    /// <summary>
+    /// Destructor
+    /// </summary>
+    virtual ~CascadeStage() {}
+
+    /// <summary>
+    /// Get a short name for statistics
+    /// </summary>
+    virtual const char* GetName() const = 0;
+
+    /// <summary>
+    /// Check if the stage can run on the current frame. Stages that cannot are bypassed
+    /// </summary>
+    virtual bool IsReady() const
+    {
+        return true;
+    }
+
+    /// <summary>
+    /// Test a candidate
+    /// </summary>
+    /// <param name="frame">Frame data</param>
+    /// <param name="candidate">Candidate to test, may be annotated</param>
+    /// <returns>True to keep the candidate</returns>
+    virtual bool Test(const CascadeFrame& frame, BallCandidate& candidate) = 0;
+};
+
+/// <summary>
+/// Runs ball candidates through a list of stages in order. Each stage has its own
+/// time budget per frame and keeps rejection statistics. Stages are not owned and
+/// can be added without touching the others.
+/// </summary>
+class DetectionCascade
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    DetectionCascade();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~DetectionCascade();
+
+public:
+    /// <summary>
+    /// Append a stage. The stage must outlive the cascade
+    /// </summary>
+    /// <param name="pStage">Stage to append</param>
+    /// <param name="budget">Time budget per frame in microseconds, zero for none</param>
+    /// <param name="overrun">What to do with candidates left when the budget is spent</param>
+    void AddStage(CascadeStage* pStage, UINT budget, CASCADE_OVERRUN overrun);
+
+    /// <summary>
+    /// Change the time budget of a stage
+    /// </summary>
+    /// <param name="stage">Stage index</param>
+    /// <param name="budget">Time budget per frame in microseconds, zero for none</param>
+    void SetBudget(UINT stage, UINT budget);
+
+    /// <summary>
+    /// Enable or disable a stage without removing it
+    /// </summary>
+    /// <param name="stage">Stage index</param>
+    /// <param name="enabled">True to run the stage</param>
+    void EnableStage(UINT stage, bool enabled);
+
+    /// <summary>
+    /// Run every stage over the candidates
+    /// </summary>
+    /// <param name="frame">Frame data</param>
+    /// <param name="candidates">Candidates, reduced in place to the accepted ones</param>
+    /// <returns>Number of accepted candidates</returns>
+    UINT Run(const CascadeFrame& frame, std::vector<BallCandidate>& candidates);
+
+    /// <summary>
+    /// Clear the accumulated statistics
+    /// </summary>
+    void ResetStats();
+
+    /// <summary>
+    /// Get the number of stages
+    /// </summary>
+    UINT GetStageCount() const
+    {
+        return (UINT)m_stages.size();
+    }
+
+    /// <summary>
+    /// Get the statistics of a stage
+    /// </summary>
+    /// <param name="stage">Stage index</param>
+    const CascadeStageStats& GetStats(UINT stage) const
+    {
+        return m_stages[stage].stats;
+    }
+
+private:
+    /// <summary>
+    /// Stage with its settings and statistics
+    /// </summary>
+    struct StageEntry
+    {
+        CascadeStage*       pStage;
+        UINT                budget;
+        CASCADE_OVERRUN     overrun;
+        bool                enabled;
+        CascadeStageStats   stats;
+    };
+
+    /// <summary>
+    /// Run one stage over the candidates
+    /// </summary>
+    void RunStage(StageEntry& entry, const CascadeFrame& frame, std::vector<BallCandidate>& candidates);
+
+private:
+    std::vector<StageEntry> m_stages;
+};
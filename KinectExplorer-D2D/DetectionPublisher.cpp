@@ -0,0 +1,100 @@
+//------------------------------------------------------------------------------
+// <copyright file="DetectionPublisher.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "DetectionPublisher.h"
+
+/// <summary>
+/// Constructor
+/// </summary>
+DetectionPublisher::DetectionPublisher()
+    : m_sequence(0)
+    , m_droppedCount(0)
+{
+    ZeroMemory(&m_packet, sizeof(m_packet));
+    m_packet.header.magic   = DETECTION_PACKET_MAGIC;
+    m_packet.header.version = DETECTION_PACKET_VERSION;
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+DetectionPublisher::~DetectionPublisher()
+{
+}
+
+/// <summary>
+/// Open the socket to the controller
+/// </summary>
+/// <param name="address">Controller IPv4 address in dotted form</param>
+/// <param name="port">Controller port</param>
+/// <returns>Indicates success or failure</returns>
+HRESULT DetectionPublisher::Open(const char* address, USHORT port)
+{
+    m_sequence     = 0;
+    m_droppedCount = 0;
+
+    return m_socket.OpenSender(address, port);
+}
+
+/// <summary>
+/// Close the socket
+/// </summary>
+void DetectionPublisher::Close()
+{
+    m_socket.Close();
+}
+
+/// <summary>
+/// Send the confirmed tracks of a frame. Does nothing while closed
+/// </summary>
+/// <param name="tracks">Current ball tracks</param>
+/// <param name="frameNumber">Depth frame number</param>
+/// <param name="timestamp">Frame time in milliseconds</param>
+/// <returns>S_OK if sent, S_FALSE if closed or the datagram was dropped, or a failure code</returns>
+HRESULT DetectionPublisher::Publish(const std::vector<BallTrack>& tracks, UINT frameNumber, LONGLONG timestamp)
+{
+    if (!m_socket.IsOpen())
+    {
+        return S_FALSE;
+    }
+
+    UINT count = 0;
+    for (size_t i = 0; i < tracks.size() && count < DETECTION_PACKET_MAX_BALLS; i++)
+    {
+        const BallTrack& track = tracks[i];
+        if (!track.confirmed)
+        {
+            continue;
+        }
+
+        DetectionPacketBall& ball = m_packet.balls[count++];
+        ball.id = track.id;
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            ball.position[axis] = track.state[axis][0];
+            ball.velocity[axis] = track.state[axis][1];
+        }
+
+        // Share of frames the ball was seen in, lowered while it coasts
+        ball.confidence = track.age > 0 ? (FLOAT)track.hits / track.age / (1 + track.missed) : 0.0f;
+    }
+
+    // Receivers count lost packets by gaps in the sequence, so it advances even if the send fails
+    m_packet.header.ballCount   = (USHORT)count;
+    m_packet.header.sequence    = m_sequence++;
+    m_packet.header.frameNumber = frameNumber;
+    m_packet.header.timestamp   = timestamp;
+    m_packet.header.sendTime    = GetDetectionPacketTime();
+
+    HRESULT hr = m_socket.Send(&m_packet, sizeof(DetectionPacketHeader) + count * sizeof(DetectionPacketBall));
+    if (S_OK != hr)
+    {
+        ++m_droppedCount;
+    }
+
+    return hr;
+}
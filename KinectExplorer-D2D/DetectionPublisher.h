@@ -0,0 +1,128 @@
+//------------------------------------------------------------------------------
+// <copyright file="DetectionPublisher.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+#include "NuiTypes.h"
+#include "BallTracker.h"
+#include "UdpSocket.h"
+
+#define DETECTION_PACKET_MAGIC      0x4C4C4142  // "BALL" in memory order
+#define DETECTION_PACKET_VERSION    1
+#define DETECTION_PACKET_MAX_BALLS  16
+
+#pragma pack(push, 1)
+
+/// <summary>
+/// Fixed layout header of a detection packet. All fields are little endian
+/// </summary>
+struct DetectionPacketHeader
+{
+    UINT        magic;          // DETECTION_PACKET_MAGIC
+    USHORT      version;        // DETECTION_PACKET_VERSION
+    USHORT      ballCount;      // Ball records following the header
+    UINT        sequence;       // Incremented for every packet sent
+    UINT        frameNumber;    // Depth frame the balls were measured in
+    LONGLONG    timestamp;      // Depth frame time, milliseconds
+    LONGLONG    sendTime;       // Steady clock of the sender, microseconds
+};
+
+/// <summary>
+/// One tracked ball in a detection packet
+/// </summary>
+struct DetectionPacketBall
+{
+    UINT        id;             // Stable track ID
+    FLOAT       position[3];    // Meters
+    FLOAT       velocity[3];    // Meters per second
+    FLOAT       confidence;     // Zero to one
+};
+
+/// <summary>
+/// Detection packet as sent. Only the used ball records are put on the wire
+/// </summary>
+struct DetectionPacket
+{
+    DetectionPacketHeader   header;
+    DetectionPacketBall     balls[DETECTION_PACKET_MAX_BALLS];
+};
+
+#pragma pack(pop)
+
+/// <summary>
+/// Clock stamped into packets. Sender and receiver on the same machine share it
+/// </summary>
+/// <returns>Microseconds since an arbitrary start</returns>
+inline LONGLONG GetDetectionPacketTime()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// <summary>
+/// Sends the confirmed ball tracks of every depth frame to a controller as one UDP
+/// datagram. The packet lives in the publisher and is filled in place, so publishing
+/// neither allocates nor formats text, and the socket never blocks the frame.
+/// </summary>
+class DetectionPublisher
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    DetectionPublisher();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~DetectionPublisher();
+
+public:
+    /// <summary>
+    /// Open the socket to the controller
+    /// </summary>
+    /// <param name="address">Controller IPv4 address in dotted form</param>
+    /// <param name="port">Controller port</param>
+    /// <returns>Indicates success or failure</returns>
+    HRESULT Open(const char* address, USHORT port);
+
+    /// <summary>
+    /// Close the socket
+    /// </summary>
+    void Close();
+
+    /// <summary>
+    /// Indicates whether the publisher is open
+    /// </summary>
+    bool IsOpen() const
+    {
+        return m_socket.IsOpen();
+    }
+
+    /// <summary>
+    /// Send the confirmed tracks of a frame. Does nothing while closed
+    /// </summary>
+    /// <param name="tracks">Current ball tracks</param>
+    /// <param name="frameNumber">Depth frame number</param>
+    /// <param name="timestamp">Frame time in milliseconds</param>
+    /// <returns>S_OK if sent, S_FALSE if closed or the datagram was dropped, or a failure code</returns>
+    HRESULT Publish(const std::vector<BallTrack>& tracks, UINT frameNumber, LONGLONG timestamp);
+
+    /// <summary>
+    /// Get number of packets the socket could not take
+    /// </summary>
+    UINT GetDroppedCount() const
+    {
+        return m_droppedCount;
+    }
+
+private:
+    UdpSocket       m_socket;
+    DetectionPacket m_packet;
+    UINT            m_sequence;
+    UINT            m_droppedCount;
+};
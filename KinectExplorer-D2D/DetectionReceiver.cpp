@@ -0,0 +1,98 @@
+//------------------------------------------------------------------------------
+// <copyright file="DetectionReceiver.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "DetectionReceiver.h"
+
+/// <summary>
+/// Constructor
+/// </summary>
+DetectionReceiver::DetectionReceiver()
+{
+    ZeroMemory(&m_packet, sizeof(m_packet));
+    ResetStats();
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+DetectionReceiver::~DetectionReceiver()
+{
+}
+
+/// <summary>
+/// Start listening
+/// </summary>
+/// <param name="port">Local port the publisher sends to</param>
+/// <returns>Indicates success or failure</returns>
+HRESULT DetectionReceiver::Open(USHORT port)
+{
+    ResetStats();
+    return m_socket.OpenReceiver(port);
+}
+
+/// <summary>
+/// Stop listening
+/// </summary>
+void DetectionReceiver::Close()
+{
+    m_socket.Close();
+}
+
+/// <summary>
+/// Clear packet counts and latency
+/// </summary>
+void DetectionReceiver::ResetStats()
+{
+    ZeroMemory(&m_stats, sizeof(m_stats));
+    m_latencySum   = 0.0;
+    m_nextSequence = 0;
+}
+
+/// <summary>
+/// Wait for the next detection packet
+/// </summary>
+/// <param name="timeout">Longest wait in milliseconds</param>
+/// <returns>S_OK if a packet arrived, S_FALSE on timeout or a malformed datagram, or a failure code</returns>
+HRESULT DetectionReceiver::Receive(UINT timeout)
+{
+    UINT    size = 0;
+    HRESULT hr   = m_socket.Receive(&m_packet, sizeof(m_packet), timeout, size);
+    if (S_OK != hr)
+    {
+        return hr;
+    }
+
+    // Stamp the arrival before any checks so they do not count as latency
+    LONGLONG now = GetDetectionPacketTime();
+
+    const DetectionPacketHeader& header = m_packet.header;
+    if (size < sizeof(DetectionPacketHeader)
+        || DETECTION_PACKET_MAGIC != header.magic
+        || DETECTION_PACKET_VERSION != header.version
+        || header.ballCount > DETECTION_PACKET_MAX_BALLS
+        || size != sizeof(DetectionPacketHeader) + header.ballCount * sizeof(DetectionPacketBall))
+    {
+        ++m_stats.malformed;
+        return S_FALSE;
+    }
+
+    // A sequence behind the expected one is a restarted publisher, not a loss
+    if (m_stats.received > 0 && header.sequence > m_nextSequence)
+    {
+        m_stats.lost += header.sequence - m_nextSequence;
+    }
+    m_nextSequence = header.sequence + 1;
+
+    FLOAT latency = (FLOAT)(now - header.sendTime);
+
+    ++m_stats.received;
+    m_latencySum        += latency;
+    m_stats.lastLatency  = latency;
+    m_stats.meanLatency  = (FLOAT)(m_latencySum / m_stats.received);
+    m_stats.maxLatency   = latency > m_stats.maxLatency ? latency : m_stats.maxLatency;
+
+    return S_OK;
+}
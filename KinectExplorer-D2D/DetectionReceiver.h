@@ -0,0 +1,91 @@
+//------------------------------------------------------------------------------
+// <copyright file="DetectionReceiver.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include "NuiTypes.h"
+#include "DetectionPublisher.h"
+#include "UdpSocket.h"
+
+/// <summary>
+/// Counts kept by the receiver
+/// </summary>
+struct DetectionReceiverStats
+{
+    UINT    received;           // Valid packets
+    UINT    lost;               // Sequence numbers skipped
+    UINT    malformed;          // Datagrams that are not detection packets
+    FLOAT   lastLatency;        // Send to receive, microseconds
+    FLOAT   meanLatency;
+    FLOAT   maxLatency;
+};
+
+/// <summary>
+/// Receives detection packets and checks them. Running it on the machine of the
+/// publisher, against the loopback address, measures the send to receive latency
+/// from the steady clock stamp in every packet.
+/// </summary>
+class DetectionReceiver
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    DetectionReceiver();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~DetectionReceiver();
+
+public:
+    /// <summary>
+    /// Start listening
+    /// </summary>
+    /// <param name="port">Local port the publisher sends to</param>
+    /// <returns>Indicates success or failure</returns>
+    HRESULT Open(USHORT port);
+
+    /// <summary>
+    /// Stop listening
+    /// </summary>
+    void Close();
+
+    /// <summary>
+    /// Wait for the next detection packet
+    /// </summary>
+    /// <param name="timeout">Longest wait in milliseconds</param>
+    /// <returns>S_OK if a packet arrived, S_FALSE on timeout or a malformed datagram, or a failure code</returns>
+    HRESULT Receive(UINT timeout);
+
+    /// <summary>
+    /// Get the last packet received
+    /// </summary>
+    const DetectionPacket& GetPacket() const
+    {
+        return m_packet;
+    }
+
+    /// <summary>
+    /// Get packet counts and latency
+    /// </summary>
+    const DetectionReceiverStats& GetStats() const
+    {
+        return m_stats;
+    }
+
+    /// <summary>
+    /// Clear packet counts and latency
+    /// </summary>
+    void ResetStats();
+
+private:
+    UdpSocket               m_socket;
+    DetectionPacket         m_packet;
+    DetectionReceiverStats  m_stats;
+    double                  m_latencySum;
+    UINT                    m_nextSequence;
+};
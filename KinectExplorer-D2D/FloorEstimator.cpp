@@ -0,0 +1,515 @@
+//------------------------------------------------------------------------------
+// <copyright file="FloorEstimator.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include <cmath>
+#include "FloorEstimator.h"
+
+#define STANDARD_GRAVITY            9.80665f
+#define MILLIMETERS_TO_METERS       0.001f
+#define GRID_COLUMNS                80      // Sample grid, every 8th pixel at 640x480
+#define GRID_ROWS                   60
+#define MINIMUM_SAMPLE_DEPTH        400     // Millimeters
+#define MAXIMUM_SAMPLE_DEPTH        6000    // Millimeters, farther floor is too noisy
+#define MINIMUM_CAMERA_HEIGHT       0.2f    // Meters, points nearer to camera height are not floor
+#define PRIOR_COSINE                0.985f  // Planes within about 10 degrees of level
+#define MINIMUM_READING             0.5f    // Smaller accelerometer readings are not gravity
+#define SEARCH_ITERATIONS           64
+#define INLIER_DISTANCE             0.03f   // Meters from the plane for search support
+#define TRACK_DISTANCE              0.05f   // Meters from the plane for tracking support
+#define MINIMUM_INLIERS             50
+#define FORGETTING_FACTOR           0.8     // Weight kept by older frames at each new one
+#define LOST_FRAMES                 15      // Frames without support before the floor is searched again
+#define FLOOR_MARGIN                0.03f   // Meters above the floor still rejected as floor
+
+/// <summary>
+/// Dot product of two directions
+/// </summary>
+static inline FLOAT Dot(const FLOAT a[3], const FLOAT b[3])
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+/// <summary>
+/// Cross product of two directions
+/// </summary>
+static inline void Cross(const FLOAT a[3], const FLOAT b[3], FLOAT result[3])
+{
+    result[0] = a[1] * b[2] - a[2] * b[1];
+    result[1] = a[2] * b[0] - a[0] * b[2];
+    result[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+/// <summary>
+/// Scale a direction to unit length
+/// </summary>
+/// <returns>Length before scaling</returns>
+static inline FLOAT Normalize(FLOAT v[3])
+{
+    FLOAT length = sqrtf(Dot(v, v));
+    if (length > 0.0f)
+    {
+        v[0] /= length;
+        v[1] /= length;
+        v[2] /= length;
+    }
+    return length;
+}
+
+/// <summary>
+/// Constructor
+/// </summary>
+FloorEstimator::FloorEstimator()
+    : m_random(1)
+{
+    m_up[0] = 0.0f;
+    m_up[1] = 1.0f;
+    m_up[2] = 0.0f;
+
+    Reset();
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+FloorEstimator::~FloorEstimator()
+{
+}
+
+/// <summary>
+/// Forget the floor plane
+/// </summary>
+void FloorEstimator::Reset()
+{
+    m_plane.x = 0.0f;
+    m_plane.y = 0.0f;
+    m_plane.z = 0.0f;
+    m_plane.w = 0.0f;
+
+    m_valid       = false;
+    m_inlierCount = 0;
+    m_lostFrames  = 0;
+}
+
+/// <summary>
+/// Set the accelerometer reading used as the gravity prior
+/// </summary>
+/// <param name="reading">Gravity in camera space in units of g, as NuiAccelerometerGetCurrentReading returns it</param>
+void FloorEstimator::SetGravity(const Vector4& reading)
+{
+    FLOAT up[3] = { -reading.x, -reading.y, -reading.z };
+
+    // No reading yet, keep the previous direction
+    if (Normalize(up) < MINIMUM_READING)
+    {
+        return;
+    }
+
+    m_up[0] = up[0];
+    m_up[1] = up[1];
+    m_up[2] = up[2];
+}
+
+/// <summary>
+/// Get gravity in camera space. Taken from the floor normal when a floor is known
+/// </summary>
+/// <returns>Acceleration in meters per second squared</returns>
+Vector4 FloorEstimator::GetGravity() const
+{
+    Vector4 gravity;
+    if (m_valid)
+    {
+        gravity.x = -m_plane.x * STANDARD_GRAVITY;
+        gravity.y = -m_plane.y * STANDARD_GRAVITY;
+        gravity.z = -m_plane.z * STANDARD_GRAVITY;
+    }
+    else
+    {
+        gravity.x = -m_up[0] * STANDARD_GRAVITY;
+        gravity.y = -m_up[1] * STANDARD_GRAVITY;
+        gravity.z = -m_up[2] * STANDARD_GRAVITY;
+    }
+    gravity.w = 0.0f;
+
+    return gravity;
+}
+
+/// <summary>
+/// Get the height of a point above the floor
+/// </summary>
+/// <param name="point">Camera space point in meters</param>
+/// <returns>Height in meters, negative below the floor</returns>
+FLOAT FloorEstimator::GetHeight(const Vector4& point) const
+{
+    return m_plane.x * point.x + m_plane.y * point.y + m_plane.z * point.z + m_plane.w;
+}
+
+/// <summary>
+/// Update the floor plane with a depth frame
+/// </summary>
+/// <param name="pDepth">The pointer to depth pixels</param>
+/// <param name="pointCloud">Point cloud builder set to the resolution of the frame</param>
+/// <returns>True if a floor plane is known after the update</returns>
+bool FloorEstimator::Update(const NUI_DEPTH_IMAGE_PIXEL* pDepth, const PointCloudBuilder& pointCloud)
+{
+    if (!pDepth || 0 == pointCloud.GetWidth())
+    {
+        return m_valid;
+    }
+
+    SamplePoints(pDepth, pointCloud);
+
+    if (m_valid)
+    {
+        // Refine the tracked plane with the points near it instead of searching again
+        m_inlierCount = Accumulate(TRACK_DISTANCE);
+        if (m_inlierCount >= MINIMUM_INLIERS)
+        {
+            m_lostFrames = 0;
+            Solve();
+        }
+        else if (++m_lostFrames > LOST_FRAMES)
+        {
+            m_valid = false;
+        }
+
+        // A tilt of the sensor shows as a plane which no longer agrees with gravity
+        FLOAT normal[3] = { m_plane.x, m_plane.y, m_plane.z };
+        if (Dot(normal, m_up) < PRIOR_COSINE)
+        {
+            m_valid = false;
+        }
+    }
+
+    if (!m_valid)
+    {
+        m_valid      = Search();
+        m_lostFrames = 0;
+    }
+
+    return m_valid;
+}
+
+/// <summary>
+/// Convert a coarse grid of depth pixels to points below the camera
+/// </summary>
+void FloorEstimator::SamplePoints(const NUI_DEPTH_IMAGE_PIXEL* pDepth, const PointCloudBuilder& pointCloud)
+{
+    UINT width  = pointCloud.GetWidth();
+    UINT height = pointCloud.GetHeight();
+    UINT stepX  = width  > GRID_COLUMNS ? width  / GRID_COLUMNS : 1;
+    UINT stepY  = height > GRID_ROWS    ? height / GRID_ROWS    : 1;
+
+    m_x.clear();
+    m_y.clear();
+    m_z.clear();
+
+    for (UINT y = stepY / 2; y < height; y += stepY)
+    {
+        for (UINT x = stepX / 2; x < width; x += stepX)
+        {
+            USHORT depth = pDepth[y * width + x].depth;
+            if (depth < MINIMUM_SAMPLE_DEPTH || depth > MAXIMUM_SAMPLE_DEPTH)
+            {
+                continue;
+            }
+
+            Vector4 point = pointCloud.ToPoint(x, y, depth);
+            FLOAT   p[3]  = { point.x, point.y, point.z };
+
+            if (Dot(p, m_up) < -MINIMUM_CAMERA_HEIGHT)
+            {
+                m_x.push_back(point.x);
+                m_y.push_back(point.y);
+                m_z.push_back(point.z);
+            }
+        }
+    }
+}
+
+/// <summary>
+/// Search the sampled points for the level plane with the most support
+/// </summary>
+/// <returns>True if a plane was found</returns>
+bool FloorEstimator::Search()
+{
+    UINT count = (UINT)m_z.size();
+    if (count < MINIMUM_INLIERS)
+    {
+        m_inlierCount = 0;
+        return false;
+    }
+
+    FLOAT bestNormal[3] = { 0.0f, 0.0f, 0.0f };
+    FLOAT bestDistance  = 0.0f;
+    UINT  bestSupport   = 0;
+
+    for (UINT iteration = 0; iteration < SEARCH_ITERATIONS; iteration++)
+    {
+        UINT i = NextRandom() % count;
+        UINT j = NextRandom() % count;
+        UINT k = NextRandom() % count;
+        if (i == j || j == k || i == k)
+        {
+            continue;
+        }
+
+        FLOAT u[3] = { m_x[j] - m_x[i], m_y[j] - m_y[i], m_z[j] - m_z[i] };
+        FLOAT v[3] = { m_x[k] - m_x[i], m_y[k] - m_y[i], m_z[k] - m_z[i] };
+        FLOAT normal[3];
+        Cross(u, v, normal);
+
+        if (Normalize(normal) <= 0.0f)
+        {
+            continue;
+        }
+
+        // Only planes close to level are tried, with the normal pointing up
+        FLOAT level = Dot(normal, m_up);
+        if (level < 0.0f)
+        {
+            normal[0] = -normal[0];
+            normal[1] = -normal[1];
+            normal[2] = -normal[2];
+            level     = -level;
+        }
+        if (level < PRIOR_COSINE)
+        {
+            continue;
+        }
+
+        FLOAT distance = -(normal[0] * m_x[i] + normal[1] * m_y[i] + normal[2] * m_z[i]);
+        UINT  support  = 0;
+
+        for (UINT n = 0; n < count; n++)
+        {
+            FLOAT h = normal[0] * m_x[n] + normal[1] * m_y[n] + normal[2] * m_z[n] + distance;
+            if (fabsf(h) < INLIER_DISTANCE)
+            {
+                ++support;
+            }
+        }
+
+        // Of equally supported planes the lower one is the floor, tables are above it
+        if (support > bestSupport || (support == bestSupport && distance > bestDistance))
+        {
+            bestNormal[0] = normal[0];
+            bestNormal[1] = normal[1];
+            bestNormal[2] = normal[2];
+            bestDistance  = distance;
+            bestSupport   = support;
+        }
+    }
+
+    if (bestSupport < MINIMUM_INLIERS)
+    {
+        m_inlierCount = 0;
+        return false;
+    }
+
+    m_plane.x = bestNormal[0];
+    m_plane.y = bestNormal[1];
+    m_plane.z = bestNormal[2];
+    m_plane.w = bestDistance;
+
+    // Polish the hypothesis with a least squares fit over its support
+    Restart(bestNormal);
+    m_inlierCount = Accumulate(INLIER_DISTANCE);
+    Solve();
+
+    return true;
+}
+
+/// <summary>
+/// Start new fit sums in a frame whose normal axis is the given plane normal
+/// </summary>
+void FloorEstimator::Restart(const FLOAT normal[3])
+{
+    m_axisN[0] = normal[0];
+    m_axisN[1] = normal[1];
+    m_axisN[2] = normal[2];
+
+    // Any direction not parallel to the normal gives the first in-plane axis
+    FLOAT side[3] = { 1.0f, 0.0f, 0.0f };
+    if (fabsf(normal[0]) > 0.9f)
+    {
+        side[0] = 0.0f;
+        side[2] = 1.0f;
+    }
+
+    Cross(side, m_axisN, m_axisA);
+    Normalize(m_axisA);
+    Cross(m_axisN, m_axisA, m_axisB);
+
+    m_sumW  = 0.0;
+    m_sumA  = 0.0;
+    m_sumB  = 0.0;
+    m_sumH  = 0.0;
+    m_sumAA = 0.0;
+    m_sumAB = 0.0;
+    m_sumBB = 0.0;
+    m_sumAH = 0.0;
+    m_sumBH = 0.0;
+}
+
+/// <summary>
+/// Fade the fit sums and add the sampled points near the current plane
+/// </summary>
+/// <param name="distance">Largest distance from the plane in meters</param>
+/// <returns>Number of points added</returns>
+UINT FloorEstimator::Accumulate(FLOAT distance)
+{
+    m_sumW  *= FORGETTING_FACTOR;
+    m_sumA  *= FORGETTING_FACTOR;
+    m_sumB  *= FORGETTING_FACTOR;
+    m_sumH  *= FORGETTING_FACTOR;
+    m_sumAA *= FORGETTING_FACTOR;
+    m_sumAB *= FORGETTING_FACTOR;
+    m_sumBB *= FORGETTING_FACTOR;
+    m_sumAH *= FORGETTING_FACTOR;
+    m_sumBH *= FORGETTING_FACTOR;
+
+    UINT count = (UINT)m_z.size();
+    UINT added = 0;
+
+    for (UINT n = 0; n < count; n++)
+    {
+        FLOAT p[3] = { m_x[n], m_y[n], m_z[n] };
+
+        FLOAT h = m_plane.x * p[0] + m_plane.y * p[1] + m_plane.z * p[2] + m_plane.w;
+        if (fabsf(h) >= distance)
+        {
+            continue;
+        }
+
+        double a = Dot(p, m_axisA);
+        double b = Dot(p, m_axisB);
+        double c = Dot(p, m_axisN);
+
+        m_sumW  += 1.0;
+        m_sumA  += a;
+        m_sumB  += b;
+        m_sumH  += c;
+        m_sumAA += a * a;
+        m_sumAB += a * b;
+        m_sumBB += b * b;
+        m_sumAH += a * c;
+        m_sumBH += b * c;
+        ++added;
+    }
+
+    return added;
+}
+
+/// <summary>
+/// Solve the fit sums for the plane
+/// </summary>
+/// <returns>True if the sums determine a plane</returns>
+bool FloorEstimator::Solve()
+{
+    // Height along the normal axis is fitted as h = c0 + c1 a + c2 b by Cramer's rule
+    double m00 = m_sumW, m01 = m_sumA,  m02 = m_sumB;
+    double m11 = m_sumAA, m12 = m_sumAB;
+    double m22 = m_sumBB;
+
+    double det = m00 * (m11 * m22 - m12 * m12)
+               - m01 * (m01 * m22 - m12 * m02)
+               + m02 * (m01 * m12 - m11 * m02);
+    if (fabs(det) < 1e-12)
+    {
+        return false;
+    }
+
+    double c0 = (m_sumH  * (m11 * m22 - m12 * m12)
+               - m01 * (m_sumAH * m22 - m12 * m_sumBH)
+               + m02 * (m_sumAH * m12 - m11 * m_sumBH)) / det;
+    double c1 = (m00 * (m_sumAH * m22 - m12 * m_sumBH)
+               - m_sumH * (m01 * m22 - m12 * m02)
+               + m02 * (m01 * m_sumBH - m_sumAH * m02)) / det;
+    double c2 = (m00 * (m11 * m_sumBH - m_sumAH * m12)
+               - m01 * (m01 * m_sumBH - m_sumAH * m02)
+               + m_sumH * (m01 * m12 - m11 * m02)) / det;
+
+    // h - c1 a - c2 b - c0 = 0 in camera space
+    FLOAT normal[3];
+    for (int i = 0; i < 3; i++)
+    {
+        normal[i] = (FLOAT)(m_axisN[i] - c1 * m_axisA[i] - c2 * m_axisB[i]);
+    }
+
+    FLOAT length = Normalize(normal);
+
+    m_plane.x = normal[0];
+    m_plane.y = normal[1];
+    m_plane.z = normal[2];
+    m_plane.w = (FLOAT)(-c0 / length);
+
+    return true;
+}
+
+/// <summary>
+/// Next value of the pseudo random sequence used by the search
+/// </summary>
+UINT FloorEstimator::NextRandom()
+{
+    m_random = m_random * 1664525u + 1013904223u;
+    return m_random >> 8;
+}
+
+/// <summary>
+/// Clear the mask bits of pixels on or below the floor
+/// </summary>
+/// <param name="mask">Mask to clear floor pixels in</param>
+/// <param name="pDepth">The pointer to depth pixels</param>
+/// <param name="pointCloud">Point cloud builder set to the resolution of the frame</param>
+void FloorEstimator::RejectFloor(PackedBitmask& mask, const NUI_DEPTH_IMAGE_PIXEL* pDepth, const PointCloudBuilder& pointCloud) const
+{
+    UINT width  = mask.GetWidth();
+    UINT height = mask.GetHeight();
+
+    if (!m_valid || !pDepth || width != pointCloud.GetWidth() || height != pointCloud.GetHeight())
+    {
+        return;
+    }
+
+    // Rays are linear in the pixel position, so the height of a pixel per meter of depth is too
+    Vector4 origin = pointCloud.ToPoint(0, 0, 1000);
+    Vector4 right  = pointCloud.ToPoint(1, 0, 1000);
+    Vector4 down   = pointCloud.ToPoint(0, 1, 1000);
+
+    FLOAT base  = GetHeight(origin) - m_plane.w;
+    FLOAT stepX = GetHeight(right)  - m_plane.w - base;
+    FLOAT stepY = GetHeight(down)   - m_plane.w - base;
+
+    for (UINT y = 0; y < height; y++)
+    {
+        ULONGLONG*                   pRow      = mask.GetRow(y);
+        const NUI_DEPTH_IMAGE_PIXEL* pDepthRow = pDepth + y * width;
+        FLOAT                        rowBase   = base + y * stepY;
+
+        for (UINT w = 0; w < mask.GetWordsPerRow(); w++)
+        {
+            ULONGLONG bits  = pRow[w];
+            ULONGLONG floorBits = 0;
+
+            for (UINT bit = 0; bits; bit++, bits >>= 1)
+            {
+                if (0 == (bits & 1))
+                {
+                    continue;
+                }
+
+                UINT  x      = w * BITS_PER_MASK_WORD + bit;
+                FLOAT meters = pDepthRow[x].depth * MILLIMETERS_TO_METERS;
+                if (meters * (rowBase + x * stepX) + m_plane.w < FLOOR_MARGIN)
+                {
+                    floorBits |= 1ULL << bit;
+                }
+            }
+
+            pRow[w] &= ~floorBits;
+        }
+    }
+}
@@ -0,0 +1,161 @@
+//------------------------------------------------------------------------------
+// <copyright file="FloorEstimator.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include "NuiTypes.h"
+#include "PackedBitmask.h"
+#include "PointCloudBuilder.h"
+
+/// <summary>
+/// Finds and tracks the floor plane in depth frames. The accelerometer gives the
+/// up direction, so a RANSAC search over a coarse grid of depth points only tries
+/// planes close to level. Once found, the plane is tracked by a least squares fit
+/// whose sums are kept across frames with a forgetting factor, so each frame only
+/// adds the grid points near the current plane. The search runs again when the
+/// floor is lost or the plane no longer agrees with gravity.
+/// </summary>
+class FloorEstimator
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    FloorEstimator();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~FloorEstimator();
+
+public:
+    /// <summary>
+    /// Set the accelerometer reading used as the gravity prior
+    /// </summary>
+    /// <param name="reading">Gravity in camera space in units of g, as NuiAccelerometerGetCurrentReading returns it</param>
+    void SetGravity(const Vector4& reading);
+
+    /// <summary>
+    /// Update the floor plane with a depth frame
+    /// </summary>
+    /// <param name="pDepth">The pointer to depth pixels</param>
+    /// <param name="pointCloud">Point cloud builder set to the resolution of the frame</param>
+    /// <returns>True if a floor plane is known after the update</returns>
+    bool Update(const NUI_DEPTH_IMAGE_PIXEL* pDepth, const PointCloudBuilder& pointCloud);
+
+    /// <summary>
+    /// Forget the floor plane
+    /// </summary>
+    void Reset();
+
+    /// <summary>
+    /// Indicates whether a floor plane is known
+    /// </summary>
+    bool IsValid() const
+    {
+        return m_valid;
+    }
+
+    /// <summary>
+    /// Get the floor plane
+    /// </summary>
+    /// <returns>Plane Ax + By + Cz + D = 0 with unit normal (A, B, C) pointing up, as the skeleton floor clip plane</returns>
+    const Vector4& GetPlane() const
+    {
+        return m_plane;
+    }
+
+    /// <summary>
+    /// Get gravity in camera space. Taken from the floor normal when a floor is known
+    /// </summary>
+    /// <returns>Acceleration in meters per second squared</returns>
+    Vector4 GetGravity() const;
+
+    /// <summary>
+    /// Get the height of a point above the floor
+    /// </summary>
+    /// <param name="point">Camera space point in meters</param>
+    /// <returns>Height in meters, negative below the floor</returns>
+    FLOAT GetHeight(const Vector4& point) const;
+
+    /// <summary>
+    /// Get number of grid points that supported the plane in the last update
+    /// </summary>
+    UINT GetInlierCount() const
+    {
+        return m_inlierCount;
+    }
+
+    /// <summary>
+    /// Clear the mask bits of pixels on or below the floor
+    /// </summary>
+    /// <param name="mask">Mask to clear floor pixels in</param>
+    /// <param name="pDepth">The pointer to depth pixels</param>
+    /// <param name="pointCloud">Point cloud builder set to the resolution of the frame</param>
+    void RejectFloor(PackedBitmask& mask, const NUI_DEPTH_IMAGE_PIXEL* pDepth, const PointCloudBuilder& pointCloud) const;
+
+private:
+    /// <summary>
+    /// Convert a coarse grid of depth pixels to points below the camera
+    /// </summary>
+    void SamplePoints(const NUI_DEPTH_IMAGE_PIXEL* pDepth, const PointCloudBuilder& pointCloud);
+
+    /// <summary>
+    /// Search the sampled points for the level plane with the most support
+    /// </summary>
+    /// <returns>True if a plane was found</returns>
+    bool Search();
+
+    /// <summary>
+    /// Start new fit sums in a frame whose normal axis is the given plane normal
+    /// </summary>
+    void Restart(const FLOAT normal[3]);
+
+    /// <summary>
+    /// Fade the fit sums and add the sampled points near the current plane
+    /// </summary>
+    /// <param name="distance">Largest distance from the plane in meters</param>
+    /// <returns>Number of points added</returns>
+    UINT Accumulate(FLOAT distance);
+
+    /// <summary>
+    /// Solve the fit sums for the plane
+    /// </summary>
+    /// <returns>True if the sums determine a plane</returns>
+    bool Solve();
+
+    /// <summary>
+    /// Next value of the pseudo random sequence used by the search
+    /// </summary>
+    UINT NextRandom();
+
+private:
+    FLOAT   m_up[3];            // Up direction from the accelerometer
+    FLOAT   m_axisA[3];         // Fit frame, two directions in the plane and its normal
+    FLOAT   m_axisB[3];
+    FLOAT   m_axisN[3];
+
+    double  m_sumW;             // Weighted sums of height h over plane coordinates a and b
+    double  m_sumA;
+    double  m_sumB;
+    double  m_sumH;
+    double  m_sumAA;
+    double  m_sumAB;
+    double  m_sumBB;
+    double  m_sumAH;
+    double  m_sumBH;
+
+    Vector4 m_plane;
+    bool    m_valid;
+    UINT    m_inlierCount;
+    UINT    m_lostFrames;
+    UINT    m_random;
+
+    std::vector<FLOAT>  m_x;
+    std::vector<FLOAT>  m_y;
+    std::vector<FLOAT>  m_z;
+};
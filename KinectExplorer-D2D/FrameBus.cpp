@@ -0,0 +1,473 @@
+//------------------------------------------------------------------------------
+// <copyright file="FrameBus.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include <atomic>
+#include <cstring>
+#include "FrameBus.h"
+
+#define FRAME_BUS_MAGIC     0x53554246  // "FBUS" in memory order
+#define FRAME_BUS_VERSION   1
+#define CACHE_LINE_SIZE     64
+
+/// <summary>
+/// Reader table entry, one cache line so readers do not share lines
+/// </summary>
+struct FrameBusReaderEntry
+{
+    std::atomic<UINT>       active;
+    std::atomic<ULONGLONG>  position;       // Sequence of the last frame taken
+    std::atomic<ULONGLONG>  overwritten;
+    BYTE                    padding[CACHE_LINE_SIZE - 24];
+};
+
+/// <summary>
+/// Start of the shared region. The slots follow it
+/// </summary>
+struct FrameBusHeader
+{
+    UINT                    magic;
+    UINT                    version;
+    UINT                    slotCount;
+    UINT                    slotSize;       // Largest frame in bytes
+    ULONGLONG               slotStride;     // Bytes from one slot to the next
+    BYTE                    padding0[CACHE_LINE_SIZE - 24];
+    std::atomic<ULONGLONG>  published;      // Sequence of the newest complete frame, zero before the first
+    BYTE                    padding1[CACHE_LINE_SIZE - 8];
+    FrameBusReaderEntry     readers[FRAME_BUS_MAX_READERS];
+};
+
+/// <summary>
+/// Slot header. The frame data starts on the next cache line
+/// </summary>
+struct FrameBusSlot
+{
+    std::atomic<ULONGLONG>  stamp;          // Twice the sequence when complete, odd while written
+    FrameBusFrameInfo       info;
+};
+
+static_assert(sizeof(FrameBusReaderEntry) == CACHE_LINE_SIZE, "Reader entry must fill one cache line");
+static_assert(sizeof(FrameBusSlot) <= CACHE_LINE_SIZE, "Slot header must fit one cache line");
+
+/// <summary>
+/// Round a size up to whole cache lines
+/// </summary>
+static inline ULONGLONG AlignToCacheLine(ULONGLONG size)
+{
+    return (size + CACHE_LINE_SIZE - 1) & ~(ULONGLONG)(CACHE_LINE_SIZE - 1);
+}
+
+/// <summary>
+/// Find the slot holding a sequence
+/// </summary>
+static inline FrameBusSlot* GetSlot(FrameBusHeader* pHeader, ULONGLONG sequence)
+{
+    BYTE* pSlots = (BYTE*)pHeader + AlignToCacheLine(sizeof(FrameBusHeader));
+    return (FrameBusSlot*)(pSlots + (sequence % pHeader->slotCount) * pHeader->slotStride);
+}
+
+/// <summary>
+/// Get the frame data of a slot
+/// </summary>
+static inline BYTE* GetSlotData(FrameBusSlot* pSlot)
+{
+    return (BYTE*)pSlot + CACHE_LINE_SIZE;
+}
+
+/// <summary>
+/// Constructor
+/// </summary>
+FrameBusWriter::FrameBusWriter()
+    : m_pHeader(nullptr)
+    , m_pWriting(nullptr)
+    , m_published(0)
+{
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+FrameBusWriter::~FrameBusWriter()
+{
+    Close();
+}
+
+/// <summary>
+/// Create the bus
+/// </summary>
+/// <param name="name">Bus name shared with readers</param>
+/// <param name="slotCount">Number of frame slots</param>
+/// <param name="slotSize">Largest frame in bytes</param>
+/// <returns>Indicates success or failure</returns>
+HRESULT FrameBusWriter::Create(const char* name, UINT slotCount, UINT slotSize)
+{
+    Close();
+
+    // A reader needs one slot to read while the writer fills another
+    if (slotCount < 2 || 0 == slotSize)
+    {
+        return E_INVALIDARG;
+    }
+
+    ULONGLONG stride = CACHE_LINE_SIZE + AlignToCacheLine(slotSize);
+    ULONGLONG total  = AlignToCacheLine(sizeof(FrameBusHeader)) + stride * slotCount;
+
+    HRESULT hr = m_memory.Create(name, (size_t)total);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    // The region is zero filled, so every stamp and reader entry starts cleared
+    m_pHeader = (FrameBusHeader*)m_memory.GetData();
+    m_pHeader->version    = FRAME_BUS_VERSION;
+    m_pHeader->slotCount  = slotCount;
+    m_pHeader->slotSize   = slotSize;
+    m_pHeader->slotStride = stride;
+    m_pHeader->published.store(0, std::memory_order_relaxed);
+
+    // Readers check the magic last, after the layout is in place
+    std::atomic_thread_fence(std::memory_order_release);
+    m_pHeader->magic = FRAME_BUS_MAGIC;
+
+    m_published = 0;
+    return S_OK;
+}
+
+/// <summary>
+/// Remove the bus. Readers keep the frames they mapped
+/// </summary>
+void FrameBusWriter::Close()
+{
+    m_memory.Close();
+    m_pHeader  = nullptr;
+    m_pWriting = nullptr;
+}
+
+/// <summary>
+/// Start writing the next frame in place
+/// </summary>
+/// <param name="info">Frame metadata</param>
+/// <returns>The pointer to the slot to write the frame data to, nullptr if closed or the frame is too large</returns>
+BYTE* FrameBusWriter::BeginFrame(const FrameBusFrameInfo& info)
+{
+    if (!m_pHeader || info.size > m_pHeader->slotSize)
+    {
+        return nullptr;
+    }
+
+    ULONGLONG sequence = m_published + 1;
+
+    // Mark the slot as being written before any of its bytes change
+    m_pWriting = GetSlot(m_pHeader, sequence);
+    m_pWriting->stamp.store(sequence * 2 - 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    m_pWriting->info = info;
+    return GetSlotData(m_pWriting);
+}
+
+/// <summary>
+/// Publish the frame started by BeginFrame
+/// </summary>
+void FrameBusWriter::EndFrame()
+{
+    if (!m_pWriting)
+    {
+        return;
+    }
+
+    ++m_published;
+    m_pWriting->stamp.store(m_published * 2, std::memory_order_release);
+    m_pHeader->published.store(m_published, std::memory_order_release);
+    m_pWriting = nullptr;
+}
+
+/// <summary>
+/// Copy a frame into the next slot and publish it
+/// </summary>
+/// <param name="info">Frame metadata</param>
+/// <param name="pData">The pointer to frame data of info.size bytes</param>
+/// <returns>S_OK if published, S_FALSE if closed or no reader is registered, or a failure code</returns>
+HRESULT FrameBusWriter::Publish(const FrameBusFrameInfo& info, const void* pData)
+{
+    // Nobody would see the frame, so it is not copied. A reader starts at the next published frame anyway
+    if (!HasReaders())
+    {
+        return S_FALSE;
+    }
+
+    BYTE* pSlotData = BeginFrame(info);
+    if (!pSlotData)
+    {
+        return E_INVALIDARG;
+    }
+
+    memcpy(pSlotData, pData, info.size);
+    EndFrame();
+    return S_OK;
+}
+
+/// <summary>
+/// Indicates whether any reader is registered
+/// </summary>
+bool FrameBusWriter::HasReaders() const
+{
+    if (!m_pHeader)
+    {
+        return false;
+    }
+
+    for (UINT i = 0; i < FRAME_BUS_MAX_READERS; i++)
+    {
+        if (m_pHeader->readers[i].active.load(std::memory_order_relaxed))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/// <summary>
+/// Get how far a registered reader is behind
+/// </summary>
+/// <param name="reader">Reader table index, less than FRAME_BUS_MAX_READERS</param>
+/// <param name="lag">Receives published frames the reader has not taken</param>
+/// <param name="overwritten">Receives frames the reader lost to overwriting</param>
+/// <returns>False if no reader uses the entry</returns>
+bool FrameBusWriter::GetReaderStatus(UINT reader, ULONGLONG& lag, ULONGLONG& overwritten) const
+{
+    lag         = 0;
+    overwritten = 0;
+
+    if (!m_pHeader || reader >= FRAME_BUS_MAX_READERS)
+    {
+        return false;
+    }
+
+    const FrameBusReaderEntry& entry = m_pHeader->readers[reader];
+    if (!entry.active.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+
+    ULONGLONG position = entry.position.load(std::memory_order_relaxed);
+    lag         = m_published > position ? m_published - position : 0;
+    overwritten = entry.overwritten.load(std::memory_order_relaxed);
+    return true;
+}
+
+/// <summary>
+/// Constructor
+/// </summary>
+FrameBusReader::FrameBusReader()
+    : m_pHeader(nullptr)
+    , m_reader(-1)
+    , m_next(1)
+    , m_overwritten(0)
+{
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+FrameBusReader::~FrameBusReader()
+{
+    Close();
+}
+
+/// <summary>
+/// Map a bus and register as a reader. Reading starts at the next published frame
+/// </summary>
+/// <param name="name">Bus name given to the writer</param>
+/// <returns>Indicates success or failure. Fails if the reader table is full</returns>
+HRESULT FrameBusReader::Open(const char* name)
+{
+    Close();
+
+    HRESULT hr = m_memory.Open(name);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    FrameBusHeader* pHeader = (FrameBusHeader*)m_memory.GetData();
+    if (m_memory.GetSize() < sizeof(FrameBusHeader) || FRAME_BUS_MAGIC != pHeader->magic)
+    {
+        Close();
+        return E_FAIL;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    ULONGLONG total = AlignToCacheLine(sizeof(FrameBusHeader)) + pHeader->slotStride * pHeader->slotCount;
+    if (FRAME_BUS_VERSION != pHeader->version || pHeader->slotCount < 2 || m_memory.GetSize() < total)
+    {
+        Close();
+        return E_FAIL;
+    }
+
+    // The writer only publishes while it sees a reader, so an unregistered reader would starve
+    for (UINT i = 0; i < FRAME_BUS_MAX_READERS; i++)
+    {
+        UINT expected = 0;
+        if (pHeader->readers[i].active.compare_exchange_strong(expected, 1))
+        {
+            m_reader = (int)i;
+            break;
+        }
+    }
+
+    if (m_reader < 0)
+    {
+        Close();
+        return E_FAIL;
+    }
+
+    m_pHeader     = pHeader;
+    m_next        = m_pHeader->published.load(std::memory_order_acquire) + 1;
+    m_overwritten = 0;
+    PublishPosition();
+
+    return S_OK;
+}
+
+/// <summary>
+/// Unregister and unmap the bus
+/// </summary>
+void FrameBusReader::Close()
+{
+    if (m_pHeader && m_reader >= 0)
+    {
+        m_pHeader->readers[m_reader].active.store(0, std::memory_order_release);
+    }
+
+    m_memory.Close();
+    m_pHeader = nullptr;
+    m_reader  = -1;
+}
+
+/// <summary>
+/// Take the next frame
+/// </summary>
+/// <param name="frame">Receives the frame</param>
+/// <returns>S_OK if there is a frame, S_FALSE if no new frame was published, or a failure code</returns>
+HRESULT FrameBusReader::Acquire(FrameBusFrame& frame)
+{
+    if (!m_pHeader)
+    {
+        return E_FAIL;
+    }
+
+    while (true)
+    {
+        ULONGLONG published = m_pHeader->published.load(std::memory_order_acquire);
+        if (m_next > published)
+        {
+            return S_FALSE;
+        }
+
+        // A whole ring behind, everything older than the ring is gone
+        if (published - m_next >= m_pHeader->slotCount)
+        {
+            ULONGLONG oldest = published - m_pHeader->slotCount + 1;
+            m_overwritten += oldest - m_next;
+            m_next         = oldest;
+        }
+
+        FrameBusSlot* pSlot = GetSlot(m_pHeader, m_next);
+        ULONGLONG     stamp = pSlot->stamp.load(std::memory_order_acquire);
+
+        frame.info     = pSlot->info;
+        frame.pData    = GetSlotData(pSlot);
+        frame.sequence = m_next;
+
+        // The metadata is only trusted if the stamp did not move while it was copied
+        std::atomic_thread_fence(std::memory_order_acquire);
+        bool intact = stamp == m_next * 2 && pSlot->stamp.load(std::memory_order_relaxed) == stamp;
+
+        ++m_next;
+
+        if (intact)
+        {
+            PublishPosition();
+            return S_OK;
+        }
+
+        // The writer lapped us on this slot, try the next frame
+        ++m_overwritten;
+    }
+}
+
+/// <summary>
+/// Finish with a frame
+/// </summary>
+/// <param name="frame">Frame from Acquire</param>
+/// <returns>True if the frame was not overwritten while in use</returns>
+bool FrameBusReader::Release(const FrameBusFrame& frame)
+{
+    if (!m_pHeader)
+    {
+        return false;
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    FrameBusSlot* pSlot = GetSlot(m_pHeader, frame.sequence);
+    if (pSlot->stamp.load(std::memory_order_relaxed) == frame.sequence * 2)
+    {
+        return true;
+    }
+
+    ++m_overwritten;
+    PublishPosition();
+    return false;
+}
+
+/// <summary>
+/// Skip all but the newest published frame, for readers which only show the latest
+/// </summary>
+void FrameBusReader::SkipToLatest()
+{
+    if (!m_pHeader)
+    {
+        return;
+    }
+
+    ULONGLONG published = m_pHeader->published.load(std::memory_order_acquire);
+    if (published > m_next)
+    {
+        m_next = published;
+        PublishPosition();
+    }
+}
+
+/// <summary>
+/// Get published frames not taken yet
+/// </summary>
+ULONGLONG FrameBusReader::GetLag() const
+{
+    if (!m_pHeader)
+    {
+        return 0;
+    }
+
+    ULONGLONG published = m_pHeader->published.load(std::memory_order_acquire);
+    return published >= m_next ? published - m_next + 1 : 0;
+}
+
+/// <summary>
+/// Update the reader table entry
+/// </summary>
+void FrameBusReader::PublishPosition()
+{
+    if (m_reader < 0)
+    {
+        return;
+    }
+
+    FrameBusReaderEntry& entry = m_pHeader->readers[m_reader];
+    entry.position.store(m_next - 1, std::memory_order_relaxed);
+    entry.overwritten.store(m_overwritten, std::memory_order_relaxed);
+}
@@ -0,0 +1,211 @@
+//------------------------------------------------------------------------------
+// <copyright file="FrameBus.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include "NuiTypes.h"
+#include "SharedMemory.h"
+
+#define FRAME_BUS_MAX_READERS   8
+
+/// <summary>
+/// Kind of frame held in a frame bus slot
+/// </summary>
+enum FrameBusFrameType
+{
+    FrameBusDepth    = 1,   // NUI_DEPTH_IMAGE_PIXEL rows
+    FrameBusColor    = 2,   // 32 bit BGRX rows
+    FrameBusSkeleton = 3    // One NUI_SKELETON_FRAME
+};
+
+/// <summary>
+/// Metadata stored with every frame
+/// </summary>
+struct FrameBusFrameInfo
+{
+    UINT        type;           // FrameBusFrameType
+    UINT        width;          // Pixels, zero for frames which are not images
+    UINT        height;
+    UINT        stride;         // Bytes per row
+    UINT        size;           // Bytes of frame data
+    UINT        frameNumber;    // Sensor frame number
+    LONGLONG    timestamp;      // Sensor frame time, milliseconds
+};
+
+/// <summary>
+/// Frame handed to a reader. The data points into the shared slot
+/// </summary>
+struct FrameBusFrame
+{
+    FrameBusFrameInfo   info;
+    const BYTE*         pData;
+    ULONGLONG           sequence;   // Publish order, starting at one
+};
+
+struct FrameBusHeader;
+struct FrameBusSlot;
+
+/// <summary>
+/// Producer side of a frame bus: a ring of fixed size frame slots in shared memory.
+/// One writer fills slots in place and publishes them by sequence number, without
+/// locks and without waiting for readers. Each slot carries a sequence stamp that is
+/// odd while it is written, so readers can tell whether a frame was overwritten
+/// under them. Readers register in a table in the header, where the writer can see
+/// how far behind each one is. While the table is empty, publishing copies nothing.
+/// </summary>
+class FrameBusWriter
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    FrameBusWriter();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~FrameBusWriter();
+
+public:
+    /// <summary>
+    /// Create the bus
+    /// </summary>
+    /// <param name="name">Bus name shared with readers</param>
+    /// <param name="slotCount">Number of frame slots</param>
+    /// <param name="slotSize">Largest frame in bytes</param>
+    /// <returns>Indicates success or failure</returns>
+    HRESULT Create(const char* name, UINT slotCount, UINT slotSize);
+
+    /// <summary>
+    /// Remove the bus. Readers keep the frames they mapped
+    /// </summary>
+    void Close();
+
+    /// <summary>
+    /// Indicates whether the bus is created
+    /// </summary>
+    bool IsOpen() const
+    {
+        return nullptr != m_pHeader;
+    }
+
+    /// <summary>
+    /// Start writing the next frame in place
+    /// </summary>
+    /// <param name="info">Frame metadata</param>
+    /// <returns>The pointer to the slot to write the frame data to, nullptr if closed or the frame is too large</returns>
+    BYTE* BeginFrame(const FrameBusFrameInfo& info);
+
+    /// <summary>
+    /// Publish the frame started by BeginFrame
+    /// </summary>
+    void EndFrame();
+
+    /// <summary>
+    /// Copy a frame into the next slot and publish it
+    /// </summary>
+    /// <param name="info">Frame metadata</param>
+    /// <param name="pData">The pointer to frame data of info.size bytes</param>
+    /// <returns>S_OK if published, S_FALSE if closed or no reader is registered, or a failure code</returns>
+    HRESULT Publish(const FrameBusFrameInfo& info, const void* pData);
+
+    /// <summary>
+    /// Indicates whether any reader is registered
+    /// </summary>
+    bool HasReaders() const;
+
+    /// <summary>
+    /// Get how far a registered reader is behind
+    /// </summary>
+    /// <param name="reader">Reader table index, less than FRAME_BUS_MAX_READERS</param>
+    /// <param name="lag">Receives published frames the reader has not taken</param>
+    /// <param name="overwritten">Receives frames the reader lost to overwriting</param>
+    /// <returns>False if no reader uses the entry</returns>
+    bool GetReaderStatus(UINT reader, ULONGLONG& lag, ULONGLONG& overwritten) const;
+
+private:
+    SharedMemory    m_memory;
+    FrameBusHeader* m_pHeader;
+    FrameBusSlot*   m_pWriting;     // Slot between BeginFrame and EndFrame
+    ULONGLONG       m_published;
+};
+
+/// <summary>
+/// Consumer side of a frame bus. Frames are read in place, in publish order. A reader
+/// which falls a whole ring behind skips to the oldest intact frame and counts the
+/// frames it lost. Release tells whether a frame stayed intact while it was used.
+/// </summary>
+class FrameBusReader
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    FrameBusReader();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~FrameBusReader();
+
+public:
+    /// <summary>
+    /// Map a bus and register as a reader. Reading starts at the next published frame
+    /// </summary>
+    /// <param name="name">Bus name given to the writer</param>
+    /// <returns>Indicates success or failure. Fails if the reader table is full</returns>
+    HRESULT Open(const char* name);
+
+    /// <summary>
+    /// Unregister and unmap the bus
+    /// </summary>
+    void Close();
+
+    /// <summary>
+    /// Take the next frame
+    /// </summary>
+    /// <param name="frame">Receives the frame</param>
+    /// <returns>S_OK if there is a frame, S_FALSE if no new frame was published, or a failure code</returns>
+    HRESULT Acquire(FrameBusFrame& frame);
+
+    /// <summary>
+    /// Finish with a frame
+    /// </summary>
+    /// <param name="frame">Frame from Acquire</param>
+    /// <returns>True if the frame was not overwritten while in use</returns>
+    bool Release(const FrameBusFrame& frame);
+
+    /// <summary>
+    /// Skip all but the newest published frame, for readers which only show the latest
+    /// </summary>
+    void SkipToLatest();
+
+    /// <summary>
+    /// Get published frames not taken yet
+    /// </summary>
+    ULONGLONG GetLag() const;
+
+    /// <summary>
+    /// Get frames lost to overwriting
+    /// </summary>
+    ULONGLONG GetOverwrittenCount() const
+    {
+        return m_overwritten;
+    }
+
+private:
+    /// <summary>
+    /// Update the reader table entry
+    /// </summary>
+    void PublishPosition();
+
+private:
+    SharedMemory    m_memory;
+    FrameBusHeader* m_pHeader;
+    int             m_reader;       // Reader table index, -1 while closed
+    ULONGLONG       m_next;         // Sequence of the next frame to take
+    ULONGLONG       m_overwritten;
+};
@@ -0,0 +1,491 @@
+//------------------------------------------------------------------------------
+// <copyright file="HoughCircleDetector.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include "HoughCircleDetector.h"
+
+#define DEFAULT_EDGE_STEP       40      // Millimeters
+#define DEFAULT_MINIMUM_SUPPORT 0.22f   // Half hidden balls show less than half their rim
+#define UNKNOWN_DEPTH           8000    // Pixels without depth count as far away
+#define MINIMUM_RADIUS          2.0f    // Pixels, smaller circles have too few rim pixels
+#define MINIMUM_CELL_VOTES      3
+#define SUPPORT_SPREAD          0.1f    // Votes of large circles scatter over about a tenth of the radius
+#define RADIUS_FRACTION         16.0f   // Radius sums are kept in 1/16 pixel
+#define MINIMUM_ROWS_PER_BAND   16
+#define MILLIMETERS_TO_METERS   0.001f
+#define PI                      3.14159265f
+
+/// <summary>
+/// Order circles by decreasing support
+/// </summary>
+static bool StrongerCircle(const CircleDetection& a, const CircleDetection& b)
+{
+    return a.support > b.support;
+}
+
+/// <summary>
+/// Constructor
+/// </summary>
+HoughCircleDetector::HoughCircleDetector()
+    : m_edgeStep(DEFAULT_EDGE_STEP)
+    , m_minimumSupport(DEFAULT_MINIMUM_SUPPORT)
+    , m_pMask(nullptr)
+    , m_pDepth(nullptr)
+    , m_pScaleTable(nullptr)
+    , m_width(0)
+    , m_height(0)
+    , m_cellsX(0)
+    , m_cellsY(0)
+    , m_tilesX(0)
+    , m_tilesY(0)
+    , m_bandCount(0)
+    , m_rowsPerBand(0)
+    , m_voteCount(0)
+    , m_pParallel(nullptr)
+{
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+HoughCircleDetector::~HoughCircleDetector()
+{
+}
+
+/// <summary>
+/// Set the smallest depth step treated as an edge
+/// </summary>
+/// <param name="step">Depth step in millimeters</param>
+void HoughCircleDetector::SetEdgeStep(USHORT step)
+{
+    m_edgeStep = step;
+}
+
+/// <summary>
+/// Set the smallest share of the circumference that must vote for a circle
+/// </summary>
+/// <param name="support">Ratio, 0.5 accepts half hidden balls</param>
+void HoughCircleDetector::SetMinimumSupport(FLOAT support)
+{
+    m_minimumSupport = support;
+}
+
+/// <summary>
+/// Set the pool the bands vote on
+/// </summary>
+/// <param name="pParallel">The pointer to the pool shared with other stages, nullptr to vote on the calling thread</param>
+void HoughCircleDetector::SetParallelBands(ParallelBands* pParallel)
+{
+    m_pParallel = pParallel;
+}
+
+/// <summary>
+/// Size the accumulators for a frame size
+/// </summary>
+void HoughCircleDetector::Resize(UINT width, UINT height)
+{
+    // Split rows into bands like the blob labeler, each band votes into its own accumulator
+    UINT bandCount = ParallelBands::GetThreadCount(m_pParallel);
+    if (bandCount * MINIMUM_ROWS_PER_BAND > height)
+    {
+        bandCount = (height + MINIMUM_ROWS_PER_BAND - 1) / MINIMUM_ROWS_PER_BAND;
+    }
+
+    if (width == m_width && height == m_height && bandCount == m_bandCount)
+    {
+        return;
+    }
+
+    m_width       = width;
+    m_height      = height;
+    m_bandCount   = bandCount;
+    m_rowsPerBand = (height + bandCount - 1) / bandCount;
+
+    UINT tileSize = 1 << HOUGH_TILE_SHIFT;
+    m_cellsX = (width  + (1 << HOUGH_CELL_SHIFT) - 1) >> HOUGH_CELL_SHIFT;
+    m_cellsY = (height + (1 << HOUGH_CELL_SHIFT) - 1) >> HOUGH_CELL_SHIFT;
+    m_tilesX = (m_cellsX + tileSize - 1) >> HOUGH_TILE_SHIFT;
+    m_tilesY = (m_cellsY + tileSize - 1) >> HOUGH_TILE_SHIFT;
+
+    UINT tileCount = m_tilesX * m_tilesY;
+    UINT cellCount = tileCount * HOUGH_TILE_CELLS;
+
+    m_bands.resize(bandCount);
+    for (UINT band = 0; band < bandCount; band++)
+    {
+        m_bands[band].votes.assign(cellCount, 0);
+        m_bands[band].radiusSum.assign(cellCount, 0);
+        m_bands[band].touched.assign(tileCount, 0);
+        m_bands[band].voteCount = 0;
+    }
+
+    m_votes.assign(cellCount, 0);
+    m_radiusSum.assign(cellCount, 0);
+    m_touched.assign(tileCount, 0);
+}
+
+/// <summary>
+/// Find circles in a depth frame
+/// </summary>
+/// <param name="mask">Foreground mask selecting the voting pixels</param>
+/// <param name="pDepth">The pointer to depth pixels of the same size as the mask</param>
+/// <param name="scaleTable">Ball radius per depth for the frame resolution</param>
+/// <returns>Number of circles found</returns>
+UINT HoughCircleDetector::Detect(const PackedBitmask& mask, const NUI_DEPTH_IMAGE_PIXEL* pDepth, const BallScaleTable& scaleTable)
+{
+    m_circles.clear();
+    m_voteCount = 0;
+
+    if (!pDepth || mask.GetWidth() < 3 || mask.GetHeight() < 3)
+    {
+        return 0;
+    }
+
+    Resize(mask.GetWidth(), mask.GetHeight());
+
+    m_pMask       = &mask;
+    m_pDepth      = pDepth;
+    m_pScaleTable = &scaleTable;
+
+    ParallelBands::Run(m_pParallel, m_bandCount, [this](UINT band) { VoteBandRows(band); });
+
+    for (UINT band = 0; band < m_bandCount; band++)
+    {
+        m_voteCount += m_bands[band].voteCount;
+    }
+
+    if (m_voteCount > 0)
+    {
+        ParallelBands::Run(m_pParallel, m_tilesY, [this](UINT tileRow) { MergeTileRow(tileRow); });
+        FindPeaks();
+    }
+
+    return (UINT)m_circles.size();
+}
+
+/// <summary>
+/// Cast the votes of the edge pixels of one band
+/// </summary>
+void HoughCircleDetector::VoteBandRows(UINT band)
+{
+    VoteBand& votes = m_bands[band];
+    votes.voteCount = 0;
+
+    // Rows of the band that have a full 3x3 neighbourhood
+    UINT top    = band * m_rowsPerBand;
+    UINT bottom = top + m_rowsPerBand;
+    if (top < 1)
+    {
+        top = 1;
+    }
+    if (bottom > m_height - 1)
+    {
+        bottom = m_height - 1;
+    }
+
+    // Sobel responds with four times a depth step
+    int threshold = 4 * m_edgeStep;
+    int thresholdSq = threshold * threshold;
+
+    for (UINT y = top; y < bottom; y++)
+    {
+        const ULONGLONG* pMaskRow = m_pMask->GetRow(y);
+        const NUI_DEPTH_IMAGE_PIXEL* pAbove = m_pDepth + (y - 1) * m_width;
+        const NUI_DEPTH_IMAGE_PIXEL* pRow   = pAbove + m_width;
+        const NUI_DEPTH_IMAGE_PIXEL* pBelow = pRow + m_width;
+
+        for (UINT w = 0; w < m_pMask->GetWordsPerRow(); w++)
+        {
+            // Visit foreground pixels only
+            for (ULONGLONG bits = pMaskRow[w]; 0 != bits; bits &= bits - 1)
+            {
+                UINT bit = 0;
+                while (0 == ((bits >> bit) & 1))
+                {
+                    ++bit;
+                }
+
+                UINT x = w * BITS_PER_MASK_WORD + bit;
+                if (0 == x || x >= m_width - 1 || 0 == pRow[x].depth)
+                {
+                    continue;
+                }
+
+                int d[9];
+                for (int i = 0; i < 3; i++)
+                {
+                    d[i]     = pAbove[x - 1 + i].depth;
+                    d[3 + i] = pRow[x - 1 + i].depth;
+                    d[6 + i] = pBelow[x - 1 + i].depth;
+                }
+
+                int lowest  = INT_MAX;
+                int highest = 0;
+                for (int i = 0; i < 9; i++)
+                {
+                    if (0 == d[i])
+                    {
+                        d[i] = UNKNOWN_DEPTH;
+                    }
+                    lowest  = d[i] < lowest  ? d[i] : lowest;
+                    highest = d[i] > highest ? d[i] : highest;
+                }
+
+                // Gradient points toward increasing depth, out of the ball
+                int gx = (d[2] + 2 * d[5] + d[8]) - (d[0] + 2 * d[3] + d[6]);
+                int gy = (d[6] + 2 * d[7] + d[8]) - (d[0] + 2 * d[1] + d[2]);
+                int magnitudeSq = gx * gx + gy * gy;
+
+                // Only the near side of an edge belongs to the ball and knows its depth
+                if (magnitudeSq < thresholdSq || 2 * d[4] > lowest + highest)
+                {
+                    continue;
+                }
+
+                FLOAT radius = m_pScaleTable->GetRadius((USHORT)d[4]);
+                if (radius < MINIMUM_RADIUS)
+                {
+                    continue;
+                }
+
+                FLOAT scale   = radius / sqrtf((FLOAT)magnitudeSq);
+                FLOAT centerX = x - gx * scale;
+                FLOAT centerY = y - gy * scale;
+
+                if (centerX < 0.0f || centerY < 0.0f || centerX >= m_width || centerY >= m_height)
+                {
+                    continue;
+                }
+
+                UINT cellX = (UINT)centerX >> HOUGH_CELL_SHIFT;
+                UINT cellY = (UINT)centerY >> HOUGH_CELL_SHIFT;
+                UINT index = CellIndex(cellX, cellY);
+
+                if (votes.votes[index] < USHRT_MAX)
+                {
+                    ++votes.votes[index];
+                    votes.radiusSum[index] += (UINT)(radius * RADIUS_FRACTION + 0.5f);
+                }
+
+                votes.touched[index >> (2 * HOUGH_TILE_SHIFT)] = 1;
+                ++votes.voteCount;
+            }
+        }
+    }
+}
+
+/// <summary>
+/// Sum the band accumulators over one row of tiles
+/// </summary>
+void HoughCircleDetector::MergeTileRow(UINT tileRow)
+{
+    for (UINT tile = tileRow * m_tilesX; tile < (tileRow + 1) * m_tilesX; tile++)
+    {
+        UINT    first  = tile * HOUGH_TILE_CELLS;
+        USHORT* pVotes = &m_votes[first];
+        UINT*   pSums  = &m_radiusSum[first];
+
+        // Tiles of the last frame are cleared so peak search can read neighbours freely
+        if (m_touched[tile])
+        {
+            ZeroMemory(pVotes, HOUGH_TILE_CELLS * sizeof(USHORT));
+            ZeroMemory(pSums,  HOUGH_TILE_CELLS * sizeof(UINT));
+            m_touched[tile] = 0;
+        }
+
+        for (UINT band = 0; band < m_bandCount; band++)
+        {
+            VoteBand& votes = m_bands[band];
+            if (!votes.touched[tile])
+            {
+                continue;
+            }
+
+            USHORT* pBandVotes = &votes.votes[first];
+            UINT*   pBandSums  = &votes.radiusSum[first];
+            UINT    i = 0;
+
+#ifdef NUI_USE_SSE2
+            for (; i < HOUGH_TILE_CELLS; i += 8)
+            {
+                __m128i sum = _mm_adds_epu16(_mm_loadu_si128((const __m128i*)(pVotes + i)), _mm_loadu_si128((const __m128i*)(pBandVotes + i)));
+                _mm_storeu_si128((__m128i*)(pVotes + i), sum);
+
+                __m128i low  = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(pSums + i)),     _mm_loadu_si128((const __m128i*)(pBandSums + i)));
+                __m128i high = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(pSums + i + 4)), _mm_loadu_si128((const __m128i*)(pBandSums + i + 4)));
+                _mm_storeu_si128((__m128i*)(pSums + i),     low);
+                _mm_storeu_si128((__m128i*)(pSums + i + 4), high);
+            }
+#endif
+
+            for (; i < HOUGH_TILE_CELLS; i++)
+            {
+                UINT sum  = pVotes[i] + pBandVotes[i];
+                pVotes[i] = (USHORT)(sum < USHRT_MAX ? sum : USHRT_MAX);
+                pSums[i] += pBandSums[i];
+            }
+
+            // Leave the band accumulator clean for the next frame
+            ZeroMemory(pBandVotes, HOUGH_TILE_CELLS * sizeof(USHORT));
+            ZeroMemory(pBandSums,  HOUGH_TILE_CELLS * sizeof(UINT));
+            votes.touched[tile] = 0;
+            m_touched[tile]     = 1;
+        }
+    }
+}
+
+/// <summary>
+/// Sum the votes of a square of cells
+/// </summary>
+/// <param name="cellX">Center cell column</param>
+/// <param name="cellY">Center cell row</param>
+/// <param name="spread">Cells on each side of the center</param>
+UINT HoughCircleDetector::CountVotes(UINT cellX, UINT cellY, int spread) const
+{
+    int left   = (int)cellX - spread;
+    int top    = (int)cellY - spread;
+    int right  = (int)cellX + spread;
+    int bottom = (int)cellY + spread;
+
+    left   = left < 0 ? 0 : left;
+    top    = top  < 0 ? 0 : top;
+    right  = right  >= (int)m_cellsX ? (int)m_cellsX - 1 : right;
+    bottom = bottom >= (int)m_cellsY ? (int)m_cellsY - 1 : bottom;
+
+    UINT votes = 0;
+    for (int y = top; y <= bottom; y++)
+    {
+        for (int x = left; x <= right; x++)
+        {
+            votes += m_votes[CellIndex(x, y)];
+        }
+    }
+
+    return votes;
+}
+
+/// <summary>
+/// Find local maxima with enough support
+/// </summary>
+void HoughCircleDetector::FindPeaks()
+{
+    UINT tileSize = 1 << HOUGH_TILE_SHIFT;
+    FLOAT depthScale = m_pScaleTable->GetBallRadius() * m_pScaleTable->GetFocalLength() / MILLIMETERS_TO_METERS;
+
+    for (UINT tile = 0; tile < m_tilesX * m_tilesY; tile++)
+    {
+        if (!m_touched[tile])
+        {
+            continue;
+        }
+
+        UINT tileX = (tile % m_tilesX) << HOUGH_TILE_SHIFT;
+        UINT tileY = (tile / m_tilesX) << HOUGH_TILE_SHIFT;
+
+        for (UINT cell = 0; cell < HOUGH_TILE_CELLS; cell++)
+        {
+            UINT count = m_votes[tile * HOUGH_TILE_CELLS + cell];
+            if (count < MINIMUM_CELL_VOTES)
+            {
+                continue;
+            }
+
+            UINT cellX = tileX + (cell & (tileSize - 1));
+            UINT cellY = tileY + (cell >> HOUGH_TILE_SHIFT);
+            if (cellX >= m_cellsX || cellY >= m_cellsY)
+            {
+                continue;
+            }
+
+            // Local maximum over 3x3 cells, ties go to the first cell in row order
+            bool  peak      = true;
+            UINT  sumVotes  = 0;
+            UINT  sumRadius = 0;
+            FLOAT sumX      = 0.0f;
+            FLOAT sumY      = 0.0f;
+
+            for (int dy = -1; dy <= 1 && peak; dy++)
+            {
+                for (int dx = -1; dx <= 1; dx++)
+                {
+                    int nx = (int)cellX + dx;
+                    int ny = (int)cellY + dy;
+                    if (nx < 0 || ny < 0 || nx >= (int)m_cellsX || ny >= (int)m_cellsY)
+                    {
+                        continue;
+                    }
+
+                    UINT index = CellIndex(nx, ny);
+                    UINT other = m_votes[index];
+                    if (other > count || (other == count && (dy < 0 || (0 == dy && dx < 0))))
+                    {
+                        peak = false;
+                        break;
+                    }
+
+                    sumVotes  += other;
+                    sumRadius += m_radiusSum[index];
+                    sumX      += (FLOAT)nx * other;
+                    sumY      += (FLOAT)ny * other;
+                }
+            }
+
+            if (!peak)
+            {
+                continue;
+            }
+
+            FLOAT radius = sumRadius / (RADIUS_FRACTION * sumVotes);
+
+            // Steep surface just inside the rim and gradient noise scatter the votes of large circles
+            int  spread  = 1 + ((int)(radius * SUPPORT_SPREAD) >> HOUGH_CELL_SHIFT);
+            UINT support = (spread > 1) ? CountVotes(cellX, cellY, spread) : sumVotes;
+
+            FLOAT ratio = support / (2.0f * PI * radius);
+            if (ratio < m_minimumSupport)
+            {
+                continue;
+            }
+
+            // Cell centers lie half a cell into their pixels
+            FLOAT cellSize = (FLOAT)(1 << HOUGH_CELL_SHIFT);
+
+            CircleDetection circle;
+            circle.imageX      = (sumX / sumVotes + 0.5f) * cellSize - 0.5f;
+            circle.imageY      = (sumY / sumVotes + 0.5f) * cellSize - 0.5f;
+            circle.imageRadius = radius;
+            circle.support     = ratio;
+            circle.depth       = (USHORT)(depthScale / radius + 0.5f);
+
+            m_circles.push_back(circle);
+        }
+    }
+
+    // Keep the strongest of overlapping circles
+    std::sort(m_circles.begin(), m_circles.end(), StrongerCircle);
+
+    size_t kept = 0;
+    for (size_t i = 0; i < m_circles.size(); i++)
+    {
+        bool overlaps = false;
+        for (size_t j = 0; j < kept && !overlaps; j++)
+        {
+            FLOAT dx = m_circles[i].imageX - m_circles[j].imageX;
+            FLOAT dy = m_circles[i].imageY - m_circles[j].imageY;
+            FLOAT r  = m_circles[j].imageRadius;
+            overlaps = dx * dx + dy * dy < r * r;
+        }
+
+        if (!overlaps)
+        {
+            m_circles[kept++] = m_circles[i];
+        }
+    }
+
+    m_circles.resize(kept);
+}
@@ -0,0 +1,172 @@
+//------------------------------------------------------------------------------
+// <copyright file="HoughCircleDetector.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include "NuiTypes.h"
+#include "PackedBitmask.h"
+#include "BallScaleTable.h"
+#include "ParallelBands.h"
+
+#define HOUGH_CELL_SHIFT    1   // Accumulator cells of 2x2 pixels
+#define HOUGH_TILE_SHIFT    3   // Tiles of 8x8 cells
+#define HOUGH_TILE_CELLS    (1 << (2 * HOUGH_TILE_SHIFT))
+
+/// <summary>
+/// Circle found by voting
+/// </summary>
+struct CircleDetection
+{
+    FLOAT   imageX;         // Center, pixels
+    FLOAT   imageY;
+    FLOAT   imageRadius;    // Pixels
+    FLOAT   support;        // Votes over the circumference, about 1 for a fully visible rim
+    USHORT  depth;          // Ball center depth implied by the radius, millimeters
+};
+
+/// <summary>
+/// Finds ball outlines in depth, including balls partly hidden behind other objects.
+/// Every foreground pixel on the near side of a depth edge casts a single vote, one
+/// ball radius against the depth gradient, with the radius looked up from its depth.
+/// Votes go to an accumulator of 2x2 pixel cells stored in 8x8 cell tiles so that
+/// neighbouring votes share cache lines. Bands of rows vote in parallel on a shared
+/// pool into their own accumulators, which are summed over the touched tiles only.
+/// </summary>
+class HoughCircleDetector
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    HoughCircleDetector();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~HoughCircleDetector();
+
+public:
+    /// <summary>
+    /// Find circles in a depth frame
+    /// </summary>
+    /// <param name="mask">Foreground mask selecting the voting pixels</param>
+    /// <param name="pDepth">The pointer to depth pixels of the same size as the mask</param>
+    /// <param name="scaleTable">Ball radius per depth for the frame resolution</param>
+    /// <returns>Number of circles found</returns>
+    UINT Detect(const PackedBitmask& mask, const NUI_DEPTH_IMAGE_PIXEL* pDepth, const BallScaleTable& scaleTable);
+
+    /// <summary>
+    /// Set the smallest depth step treated as an edge
+    /// </summary>
+    /// <param name="step">Depth step in millimeters</param>
+    void SetEdgeStep(USHORT step);
+
+    /// <summary>
+    /// Set the smallest share of the circumference that must vote for a circle
+    /// </summary>
+    /// <param name="support">Ratio, 0.5 accepts half hidden balls</param>
+    void SetMinimumSupport(FLOAT support);
+
+    /// <summary>
+    /// Set the pool the bands vote on
+    /// </summary>
+    /// <param name="pParallel">The pointer to the pool shared with other stages, nullptr to vote on the calling thread</param>
+    void SetParallelBands(ParallelBands* pParallel);
+
+    /// <summary>
+    /// Get the circles found by the last call to Detect, strongest first
+    /// </summary>
+    const std::vector<CircleDetection>& GetCircles() const
+    {
+        return m_circles;
+    }
+
+    /// <summary>
+    /// Get the number of votes cast in the last frame
+    /// </summary>
+    UINT GetVoteCount() const
+    {
+        return m_voteCount;
+    }
+
+private:
+    /// <summary>
+    /// Votes of one band of rows
+    /// </summary>
+    struct VoteBand
+    {
+        std::vector<USHORT> votes;          // Per cell, tiled
+        std::vector<UINT>   radiusSum;      // Per cell, sum of voting radii in 1/16 pixel
+        std::vector<BYTE>   touched;        // Per tile
+        UINT                voteCount;
+    };
+
+    /// <summary>
+    /// Size the accumulators for a frame size
+    /// </summary>
+    void Resize(UINT width, UINT height);
+
+    /// <summary>
+    /// Cast the votes of the edge pixels of one band
+    /// </summary>
+    void VoteBandRows(UINT band);
+
+    /// <summary>
+    /// Sum the band accumulators over one row of tiles
+    /// </summary>
+    void MergeTileRow(UINT tileRow);
+
+    /// <summary>
+    /// Find local maxima with enough support
+    /// </summary>
+    void FindPeaks();
+
+    /// <summary>
+    /// Sum the votes of a square of cells
+    /// </summary>
+    /// <param name="cellX">Center cell column</param>
+    /// <param name="cellY">Center cell row</param>
+    /// <param name="spread">Cells on each side of the center</param>
+    UINT CountVotes(UINT cellX, UINT cellY, int spread) const;
+
+    /// <summary>
+    /// Get the accumulator index of a cell
+    /// </summary>
+    UINT CellIndex(UINT cellX, UINT cellY) const
+    {
+        UINT tile = (cellY >> HOUGH_TILE_SHIFT) * m_tilesX + (cellX >> HOUGH_TILE_SHIFT);
+        UINT mask = (1 << HOUGH_TILE_SHIFT) - 1;
+        return (tile << (2 * HOUGH_TILE_SHIFT)) | ((cellY & mask) << HOUGH_TILE_SHIFT) | (cellX & mask);
+    }
+
+private:
+    USHORT                          m_edgeStep;
+    FLOAT                           m_minimumSupport;
+
+    // Frame being processed
+    const PackedBitmask*            m_pMask;
+    const NUI_DEPTH_IMAGE_PIXEL*    m_pDepth;
+    const BallScaleTable*           m_pScaleTable;
+    UINT                            m_width;
+    UINT                            m_height;
+
+    UINT                            m_cellsX;
+    UINT                            m_cellsY;
+    UINT                            m_tilesX;
+    UINT                            m_tilesY;
+    UINT                            m_bandCount;
+    UINT                            m_rowsPerBand;
+
+    std::vector<VoteBand>           m_bands;
+    std::vector<USHORT>             m_votes;        // Merged, tiled
+    std::vector<UINT>               m_radiusSum;
+    std::vector<BYTE>               m_touched;
+    UINT                            m_voteCount;
+
+    std::vector<CircleDetection>    m_circles;
+    ParallelBands*                  m_pParallel;    // Shared pool, nullptr to vote on the calling thread
+};
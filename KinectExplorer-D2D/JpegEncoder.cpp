@@ -0,0 +1,527 @@
+//------------------------------------------------------------------------------
+// <copyright file="JpegEncoder.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "JpegEncoder.h"
+
+#define DEFAULT_QUALITY         75
+#define MINIMUM_ROWS_PER_BAND   2       // Block rows of 16 pixels
+#define HUFFMAN_DC_LUMINANCE    0
+#define HUFFMAN_AC_LUMINANCE    1
+#define HUFFMAN_DC_CHROMINANCE  2
+#define HUFFMAN_AC_CHROMINANCE  3
+
+// Natural order index of each zigzag position
+static const BYTE ZigZag[64] =
+{
+     0,  1,  8, 16,  9,  2,  3, 10, 17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63
+};
+
+// Example quantization tables of the JPEG standard, natural order
+static const BYTE LuminanceQuantization[64] =
+{
+    16, 11, 10, 16,  24,  40,  51,  61,
+    12, 12, 14, 19,  26,  58,  60,  55,
+    14, 13, 16, 24,  40,  57,  69,  56,
+    14, 17, 22, 29,  51,  87,  80,  62,
+    18, 22, 37, 56,  68, 109, 103,  77,
+    24, 35, 55, 64,  81, 104, 113,  92,
+    49, 64, 78, 87, 103, 121, 120, 101,
+    72, 92, 95, 98, 112, 100, 103,  99
+};
+
+static const BYTE ChrominanceQuantization[64] =
+{
+    17, 18, 24, 47, 99, 99, 99, 99,
+    18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99,
+    47, 66, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99
+};
+
+// Scale factors of the AAN forward DCT, cos(k * pi / 16) * sqrt(2) with k = 0 as 1
+static const FLOAT DctScale[8] =
+{
+    1.0f, 1.387039845f, 1.306562965f, 1.175875602f, 1.0f, 0.785694958f, 0.541196100f, 0.275899379f
+};
+
+// Standard Huffman tables, code counts per length followed by the symbols
+static const BYTE DcLuminanceBits[16]     = {0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0};
+static const BYTE DcChrominanceBits[16]   = {0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0};
+static const BYTE DcValues[12]            = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+
+static const BYTE AcLuminanceBits[16]     = {0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d};
+static const BYTE AcLuminanceValues[162]  =
+{
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+    0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08, 0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0,
+    0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7,
+    0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5,
+    0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa
+};
+
+static const BYTE AcChrominanceBits[16]   = {0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77};
+static const BYTE AcChrominanceValues[162] =
+{
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+    0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0,
+    0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+    0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+    0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+    0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5,
+    0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3,
+    0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8,
+    0xf9, 0xfa
+};
+
+static const BYTE* const HuffmanBits[4]   = {DcLuminanceBits, AcLuminanceBits, DcChrominanceBits, AcChrominanceBits};
+static const BYTE* const HuffmanValues[4] = {DcValues, AcLuminanceValues, DcValues, AcChrominanceValues};
+
+/// <summary>
+/// Append a big endian 16 bit value
+/// </summary>
+static inline void PutWord(std::vector<BYTE>& out, UINT value)
+{
+    out.push_back((BYTE)(value >> 8));
+    out.push_back((BYTE)value);
+}
+
+/// <summary>
+/// Append bits to the entropy coded data of a band, stuffing a zero after every 0xFF
+/// </summary>
+static inline void PutBits(std::vector<BYTE>& out, UINT& bitBuffer, UINT& bitCount, UINT code, UINT size)
+{
+    bitCount  += size;
+    bitBuffer |= code << (32 - bitCount);
+
+    while (bitCount >= 8)
+    {
+        BYTE byte = (BYTE)(bitBuffer >> 24);
+        out.push_back(byte);
+        if (0xFF == byte)
+        {
+            out.push_back(0);
+        }
+
+        bitBuffer <<= 8;
+        bitCount   -= 8;
+    }
+}
+
+/// <summary>
+/// One dimensional AAN forward DCT of eight values, scaled by DctScale
+/// </summary>
+static inline void ForwardDct8(FLOAT* p, UINT step)
+{
+    FLOAT tmp0 = p[0]        + p[7 * step];
+    FLOAT tmp7 = p[0]        - p[7 * step];
+    FLOAT tmp1 = p[step]     + p[6 * step];
+    FLOAT tmp6 = p[step]     - p[6 * step];
+    FLOAT tmp2 = p[2 * step] + p[5 * step];
+    FLOAT tmp5 = p[2 * step] - p[5 * step];
+    FLOAT tmp3 = p[3 * step] + p[4 * step];
+    FLOAT tmp4 = p[3 * step] - p[4 * step];
+
+    // Even part
+    FLOAT tmp10 = tmp0 + tmp3;
+    FLOAT tmp13 = tmp0 - tmp3;
+    FLOAT tmp11 = tmp1 + tmp2;
+    FLOAT tmp12 = tmp1 - tmp2;
+
+    p[0]        = tmp10 + tmp11;
+    p[4 * step] = tmp10 - tmp11;
+
+    FLOAT z1 = (tmp12 + tmp13) * 0.707106781f;
+    p[2 * step] = tmp13 + z1;
+    p[6 * step] = tmp13 - z1;
+
+    // Odd part
+    tmp10 = tmp4 + tmp5;
+    tmp11 = tmp5 + tmp6;
+    tmp12 = tmp6 + tmp7;
+
+    FLOAT z5 = (tmp10 - tmp12) * 0.382683433f;
+    FLOAT z2 = tmp10 * 0.541196100f + z5;
+    FLOAT z4 = tmp12 * 1.306562965f + z5;
+    FLOAT z3 = tmp11 * 0.707106781f;
+
+    FLOAT z11 = tmp7 + z3;
+    FLOAT z13 = tmp7 - z3;
+
+    p[5 * step] = z13 + z2;
+    p[3 * step] = z13 - z2;
+    p[1 * step] = z11 + z4;
+    p[7 * step] = z11 - z4;
+}
+
+/// <summary>
+/// Huffman code and length of every symbol, built once from the standard tables
+/// </summary>
+struct HuffmanTable
+{
+    USHORT  code[256];
+    BYTE    size[256];
+
+    HuffmanTable(const BYTE* pBits, const BYTE* pValues)
+    {
+        ZeroMemory(code, sizeof(code));
+        ZeroMemory(size, sizeof(size));
+
+        UINT next  = 0;
+        UINT index = 0;
+        for (UINT length = 1; length <= 16; length++)
+        {
+            for (UINT i = 0; i < pBits[length - 1]; i++)
+            {
+                BYTE symbol  = pValues[index++];
+                code[symbol] = (USHORT)next++;
+                size[symbol] = (BYTE)length;
+            }
+            next <<= 1;
+        }
+    }
+};
+
+static const HuffmanTable HuffmanTables[4] =
+{
+    HuffmanTable(DcLuminanceBits,   DcValues),
+    HuffmanTable(AcLuminanceBits,   AcLuminanceValues),
+    HuffmanTable(DcChrominanceBits, DcValues),
+    HuffmanTable(AcChrominanceBits, AcChrominanceValues)
+};
+
+/// <summary>
+/// Transform, quantize and entropy code one 8x8 block
+/// </summary>
+static void EncodeBlock(std::vector<BYTE>& out, UINT& bitBuffer, UINT& bitCount, FLOAT block[64], const FLOAT divisors[64], int& dc, const HuffmanTable& dcTable, const HuffmanTable& acTable)
+{
+    for (UINT row = 0; row < 8; row++)
+    {
+        ForwardDct8(block + row * 8, 1);
+    }
+    for (UINT col = 0; col < 8; col++)
+    {
+        ForwardDct8(block + col, 8);
+    }
+
+    int coefficients[64];
+    for (UINT k = 0; k < 64; k++)
+    {
+        FLOAT value = block[ZigZag[k]] * divisors[k];
+        coefficients[k] = (int)(value < 0.0f ? value - 0.5f : value + 0.5f);
+    }
+
+    // DC as the difference to the previous block of the component
+    int  diff     = coefficients[0] - dc;
+    UINT category = 0;
+    for (int magnitude = diff < 0 ? -diff : diff; magnitude; magnitude >>= 1)
+    {
+        ++category;
+    }
+    dc = coefficients[0];
+
+    PutBits(out, bitBuffer, bitCount, dcTable.code[category], dcTable.size[category]);
+    if (category > 0)
+    {
+        PutBits(out, bitBuffer, bitCount, (diff < 0 ? diff - 1 : diff) & ((1 << category) - 1), category);
+    }
+
+    // AC as runs of zeros followed by a value
+    UINT run = 0;
+    for (UINT k = 1; k < 64; k++)
+    {
+        int value = coefficients[k];
+        if (0 == value)
+        {
+            ++run;
+            continue;
+        }
+
+        while (run >= 16)
+        {
+            PutBits(out, bitBuffer, bitCount, acTable.code[0xF0], acTable.size[0xF0]);
+            run -= 16;
+        }
+
+        category = 0;
+        for (int magnitude = value < 0 ? -value : value; magnitude; magnitude >>= 1)
+        {
+            ++category;
+        }
+
+        UINT symbol = (run << 4) | category;
+        PutBits(out, bitBuffer, bitCount, acTable.code[symbol], acTable.size[symbol]);
+        PutBits(out, bitBuffer, bitCount, (value < 0 ? value - 1 : value) & ((1 << category) - 1), category);
+        run = 0;
+    }
+
+    if (run > 0)
+    {
+        PutBits(out, bitBuffer, bitCount, acTable.code[0x00], acTable.size[0x00]);
+    }
+}
+
+/// <summary>
+/// Constructor
+/// </summary>
+JpegEncoder::JpegEncoder()
+    : m_pParallel(nullptr)
+    , m_quality(0)
+    , m_pPixels(nullptr)
+    , m_width(0)
+    , m_height(0)
+    , m_blockColumns(0)
+    , m_blockRows(0)
+{
+    SetQuality(DEFAULT_QUALITY);
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+JpegEncoder::~JpegEncoder()
+{
+}
+
+/// <summary>
+/// Set the quality the quantization tables are scaled to
+/// </summary>
+/// <param name="quality">Quality from 1 to 100</param>
+void JpegEncoder::SetQuality(UINT quality)
+{
+    quality = quality < 1 ? 1 : (quality > 100 ? 100 : quality);
+    if (quality == m_quality)
+    {
+        return;
+    }
+    m_quality = quality;
+
+    // Same scaling of the example tables as the IJG library
+    UINT scale = quality < 50 ? 5000 / quality : 200 - quality * 2;
+
+    const BYTE* tables[2] = {LuminanceQuantization, ChrominanceQuantization};
+    for (UINT t = 0; t < 2; t++)
+    {
+        for (UINT k = 0; k < 64; k++)
+        {
+            UINT natural = ZigZag[k];
+            UINT value   = (tables[t][natural] * scale + 50) / 100;
+            value = value < 1 ? 1 : (value > 255 ? 255 : value);
+
+            m_quantization[t][k] = (BYTE)value;
+            m_divisors[t][k]     = 1.0f / (value * DctScale[natural / 8] * DctScale[natural % 8] * 8.0f);
+        }
+    }
+}
+
+/// <summary>
+/// Set the pool the bands are encoded on
+/// </summary>
+/// <param name="pParallel">The pointer to the pool shared with other stages, nullptr to encode on the calling thread</param>
+void JpegEncoder::SetParallelBands(ParallelBands* pParallel)
+{
+    m_pParallel = pParallel;
+}
+
+/// <summary>
+/// Encode an image
+/// </summary>
+/// <param name="pPixels">The pointer to BGRX pixels</param>
+/// <param name="width">Image width</param>
+/// <param name="height">Image height</param>
+/// <returns>Size of the JPEG stream in bytes, zero on failure</returns>
+UINT JpegEncoder::Encode(const UINT* pPixels, UINT width, UINT height)
+{
+    if (!pPixels || 0 == width || 0 == height || width > 0xFFFF || height > 0xFFFF)
+    {
+        return 0;
+    }
+
+    m_pPixels      = pPixels;
+    m_width        = width;
+    m_height       = height;
+    m_blockColumns = (width  + 15) / 16;
+    m_blockRows    = (height + 15) / 16;
+
+    UINT bandCount = ParallelBands::GetThreadCount(m_pParallel);
+    if (bandCount * MINIMUM_ROWS_PER_BAND > m_blockRows)
+    {
+        bandCount = (m_blockRows + MINIMUM_ROWS_PER_BAND - 1) / MINIMUM_ROWS_PER_BAND;
+    }
+
+    // Band buffers keep their capacity, so steady state encoding does not allocate
+    m_bands.resize(bandCount);
+    for (UINT band = 0; band < bandCount; band++)
+    {
+        m_bands[band].firstRow = m_blockRows * band / bandCount;
+        m_bands[band].endRow   = m_blockRows * (band + 1) / bandCount;
+    }
+
+    ParallelBands::Run(m_pParallel, bandCount, [this](UINT band) { EncodeBandRows(band); });
+
+    m_output.clear();
+    WriteHeaders();
+    for (UINT band = 0; band < bandCount; band++)
+    {
+        m_output.insert(m_output.end(), m_bands[band].data.begin(), m_bands[band].data.end());
+    }
+    PutWord(m_output, 0xFFD9);  // EOI
+
+    return (UINT)m_output.size();
+}
+
+/// <summary>
+/// Encode the block rows of one band
+/// </summary>
+void JpegEncoder::EncodeBandRows(UINT bandIndex)
+{
+    EncodeBand& band = m_bands[bandIndex];
+    band.data.clear();
+
+    for (UINT row = band.firstRow; row < band.endRow; row++)
+    {
+        // Every block row is a restart interval, the marker before it resets the DC predictions
+        if (row > 0)
+        {
+            band.data.push_back(0xFF);
+            band.data.push_back((BYTE)(0xD0 + ((row - 1) & 7)));
+        }
+
+        band.bitBuffer = 0;
+        band.bitCount  = 0;
+
+        int dc[3] = {0, 0, 0};
+        for (UINT column = 0; column < m_blockColumns; column++)
+        {
+            EncodeMacroblock(band, column * 16, row * 16, dc);
+        }
+
+        // Pad the last byte with ones
+        PutBits(band.data, band.bitBuffer, band.bitCount, 0x7F, 7);
+    }
+}
+
+/// <summary>
+/// Convert, transform and entropy code one 16x16 block
+/// </summary>
+void JpegEncoder::EncodeMacroblock(EncodeBand& band, UINT x, UINT y, int dc[3])
+{
+    FLOAT luma[4][64];
+    FLOAT cb[64];
+    FLOAT cr[64];
+
+    ZeroMemory(cb, sizeof(cb));
+    ZeroMemory(cr, sizeof(cr));
+
+    for (UINT dy = 0; dy < 16; dy++)
+    {
+        // Edge pixels are repeated into the padding of partial blocks
+        UINT        py   = y + dy < m_height ? y + dy : m_height - 1;
+        const UINT* pRow = m_pPixels + py * m_width;
+
+        for (UINT dx = 0; dx < 16; dx++)
+        {
+            UINT  px    = x + dx < m_width ? x + dx : m_width - 1;
+            UINT  pixel = pRow[px];
+            FLOAT b     = (FLOAT)(pixel & 0xFF);
+            FLOAT g     = (FLOAT)((pixel >> 8) & 0xFF);
+            FLOAT r     = (FLOAT)((pixel >> 16) & 0xFF);
+
+            luma[(dy / 8) * 2 + dx / 8][(dy % 8) * 8 + dx % 8] = 0.299f * r + 0.587f * g + 0.114f * b - 128.0f;
+
+            // Chroma is the average of 2x2 pixels
+            UINT c = (dy / 2) * 8 + dx / 2;
+            cb[c] += -0.168736f * r - 0.331264f * g + 0.5f      * b;
+            cr[c] +=  0.5f      * r - 0.418688f * g - 0.081312f * b;
+        }
+    }
+
+    for (UINT i = 0; i < 64; i++)
+    {
+        cb[i] *= 0.25f;
+        cr[i] *= 0.25f;
+    }
+
+    for (UINT i = 0; i < 4; i++)
+    {
+        EncodeBlock(band.data, band.bitBuffer, band.bitCount, luma[i], m_divisors[0], dc[0], HuffmanTables[HUFFMAN_DC_LUMINANCE], HuffmanTables[HUFFMAN_AC_LUMINANCE]);
+    }
+    EncodeBlock(band.data, band.bitBuffer, band.bitCount, cb, m_divisors[1], dc[1], HuffmanTables[HUFFMAN_DC_CHROMINANCE], HuffmanTables[HUFFMAN_AC_CHROMINANCE]);
+    EncodeBlock(band.data, band.bitBuffer, band.bitCount, cr, m_divisors[1], dc[2], HuffmanTables[HUFFMAN_DC_CHROMINANCE], HuffmanTables[HUFFMAN_AC_CHROMINANCE]);
+}
+
+/// <summary>
+/// Write the markers in front of the entropy coded data
+/// </summary>
+void JpegEncoder::WriteHeaders()
+{
+    static const BYTE Jfif[] = {'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0};
+
+    PutWord(m_output, 0xFFD8);  // SOI
+
+    PutWord(m_output, 0xFFE0);  // APP0
+    PutWord(m_output, 2 + sizeof(Jfif));
+    m_output.insert(m_output.end(), Jfif, Jfif + sizeof(Jfif));
+
+    PutWord(m_output, 0xFFDB);  // DQT
+    PutWord(m_output, 2 + 2 * 65);
+    for (UINT t = 0; t < 2; t++)
+    {
+        m_output.push_back((BYTE)t);
+        m_output.insert(m_output.end(), m_quantization[t], m_quantization[t] + 64);
+    }
+
+    PutWord(m_output, 0xFFC0);  // SOF0, luminance sampled 2x2, chrominance 1x1
+    PutWord(m_output, 17);
+    m_output.push_back(8);
+    PutWord(m_output, m_height);
+    PutWord(m_output, m_width);
+    m_output.push_back(3);
+    static const BYTE Components[9] = {1, 0x22, 0, 2, 0x11, 1, 3, 0x11, 1};
+    m_output.insert(m_output.end(), Components, Components + sizeof(Components));
+
+    static const BYTE TableClasses[4] = {0x00, 0x10, 0x01, 0x11};
+    for (UINT t = 0; t < 4; t++)
+    {
+        UINT count = 0;
+        for (UINT i = 0; i < 16; i++)
+        {
+            count += HuffmanBits[t][i];
+        }
+
+        PutWord(m_output, 0xFFC4);  // DHT
+        PutWord(m_output, 2 + 1 + 16 + count);
+        m_output.push_back(TableClasses[t]);
+        m_output.insert(m_output.end(), HuffmanBits[t], HuffmanBits[t] + 16);
+        m_output.insert(m_output.end(), HuffmanValues[t], HuffmanValues[t] + count);
+    }
+
+    PutWord(m_output, 0xFFDD);  // DRI, one block row per interval
+    PutWord(m_output, 4);
+    PutWord(m_output, m_blockColumns);
+
+    PutWord(m_output, 0xFFDA);  // SOS
+    PutWord(m_output, 12);
+    m_output.push_back(3);
+    static const BYTE ScanComponents[6] = {1, 0x00, 2, 0x11, 3, 0x11};
+    m_output.insert(m_output.end(), ScanComponents, ScanComponents + sizeof(ScanComponents));
+    m_output.push_back(0);
+    m_output.push_back(63);
+    m_output.push_back(0);
+}
@@ -0,0 +1,112 @@
+//------------------------------------------------------------------------------
+// <copyright file="JpegEncoder.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include "NuiTypes.h"
+#include "ParallelBands.h"
+
+/// <summary>
+/// Baseline JPEG encoder for 32 bit BGRX images, YCbCr 4:2:0 with the standard
+/// Huffman tables. Every row of 16 pixel blocks is its own restart interval, so
+/// its entropy coding does not depend on any other row. Bands of rows are then
+/// encoded on a shared pool into separate buffers and joined with restart markers.
+/// </summary>
+class JpegEncoder
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    JpegEncoder();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~JpegEncoder();
+
+public:
+    /// <summary>
+    /// Set the quality the quantization tables are scaled to
+    /// </summary>
+    /// <param name="quality">Quality from 1 to 100</param>
+    void SetQuality(UINT quality);
+
+    /// <summary>
+    /// Set the pool the bands are encoded on
+    /// </summary>
+    /// <param name="pParallel">The pointer to the pool shared with other stages, nullptr to encode on the calling thread</param>
+    void SetParallelBands(ParallelBands* pParallel);
+
+    /// <summary>
+    /// Get the quality in effect
+    /// </summary>
+    UINT GetQuality() const
+    {
+        return m_quality;
+    }
+
+    /// <summary>
+    /// Encode an image
+    /// </summary>
+    /// <param name="pPixels">The pointer to BGRX pixels</param>
+    /// <param name="width">Image width</param>
+    /// <param name="height">Image height</param>
+    /// <returns>Size of the JPEG stream in bytes, zero on failure</returns>
+    UINT Encode(const UINT* pPixels, UINT width, UINT height);
+
+    /// <summary>
+    /// Get the JPEG stream of the last Encode
+    /// </summary>
+    const BYTE* GetData() const
+    {
+        return m_output.empty() ? nullptr : &m_output[0];
+    }
+
+private:
+    /// <summary>
+    /// Entropy coded output of a band of block rows
+    /// </summary>
+    struct EncodeBand
+    {
+        UINT                firstRow;
+        UINT                endRow;
+        std::vector<BYTE>   data;
+        UINT                bitBuffer;
+        UINT                bitCount;
+    };
+
+    /// <summary>
+    /// Encode the block rows of one band
+    /// </summary>
+    void EncodeBandRows(UINT band);
+
+    /// <summary>
+    /// Convert, transform and entropy code one 16x16 block
+    /// </summary>
+    void EncodeMacroblock(EncodeBand& band, UINT x, UINT y, int dc[3]);
+
+    /// <summary>
+    /// Write the markers in front of the entropy coded data
+    /// </summary>
+    void WriteHeaders();
+
+private:
+    ParallelBands*              m_pParallel;            // Shared pool, nullptr to encode on the calling thread
+    UINT                        m_quality;
+    BYTE                        m_quantization[2][64];  // Luminance and chrominance, zigzag order
+    FLOAT                       m_divisors[2][64];      // Reciprocal quantization with the DCT scale folded in, zigzag order
+
+    const UINT*                 m_pPixels;
+    UINT                        m_width;
+    UINT                        m_height;
+    UINT                        m_blockColumns;
+    UINT                        m_blockRows;
+
+    std::vector<EncodeBand>     m_bands;
+    std::vector<BYTE>           m_output;
+};
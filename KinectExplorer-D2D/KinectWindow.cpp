@@ -5,6 +5,7 @@
 //------------------------------------------------------------------------------
 
 #include "stdafx.h"
+#include <stdio.h>
 #include "KinectWindow.h"
 #include "NuiStreamViewer.h"
 #include "NuiStream.h"
@@ -12,6 +13,7 @@
 #include "resource.h"
 #include "CameraColorSettingsViewer.h"
 #include "CameraExposureSettingsViewer.h"
+#include "ServiceOptions.h"
 
 // Window size definations
 #define PRIMARY_VIEW_MIN_WIDTH      480
@@ -25,6 +27,9 @@
 // Reoccurence period in millisecond of waitable timer. This timer is used to trigger processing of timed stream data.
 #define TIMER_PERIOD                20
 
+// Display refresh rate assumed when the display driver does not report one
+#define DEFAULT_REFRESH_RATE        60
+
 // Titles of tab control items
 #define TAB_TITLE_AUDIO             L"Audio"
 #define TAB_TITLE_ACCELEROMETER     L"Accelerometer"
@@ -37,6 +42,14 @@
 
 #define ERROR_MESSAGE_BUFFER_SIZE   1024
 
+// Frame bus shared with local processes. A slot holds the largest color frame
+#define FRAME_BUS_NAME              "KinectFrameBus%d"
+#define FRAME_BUS_SLOT_COUNT        8
+#define FRAME_BUS_SLOT_SIZE         (1280 * 960 * 4)
+
+// Services offered to other programs, from the command line
+extern ServiceOptions g_serviceOptions;
+
 // Menu item positions
 static const int ColorStreamMenuPosition            = 0;
 static const int DepthStreamMenuPosition            = 1;
@@ -62,11 +75,13 @@ KinectWindow::KinectWindow(HINSTANCE hInstance, HWND hWndParent, INuiSensor* pNu
     , m_hWndParent(hWndParent)
     , m_hInstance(hInstance)
     , m_hTimer(nullptr)
+    , m_hPresentTimer(nullptr)
     , m_hThread(nullptr)
     , m_pNuiSensor(pNuiSensor)
     , m_bSupportCameraSettings(true)
     , m_hStartWindow(INVALID_HANDLE_VALUE)
     , m_hStopStreamEventThread(INVALID_HANDLE_VALUE)
+    , m_pFrameBus(nullptr)
 {
     assert(m_pNuiSensor);
     m_pNuiSensor->AddRef();
@@ -111,6 +126,46 @@ KinectWindow::KinectWindow(HINSTANCE hInstance, HWND hWndParent, INuiSensor* pNu
     m_pAudioStream->SetStreamViewer(m_pAudioView);
     m_pAccelerometerStream->SetStreamViewer(m_pAccelView);
 
+    // Publish depth, color and skeleton frames to other processes when asked for on the command line.
+    // The slots take FRAME_BUS_SLOT_COUNT high resolution color frames, so the bus is not created by default
+    if (g_serviceOptions.frameBus)
+    {
+        char frameBusName[MAX_PATH];
+        sprintf_s(frameBusName, FRAME_BUS_NAME, m_pNuiSensor->NuiInstanceIndex());
+
+        m_pFrameBus = new FrameBusWriter();
+        if (SUCCEEDED(m_pFrameBus->Create(frameBusName, FRAME_BUS_SLOT_COUNT, FRAME_BUS_SLOT_SIZE)))
+        {
+            m_pColorStream->SetFrameBus(m_pFrameBus);
+            m_pDepthStream->SetFrameBus(m_pFrameBus);
+            m_pSkeletonStream->SetFrameBus(m_pFrameBus);
+        }
+    }
+
+    // Browsers get the depth preview only when asked for on the command line, on loopback unless an address is given
+    if (g_serviceOptions.preview)
+    {
+        m_pDepthStream->GetPreviewServer().Start(g_serviceOptions.previewAddress, g_serviceOptions.previewPort + (USHORT)m_pNuiSensor->NuiInstanceIndex());
+    }
+
+    // Ball detections go to a controller only when asked for. Without a socket they are simply not published
+    if (g_serviceOptions.publish)
+    {
+        m_pDepthStream->GetDetectionPublisher().Open(g_serviceOptions.publishAddress, g_serviceOptions.publishPort + (USHORT)m_pNuiSensor->NuiInstanceIndex());
+    }
+
+    // Color frames verify ball candidates found in depth
+    m_pDepthStream->SetColorStream(m_pColorStream);
+
+    // Gravity from the accelerometer guides the floor search in depth
+    m_pDepthStream->SetAccelerometerStream(m_pAccelerometerStream);
+
+    // Skeletons are drawn over the depth preview stream
+    m_pDepthStream->SetSkeletonStream(m_pSkeletonStream);
+
+    // Joints are placed on color images through the depth to color mapping
+    m_pSkeletonStream->SetRegistrationTable(&m_pDepthStream->GetRegistrationTable());
+
     // Create settings object
     m_pSettings = new KinectSettings(m_pNuiSensor,
                                      m_pPrimaryView,
@@ -361,6 +416,10 @@ LRESULT KinectWindow::DialogProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lPa
         UpdateTimedStreams();
         break;
 
+    case WM_PRESENTEVENT:
+        PresentViews();
+        break;
+
     case WM_INITDIALOG:
         NuiViewer::SetIcon(hWnd);
         break;
@@ -551,7 +610,7 @@ void KinectWindow::StartStreams()
 }
 
 /// <summary>
-/// Start the waitable timer to trigger process of timed streams
+/// Start the waitable timers to trigger process of timed streams and presentation of viewers
 /// </summary>
 void KinectWindow::StartTimer()
 {
@@ -561,6 +620,23 @@ void KinectWindow::StartTimer()
         LARGE_INTEGER dueTime = {0};
         SetWaitableTimer(m_hTimer, &dueTime, TIMER_PERIOD, nullptr, nullptr, FALSE);
     }
+
+    // Viewers are repainted at most once per display refresh, however fast the streams run
+    HDC hdc         = GetDC(nullptr);
+    int refreshRate = GetDeviceCaps(hdc, VREFRESH);
+    ReleaseDC(nullptr, hdc);
+
+    if (refreshRate <= 1)
+    {
+        refreshRate = DEFAULT_REFRESH_RATE;
+    }
+
+    m_hPresentTimer = CreateWaitableTimerW(nullptr, FALSE, nullptr);
+    if (m_hPresentTimer)
+    {
+        LARGE_INTEGER dueTime = {0};
+        SetWaitableTimer(m_hPresentTimer, &dueTime, (1000 + refreshRate - 1) / refreshRate, nullptr, nullptr, FALSE);
+    }
 }
 
 /// <summary>
@@ -574,11 +650,18 @@ void KinectWindow::CleanUp()
         m_hTimer = nullptr;
     }
 
+    if (m_hPresentTimer)
+    {
+        CloseHandle(m_hPresentTimer);
+        m_hPresentTimer = nullptr;
+    }
+
     SafeDelete(m_pColorStream);
     SafeDelete(m_pDepthStream);
     SafeDelete(m_pSkeletonStream);
     SafeDelete(m_pAudioStream);
     SafeDelete(m_pAccelerometerStream);
+    SafeDelete(m_pFrameBus);
     SafeDelete(m_pPrimaryView);
     SafeDelete(m_pSecondaryView);
     SafeDelete(m_pAudioView);
@@ -1000,6 +1083,15 @@ void KinectWindow::UpdateTimedStreams()
     m_pAccelerometerStream->ProcessStream();
 }
 
+/// <summary>
+/// Repaint stream viewers which received data since the last display interval
+/// </summary>
+void KinectWindow::PresentViews()
+{
+    m_pPrimaryView->Present();
+    m_pSecondaryView->Present();
+}
+
 /// <summary>
 /// Thread to handle stream events
 /// </summary>
@@ -1009,6 +1101,7 @@ DWORD KinectWindow::StreamEventThread(KinectWindow* pThis)
 {
     HANDLE events[] = {pThis->m_hStopStreamEventThread, 
                        pThis->m_hTimer, 
+                       pThis->m_hPresentTimer,
                        pThis->m_pColorStream->GetFrameReadyEvent(), 
                        pThis->m_pDepthStream->GetFrameReadyEvent(), 
                        pThis->m_pSkeletonStream->GetFrameReadyEvent()};
@@ -1024,7 +1117,11 @@ DWORD KinectWindow::StreamEventThread(KinectWindow* pThis)
         {
             SendMessageW(pThis->GetWindow(), WM_TIMEREVENT, 0, 0);
         }
-        else if(WAIT_OBJECT_0 + 4 >= ret)
+        else if (WAIT_OBJECT_0 + 2 == ret)
+        {
+            SendMessageW(pThis->GetWindow(), WM_PRESENTEVENT, 0, 0);
+        }
+        else if(WAIT_OBJECT_0 + 5 >= ret)
         {
             SendMessageW(pThis->GetWindow(), WM_STREAMEVENT, 0, 0);
         }
@@ -126,7 +126,7 @@ private:
     void StartStreams();
 
     /// <summary>
-    /// Start the waitable timer to trigger process of timed streams
+    /// Start the waitable timers to trigger process of timed streams and presentation of viewers
     /// </summary>
     void StartTimer();
 
@@ -140,6 +140,11 @@ private:
     /// </summary>
     void UpdateTimedStreams();
 
+    /// <summary>
+    /// Repaint stream viewers which received data since the last display interval
+    /// </summary>
+    void PresentViews();
+
     /// <summary>
     /// Create camera setting viewers
     /// </summary>
@@ -247,6 +252,7 @@ private:
     HWND                    m_hWndTab;                  // Handle to window of tab control
     HWND                    m_hWndParent;               // Handle to window of main console
     HANDLE                  m_hTimer;                   // Handle to waitable timer
+    HANDLE                  m_hPresentTimer;            // Handle to waitable timer firing once per display interval
     HANDLE                  m_hThread;                  // Handle to thread instance
     HANDLE                  m_hStartWindow;             // Handle to the start window sync event
     HANDLE                  m_hStopStreamEventThread;   // Event to stop stream events thread
@@ -269,6 +275,7 @@ private:
     NuiSkeletonStream*      m_pSkeletonStream;          // Pointer to skeleton stream
     NuiAudioStream*         m_pAudioStream;             // Pointer to audio stream
     NuiAccelerometerStream* m_pAccelerometerStream;     // Pointer to accelerometer stream
+    FrameBusWriter*         m_pFrameBus;                // Pointer to frame bus shared with other processes
 
     INuiSensor*             m_pNuiSensor;               // Pointer to Nui sensor
 
@@ -5,14 +5,20 @@
 //------------------------------------------------------------------------------
 
 #include "stdafx.h"
+#include <stdlib.h>
+#include <string.h>
 
 #include "MainWindow.h"
+#include "ServiceOptions.h"
 #include "Utility.h"
 
 //Define the global independent Direct resources
 ID2D1Factory* g_pD2DFactory = nullptr;
 IDWriteFactory* g_pDWriteFactory = nullptr;
 
+// Services offered by every sensor window, read from the command line
+ServiceOptions g_serviceOptions;
+
 /// <summary>
 /// Ensure the independent Direct2D resources have been created
 /// </summary>
@@ -38,6 +44,72 @@ void DiscardIndependentResources()
     SafeRelease(g_pD2DFactory);
 }
 
+/// <summary>
+/// Find a service switch and read its optional address and port, as in -switch=address:port
+/// </summary>
+/// <param name="pCommandLine">Command line arguments</param>
+/// <param name="pSwitch">Switch to look for</param>
+/// <param name="pAddress">Receives the address if one is given, SERVICE_ADDRESS_SIZE characters</param>
+/// <param name="port">Receives the port if one is given</param>
+/// <returns>True if the switch is present</returns>
+bool ParseServiceSwitch(LPCWSTR pCommandLine, LPCWSTR pSwitch, char* pAddress, USHORT& port)
+{
+    LPCWSTR pFound = wcsstr(pCommandLine, pSwitch);
+    if (nullptr == pFound)
+    {
+        return false;
+    }
+
+    LPCWSTR pValue = pFound + wcslen(pSwitch);
+    if (L'=' != *pValue)
+    {
+        return true;
+    }
+
+    // The address is plain ASCII digits and dots
+    char address[SERVICE_ADDRESS_SIZE];
+    UINT length = 0;
+    for (++pValue; ((*pValue >= L'0' && *pValue <= L'9') || L'.' == *pValue) && length + 1 < SERVICE_ADDRESS_SIZE; ++pValue)
+    {
+        address[length++] = (char)*pValue;
+    }
+    address[length] = '\0';
+
+    if (length > 0)
+    {
+        strcpy_s(pAddress, SERVICE_ADDRESS_SIZE, address);
+    }
+
+    if (L':' == *pValue)
+    {
+        UINT value = wcstoul(pValue + 1, nullptr, 10);
+        if (value > 0 && value <= 0xFFFF)
+        {
+            port = (USHORT)value;
+        }
+    }
+
+    return true;
+}
+
+/// <summary>
+/// Read the services to offer from the command line. Everything not asked for stays off
+/// </summary>
+/// <param name="pCommandLine">Command line arguments</param>
+/// <param name="options">Receives the options</param>
+void ParseServiceOptions(LPCWSTR pCommandLine, ServiceOptions& options)
+{
+    strcpy_s(options.previewAddress, DEFAULT_PREVIEW_ADDRESS);
+    options.previewPort = DEFAULT_PREVIEW_PORT;
+    options.preview     = ParseServiceSwitch(pCommandLine, L"-preview", options.previewAddress, options.previewPort);
+
+    strcpy_s(options.publishAddress, DEFAULT_PUBLISH_ADDRESS);
+    options.publishPort = DEFAULT_PUBLISH_PORT;
+    options.publish     = ParseServiceSwitch(pCommandLine, L"-publish", options.publishAddress, options.publishPort);
+
+    options.frameBus    = nullptr != wcsstr(pCommandLine, L"-framebus");
+}
+
 /// <summary>
 /// Entry point for the application
 /// </summary>
@@ -50,6 +122,8 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmd
 {
     EnsureIndependentResourcesCreated();
 
+    ParseServiceOptions(lpCmdLine, g_serviceOptions);
+
     CMainWindow application;
     int result = application.Run();
 
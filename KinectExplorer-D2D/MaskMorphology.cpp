@@ -0,0 +1,271 @@
+//------------------------------------------------------------------------------
+// <copyright file="MaskMorphology.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "MaskMorphology.h"
+
+#define ALL_BITS    (~0ULL)
+
+/// <summary>
+/// Intersect or unite a row of words into another
+/// </summary>
+static inline void CombineWords(ULONGLONG* pTarget, const ULONGLONG* pSource, UINT count, bool intersect)
+{
+    UINT w = 0;
+
+    if (intersect)
+    {
+#ifdef NUI_USE_SSE2
+        for (; w + 2 <= count; w += 2)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i*)(pTarget + w));
+            __m128i b = _mm_loadu_si128((const __m128i*)(pSource + w));
+            _mm_storeu_si128((__m128i*)(pTarget + w), _mm_and_si128(a, b));
+        }
+#endif
+        for (; w < count; w++)
+        {
+            pTarget[w] &= pSource[w];
+        }
+    }
+    else
+    {
+#ifdef NUI_USE_SSE2
+        for (; w + 2 <= count; w += 2)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i*)(pTarget + w));
+            __m128i b = _mm_loadu_si128((const __m128i*)(pSource + w));
+            _mm_storeu_si128((__m128i*)(pTarget + w), _mm_or_si128(a, b));
+        }
+#endif
+        for (; w < count; w++)
+        {
+            pTarget[w] |= pSource[w];
+        }
+    }
+}
+
+/// <summary>
+/// Constructor
+/// </summary>
+MaskMorphology::MaskMorphology()
+{
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+MaskMorphology::~MaskMorphology()
+{
+}
+
+/// <summary>
+/// Erode a mask
+/// </summary>
+/// <param name="source">Mask to erode</param>
+/// <param name="target">Receives the result, may be the source</param>
+/// <param name="shape">Structuring element shape</param>
+/// <param name="radiusX">Horizontal radius, also the disc radius</param>
+/// <param name="radiusY">Vertical radius, ignored for a disc</param>
+void MaskMorphology::Erode(const PackedBitmask& source, PackedBitmask& target, MORPHOLOGY_SHAPE shape, UINT radiusX, UINT radiusY)
+{
+    Apply(source, target, shape, radiusX, radiusY, true);
+}
+
+/// <summary>
+/// Dilate a mask
+/// </summary>
+/// <param name="source">Mask to dilate</param>
+/// <param name="target">Receives the result, may be the source</param>
+/// <param name="shape">Structuring element shape</param>
+/// <param name="radiusX">Horizontal radius, also the disc radius</param>
+/// <param name="radiusY">Vertical radius, ignored for a disc</param>
+void MaskMorphology::Dilate(const PackedBitmask& source, PackedBitmask& target, MORPHOLOGY_SHAPE shape, UINT radiusX, UINT radiusY)
+{
+    Apply(source, target, shape, radiusX, radiusY, false);
+}
+
+/// <summary>
+/// Remove specks smaller than the structuring element
+/// </summary>
+/// <param name="source">Mask to open</param>
+/// <param name="target">Receives the result, may be the source</param>
+/// <param name="shape">Structuring element shape</param>
+/// <param name="radiusX">Horizontal radius, also the disc radius</param>
+/// <param name="radiusY">Vertical radius, ignored for a disc</param>
+void MaskMorphology::Open(const PackedBitmask& source, PackedBitmask& target, MORPHOLOGY_SHAPE shape, UINT radiusX, UINT radiusY)
+{
+    Apply(source, target, shape, radiusX, radiusY, true);
+    Apply(target, target, shape, radiusX, radiusY, false);
+}
+
+/// <summary>
+/// Fill holes and gaps smaller than the structuring element
+/// </summary>
+/// <param name="source">Mask to close</param>
+/// <param name="target">Receives the result, may be the source</param>
+/// <param name="shape">Structuring element shape</param>
+/// <param name="radiusX">Horizontal radius, also the disc radius</param>
+/// <param name="radiusY">Vertical radius, ignored for a disc</param>
+void MaskMorphology::Close(const PackedBitmask& source, PackedBitmask& target, MORPHOLOGY_SHAPE shape, UINT radiusX, UINT radiusY)
+{
+    Apply(source, target, shape, radiusX, radiusY, false);
+    Apply(target, target, shape, radiusX, radiusY, true);
+}
+
+/// <summary>
+/// Apply a structuring element to a mask
+/// </summary>
+void MaskMorphology::Apply(const PackedBitmask& source, PackedBitmask& target, MORPHOLOGY_SHAPE shape, UINT radiusX, UINT radiusY, bool erode)
+{
+    UINT width  = source.GetWidth();
+    UINT height = source.GetHeight();
+
+    if (0 == width || 0 == height)
+    {
+        target.Resize(width, height);
+        return;
+    }
+
+    m_rows.Resize(width, height);
+    m_columns.Resize(width, height);
+    m_line.resize(source.GetWordsPerRow());
+
+    if (MORPHOLOGY_RECTANGLE == shape)
+    {
+        // Separable: a row pass then a column pass
+        RowPass(source, m_rows, radiusX, erode);
+        target.Resize(width, height);
+        ColumnPass(m_rows, target, radiusY, erode);
+        return;
+    }
+
+    if (&target != &source)
+    {
+        target.CopyFrom(source);
+    }
+
+    // Alternating 3x3 squares and crosses grow an octagon, close to a disc
+    for (UINT step = 0; step < radiusX; step++)
+    {
+        RowPass(target, m_rows, 1, erode);
+
+        if (0 == step % 2)
+        {
+            ColumnPass(m_rows, target, 1, erode);
+        }
+        else
+        {
+            // A cross is the union of a row and a column, its erosion is the intersection of both
+            ColumnPass(target, m_columns, 1, erode);
+            target.CopyFrom(m_rows);
+            Combine(target, m_columns, erode);
+        }
+    }
+}
+
+/// <summary>
+/// Erode or dilate every row by a horizontal line
+/// </summary>
+void MaskMorphology::RowPass(const PackedBitmask& source, PackedBitmask& target, UINT radius, bool erode)
+{
+    UINT wordsPerRow = source.GetWordsPerRow();
+    UINT tailBits    = source.GetWidth() % BITS_PER_MASK_WORD;
+    ULONGLONG tail   = (0 == tailBits) ? ALL_BITS : ((1ULL << tailBits) - 1);
+
+    // Outside pixels are set for erosion and unset for dilation
+    ULONGLONG outside = erode ? ALL_BITS : 0;
+    ULONGLONG* pLine  = &m_line[0];
+
+    target.Resize(source.GetWidth(), source.GetHeight());
+
+    for (UINT y = 0; y < source.GetHeight(); y++)
+    {
+        const ULONGLONG* pSource = source.GetRow(y);
+        for (UINT w = 0; w < wordsPerRow; w++)
+        {
+            pLine[w] = pSource[w];
+        }
+
+        // Padding bits of the last word act as outside pixels
+        if (erode)
+        {
+            pLine[wordsPerRow - 1] |= ~tail;
+        }
+
+        // Each step widens the line by one pixel on both sides
+        for (UINT step = 0; step < radius; step++)
+        {
+            ULONGLONG previous = outside;
+            for (UINT w = 0; w < wordsPerRow; w++)
+            {
+                ULONGLONG current = pLine[w];
+                ULONGLONG next    = (w + 1 < wordsPerRow) ? pLine[w + 1] : outside;
+
+                // Bit x of the shifted words holds pixel x - 1 and pixel x + 1
+                ULONGLONG left  = (current << 1) | (previous >> (BITS_PER_MASK_WORD - 1));
+                ULONGLONG right = (current >> 1) | (next << (BITS_PER_MASK_WORD - 1));
+
+                pLine[w] = erode ? (current & left & right) : (current | left | right);
+                previous = current;
+            }
+
+            if (!erode)
+            {
+                pLine[wordsPerRow - 1] &= tail;
+            }
+        }
+
+        ULONGLONG* pTarget = target.GetRow(y);
+        for (UINT w = 0; w < wordsPerRow; w++)
+        {
+            pTarget[w] = pLine[w];
+        }
+        pTarget[wordsPerRow - 1] &= tail;
+    }
+}
+
+/// <summary>
+/// Erode or dilate every column by a vertical line
+/// </summary>
+void MaskMorphology::ColumnPass(const PackedBitmask& source, PackedBitmask& target, UINT radius, bool erode)
+{
+    UINT wordsPerRow = source.GetWordsPerRow();
+    int  height      = (int)source.GetHeight();
+
+    target.Resize(source.GetWidth(), source.GetHeight());
+
+    for (int y = 0; y < height; y++)
+    {
+        // Rows past the border are outside and do not change the result
+        int first = y - (int)radius;
+        int last  = y + (int)radius;
+        first = first < 0 ? 0 : first;
+        last  = last >= height ? height - 1 : last;
+
+        ULONGLONG* pTarget = target.GetRow(y);
+        const ULONGLONG* pFirst = source.GetRow(first);
+        for (UINT w = 0; w < wordsPerRow; w++)
+        {
+            pTarget[w] = pFirst[w];
+        }
+
+        for (int row = first + 1; row <= last; row++)
+        {
+            CombineWords(pTarget, source.GetRow(row), wordsPerRow, erode);
+        }
+    }
+}
+
+/// <summary>
+/// Combine two masks word by word into the first
+/// </summary>
+void MaskMorphology::Combine(PackedBitmask& target, const PackedBitmask& other, bool intersect)
+{
+    for (UINT y = 0; y < target.GetHeight(); y++)
+    {
+        CombineWords(target.GetRow(y), other.GetRow(y), target.GetWordsPerRow(), intersect);
+    }
+}
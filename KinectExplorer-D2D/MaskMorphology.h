@@ -0,0 +1,107 @@
+//------------------------------------------------------------------------------
+// <copyright file="MaskMorphology.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include "NuiTypes.h"
+#include "PackedBitmask.h"
+
+/// <summary>
+/// Structuring element shape
+/// </summary>
+enum MORPHOLOGY_SHAPE
+{
+    MORPHOLOGY_RECTANGLE,   // (2 * radiusX + 1) x (2 * radiusY + 1), applied as a row pass and a column pass
+    MORPHOLOGY_DISC,        // Octagon of radiusX, applied as alternating 3x3 square and cross steps
+};
+
+/// <summary>
+/// Erosion, dilation, opening and closing of packed masks, 64 pixels per word.
+/// Row passes shift whole words and carry the edge bits between neighbouring words,
+/// column passes combine rows two words at a time. Pixels outside the mask count as
+/// set for erosion and unset for dilation, so blobs touching the border keep their size.
+/// </summary>
+class MaskMorphology
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    MaskMorphology();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~MaskMorphology();
+
+public:
+    /// <summary>
+    /// Erode a mask
+    /// </summary>
+    /// <param name="source">Mask to erode</param>
+    /// <param name="target">Receives the result, may be the source</param>
+    /// <param name="shape">Structuring element shape</param>
+    /// <param name="radiusX">Horizontal radius, also the disc radius</param>
+    /// <param name="radiusY">Vertical radius, ignored for a disc</param>
+    void Erode(const PackedBitmask& source, PackedBitmask& target, MORPHOLOGY_SHAPE shape, UINT radiusX, UINT radiusY);
+
+    /// <summary>
+    /// Dilate a mask
+    /// </summary>
+    /// <param name="source">Mask to dilate</param>
+    /// <param name="target">Receives the result, may be the source</param>
+    /// <param name="shape">Structuring element shape</param>
+    /// <param name="radiusX">Horizontal radius, also the disc radius</param>
+    /// <param name="radiusY">Vertical radius, ignored for a disc</param>
+    void Dilate(const PackedBitmask& source, PackedBitmask& target, MORPHOLOGY_SHAPE shape, UINT radiusX, UINT radiusY);
+
+    /// <summary>
+    /// Remove specks smaller than the structuring element
+    /// </summary>
+    /// <param name="source">Mask to open</param>
+    /// <param name="target">Receives the result, may be the source</param>
+    /// <param name="shape">Structuring element shape</param>
+    /// <param name="radiusX">Horizontal radius, also the disc radius</param>
+    /// <param name="radiusY">Vertical radius, ignored for a disc</param>
+    void Open(const PackedBitmask& source, PackedBitmask& target, MORPHOLOGY_SHAPE shape, UINT radiusX, UINT radiusY);
+
+    /// <summary>
+    /// Fill holes and gaps smaller than the structuring element
+    /// </summary>
+    /// <param name="source">Mask to close</param>
+    /// <param name="target">Receives the result, may be the source</param>
+    /// <param name="shape">Structuring element shape</param>
+    /// <param name="radiusX">Horizontal radius, also the disc radius</param>
+    /// <param name="radiusY">Vertical radius, ignored for a disc</param>
+    void Close(const PackedBitmask& source, PackedBitmask& target, MORPHOLOGY_SHAPE shape, UINT radiusX, UINT radiusY);
+
+private:
+    /// <summary>
+    /// Apply a structuring element to a mask
+    /// </summary>
+    void Apply(const PackedBitmask& source, PackedBitmask& target, MORPHOLOGY_SHAPE shape, UINT radiusX, UINT radiusY, bool erode);
+
+    /// <summary>
+    /// Erode or dilate every row by a horizontal line
+    /// </summary>
+    void RowPass(const PackedBitmask& source, PackedBitmask& target, UINT radius, bool erode);
+
+    /// <summary>
+    /// Erode or dilate every column by a vertical line
+    /// </summary>
+    void ColumnPass(const PackedBitmask& source, PackedBitmask& target, UINT radius, bool erode);
+
+    /// <summary>
+    /// Combine two masks word by word into the first
+    /// </summary>
+    void Combine(PackedBitmask& target, const PackedBitmask& other, bool intersect);
+
+private:
+    PackedBitmask           m_rows;     // Row pass result
+    PackedBitmask           m_columns;  // Column pass result of cross steps
+    std::vector<ULONGLONG>  m_line;     // One row of words
+};
@@ -0,0 +1,501 @@
+//------------------------------------------------------------------------------
+// <copyright file="MjpegServer.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "MjpegServer.h"
+#include "JpegEncoder.h"
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>
+#include <string.h>
+
+#define DEFAULT_MAX_FRAME_RATE  15
+#define DEFAULT_MAX_WIDTH       320
+#define DEFAULT_QUALITY         70
+#define DEFAULT_BANDWIDTH       250000      // Bytes per second, 2 Mbit/s
+#define MINIMUM_QUALITY         20
+#define QUALITY_STEP            5
+#define QUALITY_RAISE_RATIO     0.75        // Raise quality when frames use less of their budget than this
+#define BURST_SECONDS           0.25        // Token bucket depth
+#define MAX_DOWNSCALE           8
+#define MAX_CLIENTS             4
+#define IDLE_ACCEPT_TIMEOUT     100         // Milliseconds
+#define FRAME_WAIT_TIMEOUT      50          // Milliseconds
+#define REQUEST_TIMEOUT         500         // Milliseconds, a connection still without a full request is closed
+#define REQUEST_POLL_INTERVAL   10          // Milliseconds
+#define MAX_REQUEST_SIZE        8192        // Bytes
+#define SEND_TIMEOUT            100         // Milliseconds, a client slower than this for a frame is dropped
+
+static const char StreamHeader[] =
+    "HTTP/1.0 200 OK\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Pragma: no-cache\r\n"
+    "Connection: close\r\n"
+    "Content-Type: multipart/x-mixed-replace; boundary=frame\r\n"
+    "\r\n";
+
+/// <summary>
+/// Get a steady clock time in microseconds
+/// </summary>
+static inline ULONGLONG GetMicroseconds()
+{
+    return (ULONGLONG)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// <summary>
+/// Format the part header in front of a JPEG frame
+/// </summary>
+/// <returns>Length of the header in bytes</returns>
+static UINT FormatPartHeader(char* pBuffer, UINT frameSize)
+{
+    static const char Prefix[] = "--frame\r\nContent-Type: image/jpeg\r\nContent-Length: ";
+
+    UINT length = sizeof(Prefix) - 1;
+    memcpy(pBuffer, Prefix, length);
+
+    char digits[10];
+    UINT count = 0;
+    do
+    {
+        digits[count++] = (char)('0' + frameSize % 10);
+        frameSize /= 10;
+    } while (frameSize > 0);
+
+    while (count > 0)
+    {
+        pBuffer[length++] = digits[--count];
+    }
+
+    memcpy(pBuffer + length, "\r\n\r\n", 4);
+    return length + 4;
+}
+
+/// <summary>
+/// Run the calling thread below normal priority
+/// </summary>
+static void LowerThreadPriority()
+{
+#ifdef _WIN32
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+#else
+    setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), getpriority(PRIO_PROCESS, 0) + 5);
+#endif
+}
+
+/// <summary>
+/// Constructor
+/// </summary>
+MjpegServer::MjpegServer()
+    : m_clientCount(0)
+    , m_running(false)
+    , m_maxFrameRate(DEFAULT_MAX_FRAME_RATE)
+    , m_maxWidth(DEFAULT_MAX_WIDTH)
+    , m_maxQuality(DEFAULT_QUALITY)
+    , m_bandwidth(DEFAULT_BANDWIDTH)
+    , m_lastSubmitTime(0)
+    , m_hasPending(false)
+    , m_pendingWidth(0)
+    , m_pendingHeight(0)
+    , m_frameWidth(0)
+    , m_frameHeight(0)
+    , m_quality(DEFAULT_QUALITY)
+    , m_tokens(0.0)
+    , m_refillTime(0)
+{
+    ZeroMemory(&m_stats, sizeof(m_stats));
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+MjpegServer::~MjpegServer()
+{
+    Stop();
+}
+
+/// <summary>
+/// Listen on a local address and port and start the server thread
+/// </summary>
+/// <param name="address">Local IPv4 address in dotted form, 0.0.0.0 to serve every interface</param>
+/// <param name="port">Local port</param>
+/// <returns>Indicates success or failure</returns>
+HRESULT MjpegServer::Start(const char* address, USHORT port)
+{
+    Stop();
+
+    HRESULT hr = m_listener.Listen(address, port);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    m_quality    = m_maxQuality;
+    m_tokens     = 0.0;
+    m_refillTime = GetMicroseconds();
+
+    m_running = true;
+    m_thread  = std::thread(&MjpegServer::ServerProc, this);
+
+    return S_OK;
+}
+
+/// <summary>
+/// Stop the server thread and close all connections
+/// </summary>
+void MjpegServer::Stop()
+{
+    if (m_thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_frameLock);
+            m_running = false;
+        }
+        m_frameReady.notify_one();
+        m_thread.join();
+    }
+
+    CloseClients();
+    m_listener.Close();
+}
+
+/// <summary>
+/// Set the highest frame rate taken from SubmitFrame
+/// </summary>
+/// <param name="frameRate">Frames per second</param>
+void MjpegServer::SetMaxFrameRate(UINT frameRate)
+{
+    m_maxFrameRate = frameRate < 1 ? 1 : frameRate;
+}
+
+/// <summary>
+/// Set the widest frame sent. Wider frames are shrunk by the smallest whole factor which fits
+/// </summary>
+/// <param name="width">Width in pixels</param>
+void MjpegServer::SetMaxWidth(UINT width)
+{
+    m_maxWidth = width < 16 ? 16 : width;
+}
+
+/// <summary>
+/// Set the best quality used. Quality drops below it to fit the bandwidth
+/// </summary>
+/// <param name="quality">Quality from 1 to 100</param>
+void MjpegServer::SetQuality(UINT quality)
+{
+    m_maxQuality = quality < 1 ? 1 : (quality > 100 ? 100 : quality);
+}
+
+/// <summary>
+/// Set the bandwidth budget shared by all clients
+/// </summary>
+/// <param name="bytesPerSecond">Bytes per second</param>
+void MjpegServer::SetBandwidth(UINT bytesPerSecond)
+{
+    m_bandwidth = bytesPerSecond < 1 ? 1 : bytesPerSecond;
+}
+
+/// <summary>
+/// Offer a frame to the stream without waiting
+/// </summary>
+/// <param name="pPixels">The pointer to BGRX pixels</param>
+/// <param name="width">Image width</param>
+/// <param name="height">Image height</param>
+/// <param name="pOverlay">The pointer to the overlay to draw over the frame, or nullptr for none. A taken frame swaps it with an older overlay</param>
+/// <returns>True if the frame was taken, false if skipped by the caps or while the server is busy</returns>
+bool MjpegServer::SubmitFrame(const UINT* pPixels, UINT width, UINT height, OverlayList* pOverlay)
+{
+    // Without viewers the frame costs nothing
+    if (0 == m_clientCount || !pPixels || 0 == width || 0 == height)
+    {
+        return false;
+    }
+
+    ULONGLONG now = GetMicroseconds();
+    if (now - m_lastSubmitTime < 1000000 / m_maxFrameRate)
+    {
+        return false;
+    }
+
+    // The server thread only holds the lock to swap buffers, but even that is not waited for
+    std::unique_lock<std::mutex> lock(m_frameLock, std::try_to_lock);
+    if (!lock.owns_lock())
+    {
+        return false;
+    }
+
+    m_lastSubmitTime = now;
+
+    // A plain copy is all the submitting thread pays, the server thread shrinks the frame
+    m_pendingWidth  = width;
+    m_pendingHeight = height;
+    m_pending.resize(width * height);
+    memcpy(m_pending.data(), pPixels, width * height * sizeof(UINT));
+
+    // The overlay keeps source image positions, the compositor scales them to the frame.
+    // The caller rebuilds its overlay every frame, so it gets the older list back instead of a copy
+    if (pOverlay)
+    {
+        m_pendingOverlay.Swap(*pOverlay);
+    }
+    else
+    {
+        m_pendingOverlay.Clear();
+    }
+
+    m_hasPending = true;
+    lock.unlock();
+    m_frameReady.notify_one();
+
+    return true;
+}
+
+/// <summary>
+/// Get the stream counters
+/// </summary>
+MjpegServerStats MjpegServer::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_statsLock);
+    return m_stats;
+}
+
+/// <summary>
+/// Server thread procedure
+/// </summary>
+void MjpegServer::ServerProc()
+{
+    LowerThreadPriority();
+
+    // Encode on this thread alone, without a pool. Pool workers would run at normal priority on
+    // Windows and compete with detection, while a preview frame of DEFAULT_MAX_WIDTH takes a few milliseconds
+    JpegEncoder encoder;
+
+    while (m_running)
+    {
+        // Without clients there is no frame wait, so pending requests are polled at a short interval
+        AcceptClient(!m_clients.empty() ? 0 : (m_requests.empty() ? IDLE_ACCEPT_TIMEOUT : REQUEST_POLL_INTERVAL));
+        ReadRequests();
+        if (m_clients.empty())
+        {
+            continue;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(m_frameLock);
+            m_frameReady.wait_for(lock, std::chrono::milliseconds(FRAME_WAIT_TIMEOUT), [this] { return m_hasPending || !m_running; });
+            if (!m_hasPending || !m_running)
+            {
+                continue;
+            }
+
+            m_frame.swap(m_pending);
+            m_frameOverlay.Swap(m_pendingOverlay);
+            m_frameWidth  = m_pendingWidth;
+            m_frameHeight = m_pendingHeight;
+            m_hasPending  = false;
+        }
+
+        SendFrame(encoder);
+    }
+}
+
+/// <summary>
+/// Accept a waiting connection, its request is read later
+/// </summary>
+/// <param name="timeout">Longest wait for a connection in milliseconds</param>
+void MjpegServer::AcceptClient(UINT timeout)
+{
+    TcpSocket* pClient = new TcpSocket();
+    if (S_OK != m_listener.Accept(*pClient, timeout) || m_clients.size() + m_requests.size() >= MAX_CLIENTS)
+    {
+        delete pClient;
+        return;
+    }
+
+    PendingRequest request = {pClient, GetMicroseconds(), 0, false};
+    m_requests.push_back(request);
+}
+
+/// <summary>
+/// Read what arrived of the requests of new connections without waiting, and start
+/// the stream for those complete
+/// </summary>
+void MjpegServer::ReadRequests()
+{
+    ULONGLONG now = GetMicroseconds();
+
+    for (size_t i = 0; i < m_requests.size();)
+    {
+        PendingRequest& request = m_requests[i];
+
+        // Any request gets the stream, so only look for the empty line ending its header
+        char    buffer[512];
+        UINT    size;
+        bool    complete = false;
+        HRESULT hr       = S_OK;
+        while (!complete && request.size < MAX_REQUEST_SIZE && S_OK == (hr = request.pSocket->Receive(buffer, sizeof(buffer), 0, size)))
+        {
+            request.size += size;
+            for (UINT j = 0; j < size && !complete; j++)
+            {
+                if ('\n' == buffer[j])
+                {
+                    complete          = request.lineEmpty;
+                    request.lineEmpty = true;
+                }
+                else if ('\r' != buffer[j])
+                {
+                    request.lineEmpty = false;
+                }
+            }
+        }
+
+        if (complete && S_OK == request.pSocket->Send(StreamHeader, sizeof(StreamHeader) - 1, SEND_TIMEOUT))
+        {
+            m_clients.push_back(request.pSocket);
+        }
+        else if (complete || FAILED(hr) || request.size >= MAX_REQUEST_SIZE || now - request.acceptTime > REQUEST_TIMEOUT * 1000ULL)
+        {
+            delete request.pSocket;
+        }
+        else
+        {
+            ++i;
+            continue;
+        }
+
+        m_requests.erase(m_requests.begin() + i);
+    }
+
+    m_clientCount = (UINT)m_clients.size();
+}
+
+/// <summary>
+/// Draw, encode and send the frame taken from the pending buffer
+/// </summary>
+/// <param name="encoder">Encoder owned by the server thread</param>
+void MjpegServer::SendFrame(JpegEncoder& encoder)
+{
+    // Refill the token bucket, a full bucket holds a short burst
+    UINT      bandwidth = m_bandwidth;
+    ULONGLONG now       = GetMicroseconds();
+    double    burst     = bandwidth * BURST_SECONDS;
+
+    m_tokens    += bandwidth * ((now - m_refillTime) / 1000000.0);
+    m_tokens     = m_tokens > burst ? burst : m_tokens;
+    m_refillTime = now;
+
+    // Frames are skipped while the budget is overdrawn, lowering the frame rate
+    if (m_tokens < 0.0)
+    {
+        std::lock_guard<std::mutex> lock(m_statsLock);
+        ++m_stats.framesDropped;
+        return;
+    }
+
+    ShrinkFrame();
+    DrawOverlay();
+
+    encoder.SetQuality(m_quality);
+    UINT frameSize = encoder.Encode(m_frame.data(), m_frameWidth, m_frameHeight);
+    if (0 == frameSize)
+    {
+        return;
+    }
+
+    char header[128];
+    UINT headerSize = FormatPartHeader(header, frameSize);
+
+    for (size_t i = 0; i < m_clients.size();)
+    {
+        TcpSocket* pClient = m_clients[i];
+        if (S_OK != pClient->Send(header, headerSize, SEND_TIMEOUT) ||
+            S_OK != pClient->Send(encoder.GetData(), frameSize, SEND_TIMEOUT) ||
+            S_OK != pClient->Send("\r\n", 2, SEND_TIMEOUT))
+        {
+            // A partly sent frame breaks the stream, so the client is dropped
+            delete pClient;
+            m_clients.erase(m_clients.begin() + i);
+            continue;
+        }
+        ++i;
+    }
+    m_clientCount = (UINT)m_clients.size();
+
+    UINT bytesSent = (frameSize + headerSize + 2) * (UINT)m_clients.size();
+    m_tokens -= bytesSent;
+
+    // Steer quality so a frame for every client fits the budget at the frame rate cap
+    double budget     = (double)bandwidth / m_maxFrameRate / (m_clients.empty() ? 1 : m_clients.size());
+    UINT   maxQuality = m_maxQuality;
+    if (frameSize > budget && m_quality > MINIMUM_QUALITY)
+    {
+        m_quality = m_quality > MINIMUM_QUALITY + QUALITY_STEP ? m_quality - QUALITY_STEP : MINIMUM_QUALITY;
+    }
+    else if (frameSize < budget * QUALITY_RAISE_RATIO && m_quality < maxQuality)
+    {
+        m_quality = m_quality + QUALITY_STEP < maxQuality ? m_quality + QUALITY_STEP : maxQuality;
+    }
+    m_quality = m_quality > maxQuality ? maxQuality : m_quality;
+
+    std::lock_guard<std::mutex> lock(m_statsLock);
+    m_stats.clientCount = m_clientCount;
+    m_stats.width       = m_frameWidth;
+    m_stats.height      = m_frameHeight;
+    m_stats.quality     = encoder.GetQuality();
+    m_stats.framesSent++;
+    m_stats.bytesSent  += bytesSent;
+}
+
+/// <summary>
+/// Box filter the frame in place down to the width cap
+/// </summary>
+void MjpegServer::ShrinkFrame()
+{
+    UINT maxWidth = m_maxWidth;
+    UINT scale    = (m_frameWidth + maxWidth - 1) / maxWidth;
+    scale = scale > MAX_DOWNSCALE ? MAX_DOWNSCALE : scale;
+    if (scale <= 1)
+    {
+        return;
+    }
+
+    m_downscaler.Shrink(m_frame.data(), m_frameWidth, m_frameHeight, scale, m_frame.data());
+    m_frameWidth  /= scale;
+    m_frameHeight /= scale;
+}
+
+/// <summary>
+/// Draw the overlay into the frame
+/// </summary>
+void MjpegServer::DrawOverlay()
+{
+    m_compositor.BeginFrame(m_frame.data(), m_frameWidth, m_frameHeight);
+    m_compositor.Draw(m_frameOverlay);
+}
+
+/// <summary>
+/// Close all connections
+/// </summary>
+void MjpegServer::CloseClients()
+{
+    for (size_t i = 0; i < m_requests.size(); i++)
+    {
+        delete m_requests[i].pSocket;
+    }
+
+    for (size_t i = 0; i < m_clients.size(); i++)
+    {
+        delete m_clients[i];
+    }
+
+    m_requests.clear();
+    m_clients.clear();
+    m_clientCount = 0;
+}
@@ -0,0 +1,211 @@
+//------------------------------------------------------------------------------
+// <copyright file="MjpegServer.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "NuiTypes.h"
+#include "BoxDownscaler.h"
+#include "OverlayCompositor.h"
+#include "OverlayList.h"
+#include "TcpSocket.h"
+
+class JpegEncoder;
+
+/// <summary>
+/// Counters of the preview stream
+/// </summary>
+struct MjpegServerStats
+{
+    UINT        clientCount;
+    UINT        width;              // Size of the frames sent
+    UINT        height;
+    UINT        quality;            // Quality in effect
+    ULONGLONG   framesSent;
+    ULONGLONG   framesDropped;      // Frames skipped to stay within the bandwidth
+    ULONGLONG   bytesSent;
+};
+
+/// <summary>
+/// Embedded HTTP server which streams preview frames as multipart MJPEG, viewable
+/// in any browser. Submitting a frame only copies it into a pending buffer and takes
+/// over the overlay, and gives up instead of waiting when the server thread holds it,
+/// so the caller is never stalled. Requests of new connections are read as they
+/// arrive without waiting, so a silent connection cannot stall the stream of the
+/// others. A below normal priority thread box filters the
+/// frame down to the width cap, draws the overlay with the CPU compositor, encodes
+/// with the JPEG encoder and writes to all clients. The frame
+/// rate and width caps bound the work, and a token bucket with adaptive quality
+/// keeps the stream within the bandwidth budget. Clients which cannot keep up are
+/// dropped.
+/// </summary>
+class MjpegServer
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    MjpegServer();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~MjpegServer();
+
+public:
+    /// <summary>
+    /// Listen on a local address and port and start the server thread
+    /// </summary>
+    /// <param name="address">Local IPv4 address in dotted form, 0.0.0.0 to serve every interface</param>
+    /// <param name="port">Local port</param>
+    /// <returns>Indicates success or failure</returns>
+    HRESULT Start(const char* address, USHORT port);
+
+    /// <summary>
+    /// Stop the server thread and close all connections
+    /// </summary>
+    void Stop();
+
+    /// <summary>
+    /// Set the highest frame rate taken from SubmitFrame
+    /// </summary>
+    /// <param name="frameRate">Frames per second</param>
+    void SetMaxFrameRate(UINT frameRate);
+
+    /// <summary>
+    /// Set the widest frame sent. Wider frames are shrunk by the smallest whole factor which fits
+    /// </summary>
+    /// <param name="width">Width in pixels</param>
+    void SetMaxWidth(UINT width);
+
+    /// <summary>
+    /// Set the best quality used. Quality drops below it to fit the bandwidth
+    /// </summary>
+    /// <param name="quality">Quality from 1 to 100</param>
+    void SetQuality(UINT quality);
+
+    /// <summary>
+    /// Set the bandwidth budget shared by all clients
+    /// </summary>
+    /// <param name="bytesPerSecond">Bytes per second</param>
+    void SetBandwidth(UINT bytesPerSecond);
+
+    /// <summary>
+    /// Indicates whether any client is connected
+    /// </summary>
+    bool HasClients() const
+    {
+        return m_clientCount > 0;
+    }
+
+    /// <summary>
+    /// Offer a frame to the stream without waiting
+    /// </summary>
+    /// <param name="pPixels">The pointer to BGRX pixels</param>
+    /// <param name="width">Image width</param>
+    /// <param name="height">Image height</param>
+    /// <param name="pOverlay">The pointer to the overlay to draw over the frame, or nullptr for none. A taken frame swaps it with an older overlay</param>
+    /// <returns>True if the frame was taken, false if skipped by the caps or while the server is busy</returns>
+    bool SubmitFrame(const UINT* pPixels, UINT width, UINT height, OverlayList* pOverlay);
+
+    /// <summary>
+    /// Get the stream counters
+    /// </summary>
+    MjpegServerStats GetStats() const;
+
+private:
+    /// <summary>
+    /// Server thread procedure
+    /// </summary>
+    void ServerProc();
+
+    /// <summary>
+    /// Accept a waiting connection, its request is read later
+    /// </summary>
+    /// <param name="timeout">Longest wait for a connection in milliseconds</param>
+    void AcceptClient(UINT timeout);
+
+    /// <summary>
+    /// Read what arrived of the requests of new connections without waiting, and start
+    /// the stream for those complete
+    /// </summary>
+    void ReadRequests();
+
+    /// <summary>
+    /// Draw, encode and send the frame taken from the pending buffer
+    /// </summary>
+    /// <param name="encoder">Encoder owned by the server thread</param>
+    void SendFrame(JpegEncoder& encoder);
+
+    /// <summary>
+    /// Box filter the frame in place down to the width cap
+    /// </summary>
+    void ShrinkFrame();
+
+    /// <summary>
+    /// Draw the overlay into the frame
+    /// </summary>
+    void DrawOverlay();
+
+    /// <summary>
+    /// Close all connections
+    /// </summary>
+    void CloseClients();
+
+private:
+    /// <summary>
+    /// Connection whose request has not fully arrived
+    /// </summary>
+    struct PendingRequest
+    {
+        TcpSocket*  pSocket;
+        ULONGLONG   acceptTime;     // Microseconds
+        UINT        size;           // Bytes received
+        bool        lineEmpty;      // True at the start of a line, an empty line ends the request
+    };
+
+    TcpSocket                       m_listener;
+    std::vector<PendingRequest>     m_requests;         // Used by the server thread only
+    std::vector<TcpSocket*>         m_clients;          // Used by the server thread only
+    std::atomic<UINT>               m_clientCount;
+    std::thread                     m_thread;
+    std::atomic<bool>               m_running;
+
+    std::atomic<UINT>               m_maxFrameRate;
+    std::atomic<UINT>               m_maxWidth;
+    std::atomic<UINT>               m_maxQuality;
+    std::atomic<UINT>               m_bandwidth;
+    ULONGLONG                       m_lastSubmitTime;   // Microseconds, used by the submitting thread only
+
+    // Frame handed from SubmitFrame to the server thread, latest wins
+    std::mutex                      m_frameLock;
+    std::condition_variable         m_frameReady;
+    bool                            m_hasPending;
+    std::vector<UINT>               m_pending;
+    UINT                            m_pendingWidth;
+    UINT                            m_pendingHeight;
+    OverlayList                     m_pendingOverlay;
+
+    // Frame being encoded, swapped with the pending one
+    std::vector<UINT>               m_frame;
+    UINT                            m_frameWidth;
+    UINT                            m_frameHeight;
+    OverlayList                     m_frameOverlay;
+    BoxDownscaler                   m_downscaler;       // Used by the server thread only
+    OverlayCompositor               m_compositor;       // Used by the server thread only
+
+    // Rate control
+    UINT                            m_quality;
+    double                          m_tokens;           // Bytes which may be sent right away
+    ULONGLONG                       m_refillTime;       // Microseconds
+
+    mutable std::mutex              m_statsLock;
+    MjpegServerStats                m_stats;
+};
@@ -8,6 +8,8 @@
 #include "NuiAccelerometerStream.h"
 #include "Utility.h"
 
+#define ELEVATION_POLL_TICKS    25      // The motor angle is read on every 25th reading
+
 /// <summary>
 /// Constructor
 /// </summary>
@@ -15,7 +17,11 @@
 NuiAccelerometerStream::NuiAccelerometerStream(INuiSensor* pNuiSensor)
     : m_pNuiSensor(pNuiSensor)
     , m_pAccelerometerViewer(nullptr)
+    , m_elevation(0)
+    , m_elevationTicks(0)
 {
+    ZeroMemory(&m_reading, sizeof(m_reading));
+
     if (m_pNuiSensor)
     {
         m_pNuiSensor->AddRef();
@@ -57,9 +63,44 @@ void NuiAccelerometerStream::ProcessStream()
     Vector4 reading;
     HRESULT hr = m_pNuiSensor->NuiAccelerometerGetCurrentReading(&reading);
 
+    if (SUCCEEDED(hr))
+    {
+        // Keep the reading for the floor estimation of the depth stream
+        m_reading = reading;
+    }
+
+    // Reading the motor angle is slow, it only changes when the sensor is tilted
+    if (0 == m_elevationTicks)
+    {
+        LONG elevation = 0;
+        if (SUCCEEDED(m_pNuiSensor->NuiCameraElevationGetAngle(&elevation)))
+        {
+            m_elevation = elevation;
+        }
+    }
+    m_elevationTicks = (m_elevationTicks + 1) % ELEVATION_POLL_TICKS;
+
     if (SUCCEEDED(hr) && m_pAccelerometerViewer)
     {
         // Set the reading to viewer
         m_pAccelerometerViewer->SetAccelerometerReadings(reading.x, reading.y, reading.z);
     }
+}
+
+/// <summary>
+/// Get the last accelerometer reading
+/// </summary>
+/// <returns>Gravity in units of g, all zero until the first reading</returns>
+Vector4 NuiAccelerometerStream::GetReading() const
+{
+    return m_reading;
+}
+
+/// <summary>
+/// Get the last motor elevation angle
+/// </summary>
+/// <returns>Elevation angle in degrees</returns>
+LONG NuiAccelerometerStream::GetElevationAngle() const
+{
+    return m_elevation;
 }
\ No newline at end of file
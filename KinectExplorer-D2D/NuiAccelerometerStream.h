@@ -41,7 +41,22 @@ public:
     /// <returns>Always returns S_OK</returns>
     HRESULT StartStream();
 
+    /// <summary>
+    /// Get the last accelerometer reading
+    /// </summary>
+    /// <returns>Gravity in units of g, all zero until the first reading</returns>
+    Vector4 GetReading() const;
+
+    /// <summary>
+    /// Get the last motor elevation angle
+    /// </summary>
+    /// <returns>Elevation angle in degrees</returns>
+    LONG GetElevationAngle() const;
+
 private:
     INuiSensor*             m_pNuiSensor;
     NuiAccelerometerViewer* m_pAccelerometerViewer;
+    Vector4                 m_reading;
+    LONG                    m_elevation;
+    UINT                    m_elevationTicks;
 };
\ No newline at end of file
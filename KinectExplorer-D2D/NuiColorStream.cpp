@@ -8,6 +8,14 @@
 #include "NuiColorStream.h"
 #include "NuiStreamViewer.h"
 
+#define COLOR_TABLE_FILE        "ColorClasses.bin"
+#define RED_HUE_MINIMUM         340.0f  // Degrees, the red range wraps through zero
+#define RED_HUE_MAXIMUM         20.0f
+#define BLUE_HUE_MINIMUM        200.0f
+#define BLUE_HUE_MAXIMUM        250.0f
+#define BALL_SATURATION_MINIMUM 0.45f
+#define BALL_VALUE_MINIMUM      0.2f
+
 /// <summary>
 /// Constructor
 /// </summary>
@@ -17,6 +25,8 @@ NuiColorStream::NuiColorStream(INuiSensor* pNuiSensor)
     , m_imageType(NUI_IMAGE_TYPE_COLOR)
     , m_imageResolution(NUI_IMAGE_RESOLUTION_640x480)
 {
+    // The color gate of the ball detector stays idle without a table
+    LoadColorTable();
 }
 
 /// <summary>
@@ -130,6 +140,30 @@ void NuiColorStream::ProcessStreamFrame()
     }
 }
 
+/// <summary>
+/// Get the pixels of the last color frame if it is live color of a resolution
+/// </summary>
+/// <param name="resolution">Required resolution</param>
+/// <returns>BGRX pixels, or nullptr if paused, infrared or of another resolution</returns>
+const UINT* NuiColorStream::GetColorPixels(NUI_IMAGE_RESOLUTION resolution) const
+{
+    // Infrared holds no color and a paused stream holds a stale frame
+    if (m_paused || NUI_IMAGE_TYPE_COLOR_INFRARED == m_imageType || resolution != m_imageResolution)
+    {
+        return nullptr;
+    }
+
+    // The buffer keeps the old size until the first frame after a resolution change
+    DWORD width, height;
+    NuiImageResolutionToSize(resolution, width, height);
+    if (m_imageBuffer.GetFullWidth() != width || m_imageBuffer.GetFullHeight() != height)
+    {
+        return nullptr;
+    }
+
+    return m_imageBuffer.GetFullBuffer();
+}
+
 /// <summary>
 /// Process the incoming color frame
 /// </summary>
@@ -160,6 +194,15 @@ void NuiColorStream::ProcessColor()
     // Make sure we've received valid data
     if (lockedRect.Pitch != 0)
     {
+        // Shrink to the viewer while converting. The depth color gate and the frame bus still need the full resolution image
+        if (m_pStreamViewer)
+        {
+            UINT width, height;
+            m_pStreamViewer->GetDisplaySize(width, height);
+            m_imageBuffer.SetOutputSize(width, height);
+        }
+        m_imageBuffer.SetKeepFullResolution(NUI_IMAGE_TYPE_COLOR_INFRARED != m_imageType);
+
         switch (m_imageType)
         {
         case NUI_IMAGE_TYPE_COLOR_RAW_BAYER:    // Convert raw bayer data to color image and copy to image buffer
@@ -175,6 +218,17 @@ void NuiColorStream::ProcessColor()
             break;
         }
 
+        // Other processes read the converted full resolution image from the frame bus
+        const UINT* pFullImage = m_imageBuffer.GetFullBuffer();
+        if (m_pFrameBus && pFullImage)
+        {
+            DWORD width  = m_imageBuffer.GetFullWidth();
+            DWORD height = m_imageBuffer.GetFullHeight();
+
+            FrameBusFrameInfo info = {FrameBusColor, width, height, width * sizeof(UINT), width * height * sizeof(UINT), imageFrame.dwFrameNumber, imageFrame.liTimeStamp.QuadPart};
+            m_pFrameBus->Publish(info, pFullImage);
+        }
+
         if (m_pStreamViewer)
         {
             // Set image data to viewer
@@ -187,4 +241,24 @@ void NuiColorStream::ProcessColor()
 
 ReleaseFrame:
     m_pNuiSensor->NuiImageStreamReleaseFrame(m_hStreamHandle, &imageFrame);
-}
\ No newline at end of file
+}
+
+/// <summary>
+/// Load the trained color table, or fall back to the default ball colors
+/// </summary>
+/// <returns>S_OK if the trained table was loaded</returns>
+HRESULT NuiColorStream::LoadColorTable()
+{
+    std::shared_ptr<ColorClassTable> pTable = std::make_shared<ColorClassTable>();
+
+    HRESULT hr = pTable->Load(COLOR_TABLE_FILE);
+    if (FAILED(hr))
+    {
+        // Untrained, take any saturated red or blue, the colors of the two alliances' balls
+        pTable->AddRange(BALL_COLOR_CLASS, RED_HUE_MINIMUM, RED_HUE_MAXIMUM, BALL_SATURATION_MINIMUM, BALL_VALUE_MINIMUM);
+        pTable->AddRange(BALL_COLOR_CLASS, BLUE_HUE_MINIMUM, BLUE_HUE_MAXIMUM, BALL_SATURATION_MINIMUM, BALL_VALUE_MINIMUM);
+    }
+
+    m_colorClassifier.SetTable(pTable);
+    return hr;
+}
@@ -8,6 +8,9 @@
 
 #include "NuiStream.h"
 #include "NuiImageBuffer.h"
+#include "ColorClassifier.h"
+
+#define BALL_COLOR_CLASS    0   // Class of the ball colors in the color table
 
 class NuiColorStream : public NuiStream
 {
@@ -60,14 +63,37 @@ public:
     /// <param name="resolution">Image resolution to be set</param>
     void SetImageResolution(NUI_IMAGE_RESOLUTION resolution);
 
+    /// <summary>
+    /// Get the classifier holding the color table. Frames are not classified as a whole,
+    /// the depth color gate looks up only the pixels of ball candidates
+    /// </summary>
+    ColorClassifier& GetColorClassifier()
+    {
+        return m_colorClassifier;
+    }
+
+    /// <summary>
+    /// Get the pixels of the last color frame if it is live color of a resolution
+    /// </summary>
+    /// <param name="resolution">Required resolution</param>
+    /// <returns>BGRX pixels, or nullptr if paused, infrared or of another resolution</returns>
+    const UINT* GetColorPixels(NUI_IMAGE_RESOLUTION resolution) const;
+
 private:
     /// <summary>
     /// Process the incoming color frame
     /// </summary>
     void ProcessColor();
 
+    /// <summary>
+    /// Load the trained color table, or fall back to the default ball colors
+    /// </summary>
+    /// <returns>S_OK if the trained table was loaded</returns>
+    HRESULT LoadColorTable();
+
 private:
     NUI_IMAGE_TYPE       m_imageType;
     NUI_IMAGE_RESOLUTION m_imageResolution;
     NuiImageBuffer       m_imageBuffer;
+    ColorClassifier      m_colorClassifier;
 };
\ No newline at end of file
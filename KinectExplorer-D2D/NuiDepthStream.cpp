@@ -5,10 +5,16 @@
 //------------------------------------------------------------------------------
 
 #include "stdafx.h"
+#include <algorithm>
 #include <cmath>
+#include <vector>
 #include "NuiDepthStream.h"
 #include "NuiStreamViewer.h"
 
+#define BACKGROUND_MODEL_FILE           "DepthBackground.bin"
+#define REGISTRATION_FILE               "Registration.bin"
+#define REGISTRATION_COLOR_RESOLUTION   NUI_IMAGE_RESOLUTION_640x480
+
 /// <summary>
 /// Constructor
 /// <summary>
@@ -18,7 +24,18 @@ NuiDepthStream::NuiDepthStream(INuiSensor* pNuiSensor)
     , m_imageType(NUI_IMAGE_TYPE_DEPTH_AND_PLAYER_INDEX)
     , m_nearMode(false)
     , m_depthTreatment(CLAMP_UNRELIABLE_DEPTHS)
+    , m_pColorStream(nullptr)
+    , m_pAccelerometerStream(nullptr)
+    , m_pSkeletonStream(nullptr)
 {
+    // Foreground extraction runs in the same pass as depth conversion
+    m_imageBuffer.SetBackgroundModel(&m_backgroundModel);
+
+    // Temporal smoothing runs in the same pass as hole filling
+    m_depthPrefilter.SetTemporalFilter(&m_temporalFilter);
+
+    // Floor pixels are dropped before ball detection
+    m_ballDetector.SetFloorEstimator(&m_floorEstimator);
 }
 
 /// <summary>
@@ -26,6 +43,7 @@ NuiDepthStream::NuiDepthStream(INuiSensor* pNuiSensor)
 /// </summary>
 NuiDepthStream::~NuiDepthStream()
 {
+    SaveBackground();
 }
 
 /// <summary>
@@ -67,6 +85,174 @@ void NuiDepthStream::SetDepthTreatment(DEPTH_TREATMENT treatment)
     m_depthTreatment = treatment;
 }
 
+/// <summary>
+/// Get foreground mask extracted from the last depth frame
+/// </summary>
+/// <returns>Foreground mask</returns>
+const PackedBitmask& NuiDepthStream::GetForegroundMask() const
+{
+    return m_backgroundModel.GetForegroundMask();
+}
+
+/// <summary>
+/// Get foreground blobs found in the last depth frame
+/// </summary>
+/// <returns>Collection of blobs</returns>
+const std::vector<DepthBlob>& NuiDepthStream::GetBlobs() const
+{
+    return m_ballDetector.GetBlobs();
+}
+
+/// <summary>
+/// Get balls found in the last depth frame
+/// </summary>
+/// <returns>Collection of ball detections</returns>
+const std::vector<BallDetection>& NuiDepthStream::GetBallDetections() const
+{
+    return m_ballDetector.GetDetections();
+}
+
+/// <summary>
+/// Get balls tracked across depth frames
+/// </summary>
+/// <returns>Collection of tracks</returns>
+const std::vector<BallTrack>& NuiDepthStream::GetBallTracks() const
+{
+    return m_ballTracker.GetTracks();
+}
+
+/// <summary>
+/// Get the detection cost of the last depth frame
+/// </summary>
+/// <returns>Tracker metrics</returns>
+const BallTrackerMetrics& NuiDepthStream::GetTrackerMetrics() const
+{
+    return m_ballTracker.GetMetrics();
+}
+
+/// <summary>
+/// Get fitted trajectories and landing predictions of tracked balls
+/// </summary>
+/// <returns>Collection of trajectories</returns>
+const std::vector<BallTrajectory>& NuiDepthStream::GetTrajectories() const
+{
+    return m_trajectoryPredictor.GetTrajectories();
+}
+
+/// <summary>
+/// Get the candidate cascade of the ball detector with its rejection statistics
+/// </summary>
+/// <returns>Detection cascade</returns>
+const DetectionCascade& NuiDepthStream::GetDetectionCascade() const
+{
+    return m_ballDetector.GetCascade();
+}
+
+/// <summary>
+/// Set the color stream whose frames verify ball candidates
+/// </summary>
+/// <param name="pColorStream">The pointer to color stream, or nullptr for none</param>
+void NuiDepthStream::SetColorStream(NuiColorStream* pColorStream)
+{
+    m_pColorStream = pColorStream;
+}
+
+/// <summary>
+/// Set the accelerometer stream whose readings guide the floor estimation
+/// </summary>
+/// <param name="pAccelerometerStream">The pointer to accelerometer stream, or nullptr for none</param>
+void NuiDepthStream::SetAccelerometerStream(NuiAccelerometerStream* pAccelerometerStream)
+{
+    m_pAccelerometerStream = pAccelerometerStream;
+}
+
+/// <summary>
+/// Set the skeleton stream whose skeletons are drawn over the preview
+/// </summary>
+/// <param name="pSkeletonStream">The pointer to skeleton stream, or nullptr for none</param>
+void NuiDepthStream::SetSkeletonStream(NuiSkeletonStream* pSkeletonStream)
+{
+    m_pSkeletonStream = pSkeletonStream;
+}
+
+/// <summary>
+/// Get the floor plane tracked in the depth frames
+/// </summary>
+/// <returns>Floor estimator, check IsValid before use</returns>
+const FloorEstimator& NuiDepthStream::GetFloorEstimator() const
+{
+    return m_floorEstimator;
+}
+
+/// <summary>
+/// Get the depth to color mapping of the current depth resolution
+/// </summary>
+/// <returns>Registration table, check IsValid before use</returns>
+const RegistrationTable& NuiDepthStream::GetRegistrationTable() const
+{
+    return m_registrationTable;
+}
+
+/// <summary>
+/// Load or build the depth to color mapping for a resolution pair
+/// </summary>
+/// <param name="depthResolution">Depth image resolution</param>
+/// <param name="colorResolution">Color image resolution</param>
+/// <returns>Indicates success or failure.</returns>
+HRESULT NuiDepthStream::PrepareRegistration(NUI_IMAGE_RESOLUTION depthResolution, NUI_IMAGE_RESOLUTION colorResolution)
+{
+    if (m_registrationTable.Matches(depthResolution, colorResolution))
+    {
+        return S_OK;
+    }
+
+    // A table saved by an earlier run saves thousands of mapping calls
+    if (SUCCEEDED(m_registrationTable.Load(REGISTRATION_FILE)) && m_registrationTable.Matches(depthResolution, colorResolution))
+    {
+        return S_OK;
+    }
+
+    HRESULT hr = m_registrationTable.Initialize(depthResolution, colorResolution);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    DWORD width, height;
+    NuiImageResolutionToSize(depthResolution, width, height);
+
+    DWORD count = width * height;
+    std::vector<USHORT> depthValues(count);
+    std::vector<LONG>   colorCoordinates(count * 2);
+
+    // Map a whole frame of constant depth once per boundary
+    for (UINT boundary = 0; boundary < REGISTRATION_BOUNDARY_COUNT; boundary++)
+    {
+        std::fill(depthValues.begin(), depthValues.end(), (USHORT)(m_registrationTable.GetBoundaryDepth(boundary) << NUI_IMAGE_PLAYER_INDEX_SHIFT));
+
+        hr = m_pNuiSensor->NuiImageGetColorPixelCoordinateFrameFromDepthPixelFrameAtResolution(colorResolution, depthResolution,
+                                                                                              count, &depthValues[0],
+                                                                                              count * 2, &colorCoordinates[0]);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        m_registrationTable.SetBoundaryMapping(boundary, &colorCoordinates[0]);
+    }
+
+    return m_registrationTable.Save(REGISTRATION_FILE);
+}
+
+/// <summary>
+/// Save the learned depth background so the next start warms up instantly
+/// </summary>
+/// <returns>Indicates success or failure.</returns>
+HRESULT NuiDepthStream::SaveBackground()
+{
+    return m_backgroundModel.Save(BACKGROUND_MODEL_FILE);
+}
+
 /// <summary>
 /// Start stream processing.
 /// </summary>
@@ -96,6 +282,19 @@ HRESULT NuiDepthStream::OpenStream(NUI_IMAGE_RESOLUTION resolution)
     {
         m_pNuiSensor->NuiImageStreamSetImageFrameFlags(m_hStreamHandle, m_nearMode ? NUI_IMAGE_STREAM_FLAG_ENABLE_NEAR_MODE : 0);   // Set image flags
         m_imageBuffer.SetImageSize(resolution); // Set source image resolution to image buffer
+        m_depthPrefilter.SetResolution(resolution);
+        m_depthPrefilter.Reset();
+        m_temporalFilter.Reset();
+        m_ballDetector.SetResolution(resolution);
+        m_ballTracker.Reset();
+        m_trajectoryPredictor.Reset();
+        PrepareRegistration(resolution, REGISTRATION_COLOR_RESOLUTION);
+
+        // Restore the background learned in a previous run. A mismatching resolution is relearned on the first frame
+        if (!m_backgroundModel.IsWarmedUp())
+        {
+            m_backgroundModel.Load(BACKGROUND_MODEL_FILE);
+        }
     }
 
     return hr;
@@ -152,9 +351,45 @@ void NuiDepthStream::ProcessDepth()
     // Make sure we've received valid data
     if (lockedRect.Pitch != 0)
     {
+        // Fill holes, drop flying pixels and smooth depth in place, so every later stage reads the cleaned depth
+        m_depthPrefilter.Process((NUI_DEPTH_IMAGE_PIXEL*)lockedRect.pBits, lockedRect.size);
+
+        // Other processes read the cleaned depth from the frame bus
+        if (m_pFrameBus)
+        {
+            UINT width  = lockedRect.Pitch / sizeof(NUI_DEPTH_IMAGE_PIXEL);
+            UINT height = lockedRect.size / lockedRect.Pitch;
+
+            FrameBusFrameInfo info = {FrameBusDepth, width, height, (UINT)lockedRect.Pitch, (UINT)lockedRect.size, imageFrame.dwFrameNumber, imageFrame.liTimeStamp.QuadPart};
+            m_pFrameBus->Publish(info, lockedRect.pBits);
+        }
+
+        // Analysis reads the depth pixels. The full resolution image is kept only for the
+        // preview stream, which shrinks it to its own width rather than the viewer's
+        if (m_pStreamViewer)
+        {
+            UINT width, height;
+            m_pStreamViewer->GetDisplaySize(width, height);
+            m_imageBuffer.SetOutputSize(width, height);
+        }
+        m_imageBuffer.SetKeepFullResolution(m_previewServer.HasClients());
+
         // Conver depth data to color image and copy to image buffer
         m_imageBuffer.CopyDepth(lockedRect.pBits, lockedRect.size, nearMode, m_depthTreatment);
 
+        // Find and track balls in the foreground while the depth frame is still locked
+        UpdateColorGate();
+        UpdateOrientation();
+        UpdateFloor((const NUI_DEPTH_IMAGE_PIXEL*)lockedRect.pBits);
+        m_ballTracker.Update(m_ballDetector, m_backgroundModel.GetForegroundMask(), (const NUI_DEPTH_IMAGE_PIXEL*)lockedRect.pBits, imageFrame.liTimeStamp.QuadPart);
+        m_trajectoryPredictor.Update(m_ballTracker.GetTracks(), imageFrame.liTimeStamp.QuadPart);
+
+        // Results go out before drawing, so the controller does not wait for the viewer
+        m_detectionPublisher.Publish(m_ballTracker.GetTracks(), imageFrame.dwFrameNumber, imageFrame.liTimeStamp.QuadPart);
+
+        // Only copies the frame, encoding runs on the preview server's thread
+        SubmitPreview();
+
         // Draw ou the data with Direct2D
         if (m_pStreamViewer)
         {
@@ -169,4 +404,90 @@ void NuiDepthStream::ProcessDepth()
 ReleaseFrame:
     // Release the frame
     m_pNuiSensor->NuiImageStreamReleaseFrame(m_hStreamHandle, &imageFrame);
+}
+
+/// <summary>
+/// Hand the latest color frame and ball color to the detector's color stage
+/// </summary>
+void NuiDepthStream::UpdateColorGate()
+{
+    ColorGateStage& colorGate = m_ballDetector.GetColorGate();
+
+    // Both streams are processed on the same thread, so the color buffer is stable until the next color frame
+    if (!m_pColorStream)
+    {
+        colorGate.SetColorFrame(nullptr, nullptr);
+        colorGate.SetColorClass(nullptr, BALL_COLOR_CLASS);
+        return;
+    }
+
+    colorGate.SetColorFrame(m_pColorStream->GetColorPixels(REGISTRATION_COLOR_RESOLUTION), &m_registrationTable);
+    colorGate.SetColorClass(m_pColorStream->GetColorClassifier().GetTable(), BALL_COLOR_CLASS);
+}
+
+/// <summary>
+/// Follow the sensor tilt and rotate the detector's point cloud to level
+/// </summary>
+void NuiDepthStream::UpdateOrientation()
+{
+    if (!m_pAccelerometerStream)
+    {
+        return;
+    }
+
+    // The ray table is only rebuilt when the tilt really changed
+    if (m_orientation.Update(m_pAccelerometerStream->GetReading(), m_pAccelerometerStream->GetElevationAngle()))
+    {
+        FLOAT rotation[3][3];
+        m_orientation.GetRotation(rotation);
+        m_ballDetector.SetRotation(rotation);
+    }
+}
+
+/// <summary>
+/// Track the floor and hand it to the trajectory predictor
+/// </summary>
+/// <param name="pDepth">The pointer to depth pixels</param>
+void NuiDepthStream::UpdateFloor(const NUI_DEPTH_IMAGE_PIXEL* pDepth)
+{
+    // Points are in the leveled frame of the point cloud, and so must gravity be
+    if (m_pAccelerometerStream)
+    {
+        m_floorEstimator.SetGravity(m_ballDetector.GetPointCloud().ToOutput(m_pAccelerometerStream->GetReading()));
+    }
+
+    // Ball heights and bounces are measured from the fitted floor once there is one
+    if (m_floorEstimator.Update(pDepth, m_ballDetector.GetPointCloud()))
+    {
+        m_trajectoryPredictor.SetFloorPlane(m_floorEstimator.GetPlane());
+    }
+    m_trajectoryPredictor.SetGravity(m_floorEstimator.GetGravity());
+}
+
+/// <summary>
+/// Offer the colorized depth with skeletons, confirmed balls and their trajectories drawn to the preview stream
+/// </summary>
+void NuiDepthStream::SubmitPreview()
+{
+    // A client which connected during this frame gets the next one
+    const UINT* pFullImage = m_imageBuffer.GetFullBuffer();
+    if (!m_previewServer.HasClients() || !pFullImage)
+    {
+        return;
+    }
+
+    // Overlay positions are in depth pixels, the compositor scales them to the image the server sends
+    m_previewOverlay.Clear();
+    m_previewOverlay.SetSourceSize(m_imageBuffer.GetFullWidth(), m_imageBuffer.GetFullHeight());
+
+    const SkeletonStore* pSkeletons = m_pSkeletonStream ? m_pSkeletonStream->GetSkeletonStore() : nullptr;
+    if (pSkeletons)
+    {
+        m_previewOverlay.AddSkeletons(*pSkeletons);
+    }
+
+    m_previewOverlay.AddTrajectories(m_trajectoryPredictor, m_ballDetector);
+    m_previewOverlay.AddTracks(m_ballTracker.GetTracks());
+
+    m_previewServer.SubmitFrame(pFullImage, m_imageBuffer.GetFullWidth(), m_imageBuffer.GetFullHeight(), &m_previewOverlay);
 }
\ No newline at end of file
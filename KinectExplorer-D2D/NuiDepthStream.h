@@ -8,6 +8,16 @@
 
 #include "NuiStream.h"
 #include "NuiImageBuffer.h"
+#include "NuiColorStream.h"
+#include "NuiAccelerometerStream.h"
+#include "NuiSkeletonStream.h"
+#include "DepthPrefilter.h"
+#include "DetectionPublisher.h"
+#include "FloorEstimator.h"
+#include "MjpegServer.h"
+#include "SensorOrientation.h"
+#include "TrajectoryPredictor.h"
+#include "RegistrationTable.h"
 
 class NuiDepthStream : public NuiStream
 {
@@ -61,15 +71,154 @@ public:
     /// <param name="treatment">Depth treatment mode to set</param>
     void SetDepthTreatment(DEPTH_TREATMENT treatment);
 
+    /// <summary>
+    /// Get foreground mask extracted from the last depth frame
+    /// </summary>
+    /// <returns>Foreground mask</returns>
+    const PackedBitmask& GetForegroundMask() const;
+
+    /// <summary>
+    /// Get foreground blobs found in the last depth frame
+    /// </summary>
+    /// <returns>Collection of blobs</returns>
+    const std::vector<DepthBlob>& GetBlobs() const;
+
+    /// <summary>
+    /// Get balls found in the last depth frame
+    /// </summary>
+    /// <returns>Collection of ball detections</returns>
+    const std::vector<BallDetection>& GetBallDetections() const;
+
+    /// <summary>
+    /// Get balls tracked across depth frames
+    /// </summary>
+    /// <returns>Collection of tracks</returns>
+    const std::vector<BallTrack>& GetBallTracks() const;
+
+    /// <summary>
+    /// Get the detection cost of the last depth frame
+    /// </summary>
+    /// <returns>Tracker metrics</returns>
+    const BallTrackerMetrics& GetTrackerMetrics() const;
+
+    /// <summary>
+    /// Get fitted trajectories and landing predictions of tracked balls
+    /// </summary>
+    /// <returns>Collection of trajectories</returns>
+    const std::vector<BallTrajectory>& GetTrajectories() const;
+
+    /// <summary>
+    /// Get the candidate cascade of the ball detector with its rejection statistics
+    /// </summary>
+    /// <returns>Detection cascade</returns>
+    const DetectionCascade& GetDetectionCascade() const;
+
+    /// <summary>
+    /// Set the color stream whose frames verify ball candidates
+    /// </summary>
+    /// <param name="pColorStream">The pointer to color stream, or nullptr for none</param>
+    void SetColorStream(NuiColorStream* pColorStream);
+
+    /// <summary>
+    /// Set the accelerometer stream whose readings guide the floor estimation
+    /// </summary>
+    /// <param name="pAccelerometerStream">The pointer to accelerometer stream, or nullptr for none</param>
+    void SetAccelerometerStream(NuiAccelerometerStream* pAccelerometerStream);
+
+    /// <summary>
+    /// Set the skeleton stream whose skeletons are drawn over the preview
+    /// </summary>
+    /// <param name="pSkeletonStream">The pointer to skeleton stream, or nullptr for none</param>
+    void SetSkeletonStream(NuiSkeletonStream* pSkeletonStream);
+
+    /// <summary>
+    /// Get the floor plane tracked in the depth frames
+    /// </summary>
+    /// <returns>Floor estimator, check IsValid before use</returns>
+    const FloorEstimator& GetFloorEstimator() const;
+
+    /// <summary>
+    /// Get the depth to color mapping of the current depth resolution
+    /// </summary>
+    /// <returns>Registration table, check IsValid before use</returns>
+    const RegistrationTable& GetRegistrationTable() const;
+
+    /// <summary>
+    /// Get the MJPEG server of the depth preview. Start it to serve browsers
+    /// </summary>
+    MjpegServer& GetPreviewServer()
+    {
+        return m_previewServer;
+    }
+
+    /// <summary>
+    /// Get the publisher of the ball detections. Open it to send them to a controller
+    /// </summary>
+    DetectionPublisher& GetDetectionPublisher()
+    {
+        return m_detectionPublisher;
+    }
+
+    /// <summary>
+    /// Load or build the depth to color mapping for a resolution pair
+    /// </summary>
+    /// <param name="depthResolution">Depth image resolution</param>
+    /// <param name="colorResolution">Color image resolution</param>
+    /// <returns>Indicates success or failure.</returns>
+    HRESULT PrepareRegistration(NUI_IMAGE_RESOLUTION depthResolution, NUI_IMAGE_RESOLUTION colorResolution);
+
+    /// <summary>
+    /// Save the learned depth background so the next start warms up instantly
+    /// </summary>
+    /// <returns>Indicates success or failure.</returns>
+    HRESULT SaveBackground();
+
 private:
     /// <summary>
     /// Retrieve depth data from stream frame
     /// </summary>
     void ProcessDepth();
 
+    /// <summary>
+    /// Hand the latest color frame and ball color to the detector's color stage
+    /// </summary>
+    void UpdateColorGate();
+
+    /// <summary>
+    /// Follow the sensor tilt and rotate the detector's point cloud to level
+    /// </summary>
+    void UpdateOrientation();
+
+    /// <summary>
+    /// Track the floor and hand it to the trajectory predictor
+    /// </summary>
+    /// <param name="pDepth">The pointer to depth pixels</param>
+    void UpdateFloor(const NUI_DEPTH_IMAGE_PIXEL* pDepth);
+
+    /// <summary>
+    /// Offer the colorized depth with skeletons, confirmed balls and their trajectories drawn to the preview stream
+    /// </summary>
+    void SubmitPreview();
+
 private:
     bool            m_nearMode;
     NUI_IMAGE_TYPE  m_imageType;
     NuiImageBuffer  m_imageBuffer;
     DEPTH_TREATMENT m_depthTreatment;
+
+    DepthPrefilter  m_depthPrefilter;
+    DepthTemporalFilter m_temporalFilter;
+    DepthBackgroundModel m_backgroundModel;
+    BallDetector    m_ballDetector;
+    BallTracker     m_ballTracker;
+    TrajectoryPredictor m_trajectoryPredictor;
+    RegistrationTable   m_registrationTable;
+    NuiColorStream*     m_pColorStream;
+    FloorEstimator      m_floorEstimator;
+    SensorOrientation   m_orientation;
+    DetectionPublisher  m_detectionPublisher;
+    MjpegServer         m_previewServer;
+    OverlayList         m_previewOverlay;
+    NuiAccelerometerStream* m_pAccelerometerStream;
+    NuiSkeletonStream*  m_pSkeletonStream;
 };
\ No newline at end of file
@@ -44,6 +44,13 @@ NuiImageBuffer::NuiImageBuffer()
     , m_srcWidth(0)
     , m_srcHeight(0)
     , m_pBuffer(nullptr)
+    , m_pBackgroundModel(nullptr)
+    , m_outputWidth(0)
+    , m_outputHeight(0)
+    , m_scale(1)
+    , m_keepFullResolution(false)
+    , m_fullWidth(0)
+    , m_fullHeight(0)
 {
     InitDepthColorTable();
 }
@@ -65,6 +72,27 @@ void NuiImageBuffer::SetImageSize(NUI_IMAGE_RESOLUTION resolution)
     GetImageSize(resolution, m_srcWidth, m_srcHeight);
 }
 
+/// <summary>
+/// Set the size the image is displayed at. Conversions shrink the image by the largest
+/// whole factor which keeps it at least that size, box filtering in the same pass
+/// </summary>
+/// <param name="width">Display width. Zero to keep the source size</param>
+/// <param name="height">Display height. Zero to keep the source size</param>
+void NuiImageBuffer::SetOutputSize(DWORD width, DWORD height)
+{
+    m_outputWidth  = width;
+    m_outputHeight = height;
+}
+
+/// <summary>
+/// Keep a full resolution copy of converted images for analysis, next to the shrunk image
+/// </summary>
+/// <param name="keep">True to keep the full resolution image</param>
+void NuiImageBuffer::SetKeepFullResolution(bool keep)
+{
+    m_keepFullResolution = keep;
+}
+
 /// <summary>
 /// Calculate image width and height according to image resolution enumeration value.
 /// If resolution enumeration is invalid, width and height will be set to zero.
@@ -116,6 +144,46 @@ BYTE* NuiImageBuffer::GetBuffer() const
     return m_pBuffer;
 }
 
+/// <summary>
+/// Get width of the full resolution image.
+/// </summary>
+/// <returns>Width of the last converted source image.</returns>
+DWORD NuiImageBuffer::GetFullWidth() const
+{
+    return m_fullWidth;
+}
+
+/// <summary>
+/// Get height of the full resolution image.
+/// </summary>
+/// <returns>Height of the last converted source image.</returns>
+DWORD NuiImageBuffer::GetFullHeight() const
+{
+    return m_fullHeight;
+}
+
+/// <summary>
+/// Return the full resolution image.
+/// </summary>
+/// <returns>
+/// The pointer to the full resolution pixels, the same as GetBuffer if the image is not shrunk
+/// Return value is nullptr unless the full resolution image is kept
+/// </returns>
+const UINT* NuiImageBuffer::GetFullBuffer() const
+{
+    if (!m_keepFullResolution)
+    {
+        return nullptr;
+    }
+
+    if (1 == m_scale)
+    {
+        return (const UINT*)m_pBuffer;
+    }
+
+    return m_fullBuffer.empty() ? nullptr : &m_fullBuffer[0];
+}
+
 /// <summary>
 /// Allocate a buffer of size and return it
 /// </summary>
@@ -142,11 +210,104 @@ BYTE* NuiImageBuffer::ResetBuffer(UINT size)
 /// </summary>
 void NuiImageBuffer::Clear()
 {
-    m_width  = 0;
-    m_height = 0;
+    m_width      = 0;
+    m_height     = 0;
+    m_fullWidth  = 0;
+    m_fullHeight = 0;
+    m_scale      = 1;
+    m_fullBuffer.clear();
     ResetBuffer(0);
 }
 
+/// <summary>
+/// Check the source size and set up image sizes and buffers for a conversion
+/// </summary>
+/// <param name="size">Size in bytes of the source image</param>
+/// <param name="bytesPerPixel">Bytes per source pixel</param>
+/// <returns>True if the source image matches the image resolution</returns>
+bool NuiImageBuffer::BeginConversion(UINT size, UINT bytesPerPixel)
+{
+    // Check source buffer size
+    if (0 == size || size != m_srcWidth * m_srcHeight * bytesPerPixel)
+    {
+        return false;
+    }
+
+    // Largest whole factor which keeps the shrunk image at least the display size
+    m_scale = 1;
+    if (0 != m_outputWidth && 0 != m_outputHeight)
+    {
+        m_scale = min(m_srcWidth / m_outputWidth, m_srcHeight / m_outputHeight);
+        m_scale = max(m_scale, (DWORD)1);
+    }
+
+    m_fullWidth  = m_srcWidth;
+    m_fullHeight = m_srcHeight;
+    m_width      = m_srcWidth  / m_scale;
+    m_height     = m_srcHeight / m_scale;
+
+    // Allocate buffer for image. If required buffer size hasn't changed, the previously allocated buffer is returned
+    ResetBuffer(m_width * m_height * BYTES_PER_PIXEL_RGB);
+
+    if (1 == m_scale)
+    {
+        // Converted rows go straight to the image buffer
+        m_fullBuffer.clear();
+        return true;
+    }
+
+    m_downscaler.Reset(m_width, m_scale);
+
+    if (m_keepFullResolution)
+    {
+        m_fullBuffer.resize(m_fullWidth * m_fullHeight);
+    }
+    else
+    {
+        m_conversionRows.resize(m_fullWidth * 2);
+    }
+
+    return true;
+}
+
+/// <summary>
+/// Get the row a conversion writes the full resolution pixels of a source row to
+/// </summary>
+/// <param name="y">Source row</param>
+/// <returns>The pointer to the first pixel of the row</returns>
+UINT* NuiImageBuffer::GetConversionRow(DWORD y)
+{
+    if (1 == m_scale)
+    {
+        return (UINT*)m_pBuffer + y * m_width;
+    }
+
+    if (m_keepFullResolution)
+    {
+        return &m_fullBuffer[y * m_fullWidth];
+    }
+
+    // Only the rows being filtered are needed, and they stay in cache
+    return &m_conversionRows[(y % 2) * m_fullWidth];
+}
+
+/// <summary>
+/// Add a converted row to the box filter, and write the shrunk row once all of its source rows are added
+/// </summary>
+/// <param name="pRow">The pointer to the converted full resolution row</param>
+/// <param name="y">Source row</param>
+void NuiImageBuffer::DownscaleRow(const UINT* pRow, DWORD y)
+{
+    DWORD outputY = y / m_scale;
+    if (1 == m_scale || outputY >= m_height)
+    {
+        return;
+    }
+
+    // Rows past the last whole box are dropped, the filter drops the columns
+    m_downscaler.AddRow(pRow, y, (UINT*)m_pBuffer + outputY * m_width);
+}
+
 /// <summary>
 /// Initialize the depth-color mapping table.
 /// </summary>
@@ -280,21 +441,30 @@ BYTE NuiImageBuffer::GetIntensity(int depth)
 /// <param name="size">Size in bytes to copy</param>
 void NuiImageBuffer::CopyRGB(const BYTE* pImage, UINT size)
 {
-    // Check source buffer size
-    if (size != m_srcWidth * m_srcHeight * BYTES_PER_PIXEL_RGB)
+    if (!BeginConversion(size, BYTES_PER_PIXEL_RGB))
     {
         return;
     }
 
-    // Set image size to source image size
-    m_width  = m_srcWidth;
-    m_height = m_srcHeight;
+    if (1 == m_scale)
+    {
+        // Copy source image to buffer
+        memcpy_s(m_pBuffer, m_nSizeInBytes, pImage, size);
+        return;
+    }
 
-    // Allocate buffer for image
-    ResetBuffer(m_width * m_height * BYTES_PER_PIXEL_RGB);
+    // Source pixels are already BGRX, so they are filtered where they are
+    for (DWORD y = 0; y < m_srcHeight; y++)
+    {
+        const UINT* pRow = (const UINT*)pImage + y * m_srcWidth;
+
+        if (m_keepFullResolution)
+        {
+            memcpy(GetConversionRow(y), pRow, m_srcWidth * BYTES_PER_PIXEL_RGB);
+        }
 
-    // Copy source image to buffer
-    memcpy_s(m_pBuffer, m_nSizeInBytes, pImage, size);
+        DownscaleRow(pRow, y);
+    }
 }
 
 /// <summary>
@@ -304,28 +474,23 @@ void NuiImageBuffer::CopyRGB(const BYTE* pImage, UINT size)
 /// <param name="size">Size in bytes to copy</param>
 void NuiImageBuffer::CopyBayer(const BYTE* pImage, UINT size)
 {
-    // Check source buffer size
-    if (size != m_srcWidth * m_srcHeight * BYTES_PER_PIXEL_BAYER)
+    // Check if source image size can mod by 2
+    if (0 != m_srcWidth % 2 || 0 != m_srcHeight % 2)
     {
         return;
     }
 
-    // Check if source image size can mod by 2
-    if (0 != m_srcWidth % 2 || 0 != m_srcHeight % 2)
+    if (!BeginConversion(size, BYTES_PER_PIXEL_BAYER))
     {
         return;
     }
 
-    // Converted image size is equal to source image size
-    m_width  = m_srcWidth;
-    m_height = m_srcHeight;
-
-    // Allocate buffer for image
-    UINT* pBuffer = (UINT*)ResetBuffer(m_width * m_height * BYTES_PER_PIXEL_RGB);
-
-    // Run through pixels
+    // Run through pairs of rows
     for (DWORD y = 0; y < m_srcHeight; y += 2)
     {
+        UINT* pFirstRow  = GetConversionRow(y);
+        UINT* pSecondRow = GetConversionRow(y + 1);
+
         for (DWORD x = 0; x < m_srcWidth; x += 2)
         {
             int firstRowOffset  = (y * m_srcWidth) + x;
@@ -338,11 +503,14 @@ void NuiImageBuffer::CopyBayer(const BYTE* pImage, UINT size)
             BYTE b  = pImage[secondRowOffset];      // |__|__|
 
             // Set color to buffered pixel
-            SetColor(pBuffer + firstRowOffset,      r, g1, b);
-            SetColor(pBuffer + firstRowOffset  + 1, r, g1, b);
-            SetColor(pBuffer + secondRowOffset,     r, g2, b);
-            SetColor(pBuffer + secondRowOffset + 1, r, g2, b);
+            SetColor(pFirstRow  + x,     r, g1, b);
+            SetColor(pFirstRow  + x + 1, r, g1, b);
+            SetColor(pSecondRow + x,     r, g2, b);
+            SetColor(pSecondRow + x + 1, r, g2, b);
         }
+
+        DownscaleRow(pFirstRow,  y);
+        DownscaleRow(pSecondRow, y + 1);
     }
 }
 
@@ -353,35 +521,36 @@ void NuiImageBuffer::CopyBayer(const BYTE* pImage, UINT size)
 /// <param name="size">Size in bytes to copy</param>
 void NuiImageBuffer::CopyInfrared(const BYTE* pImage, UINT size)
 {
-    // Check source buffer size
-    if (size != m_srcWidth * m_srcHeight * BYTES_PER_PIXEL_INFRARED)
+    if (!BeginConversion(size, BYTES_PER_PIXEL_INFRARED))
     {
         return;
     }
 
-    // Converted image size is equal to source image size
-    m_width  = m_srcWidth;
-    m_height = m_srcHeight;
+    // Run through rows
+    for (DWORD y = 0; y < m_srcHeight; y++)
+    {
+        UINT*   pRow      = GetConversionRow(y);
+        UINT*   pBuffer   = pRow;
 
-    // Allocate buffer for image
-    UINT*   pBuffer   = (UINT*)ResetBuffer(m_width * m_height * BYTES_PER_PIXEL_RGB);
+        // Initialize pixel pointers to start and end of the row
+        USHORT* pPixelRun = (USHORT*)pImage + y * m_srcWidth;
+        USHORT* pPixelEnd = pPixelRun + m_srcWidth;
 
-    // Initialize pixel pointers
-    USHORT* pPixelRun = (USHORT*)pImage;
-    USHORT* pPixelEnd = pPixelRun + size / BYTES_PER_PIXEL_INFRARED;
+        // Run through pixels
+        while (pPixelRun < pPixelEnd)
+        {
+            // Convert pixel from 16-bit to 8-bit intensity
+            BYTE intensity = (*pPixelRun) >> 8;
 
-    // Run through pixels
-    while (pPixelRun < pPixelEnd)
-    {
-        // Convert pixel from 16-bit to 8-bit intensity
-        BYTE intensity = (*pPixelRun) >> 8;
+            // Set pixel color with R, G and B components all equal to intensity
+            SetColor(pBuffer, intensity, intensity, intensity);
 
-        // Set pixel color with R, G and B components all equal to intensity
-        SetColor(pBuffer, intensity, intensity, intensity);
+            // Move to next pixel
+            ++pPixelRun;
+            ++pBuffer;
+        }
 
-        // Move to next pixel
-        ++pPixelRun;
-        ++pBuffer;
+        DownscaleRow(pRow, y);
     }
 }
 
@@ -394,8 +563,7 @@ void NuiImageBuffer::CopyInfrared(const BYTE* pImage, UINT size)
 /// <param name="treatment">Depth treatment mode</param>
 void NuiImageBuffer::CopyDepth(const BYTE* pImage, UINT size, BOOL nearMode, DEPTH_TREATMENT treatment)
 {
-    // Check source buffer size
-    if (size != m_srcWidth * m_srcHeight * BYTES_PER_PIXEL_DEPTH)
+    if (!BeginConversion(size, BYTES_PER_PIXEL_DEPTH))
     {
         return;
     }
@@ -409,29 +577,57 @@ void NuiImageBuffer::CopyDepth(const BYTE* pImage, UINT size, BOOL nearMode, DEP
         InitDepthColorTable();
     }
 
-    // Converted image size is equal to source image size
-    m_width  = m_srcWidth;
-    m_height = m_srcHeight;
+    if (m_pBackgroundModel)
+    {
+        m_pBackgroundModel->BeginFrame(m_srcWidth, m_srcHeight);
+    }
 
-    // Allocate buffer for color image. If required buffer size hasn't changed, the previously allocated buffer is returned
-    UINT* rgbrun = (UINT*)ResetBuffer(m_width * m_height * BYTES_PER_PIXEL_RGB);
+    // Run through rows, so the background model reads each row while it is still in cache
+    for (DWORD y = 0; y < m_srcHeight; y++)
+    {
+        // Initialize pixel pointers to start and end of the row
+        const NUI_DEPTH_IMAGE_PIXEL* pRowStart = (const NUI_DEPTH_IMAGE_PIXEL*)pImage + y * m_srcWidth;
+        const NUI_DEPTH_IMAGE_PIXEL* pPixelRun = pRowStart;
+        const NUI_DEPTH_IMAGE_PIXEL* pPixelEnd = pRowStart + m_srcWidth;
+        UINT*                        pRow      = GetConversionRow(y);
+        UINT*                        rgbrun    = pRow;
+
+        // Run through pixels
+        while (pPixelRun < pPixelEnd)
+        {
+            // Get pixel depth and player index
+            USHORT depth = pPixelRun->depth;
+            USHORT index = pPixelRun->playerIndex;
 
-    // Initialize pixel pointers to start and end of image buffer
-    NUI_DEPTH_IMAGE_PIXEL* pPixelRun = (NUI_DEPTH_IMAGE_PIXEL*)pImage;
-    NUI_DEPTH_IMAGE_PIXEL* pPixelEnd = pPixelRun + m_srcWidth * m_srcHeight;
+            // Get mapped color from depth-color table
+            *rgbrun = m_depthColorTable[index][depth];
 
-    // Run through pixels
-    while (pPixelRun < pPixelEnd)
-    {
-        // Get pixel depth and player index
-        USHORT depth = pPixelRun->depth;
-        USHORT index = pPixelRun->playerIndex;
+            // Move the pointers to next pixel
+            ++rgbrun;
+            ++pPixelRun;
+        }
 
-        // Get mapped color from depth-color table
-        *rgbrun = m_depthColorTable[index][depth];
+        // Shrink for display while the colored row is still in cache
+        DownscaleRow(pRow, y);
+
+        // Update background and emit this row's foreground bits
+        if (m_pBackgroundModel)
+        {
+            m_pBackgroundModel->ProcessRow(pRowStart, y);
+        }
+    }
 
-        // Move the pointers to next pixel
-        ++rgbrun;
-        ++pPixelRun;
+    if (m_pBackgroundModel)
+    {
+        m_pBackgroundModel->EndFrame();
     }
+}
+
+/// <summary>
+/// Attach a background model which is updated in the same pass as depth conversion
+/// </summary>
+/// <param name="pModel">The pointer to background model. nullptr to detach</param>
+void NuiImageBuffer::SetBackgroundModel(DepthBackgroundModel* pModel)
+{
+    m_pBackgroundModel = pModel;
 }
\ No newline at end of file
@@ -7,6 +7,9 @@
 #pragma once
 
 #include <NuiApi.h>
+#include <vector>
+#include "BoxDownscaler.h"
+#include "DepthBackgroundModel.h"
 
 #define MAX_PLAYER_INDEX    6
 
@@ -37,6 +40,20 @@ public:
     /// <param name="resolution">Image resolution</param>
     void SetImageSize(NUI_IMAGE_RESOLUTION resolution);
 
+    /// <summary>
+    /// Set the size the image is displayed at. Conversions shrink the image by the largest
+    /// whole factor which keeps it at least that size, box filtering in the same pass
+    /// </summary>
+    /// <param name="width">Display width. Zero to keep the source size</param>
+    /// <param name="height">Display height. Zero to keep the source size</param>
+    void SetOutputSize(DWORD width, DWORD height);
+
+    /// <summary>
+    /// Keep a full resolution copy of converted images for analysis, next to the shrunk image
+    /// </summary>
+    /// <param name="keep">True to keep the full resolution image</param>
+    void SetKeepFullResolution(bool keep);
+
     /// <summary>
     /// Clear buffer
     /// </summary>
@@ -69,6 +86,27 @@ public:
     /// </returns>
     BYTE* GetBuffer() const;
 
+    /// <summary>
+    /// Get width of the full resolution image.
+    /// </summary>
+    /// <returns>Width of the last converted source image.</returns>
+    DWORD GetFullWidth() const;
+
+    /// <summary>
+    /// Get height of the full resolution image.
+    /// </summary>
+    /// <returns>Height of the last converted source image.</returns>
+    DWORD GetFullHeight() const;
+
+    /// <summary>
+    /// Return the full resolution image.
+    /// </summary>
+    /// <returns>
+    /// The pointer to the full resolution pixels, the same as GetBuffer if the image is not shrunk
+    /// Return value is nullptr unless the full resolution image is kept
+    /// </returns>
+    const UINT* GetFullBuffer() const;
+
     /// <summary>
     /// Copy color frame image to image buffer
     /// </summary>
@@ -99,6 +137,11 @@ public:
     /// <param name="treatment">Depth treatment mode</param>
     void CopyDepth(const BYTE* source, UINT size, BOOL nearMode, DEPTH_TREATMENT treatment);
 
+    /// <summary>
+    /// Attach a background model which is updated in the same pass as depth conversion
+    /// </summary>
+    /// <param name="pModel">The pointer to background model. nullptr to detach</param>
+    void SetBackgroundModel(DepthBackgroundModel* pModel);
 
 private:
     /// <summary>
@@ -139,6 +182,28 @@ private:
     /// <returns>The pointer to the allocated buffer. If size hasn't changed, the previously allocated buffer is returned</returns>
     BYTE* ResetBuffer(UINT size);
 
+    /// <summary>
+    /// Check the source size and set up image sizes and buffers for a conversion
+    /// </summary>
+    /// <param name="size">Size in bytes of the source image</param>
+    /// <param name="bytesPerPixel">Bytes per source pixel</param>
+    /// <returns>True if the source image matches the image resolution</returns>
+    bool BeginConversion(UINT size, UINT bytesPerPixel);
+
+    /// <summary>
+    /// Get the row a conversion writes the full resolution pixels of a source row to
+    /// </summary>
+    /// <param name="y">Source row</param>
+    /// <returns>The pointer to the first pixel of the row</returns>
+    UINT* GetConversionRow(DWORD y);
+
+    /// <summary>
+    /// Add a converted row to the box filter, and write the shrunk row once all of its source rows are added
+    /// </summary>
+    /// <param name="pRow">The pointer to the converted full resolution row</param>
+    /// <param name="y">Source row</param>
+    void DownscaleRow(const UINT* pRow, DWORD y);
+
 private:
     static const BYTE    m_intensityShiftR[MAX_PLAYER_INDEX + 1];
     static const BYTE    m_intensityShiftG[MAX_PLAYER_INDEX + 1];
@@ -153,4 +218,16 @@ private:
     DWORD               m_nSizeInBytes;
     BYTE*               m_pBuffer;
     DEPTH_TREATMENT     m_depthTreatment;
+
+    DWORD               m_outputWidth;
+    DWORD               m_outputHeight;
+    DWORD               m_scale;                // Shrink factor of the last conversion
+    bool                m_keepFullResolution;
+    DWORD               m_fullWidth;
+    DWORD               m_fullHeight;
+    std::vector<UINT>   m_fullBuffer;           // Full resolution image, only kept when shrinking
+    std::vector<UINT>   m_conversionRows;       // Two converted rows, when no full resolution image is kept
+    BoxDownscaler       m_downscaler;           // Box filter of the current conversion
+
+    DepthBackgroundModel* m_pBackgroundModel;
 };
\ No newline at end of file
@@ -18,6 +18,7 @@ NuiSkeletonStream::NuiSkeletonStream(INuiSensor* pNuiSensor)
     , m_seated(false)
     , m_chooserMode(ChooserModeDefault)
     , m_pSecondStreamViewer(nullptr)
+    , m_pRegistration(nullptr)
 {
     m_stickyIDs[FirstTrackID] = 0;
     m_stickyIDs[SecondTrackID] = 0;
@@ -84,6 +85,15 @@ void NuiSkeletonStream::SetSecondStreamViewer(NuiStreamViewer* pStreamViewer)
     m_pSecondStreamViewer = pStreamViewer;
 }
 
+/// <summary>
+/// Set the depth to color mapping used to place joints on color images
+/// </summary>
+/// <param name="pRegistration">The pointer to registration table, or nullptr to place joints by depth coordinates</param>
+void NuiSkeletonStream::SetRegistrationTable(const RegistrationTable* pRegistration)
+{
+    m_pRegistration = pRegistration;
+}
+
 /// <summary>
 /// Start stream processing
 /// </summary>
@@ -94,7 +104,8 @@ HRESULT NuiSkeletonStream::StartStream()
         if (m_paused)
         {
             // Clear skeleton data in stream viewers
-            AssignSkeletonFrameToStreamViewers(nullptr);
+            m_skeletonStore.Clear();
+            AssignSkeletonsToStreamViewers(nullptr);
 
             // Disable tracking skeleton
             return m_pNuiSensor->NuiSkeletonTrackingDisable();
@@ -147,15 +158,26 @@ void NuiSkeletonStream::ProcessSkeleton()
     {
         // If occur error when get skeleton data or pause tracking skeleton,
         // clear skeleton data in stream viewers
-        AssignSkeletonFrameToStreamViewers(nullptr);
+        m_skeletonStore.Clear();
+        AssignSkeletonsToStreamViewers(nullptr);
         return;
     }
 
     // smooth out the skeleton data
     m_pNuiSensor->NuiTransformSmooth(&m_skeletonFrame, nullptr);
 
+    // Project every joint once for the chooser, the viewers and the preview
+    m_skeletonStore.Update(m_skeletonFrame, m_pRegistration);
+
+    // Other processes read the smoothed skeletons from the frame bus
+    if (m_pFrameBus)
+    {
+        FrameBusFrameInfo info = {FrameBusSkeleton, 0, 0, 0, sizeof(m_skeletonFrame), m_skeletonFrame.dwFrameNumber, m_skeletonFrame.liTimeStamp.QuadPart};
+        m_pFrameBus->Publish(info, &m_skeletonFrame);
+    }
+
     // Set skeleton data to stream viewers
-    AssignSkeletonFrameToStreamViewers(&m_skeletonFrame);
+    AssignSkeletonsToStreamViewers(&m_skeletonStore);
 
     UpdateTrackedSkeletons();
 }
@@ -197,18 +219,15 @@ void NuiSkeletonStream::ChooseClosestSkeletons(DWORD trackIDs[TrackIDIndexCount]
 {
     ZeroMemory(trackIDs, TrackIDIndexCount * sizeof(DWORD));
 
-    // Initial depth array with max posible value
-    USHORT nearestDepth[TrackIDIndexCount] = {NUI_IMAGE_DEPTH_MAXIMUM, NUI_IMAGE_DEPTH_MAXIMUM};
+    // Initial depth array with max posible value, in millimeters as stored
+    USHORT nearestDepth[TrackIDIndexCount] = {NUI_IMAGE_DEPTH_MAXIMUM >> NUI_IMAGE_PLAYER_INDEX_SHIFT, NUI_IMAGE_DEPTH_MAXIMUM >> NUI_IMAGE_PLAYER_INDEX_SHIFT};
 
     for (int i = 0; i < NUI_SKELETON_COUNT; i++)
     {
         if (NUI_SKELETON_NOT_TRACKED != m_skeletonFrame.SkeletonData[i].eTrackingState)
         {
-            LONG   x, y;
-            USHORT depth;
-
-            // Transform skeleton coordinates to depth image
-            NuiTransformSkeletonToDepthImage(m_skeletonFrame.SkeletonData[i].Position, &x, &y, &depth);
+            // Depth of the skeleton position, already projected by the skeleton store
+            USHORT depth = m_skeletonStore.GetDepth()[SkeletonStore::GetPointIndex(i, SKELETON_STORE_POSITION)];
 
             // Compare depth to peviously found item
             if (depth < nearestDepth[FirstTrackID])
@@ -416,16 +435,16 @@ void NuiSkeletonStream::FindMostActiveIDs(DWORD trackIDs[TrackIDIndexCount])
 /// <summary>
 /// Assign the skeleton data to the stream viewers
 /// </summary>
-/// <param name="pFrame">The pointer to skeleton frame</param>
-void NuiSkeletonStream::AssignSkeletonFrameToStreamViewers(const NUI_SKELETON_FRAME* pFrame)
+/// <param name="pSkeletons">The pointer to skeleton store, or nullptr to clear the skeletons</param>
+void NuiSkeletonStream::AssignSkeletonsToStreamViewers(const SkeletonStore* pSkeletons)
 {
     if (m_pStreamViewer)
     {
-        m_pStreamViewer->SetSkeleton(pFrame);
+        m_pStreamViewer->SetSkeleton(pSkeletons);
     }
 
     if (m_pSecondStreamViewer)
     {
-        m_pSecondStreamViewer->SetSkeleton(pFrame);
+        m_pSecondStreamViewer->SetSkeleton(pSkeletons);
     }
 }
\ No newline at end of file
@@ -9,6 +9,8 @@
 #include <map>
 #include "NuiStream.h"
 #include "NuiActivityWatcher.h"
+#include "RegistrationTable.h"
+#include "SkeletonStore.h"
 
 // Nui skeleton chooser mode
 enum ChooserMode
@@ -85,6 +87,21 @@ public:
     /// <param name="pStreamViewer">The pointer to the stream viewer to be attached</param>
     void SetSecondStreamViewer(NuiStreamViewer* pViewer);
 
+    /// <summary>
+    /// Set the depth to color mapping used to place joints on color images
+    /// </summary>
+    /// <param name="pRegistration">The pointer to registration table, or nullptr to place joints by depth coordinates</param>
+    void SetRegistrationTable(const RegistrationTable* pRegistration);
+
+    /// <summary>
+    /// Get the latest smoothed skeletons with their projected joints
+    /// </summary>
+    /// <returns>The pointer to skeleton store, or nullptr while paused or before a frame arrived</returns>
+    const SkeletonStore* GetSkeletonStore() const
+    {
+        return m_skeletonStore.IsValid() ? &m_skeletonStore : nullptr;
+    }
+
 private:
     /// <summary>
     /// Process on incoming frame
@@ -150,8 +167,8 @@ private:
     /// <summary>
     /// Assign the skeleton data to the stream viewers
     /// </summary>
-    /// <param name="pFrame">The pointer to skeleton frame</param>
-    void AssignSkeletonFrameToStreamViewers(const NUI_SKELETON_FRAME* pFrame);
+    /// <param name="pSkeletons">The pointer to skeleton store, or nullptr to clear the skeletons</param>
+    void AssignSkeletonsToStreamViewers(const SkeletonStore* pSkeletons);
 
 private:
     bool                m_near;
@@ -159,6 +176,8 @@ private:
     DWORD               m_stickyIDs[TrackIDIndexCount];
     ChooserMode         m_chooserMode;
     NUI_SKELETON_FRAME  m_skeletonFrame;
+    SkeletonStore       m_skeletonStore;
+    const RegistrationTable* m_pRegistration;
     NuiStreamViewer*    m_pSecondStreamViewer;
 
     std::map<int, NuiActivityWatcher*> m_activityWatchers;
@@ -15,6 +15,7 @@
 NuiStream::NuiStream(INuiSensor* pNuiSensor)
     : m_pNuiSensor(pNuiSensor)
     , m_pStreamViewer(nullptr)
+    , m_pFrameBus(nullptr)
     , m_hStreamHandle(INVALID_HANDLE_VALUE)
     , m_paused(false)
 {
@@ -79,4 +80,13 @@ NuiStreamViewer* NuiStream::SetStreamViewer(NuiStreamViewer * pStreamViewer)
     }
 
     return pOldViewer;
+}
+
+/// <summary>
+/// Attach the frame bus the stream publishes its frames to
+/// </summary>
+/// <param name="pFrameBus">The pointer to frame bus writer. nullptr to stop publishing</param>
+void NuiStream::SetFrameBus(FrameBusWriter* pFrameBus)
+{
+    m_pFrameBus = pFrameBus;
 }
\ No newline at end of file
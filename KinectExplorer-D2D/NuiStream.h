@@ -8,6 +8,7 @@
 
 #include <NuiApi.h>
 #include "NuiStreamViewer.h"
+#include "FrameBus.h"
 #include "Utility.h"
 
 class NuiStream
@@ -32,6 +33,12 @@ public:
     /// <returns>Previously attached viewer object. If none, returns nullptr</returns>
     virtual NuiStreamViewer* SetStreamViewer(NuiStreamViewer* pStreamViewer);
 
+    /// <summary>
+    /// Attach the frame bus the stream publishes its frames to
+    /// </summary>
+    /// <param name="pFrameBus">The pointer to frame bus writer. nullptr to stop publishing</param>
+    void SetFrameBus(FrameBusWriter* pFrameBus);
+
     /// <summary>
     /// Subclass should override this method to process the next incoming
     /// stream frame when stream event is set.
@@ -58,6 +65,7 @@ public:
 
 protected:
     NuiStreamViewer*    m_pStreamViewer;
+    FrameBusWriter*     m_pFrameBus;
     INuiSensor*         m_pNuiSensor;
 
     bool                m_paused;
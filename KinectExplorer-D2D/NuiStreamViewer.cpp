@@ -19,11 +19,17 @@ NuiStreamViewer::NuiStreamViewer(const NuiViewer* pParent)
     , m_imageType(NUI_IMAGE_TYPE_COLOR)
     , m_pImage(nullptr)
     , m_pauseSkeleton(false)
-    , m_pSkeletonFrame(nullptr)
+    , m_presentPending(false)
+    , m_pSkeletons(nullptr)
     , m_drawEdgeFlags(0)
     , m_frameCount(0)
     , m_lastFrameCount(0)
     , m_fps(0)
+    , m_paintCount(0)
+    , m_lastPaintCount(0)
+    , m_paintFps(0)
+    , m_displayWidth(0)
+    , m_displayHeight(0)
 {
     m_pImageRenderer = new ImageRenderer();
 
@@ -65,6 +71,13 @@ LRESULT NuiStreamViewer::DialogProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM
             UINT width  = LOWORD(lParam);
             UINT height = HIWORD(lParam);
             m_pImageRenderer->ResizeRenderTarget(width, height);
+
+            // Minimized viewers keep the last size, so streams do not shrink images to nothing
+            if (width && height)
+            {
+                m_displayWidth  = width;
+                m_displayHeight = height;
+            }
         }
         break;
 
@@ -121,6 +134,8 @@ void NuiStreamViewer::OnPaint(WPARAM wParam, LPARAM lParam)
     DrawRedEdges(imageRect);
 
     m_pImageRenderer->EndDraw();
+
+    m_paintCount++;
 }
 
 /// <summary>
@@ -142,22 +157,22 @@ void NuiStreamViewer::DrawImage(const D2D1_RECT_F& imageRect)
 /// <param name="imageRect">The rect which the color or depth stream image is streched to fit</param>
 void NuiStreamViewer::DrawSkeletons(const D2D1_RECT_F& imageRect)
 {
-    if (m_pSkeletonFrame && !m_pauseSkeleton)
+    if (m_pSkeletons && !m_pauseSkeleton)
     {
         // Clip the area to avoid drawing outside the image
         m_pImageRenderer->SetClipRect(imageRect);
 
-        for (int i = 0; i < NUI_SKELETON_COUNT; i++)
+        for (UINT i = 0; i < NUI_SKELETON_COUNT; i++)
         {
-            NUI_SKELETON_TRACKING_STATE state = m_pSkeletonFrame->SkeletonData[i].eTrackingState;
+            NUI_SKELETON_TRACKING_STATE state = m_pSkeletons->GetTrackingState(i);
             if (NUI_SKELETON_TRACKED == state)
             {
                 // Draw bones and joints of tracked skeleton
-                DrawSkeleton(m_pSkeletonFrame->SkeletonData[i], imageRect);
+                DrawSkeleton(i, imageRect);
             }
             else if (NUI_SKELETON_POSITION_ONLY == state)
             {
-                DrawPosition(m_pSkeletonFrame->SkeletonData[i], imageRect);
+                DrawPosition(i, imageRect);
             }
         }
 
@@ -168,68 +183,77 @@ void NuiStreamViewer::DrawSkeletons(const D2D1_RECT_F& imageRect)
 /// <summary>
 /// Draw skeleton.
 /// </summary>
-/// <param name="skeletonData">Skeleton coordinates</param>
+/// <param name="skeleton">Skeleton index in the skeleton store</param>
 /// <param name="imageRect">The rect which the color or depth stream image is streched to fit</param>
-void NuiStreamViewer::DrawSkeleton(const NUI_SKELETON_DATA& skeletonData, const D2D1_RECT_F& imageRect)
+void NuiStreamViewer::DrawSkeleton(UINT skeleton, const D2D1_RECT_F& imageRect)
 {
     // Torso
-    DrawBone(skeletonData, imageRect, NUI_SKELETON_POSITION_HEAD,               NUI_SKELETON_POSITION_SHOULDER_CENTER);
-    DrawBone(skeletonData, imageRect, NUI_SKELETON_POSITION_SHOULDER_CENTER,    NUI_SKELETON_POSITION_SHOULDER_LEFT);
-    DrawBone(skeletonData, imageRect, NUI_SKELETON_POSITION_SHOULDER_CENTER,    NUI_SKELETON_POSITION_SHOULDER_RIGHT);
-    DrawBone(skeletonData, imageRect, NUI_SKELETON_POSITION_SHOULDER_CENTER,    NUI_SKELETON_POSITION_SPINE);
-    DrawBone(skeletonData, imageRect, NUI_SKELETON_POSITION_SPINE,              NUI_SKELETON_POSITION_HIP_CENTER);
-    DrawBone(skeletonData, imageRect, NUI_SKELETON_POSITION_HIP_CENTER,         NUI_SKELETON_POSITION_HIP_LEFT);
-    DrawBone(skeletonData, imageRect, NUI_SKELETON_POSITION_HIP_CENTER,         NUI_SKELETON_POSITION_HIP_RIGHT);
+    DrawBone(skeleton, imageRect, NUI_SKELETON_POSITION_HEAD,               NUI_SKELETON_POSITION_SHOULDER_CENTER);
+    DrawBone(skeleton, imageRect, NUI_SKELETON_POSITION_SHOULDER_CENTER,    NUI_SKELETON_POSITION_SHOULDER_LEFT);
+    DrawBone(skeleton, imageRect, NUI_SKELETON_POSITION_SHOULDER_CENTER,    NUI_SKELETON_POSITION_SHOULDER_RIGHT);
+    DrawBone(skeleton, imageRect, NUI_SKELETON_POSITION_SHOULDER_CENTER,    NUI_SKELETON_POSITION_SPINE);
+    DrawBone(skeleton, imageRect, NUI_SKELETON_POSITION_SPINE,              NUI_SKELETON_POSITION_HIP_CENTER);
+    DrawBone(skeleton, imageRect, NUI_SKELETON_POSITION_HIP_CENTER,         NUI_SKELETON_POSITION_HIP_LEFT);
+    DrawBone(skeleton, imageRect, NUI_SKELETON_POSITION_HIP_CENTER,         NUI_SKELETON_POSITION_HIP_RIGHT);
 
     // Left arm
-    DrawBone(skeletonData, imageRect, NUI_SKELETON_POSITION_SHOULDER_LEFT,      NUI_SKELETON_POSITION_ELBOW_LEFT);
-    DrawBone(skeletonData, imageRect, NUI_SKELETON_POSITION_ELBOW_LEFT,         NUI_SKELETON_POSITION_WRIST_LEFT);
-    DrawBone(skeletonData, imageRect, NUI_SKELETON_POSITION_WRIST_LEFT,         NUI_SKELETON_POSITION_HAND_LEFT);
+    DrawBone(skeleton, imageRect, NUI_SKELETON_POSITION_SHOULDER_LEFT,      NUI_SKELETON_POSITION_ELBOW_LEFT);
+    DrawBone(skeleton, imageRect, NUI_SKELETON_POSITION_ELBOW_LEFT,         NUI_SKELETON_POSITION_WRIST_LEFT);
+    DrawBone(skeleton, imageRect, NUI_SKELETON_POSITION_WRIST_LEFT,         NUI_SKELETON_POSITION_HAND_LEFT);
 
     // Right arm
-    DrawBone(skeletonData, imageRect, NUI_SKELETON_POSITION_SHOULDER_RIGHT,     NUI_SKELETON_POSITION_ELBOW_RIGHT);
-    DrawBone(skeletonData, imageRect, NUI_SKELETON_POSITION_ELBOW_RIGHT,        NUI_SKELETON_POSITION_WRIST_RIGHT);
-    DrawBone(skeletonData, imageRect, NUI_SKELETON_POSITION_WRIST_RIGHT,        NUI_SKELETON_POSITION_HAND_RIGHT);
+    DrawBone(skeleton, imageRect, NUI_SKELETON_POSITION_SHOULDER_RIGHT,     NUI_SKELETON_POSITION_ELBOW_RIGHT);
+    DrawBone(skeleton, imageRect, NUI_SKELETON_POSITION_ELBOW_RIGHT,        NUI_SKELETON_POSITION_WRIST_RIGHT);
+    DrawBone(skeleton, imageRect, NUI_SKELETON_POSITION_WRIST_RIGHT,        NUI_SKELETON_POSITION_HAND_RIGHT);
 
     // Left leg
-    DrawBone(skeletonData, imageRect, NUI_SKELETON_POSITION_HIP_LEFT,           NUI_SKELETON_POSITION_KNEE_LEFT);
-    DrawBone(skeletonData, imageRect, NUI_SKELETON_POSITION_KNEE_LEFT,          NUI_SKELETON_POSITION_ANKLE_LEFT);
-    DrawBone(skeletonData, imageRect, NUI_SKELETON_POSITION_ANKLE_LEFT,         NUI_SKELETON_POSITION_FOOT_LEFT);
+    DrawBone(skeleton, imageRect, NUI_SKELETON_POSITION_HIP_LEFT,           NUI_SKELETON_POSITION_KNEE_LEFT);
+    DrawBone(skeleton, imageRect, NUI_SKELETON_POSITION_KNEE_LEFT,          NUI_SKELETON_POSITION_ANKLE_LEFT);
+    DrawBone(skeleton, imageRect, NUI_SKELETON_POSITION_ANKLE_LEFT,         NUI_SKELETON_POSITION_FOOT_LEFT);
 
     // Right leg
-    DrawBone(skeletonData, imageRect, NUI_SKELETON_POSITION_HIP_RIGHT,          NUI_SKELETON_POSITION_KNEE_RIGHT);
-    DrawBone(skeletonData, imageRect, NUI_SKELETON_POSITION_KNEE_RIGHT,         NUI_SKELETON_POSITION_ANKLE_RIGHT);
-    DrawBone(skeletonData, imageRect, NUI_SKELETON_POSITION_ANKLE_RIGHT,        NUI_SKELETON_POSITION_FOOT_RIGHT);
+    DrawBone(skeleton, imageRect, NUI_SKELETON_POSITION_HIP_RIGHT,          NUI_SKELETON_POSITION_KNEE_RIGHT);
+    DrawBone(skeleton, imageRect, NUI_SKELETON_POSITION_KNEE_RIGHT,         NUI_SKELETON_POSITION_ANKLE_RIGHT);
+    DrawBone(skeleton, imageRect, NUI_SKELETON_POSITION_ANKLE_RIGHT,        NUI_SKELETON_POSITION_FOOT_RIGHT);
 
     // Draw joints
     for (int i = 0; i < NUI_SKELETON_POSITION_COUNT; i++)
     {
-        DrawJoint(skeletonData, imageRect, (NUI_SKELETON_POSITION_INDEX)i);
+        DrawJoint(skeleton, imageRect, (NUI_SKELETON_POSITION_INDEX)i);
     }
 }
 
 /// <summary>
 /// Draw a circle to indicate a skeleton of which only position info is available
 /// </summary>
-/// <param name="skeletonData">Skeleton coordinates</param>
+/// <param name="skeleton">Skeleton index in the skeleton store</param>
 /// <param name="imageRect">The rect which the color or depth stream image is streched to fit</param>
-void NuiStreamViewer::DrawPosition(const NUI_SKELETON_DATA& skeletonData, const D2D1_RECT_F& imageRect)
+void NuiStreamViewer::DrawPosition(UINT skeleton, const D2D1_RECT_F& imageRect)
 {
-    D2D1_POINT_2F center = ToImageRect(skeletonData.Position, imageRect);
+    UINT index = SkeletonStore::GetPointIndex(skeleton, SKELETON_STORE_POSITION);
+    if (NUI_SKELETON_POSITION_NOT_TRACKED == m_pSkeletons->GetPointState(index))
+    {
+        return;
+    }
+
+    D2D1_POINT_2F center = ToImageRect(index, imageRect);
     m_pImageRenderer->DrawCircle(center, 5.0f, ImageRendererBrushGreen, 2.5f);
 }
 
 /// <summary>
 /// Draw a bone between 2 tracked joint.
 /// <summary>
-/// <param name="skeletonData">Skeleton coordinates</param>
+/// <param name="skeleton">Skeleton index in the skeleton store</param>
 /// <param name="imageRect">The rect which the color or depth image is streched to fit</param>
 /// <param name="joint0">Index for the first joint</param>
 /// <param name="joint1">Index for the second joint</param>
-void NuiStreamViewer::DrawBone(const NUI_SKELETON_DATA& skeletonData, const D2D1_RECT_F& imageRect, NUI_SKELETON_POSITION_INDEX joint0, NUI_SKELETON_POSITION_INDEX joint1)
+void NuiStreamViewer::DrawBone(UINT skeleton, const D2D1_RECT_F& imageRect, NUI_SKELETON_POSITION_INDEX joint0, NUI_SKELETON_POSITION_INDEX joint1)
 {
-    NUI_SKELETON_POSITION_TRACKING_STATE state0 = skeletonData.eSkeletonPositionTrackingState[joint0];
-    NUI_SKELETON_POSITION_TRACKING_STATE state1 = skeletonData.eSkeletonPositionTrackingState[joint1];
+    UINT index0 = SkeletonStore::GetPointIndex(skeleton, joint0);
+    UINT index1 = SkeletonStore::GetPointIndex(skeleton, joint1);
+
+    NUI_SKELETON_POSITION_TRACKING_STATE state0 = m_pSkeletons->GetPointState(index0);
+    NUI_SKELETON_POSITION_TRACKING_STATE state1 = m_pSkeletons->GetPointState(index1);
 
     // Any is not tracked
     if (NUI_SKELETON_POSITION_NOT_TRACKED == state0 || NUI_SKELETON_POSITION_NOT_TRACKED == state1)
@@ -243,8 +267,8 @@ void NuiStreamViewer::DrawBone(const NUI_SKELETON_DATA& skeletonData, const D2D1
         return;
     }
 
-    D2D1_POINT_2F point0 = ToImageRect(skeletonData.SkeletonPositions[joint0], imageRect);
-    D2D1_POINT_2F point1 = ToImageRect(skeletonData.SkeletonPositions[joint1], imageRect);
+    D2D1_POINT_2F point0 = ToImageRect(index0, imageRect);
+    D2D1_POINT_2F point1 = ToImageRect(index1, imageRect);
 
     // We assume all drawn bones are inferred unless BOTH joints are tracked
     if (NUI_SKELETON_POSITION_TRACKED == state0 && NUI_SKELETON_POSITION_TRACKED == state1)
@@ -260,12 +284,13 @@ void NuiStreamViewer::DrawBone(const NUI_SKELETON_DATA& skeletonData, const D2D1
 /// <summary>
 /// Draw a joint of the skeleton
 /// </summary>
-/// <param name="skeletonData">Skeleton coordinates</param>
+/// <param name="skeleton">Skeleton index in the skeleton store</param>
 /// <param name="imageRect">The rect which the color or depth image is streched to fit</param>
 /// <param name="joint">Index for the joint to be drawn</param>
-void NuiStreamViewer::DrawJoint(const NUI_SKELETON_DATA& skeletonData, const D2D1_RECT_F& imageRect, NUI_SKELETON_POSITION_INDEX joint)
+void NuiStreamViewer::DrawJoint(UINT skeleton, const D2D1_RECT_F& imageRect, NUI_SKELETON_POSITION_INDEX joint)
 {
-    NUI_SKELETON_POSITION_TRACKING_STATE state = skeletonData.eSkeletonPositionTrackingState[joint];
+    UINT index = SkeletonStore::GetPointIndex(skeleton, joint);
+    NUI_SKELETON_POSITION_TRACKING_STATE state = m_pSkeletons->GetPointState(index);
 
     // Not tracked
     if (NUI_SKELETON_POSITION_NOT_TRACKED == state)
@@ -273,7 +298,7 @@ void NuiStreamViewer::DrawJoint(const NUI_SKELETON_DATA& skeletonData, const D2D
         return;
     }
 
-    D2D1_POINT_2F point = ToImageRect(skeletonData.SkeletonPositions[joint], imageRect);
+    D2D1_POINT_2F point = ToImageRect(index, imageRect);
 
     if (NUI_SKELETON_POSITION_TRACKED == state)
     {
@@ -323,7 +348,7 @@ void NuiStreamViewer::DrawResolution(const RECT& clientRect)
     {
         WCHAR buffer[MaxStringChars];
         D2D1_RECT_F rect = D2D1::RectF((FLOAT)clientRect.left, (FLOAT)clientRect.top, (FLOAT)clientRect.right, 10.0f);
-        swprintf_s(buffer, sizeof(buffer) / sizeof(WCHAR), L"Resolution: %dx%d", m_pImage->GetWidth(), m_pImage->GetHeight());
+        swprintf_s(buffer, sizeof(buffer) / sizeof(WCHAR), L"Resolution: %dx%d  Repaint: %u fps", m_pImage->GetFullWidth(), m_pImage->GetFullHeight(), m_paintFps);
         m_pImageRenderer->DrawText(buffer, (UINT)wcsnlen_s(buffer, MaxStringChars), rect, ImageRendererBrushGreen, ImageRendererTextFormatResolution);
     }
 }
@@ -416,42 +441,70 @@ void NuiStreamViewer::SetImage(const NuiImageBuffer* pImage)
     m_pImage = pImage;
     if (m_pImage &&  m_pImage->GetBufferSize() && m_hWnd)
     {
-        InvalidateRect(m_hWnd, nullptr, FALSE);
+        // Drawn by the next Present, together with any skeleton update
+        m_presentPending = true;
 
-        UpdateFrameRate();
+        m_frameCount++;
     }
 }
 
 /// <summary>
 /// Attach skeleton data.
 /// </summary>
-/// <param name="pFrame">The pointer to skeleton frame</param>
-void NuiStreamViewer::SetSkeleton(const NUI_SKELETON_FRAME* pFrame)
+/// <param name="pSkeletons">The pointer to skeleton store, or nullptr for none</param>
+void NuiStreamViewer::SetSkeleton(const SkeletonStore* pSkeletons)
 {
     if (!m_hWnd)
     {
         return;
     }
 
-    m_pSkeletonFrame = pFrame;
+    m_pSkeletons = pSkeletons;
+
+    m_presentPending = true;
+}
+
+/// <summary>
+/// Repaint if new data arrived since the last present and the viewer can be seen.
+/// Called once per display interval, so several updates share one repaint
+/// </summary>
+void NuiStreamViewer::Present()
+{
+    UpdateFrameRate();
 
+    if (!m_presentPending || !m_hWnd)
+    {
+        return;
+    }
+
+    // Hidden or minimized viewers are not drawn. The update stays pending until they can be seen again
+    RECT clientRect;
+    if (!IsWindowVisible(m_hWnd) || IsIconic(GetAncestor(m_hWnd, GA_ROOT)) || !::GetClientRect(m_hWnd, &clientRect) || IsRectEmpty(&clientRect))
+    {
+        return;
+    }
+
+    m_presentPending = false;
+
+    // Paint right away rather than whenever the message queue runs empty
     InvalidateRect(m_hWnd, nullptr, FALSE);
+    UpdateWindow(m_hWnd);
 }
 
 /// <summary>
-/// Update frame rate
+/// Update processing and repaint frame rates
 /// </summary>
 void NuiStreamViewer::UpdateFrameRate()
 {
-    m_frameCount++;
-
     DWORD tickCount = GetTickCount();
     DWORD span      = tickCount - m_lastTick;
     if (span >= 1000)
     {
         m_fps            = (UINT)((double)(m_frameCount - m_lastFrameCount) * 1000.0 / (double)span + 0.5);
+        m_paintFps       = (UINT)((double)(m_paintCount - m_lastPaintCount) * 1000.0 / (double)span + 0.5);
         m_lastTick       = tickCount;
         m_lastFrameCount = m_frameCount;
+        m_lastPaintCount = m_paintCount;
     }
 }
 
@@ -536,34 +589,26 @@ D2D1_RECT_F NuiStreamViewer::GetImageRect(const RECT &client)
 /// <summary>
 /// Map skeleton point to window coordinate in image rect.
 /// </summary>
-/// <param name="skeletonPoint">Skeleton point to map.</param>
+/// <param name="index">Index of the point in the skeleton store</param>
 /// <param name="imageRect">The rectangle of image</param>
 /// <returns>Mapped coordinate in client area</returns>
-D2D1_POINT_2F NuiStreamViewer::ToImageRect(const Vector4& skeletonPoint, const D2D1_RECT_F& imageRect)
+D2D1_POINT_2F NuiStreamViewer::ToImageRect(UINT index, const D2D1_RECT_F& imageRect)
 {
-    const NUI_IMAGE_RESOLUTION imageResolution = NUI_IMAGE_RESOLUTION_640x480;
-    LONG x = 0, y = 0;
-    USHORT depthValue = 0;
-    NuiTransformSkeletonToDepthImage(skeletonPoint, &x, &y, &depthValue, imageResolution); // Returns coordinates in depth space
+    // The skeleton store projected the point to both images as fractions of the image size
+    FLOAT x = m_pSkeletons->GetDepthX()[index];
+    FLOAT y = m_pSkeletons->GetDepthY()[index];
 
     if (NUI_IMAGE_TYPE_COLOR == m_imageType || NUI_IMAGE_TYPE_COLOR_INFRARED == m_imageType
         || NUI_IMAGE_TYPE_COLOR_RAW_BAYER == m_imageType || NUI_IMAGE_TYPE_COLOR_RAW_YUV == m_imageType
         || NUI_IMAGE_TYPE_COLOR_YUV == m_imageType)
     {
-        LONG backupX = x, backupY = y;
-        if (FAILED(NuiImageGetColorPixelCoordinatesFromDepthPixelAtResolution(imageResolution, imageResolution, nullptr, x, y, depthValue, &x, &y)))
-        {
-            x = backupX;
-            y = backupY;
-        }
+        x = m_pSkeletons->GetColorX()[index];
+        y = m_pSkeletons->GetColorY()[index];
     }
 
-    DWORD imageWidth, imageHeight;
-    NuiImageResolutionToSize(imageResolution, imageWidth, imageHeight);
-
     FLOAT resultX, resultY;
-    resultX = x * (imageRect.right  - imageRect.left + 1.0f) / imageWidth + imageRect.left;
-    resultY = y * (imageRect.bottom - imageRect.top  + 1.0f) / imageHeight + imageRect.top;
+    resultX = x * (imageRect.right  - imageRect.left + 1.0f) + imageRect.left;
+    resultY = y * (imageRect.bottom - imageRect.top  + 1.0f) + imageRect.top;
 
     return D2D1::Point2F(resultX, resultY);
 }
@@ -11,6 +11,7 @@
 #include "NuiViewer.h"
 #include "NuiImageBuffer.h"
 #include "ImageRenderer.h"
+#include "SkeletonStore.h"
 
 enum DRAW_EDGE_FLAG
 {
@@ -44,8 +45,8 @@ public:
     /// <summary>
     /// Attach skeleton data.
     /// </summary>
-    /// <param name="pFrame">The pointer to skeleton frame</param>
-    void SetSkeleton(const NUI_SKELETON_FRAME* pFrame);
+    /// <param name="pSkeletons">The pointer to skeleton store, or nullptr for none</param>
+    void SetSkeleton(const SkeletonStore* pSkeletons);
 
     /// <summary>
     /// Pause the skeleton
@@ -53,6 +54,23 @@ public:
     /// <param name="pause">Pause or resume the skeleton</param>
     void PauseSkeleton(bool pause);
 
+    /// <summary>
+    /// Repaint if new data arrived since the last present and the viewer can be seen.
+    /// Called once per display interval, so several updates share one repaint
+    /// </summary>
+    void Present();
+
+    /// <summary>
+    /// Get the size of the client area the image is drawn in
+    /// </summary>
+    /// <param name="width">Client width, zero before the viewer is first sized</param>
+    /// <param name="height">Client height, zero before the viewer is first sized</param>
+    void GetDisplaySize(UINT& width, UINT& height) const
+    {
+        width  = m_displayWidth;
+        height = m_displayHeight;
+    }
+
     /// <summary>
     /// Set image type.
     /// </summary>
@@ -103,33 +121,33 @@ private:
     /// <summary>
     /// Draw a skeleton and overlay it on color or depth image
     /// </summary>
-    /// <param name="skeletonData">Skeleton coordinates</param>
+    /// <param name="skeleton">Skeleton index in the skeleton store</param>
     /// <param name="imageRect">The rect which the color or depth stream image is streched to fit</param>
-    void DrawSkeleton(const NUI_SKELETON_DATA& skeletonData, const D2D1_RECT_F& imageRect);
+    void DrawSkeleton(UINT skeleton, const D2D1_RECT_F& imageRect);
 
     /// <summary>
     /// Draw a circle to indicate a skeleton of which only position info is available
     /// </summary>
-    /// <param name="skeletonData">Skeleton coordinates</param>
+    /// <param name="skeleton">Skeleton index in the skeleton store</param>
     /// <param name="imageRect">The rect which the color or depth stream image is streched to fit</param>
-    void DrawPosition(const NUI_SKELETON_DATA& skeletonData, const D2D1_RECT_F& imageRect);
+    void DrawPosition(UINT skeleton, const D2D1_RECT_F& imageRect);
 
     /// <summary>
     /// Draw a bone between 2 tracked joint.
     /// <summary>
-    /// <param name="skeletonData">Skeleton coordinates</param>
+    /// <param name="skeleton">Skeleton index in the skeleton store</param>
     /// <param name="imageRect">The rect which the color or depth image is streched to fit</param>
     /// <param name="joint0">Index for the first joint</param>
     /// <param name="joint1">Index for the second joint</param>
-    void DrawBone(const NUI_SKELETON_DATA& skeletonData, const D2D1_RECT_F& imageRect, NUI_SKELETON_POSITION_INDEX joint0, NUI_SKELETON_POSITION_INDEX joint1);
+    void DrawBone(UINT skeleton, const D2D1_RECT_F& imageRect, NUI_SKELETON_POSITION_INDEX joint0, NUI_SKELETON_POSITION_INDEX joint1);
 
     /// <summary>
     /// Draw a joint of the skeleton
     /// </summary>
-    /// <param name="skeletonData">Skeleton coordinates</param>
+    /// <param name="skeleton">Skeleton index in the skeleton store</param>
     /// <param name="imageRect">The rect which the color or depth image is streched to fit</param>
     /// <param name="joint">Index for the joint to be drawn</param>
-    void DrawJoint(const NUI_SKELETON_DATA& skeletonData, const D2D1_RECT_F& imageRect, NUI_SKELETON_POSITION_INDEX joint);
+    void DrawJoint(UINT skeleton, const D2D1_RECT_F& imageRect, NUI_SKELETON_POSITION_INDEX joint);
 
     /// <summary>
     /// Draw frame FPS counter
@@ -150,7 +168,7 @@ private:
     void DrawRedEdges(const D2D1_RECT_F& imageRect);
 
     /// <summary>
-    /// Update frame rate
+    /// Update processing and repaint frame rates
     /// </summary>
     void UpdateFrameRate();
 
@@ -177,23 +195,29 @@ private:
     /// <summary>
     /// Map skeleton point to window coordinate in image rect.
     /// </summary>
-    /// <param name="skeletonPoint">Skeleton point to map.</param>
+    /// <param name="index">Index of the point in the skeleton store</param>
     /// <param name="imageRect">The rectangle of image</param>
     /// <returns>Mapped coordinate in client area</returns>
-    D2D1_POINT_2F ToImageRect(const Vector4& skeletonPoint, const D2D1_RECT_F& imageRect);
+    D2D1_POINT_2F ToImageRect(UINT index, const D2D1_RECT_F& imageRect);
 
 private:
     NUI_IMAGE_TYPE              m_imageType;
 
     const NuiImageBuffer*       m_pImage;
-    const NUI_SKELETON_FRAME*   m_pSkeletonFrame;
+    const SkeletonStore*        m_pSkeletons;
 
     bool                m_pauseSkeleton;
-    UINT                m_fps;
+    bool                m_presentPending;   // New data arrived since the last present
+    UINT                m_fps;              // Frames processed per second
     UINT                m_frameCount;
     UINT                m_lastFrameCount;
+    UINT                m_paintFps;         // Repaints per second
+    UINT                m_paintCount;
+    UINT                m_lastPaintCount;
     DWORD               m_lastTick;
     DWORD               m_drawEdgeFlags;
+    UINT                m_displayWidth;     // Client size the image is stretched to
+    UINT                m_displayHeight;
 
     ImageRenderer*      m_pImageRenderer;
 };
\ No newline at end of file
@@ -0,0 +1,191 @@
+//------------------------------------------------------------------------------
+// <copyright file="NuiTypes.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+// Types and constants shared by the ball detection modules. On Windows this
+// simply pulls in the Kinect SDK. Elsewhere it provides the small subset of
+// SDK definitions the detection code relies on, so the processing modules can
+// be built and exercised on Linux against recorded or synthetic frames.
+
+#pragma once
+
+#ifdef _WIN32
+
+#include <windows.h>
+#include <NuiApi.h>
+
+#else
+
+#include <stdint.h>
+#include <string.h>
+
+typedef uint8_t     BYTE;
+typedef int16_t     SHORT;
+typedef uint16_t    USHORT;
+typedef uint32_t    UINT;
+typedef uint32_t    DWORD;
+typedef int32_t     LONG;
+typedef int32_t     BOOL;
+typedef float       FLOAT;
+typedef int32_t     HRESULT;
+typedef int64_t     LONGLONG;
+typedef uint64_t    ULONGLONG;
+
+union LARGE_INTEGER
+{
+    LONGLONG    QuadPart;
+};
+
+#ifndef TRUE
+#define TRUE    1
+#define FALSE   0
+#endif
+
+#define S_OK            ((HRESULT)0x00000000L)
+#define S_FALSE         ((HRESULT)0x00000001L)
+#define E_FAIL          ((HRESULT)0x80004005L)
+#define E_INVALIDARG    ((HRESULT)0x80070057L)
+#define E_OUTOFMEMORY   ((HRESULT)0x8007000EL)
+
+#define SUCCEEDED(hr)   (((HRESULT)(hr)) >= 0)
+#define FAILED(hr)      (((HRESULT)(hr)) < 0)
+
+#define ZeroMemory(dest, size)  memset((dest), 0, (size))
+
+struct Vector4
+{
+    FLOAT x;
+    FLOAT y;
+    FLOAT z;
+    FLOAT w;
+};
+
+struct NUI_DEPTH_IMAGE_PIXEL
+{
+    USHORT playerIndex;
+    USHORT depth;
+};
+
+enum NUI_IMAGE_RESOLUTION
+{
+    NUI_IMAGE_RESOLUTION_INVALID = -1,
+    NUI_IMAGE_RESOLUTION_80x60   = 0,
+    NUI_IMAGE_RESOLUTION_320x240 = (NUI_IMAGE_RESOLUTION_80x60 + 1),
+    NUI_IMAGE_RESOLUTION_640x480 = (NUI_IMAGE_RESOLUTION_320x240 + 1),
+    NUI_IMAGE_RESOLUTION_1280x960 = (NUI_IMAGE_RESOLUTION_640x480 + 1)
+};
+
+#define NUI_IMAGE_PLAYER_INDEX_SHIFT                            3
+#define NUI_IMAGE_PLAYER_INDEX_MASK                             ((1 << NUI_IMAGE_PLAYER_INDEX_SHIFT) - 1)
+#define NUI_IMAGE_DEPTH_MAXIMUM                                 ((4000 << NUI_IMAGE_PLAYER_INDEX_SHIFT) | NUI_IMAGE_PLAYER_INDEX_MASK)
+#define NUI_IMAGE_DEPTH_MINIMUM                                 (800 << NUI_IMAGE_PLAYER_INDEX_SHIFT)
+#define NUI_IMAGE_DEPTH_MAXIMUM_NEAR_MODE                       ((3000 << NUI_IMAGE_PLAYER_INDEX_SHIFT) | NUI_IMAGE_PLAYER_INDEX_MASK)
+#define NUI_IMAGE_DEPTH_MINIMUM_NEAR_MODE                       (400 << NUI_IMAGE_PLAYER_INDEX_SHIFT)
+
+#define NUI_CAMERA_DEPTH_NOMINAL_FOCAL_LENGTH_IN_PIXELS         (285.63f)   // Based on 320x240 pixel size.
+#define NUI_CAMERA_DEPTH_NOMINAL_INVERSE_FOCAL_LENGTH_IN_PIXELS (3.501e-3f) // (1/NUI_CAMERA_DEPTH_NOMINAL_FOCAL_LENGTH_IN_PIXELS)
+#define NUI_CAMERA_COLOR_NOMINAL_FOCAL_LENGTH_IN_PIXELS         (531.15f)   // Based on 640x480 pixel size.
+
+#define NUI_SKELETON_COUNT                                      6
+
+enum NUI_SKELETON_POSITION_INDEX
+{
+    NUI_SKELETON_POSITION_HIP_CENTER = 0,
+    NUI_SKELETON_POSITION_SPINE,
+    NUI_SKELETON_POSITION_SHOULDER_CENTER,
+    NUI_SKELETON_POSITION_HEAD,
+    NUI_SKELETON_POSITION_SHOULDER_LEFT,
+    NUI_SKELETON_POSITION_ELBOW_LEFT,
+    NUI_SKELETON_POSITION_WRIST_LEFT,
+    NUI_SKELETON_POSITION_HAND_LEFT,
+    NUI_SKELETON_POSITION_SHOULDER_RIGHT,
+    NUI_SKELETON_POSITION_ELBOW_RIGHT,
+    NUI_SKELETON_POSITION_WRIST_RIGHT,
+    NUI_SKELETON_POSITION_HAND_RIGHT,
+    NUI_SKELETON_POSITION_HIP_LEFT,
+    NUI_SKELETON_POSITION_KNEE_LEFT,
+    NUI_SKELETON_POSITION_ANKLE_LEFT,
+    NUI_SKELETON_POSITION_FOOT_LEFT,
+    NUI_SKELETON_POSITION_HIP_RIGHT,
+    NUI_SKELETON_POSITION_KNEE_RIGHT,
+    NUI_SKELETON_POSITION_ANKLE_RIGHT,
+    NUI_SKELETON_POSITION_FOOT_RIGHT,
+    NUI_SKELETON_POSITION_COUNT
+};
+
+enum NUI_SKELETON_POSITION_TRACKING_STATE
+{
+    NUI_SKELETON_POSITION_NOT_TRACKED = 0,
+    NUI_SKELETON_POSITION_INFERRED,
+    NUI_SKELETON_POSITION_TRACKED
+};
+
+enum NUI_SKELETON_TRACKING_STATE
+{
+    NUI_SKELETON_NOT_TRACKED = 0,
+    NUI_SKELETON_POSITION_ONLY,
+    NUI_SKELETON_TRACKED
+};
+
+struct NUI_SKELETON_DATA
+{
+    NUI_SKELETON_TRACKING_STATE             eTrackingState;
+    DWORD                                   dwTrackingID;
+    DWORD                                   dwEnrollmentIndex;
+    DWORD                                   dwUserIndex;
+    Vector4                                 Position;
+    Vector4                                 SkeletonPositions[NUI_SKELETON_POSITION_COUNT];
+    NUI_SKELETON_POSITION_TRACKING_STATE    eSkeletonPositionTrackingState[NUI_SKELETON_POSITION_COUNT];
+    DWORD                                   dwQualityFlags;
+};
+
+struct NUI_SKELETON_FRAME
+{
+    LARGE_INTEGER                           liTimeStamp;
+    DWORD                                   dwFrameNumber;
+    DWORD                                   dwFlags;
+    Vector4                                 vFloorClipPlane;
+    Vector4                                 vNormalToGravity;
+    NUI_SKELETON_DATA                       SkeletonData[NUI_SKELETON_COUNT];
+};
+
+/// <summary>
+/// Calculate image width and height according to image resolution enumeration value.
+/// </summary>
+inline void NuiImageResolutionToSize(NUI_IMAGE_RESOLUTION res, DWORD& refWidth, DWORD& refHeight)
+{
+    switch (res)
+    {
+    case NUI_IMAGE_RESOLUTION_80x60:
+        refWidth  = 80;
+        refHeight = 60;
+        break;
+    case NUI_IMAGE_RESOLUTION_320x240:
+        refWidth  = 320;
+        refHeight = 240;
+        break;
+    case NUI_IMAGE_RESOLUTION_640x480:
+        refWidth  = 640;
+        refHeight = 480;
+        break;
+    case NUI_IMAGE_RESOLUTION_1280x960:
+        refWidth  = 1280;
+        refHeight = 960;
+        break;
+    default:
+        refWidth  = 0;
+        refHeight = 0;
+        break;
+    }
+}
+
+#endif
+
+// SSE2 is baseline on every x86/x64 target we build for. Other targets fall
+// back to the scalar loops.
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define NUI_USE_SSE2    1
+#include <emmintrin.h>
+#endif
@@ -0,0 +1,670 @@
+//------------------------------------------------------------------------------
+// <copyright file="OverlayCompositor.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "OverlayCompositor.h"
+
+#include <math.h>
+#include <string.h>
+
+#define MAX_DIRTY_RECTS     16
+#define MIN_HALF_WIDTH      0.5f    // Thinner shapes are drawn this wide with lower opacity
+#define FONT_FIRST_CHAR     0x20
+#define FONT_LAST_CHAR      0x5F
+#define FONT_COLUMNS        5
+#define FONT_ROWS           7
+#define FONT_ADVANCE        6       // Cells from one character to the next
+
+// 5x7 font from space to underscore. One byte per column, bit 0 is the top row
+static const BYTE Font[FONT_LAST_CHAR - FONT_FIRST_CHAR + 1][FONT_COLUMNS] =
+{
+    {0x00, 0x00, 0x00, 0x00, 0x00},     // Space
+    {0x00, 0x00, 0x5F, 0x00, 0x00},     // !
+    {0x00, 0x07, 0x00, 0x07, 0x00},     // "
+    {0x14, 0x7F, 0x14, 0x7F, 0x14},     // #
+    {0x24, 0x2A, 0x7F, 0x2A, 0x12},     // $
+    {0x23, 0x13, 0x08, 0x64, 0x62},     // %
+    {0x36, 0x49, 0x55, 0x22, 0x50},     // &
+    {0x00, 0x05, 0x03, 0x00, 0x00},     // '
+    {0x00, 0x1C, 0x22, 0x41, 0x00},     // (
+    {0x00, 0x41, 0x22, 0x1C, 0x00},     // )
+    {0x14, 0x08, 0x3E, 0x08, 0x14},     // *
+    {0x08, 0x08, 0x3E, 0x08, 0x08},     // +
+    {0x00, 0x50, 0x30, 0x00, 0x00},     // ,
+    {0x08, 0x08, 0x08, 0x08, 0x08},     // -
+    {0x00, 0x60, 0x60, 0x00, 0x00},     // .
+    {0x20, 0x10, 0x08, 0x04, 0x02},     // /
+    {0x3E, 0x51, 0x49, 0x45, 0x3E},     // 0
+    {0x00, 0x42, 0x7F, 0x40, 0x00},     // 1
+    {0x42, 0x61, 0x51, 0x49, 0x46},     // 2
+    {0x21, 0x41, 0x45, 0x4B, 0x31},     // 3
+    {0x18, 0x14, 0x12, 0x7F, 0x10},     // 4
+    {0x27, 0x45, 0x45, 0x45, 0x39},     // 5
+    {0x3C, 0x4A, 0x49, 0x49, 0x30},     // 6
+    {0x01, 0x71, 0x09, 0x05, 0x03},     // 7
+    {0x36, 0x49, 0x49, 0x49, 0x36},     // 8
+    {0x06, 0x49, 0x49, 0x29, 0x1E},     // 9
+    {0x00, 0x36, 0x36, 0x00, 0x00},     // :
+    {0x00, 0x56, 0x36, 0x00, 0x00},     // ;
+    {0x08, 0x14, 0x22, 0x41, 0x00},     // <
+    {0x14, 0x14, 0x14, 0x14, 0x14},     // =
+    {0x00, 0x41, 0x22, 0x14, 0x08},     // >
+    {0x02, 0x01, 0x51, 0x09, 0x06},     // ?
+    {0x32, 0x49, 0x79, 0x41, 0x3E},     // @
+    {0x7E, 0x11, 0x11, 0x11, 0x7E},     // A
+    {0x7F, 0x49, 0x49, 0x49, 0x36},     // B
+    {0x3E, 0x41, 0x41, 0x41, 0x22},     // C
+    {0x7F, 0x41, 0x41, 0x22, 0x1C},     // D
+    {0x7F, 0x49, 0x49, 0x49, 0x41},     // E
+    {0x7F, 0x09, 0x09, 0x09, 0x01},     // F
+    {0x3E, 0x41, 0x49, 0x49, 0x7A},     // G
+    {0x7F, 0x08, 0x08, 0x08, 0x7F},     // H
+    {0x00, 0x41, 0x7F, 0x41, 0x00},     // I
+    {0x20, 0x40, 0x41, 0x3F, 0x01},     // J
+    {0x7F, 0x08, 0x14, 0x22, 0x41},     // K
+    {0x7F, 0x40, 0x40, 0x40, 0x40},     // L
+    {0x7F, 0x02, 0x0C, 0x02, 0x7F},     // M
+    {0x7F, 0x04, 0x08, 0x10, 0x7F},     // N
+    {0x3E, 0x41, 0x41, 0x41, 0x3E},     // O
+    {0x7F, 0x09, 0x09, 0x09, 0x06},     // P
+    {0x3E, 0x41, 0x51, 0x21, 0x5E},     // Q
+    {0x7F, 0x09, 0x19, 0x29, 0x46},     // R
+    {0x46, 0x49, 0x49, 0x49, 0x31},     // S
+    {0x01, 0x01, 0x7F, 0x01, 0x01},     // T
+    {0x3F, 0x40, 0x40, 0x40, 0x3F},     // U
+    {0x1F, 0x20, 0x40, 0x20, 0x1F},     // V
+    {0x3F, 0x40, 0x38, 0x40, 0x3F},     // W
+    {0x63, 0x14, 0x08, 0x14, 0x63},     // X
+    {0x07, 0x08, 0x70, 0x08, 0x07},     // Y
+    {0x61, 0x51, 0x49, 0x45, 0x43},     // Z
+    {0x00, 0x7F, 0x41, 0x41, 0x00},     // [
+    {0x02, 0x04, 0x08, 0x10, 0x20},     // Backslash
+    {0x00, 0x41, 0x41, 0x7F, 0x00},     // ]
+    {0x04, 0x02, 0x01, 0x02, 0x04},     // ^
+    {0x40, 0x40, 0x40, 0x40, 0x40},     // _
+};
+
+/// <summary>
+/// Round down to an integer without a library call
+/// </summary>
+static inline int FloorToInt(FLOAT value)
+{
+    int result = (int)value;
+    return result - (value < (FLOAT)result ? 1 : 0);
+}
+
+/// <summary>
+/// Round up to an integer without a library call
+/// </summary>
+static inline int CeilToInt(FLOAT value)
+{
+    return -FloorToInt(-value);
+}
+
+/// <summary>
+/// Check whether two rectangles overlap or share an edge
+/// </summary>
+static inline bool RectsTouch(const OverlayRect& a, const OverlayRect& b)
+{
+    return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+}
+
+/// <summary>
+/// Get the rectangle bounding two rectangles
+/// </summary>
+static inline OverlayRect UnionRect(const OverlayRect& a, const OverlayRect& b)
+{
+    OverlayRect rect;
+    rect.left   = a.left   < b.left   ? a.left   : b.left;
+    rect.top    = a.top    < b.top    ? a.top    : b.top;
+    rect.right  = a.right  > b.right  ? a.right  : b.right;
+    rect.bottom = a.bottom > b.bottom ? a.bottom : b.bottom;
+    return rect;
+}
+
+/// <summary>
+/// Get the area of a rectangle
+/// </summary>
+static inline int RectArea(const OverlayRect& rect)
+{
+    return (rect.right - rect.left) * (rect.bottom - rect.top);
+}
+
+/// <summary>
+/// Constructor
+/// </summary>
+OverlayCompositor::OverlayCompositor()
+    : m_pPixels(nullptr)
+    , m_width(0)
+    , m_height(0)
+{
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+OverlayCompositor::~OverlayCompositor()
+{
+}
+
+/// <summary>
+/// Start drawing into a frame and clear the dirty rectangles
+/// </summary>
+/// <param name="pPixels">The pointer to BGRX pixels, rows packed</param>
+/// <param name="width">Frame width</param>
+/// <param name="height">Frame height</param>
+void OverlayCompositor::BeginFrame(UINT* pPixels, UINT width, UINT height)
+{
+    m_pPixels = pPixels;
+    m_width   = pPixels ? width  : 0;
+    m_height  = pPixels ? height : 0;
+
+    // Spans are covered four pixels at a time
+    m_coverage.resize(m_width + 4);
+    m_dirtyRects.clear();
+}
+
+/// <summary>
+/// Draw a line with round caps
+/// </summary>
+/// <param name="color">BGR color with opacity in the top byte</param>
+void OverlayCompositor::DrawLine(FLOAT x0, FLOAT y0, FLOAT x1, FLOAT y1, FLOAT width, UINT color)
+{
+    DistanceShape shape;
+    shape.ax         = x0;
+    shape.ay         = y0;
+    shape.dx         = x1 - x0;
+    shape.dy         = y1 - y0;
+    shape.ring       = 0.0f;
+    shape.halfWidth  = width / 2.0f;
+
+    FLOAT length2    = shape.dx * shape.dx + shape.dy * shape.dy;
+    shape.invLength2 = length2 > 0.0f ? 1.0f / length2 : 0.0f;
+
+    DrawShape(shape, color);
+}
+
+/// <summary>
+/// Draw the outline of a circle
+/// </summary>
+/// <param name="color">BGR color with opacity in the top byte</param>
+void OverlayCompositor::DrawCircle(FLOAT x, FLOAT y, FLOAT radius, FLOAT width, UINT color)
+{
+    DistanceShape shape = {x, y, 0.0f, 0.0f, 0.0f, radius, width / 2.0f};
+    DrawShape(shape, color);
+}
+
+/// <summary>
+/// Draw a filled circle
+/// </summary>
+/// <param name="color">BGR color with opacity in the top byte</param>
+void OverlayCompositor::FillCircle(FLOAT x, FLOAT y, FLOAT radius, UINT color)
+{
+    DistanceShape shape = {x, y, 0.0f, 0.0f, 0.0f, 0.0f, radius};
+    DrawShape(shape, color);
+}
+
+/// <summary>
+/// Draw a line of text. Lower case letters are drawn as capitals, characters missing from the font as blanks
+/// </summary>
+/// <param name="x">Left edge</param>
+/// <param name="y">Top edge</param>
+/// <param name="pText">Text to draw</param>
+/// <param name="cellSize">Size of a font pixel, a character is 6 cells wide and 7 high</param>
+/// <param name="color">BGR color with opacity in the top byte</param>
+void OverlayCompositor::DrawLabel(FLOAT x, FLOAT y, const char* pText, FLOAT cellSize, UINT color)
+{
+    size_t length = pText ? strlen(pText) : 0;
+    if (!m_pPixels || 0 == length || cellSize <= 0.0f)
+    {
+        return;
+    }
+
+    // Text box clipped to the frame
+    FLOAT textWidth  = (length * FONT_ADVANCE - 1) * cellSize;
+    FLOAT textHeight = FONT_ROWS * cellSize;
+
+    OverlayRect box = {(int)floorf(x), (int)floorf(y), (int)ceilf(x + textWidth), (int)ceilf(y + textHeight)};
+    box.left   = box.left   < 0               ? 0               : box.left;
+    box.top    = box.top    < 0               ? 0               : box.top;
+    box.right  = box.right  > (int)m_width    ? (int)m_width    : box.right;
+    box.bottom = box.bottom > (int)m_height   ? (int)m_height   : box.bottom;
+    if (box.left >= box.right || box.top >= box.bottom)
+    {
+        return;
+    }
+
+    int boxWidth = box.right - box.left;
+    m_textCoverage.assign(boxWidth * (box.bottom - box.top), 0.0f);
+
+    // Add the overlap of every set font cell with the pixels under it
+    for (size_t i = 0; i < length; i++)
+    {
+        int c = (BYTE)pText[i];
+        c = (c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c;
+        if (c < FONT_FIRST_CHAR || c > FONT_LAST_CHAR)
+        {
+            continue;
+        }
+
+        const BYTE* pGlyph = Font[c - FONT_FIRST_CHAR];
+        for (int column = 0; column < FONT_COLUMNS; column++)
+        {
+            FLOAT cellLeft  = x + (i * FONT_ADVANCE + column) * cellSize;
+            FLOAT cellRight = cellLeft + cellSize;
+
+            int left  = (int)floorf(cellLeft);
+            int right = (int)ceilf(cellRight);
+            left  = left  < box.left  ? box.left  : left;
+            right = right > box.right ? box.right : right;
+
+            for (int row = 0; row < FONT_ROWS; row++)
+            {
+                if (0 == (pGlyph[column] & (1 << row)))
+                {
+                    continue;
+                }
+
+                FLOAT cellTop    = y + row * cellSize;
+                FLOAT cellBottom = cellTop + cellSize;
+
+                int top    = (int)floorf(cellTop);
+                int bottom = (int)ceilf(cellBottom);
+                top    = top    < box.top    ? box.top    : top;
+                bottom = bottom > box.bottom ? box.bottom : bottom;
+
+                for (int py = top; py < bottom; py++)
+                {
+                    FLOAT coverY = (py + 1 < cellBottom ? py + 1 : cellBottom) - (py > cellTop ? py : cellTop);
+                    FLOAT* pRow  = &m_textCoverage[(py - box.top) * boxWidth];
+
+                    for (int px = left; px < right; px++)
+                    {
+                        FLOAT coverX = (px + 1 < cellRight ? px + 1 : cellRight) - (px > cellLeft ? px : cellLeft);
+                        pRow[px - box.left] += coverX * coverY;
+                    }
+                }
+            }
+        }
+    }
+
+    AddDirtyRect(box);
+
+    FLOAT alpha = (FLOAT)(color >> 24);
+    for (int py = box.top; py < box.bottom; py++)
+    {
+        const FLOAT* pRow = &m_textCoverage[(py - box.top) * boxWidth];
+        for (int px = 0; px < boxWidth; px++)
+        {
+            FLOAT coverage = pRow[px] < 1.0f ? pRow[px] : 1.0f;
+            m_coverage[px] = (BYTE)(coverage * alpha + 0.5f);
+        }
+
+        BlendSpan(m_pPixels + py * m_width + box.left, &m_coverage[0], boxWidth, color);
+    }
+}
+
+/// <summary>
+/// Draw the items of an overlay list, scaling their source image positions to the frame
+/// </summary>
+void OverlayCompositor::Draw(const OverlayList& overlay)
+{
+    FLOAT scaleX = overlay.GetSourceWidth()  ? (FLOAT)m_width  / overlay.GetSourceWidth()  : 1.0f;
+    FLOAT scaleY = overlay.GetSourceHeight() ? (FLOAT)m_height / overlay.GetSourceHeight() : 1.0f;
+
+    const std::vector<OverlayItem>& items = overlay.GetItems();
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        const OverlayItem& item = items[i];
+
+        switch (item.type)
+        {
+        case OverlayItemLine:
+            DrawLine(item.x0 * scaleX, item.y0 * scaleY, item.x1 * scaleX, item.y1 * scaleY, item.width, item.color);
+            break;
+
+        case OverlayItemCircle:
+            DrawCircle(item.x0 * scaleX, item.y0 * scaleY, item.radius * scaleX, item.width, item.color);
+            break;
+
+        case OverlayItemDisc:
+            FillCircle(item.x0 * scaleX, item.y0 * scaleY, item.radius * scaleX, item.color);
+            break;
+
+        case OverlayItemText:
+            DrawLabel(item.x0 * scaleX, item.y0 * scaleY, item.text, item.width, item.color);
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+/// <summary>
+/// Get the rectangle bounding all dirty rectangles, empty if nothing was drawn
+/// </summary>
+OverlayRect OverlayCompositor::GetDirtyBounds() const
+{
+    OverlayRect bounds = {0, 0, 0, 0};
+    for (size_t i = 0; i < m_dirtyRects.size(); i++)
+    {
+        bounds = 0 == i ? m_dirtyRects[i] : UnionRect(bounds, m_dirtyRects[i]);
+    }
+
+    return bounds;
+}
+
+/// <summary>
+/// Rasterize a distance shape
+/// </summary>
+void OverlayCompositor::DrawShape(const DistanceShape& shape, UINT color)
+{
+    if (!m_pPixels)
+    {
+        return;
+    }
+
+    // Shapes thinner than a pixel keep a pixel's width and fade instead
+    DistanceShape s     = shape;
+    FLOAT         alpha = (FLOAT)(color >> 24);
+    if (s.halfWidth < MIN_HALF_WIDTH)
+    {
+        alpha      *= s.halfWidth > 0.0f ? s.halfWidth / MIN_HALF_WIDTH : 0.0f;
+        s.halfWidth = MIN_HALF_WIDTH;
+    }
+
+    if (alpha < 0.5f)
+    {
+        return;
+    }
+
+    // Coverage is zero further than this from the segment or ring
+    FLOAT extent = s.halfWidth + 0.5f;
+    FLOAT reach  = s.ring + extent;
+
+    FLOAT minX = s.dx < 0.0f ? s.ax + s.dx : s.ax;
+    FLOAT maxX = s.dx < 0.0f ? s.ax : s.ax + s.dx;
+    FLOAT minY = s.dy < 0.0f ? s.ay + s.dy : s.ay;
+    FLOAT maxY = s.dy < 0.0f ? s.ay : s.ay + s.dy;
+
+    OverlayRect box = {(int)floorf(minX - reach), (int)floorf(minY - reach), (int)ceilf(maxX + reach), (int)ceilf(maxY + reach)};
+    box.left   = box.left   < 0               ? 0               : box.left;
+    box.top    = box.top    < 0               ? 0               : box.top;
+    box.right  = box.right  > (int)m_width    ? (int)m_width    : box.right;
+    box.bottom = box.bottom > (int)m_height   ? (int)m_height   : box.bottom;
+    if (box.left >= box.right || box.top >= box.bottom)
+    {
+        return;
+    }
+
+    AddDirtyRect(box);
+
+    // Radius of the hole inside a ring which nothing covers
+    FLOAT hole  = s.ring - extent;
+    FLOAT invDy = 0.0f != s.dy ? 1.0f / s.dy : 0.0f;
+
+    for (int y = box.top; y < box.bottom; y++)
+    {
+        FLOAT py = y + 0.5f;
+        FLOAT h  = py - s.ay;
+
+        // Columns within reach of this row
+        FLOAT low  = (FLOAT)box.left;
+        FLOAT high = (FLOAT)box.right;
+
+        // Up to two spans per row, either side of a ring's hole
+        int spanLeft[2]  = {box.left,  0};
+        int spanRight[2] = {box.right, 0};
+
+        if (0.0f != s.dy)
+        {
+            // Only the part of a slanted segment within reach of this row
+            FLOAT t0   = (h - reach) * invDy;
+            FLOAT t1   = (h + reach) * invDy;
+            FLOAT tMin = t0 < t1 ? t0 : t1;
+            FLOAT tMax = t0 < t1 ? t1 : t0;
+            tMin = tMin < 0.0f ? 0.0f : tMin;
+            tMax = tMax > 1.0f ? 1.0f : tMax;
+            if (tMin > tMax)
+            {
+                continue;
+            }
+
+            FLOAT xa = s.ax + tMin * s.dx;
+            FLOAT xb = s.ax + tMax * s.dx;
+            low  = (xa < xb ? xa : xb) - reach;
+            high = (xa < xb ? xb : xa) + reach;
+        }
+        else if (0.0f == s.dx)
+        {
+            // Chord of a circle or disc
+            if (h * h >= reach * reach)
+            {
+                continue;
+            }
+
+            FLOAT half = sqrtf(reach * reach - h * h);
+            low  = s.ax - half;
+            high = s.ax + half;
+
+            // Skip the pixels of a ring's hole on rows crossing it
+            if (hole > 0.0f && h * h < hole * hole)
+            {
+                FLOAT inside = sqrtf(hole * hole - h * h);
+                int   inner  = FloorToInt(s.ax - inside + 0.5f);
+                int   outer  = CeilToInt(s.ax + inside - 0.5f);
+                if (inner < outer)
+                {
+                    spanRight[0] = inner;
+                    spanLeft[1]  = outer;
+                    spanRight[1] = box.right;
+                }
+            }
+        }
+
+        int left  = FloorToInt(low);
+        int right = CeilToInt(high);
+        spanLeft[0]  = left > box.left ? left : box.left;
+        spanRight[0] = right < spanRight[0] ? right : spanRight[0];
+        spanLeft[1]  = spanLeft[1] > box.left ? spanLeft[1] : box.left;
+        spanRight[1] = right < spanRight[1] ? right : spanRight[1];
+
+        for (int span = 0; span < 2; span++)
+        {
+            int count = spanRight[span] - spanLeft[span];
+            if (count <= 0)
+            {
+                continue;
+            }
+
+            CoverSpan(s, spanLeft[span], y, count, alpha, &m_coverage[0]);
+            BlendSpan(m_pPixels + y * m_width + spanLeft[span], &m_coverage[0], count, color);
+        }
+    }
+}
+
+/// <summary>
+/// Compute the opacity of a run of pixels in a row for a distance shape
+/// </summary>
+/// <param name="shape">Shape to cover</param>
+/// <param name="x">First pixel</param>
+/// <param name="y">Row</param>
+/// <param name="count">Number of pixels</param>
+/// <param name="alpha">Opacity of full coverage, 0 to 255</param>
+/// <param name="pCoverage">Receives the opacity per pixel, rounded up to a multiple of four</param>
+void OverlayCompositor::CoverSpan(const DistanceShape& shape, int x, int y, int count, FLOAT alpha, BYTE* pCoverage)
+{
+    // Coverage falls from one to zero over the pixel around the shape's edge
+    FLOAT qy    = y + 0.5f - shape.ay;
+    FLOAT edge  = shape.halfWidth + 0.5f;
+    int   i     = 0;
+
+#ifdef NUI_USE_SSE2
+    const __m128 dx         = _mm_set1_ps(shape.dx);
+    const __m128 dy         = _mm_set1_ps(shape.dy);
+    const __m128 invLength2 = _mm_set1_ps(shape.invLength2);
+    const __m128 ring       = _mm_set1_ps(shape.ring);
+    const __m128 edges      = _mm_set1_ps(edge);
+    const __m128 alphas     = _mm_set1_ps(alpha);
+    const __m128 vy         = _mm_set1_ps(qy);
+    const __m128 zero       = _mm_setzero_ps();
+    const __m128 one        = _mm_set1_ps(1.0f);
+    const __m128 half       = _mm_set1_ps(0.5f);
+    const __m128 signMask   = _mm_set1_ps(-0.0f);
+    const __m128 step       = _mm_set1_ps(4.0f);
+
+    __m128 vx = _mm_add_ps(_mm_set1_ps(x + 0.5f - shape.ax), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+
+    for (; i < count; i += 4)
+    {
+        // Nearest point of the segment
+        __m128 t = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(vx, dx), _mm_mul_ps(vy, dy)), invLength2);
+        t = _mm_min_ps(_mm_max_ps(t, zero), one);
+
+        __m128 ex = _mm_sub_ps(vx, _mm_mul_ps(t, dx));
+        __m128 ey = _mm_sub_ps(vy, _mm_mul_ps(t, dy));
+        __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey)));
+        distance = _mm_andnot_ps(signMask, _mm_sub_ps(distance, ring));
+
+        __m128 coverage = _mm_min_ps(_mm_max_ps(_mm_sub_ps(edges, distance), zero), one);
+        __m128i opacity = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(coverage, alphas), half));
+
+        opacity = _mm_packs_epi32(opacity, opacity);
+        opacity = _mm_packus_epi16(opacity, opacity);
+
+        int packed = _mm_cvtsi128_si32(opacity);
+        memcpy(pCoverage + i, &packed, sizeof(packed));
+
+        vx = _mm_add_ps(vx, step);
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        FLOAT qx = x + i + 0.5f - shape.ax;
+        FLOAT t  = (qx * shape.dx + qy * shape.dy) * shape.invLength2;
+        t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+
+        FLOAT ex       = qx - t * shape.dx;
+        FLOAT ey       = qy - t * shape.dy;
+        FLOAT distance = fabsf(sqrtf(ex * ex + ey * ey) - shape.ring);
+
+        FLOAT coverage = edge - distance;
+        coverage = coverage < 0.0f ? 0.0f : (coverage > 1.0f ? 1.0f : coverage);
+        pCoverage[i] = (BYTE)(coverage * alpha + 0.5f);
+    }
+}
+
+/// <summary>
+/// Blend a color into a run of pixels
+/// </summary>
+/// <param name="pPixels">The pointer to the first pixel</param>
+/// <param name="pCoverage">Opacity per pixel</param>
+/// <param name="count">Number of pixels</param>
+/// <param name="color">BGR color</param>
+void OverlayCompositor::BlendSpan(UINT* pPixels, const BYTE* pCoverage, int count, UINT color)
+{
+    int i = 0;
+
+#ifdef NUI_USE_SSE2
+    // Channels widened to 16 bits, two pixels per register. Opacity is scaled to 0..256,
+    // so dst * (256 - a) + src * a stays within 16 bits
+    const __m128i zero   = _mm_setzero_si128();
+    const __m128i full   = _mm_set1_epi16(256);
+    const __m128i source = _mm_unpacklo_epi8(_mm_set1_epi32((int)(color | 0xFF000000)), zero);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        int packed;
+        memcpy(&packed, pCoverage + i, sizeof(packed));
+        if (0 == packed)
+        {
+            continue;
+        }
+
+        __m128i a = _mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero);
+        a = _mm_add_epi16(a, _mm_srli_epi16(a, 7));
+        a = _mm_unpacklo_epi16(a, a);
+
+        __m128i aLow  = _mm_unpacklo_epi32(a, a);
+        __m128i aHigh = _mm_unpackhi_epi32(a, a);
+
+        __m128i pixels = _mm_loadu_si128((const __m128i*)(pPixels + i));
+        __m128i low    = _mm_unpacklo_epi8(pixels, zero);
+        __m128i high   = _mm_unpackhi_epi8(pixels, zero);
+
+        low  = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(low,  _mm_sub_epi16(full, aLow)),  _mm_mullo_epi16(source, aLow)),  8);
+        high = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(high, _mm_sub_epi16(full, aHigh)), _mm_mullo_epi16(source, aHigh)), 8);
+
+        _mm_storeu_si128((__m128i*)(pPixels + i), _mm_packus_epi16(low, high));
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        UINT a = pCoverage[i];
+        if (0 == a)
+        {
+            continue;
+        }
+        a += a >> 7;
+
+        UINT pixel = pPixels[i];
+        UINT blue  = (( pixel        & 0xFF) * (256 - a) + ( color        & 0xFF) * a) >> 8;
+        UINT green = (((pixel >> 8)  & 0xFF) * (256 - a) + ((color >> 8)  & 0xFF) * a) >> 8;
+        UINT red   = (((pixel >> 16) & 0xFF) * (256 - a) + ((color >> 16) & 0xFF) * a) >> 8;
+        UINT x     = (((pixel >> 24) & 0xFF) * (256 - a) + 0xFF * a) >> 8;
+
+        pPixels[i] = blue | (green << 8) | (red << 16) | (x << 24);
+    }
+}
+
+/// <summary>
+/// Add a rectangle within the frame to the dirty rectangles
+/// </summary>
+void OverlayCompositor::AddDirtyRect(OverlayRect rect)
+{
+    // Merge with every rectangle it touches, again as the merged rectangle grows. When
+    // there are too many, merge with the one that grows least
+    for (;;)
+    {
+        for (size_t i = 0; i < m_dirtyRects.size();)
+        {
+            if (RectsTouch(rect, m_dirtyRects[i]))
+            {
+                rect = UnionRect(rect, m_dirtyRects[i]);
+                m_dirtyRects[i] = m_dirtyRects.back();
+                m_dirtyRects.pop_back();
+                i = 0;
+                continue;
+            }
+            ++i;
+        }
+
+        if (m_dirtyRects.size() < MAX_DIRTY_RECTS)
+        {
+            break;
+        }
+
+        size_t best       = 0;
+        int    bestGrowth = 0;
+        for (size_t i = 0; i < m_dirtyRects.size(); i++)
+        {
+            int growth = RectArea(UnionRect(rect, m_dirtyRects[i])) - RectArea(m_dirtyRects[i]);
+            if (0 == i || growth < bestGrowth)
+            {
+                best       = i;
+                bestGrowth = growth;
+            }
+        }
+
+        rect = UnionRect(rect, m_dirtyRects[best]);
+        m_dirtyRects[best] = m_dirtyRects.back();
+        m_dirtyRects.pop_back();
+    }
+
+    m_dirtyRects.push_back(rect);
+}
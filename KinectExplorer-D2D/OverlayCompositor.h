@@ -0,0 +1,156 @@
+//------------------------------------------------------------------------------
+// <copyright file="OverlayCompositor.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include "NuiTypes.h"
+#include "OverlayList.h"
+
+/// <summary>
+/// Rectangle of a frame written by the compositor, right and bottom exclusive
+/// </summary>
+struct OverlayRect
+{
+    int     left;
+    int     top;
+    int     right;
+    int     bottom;
+};
+
+/// <summary>
+/// Draws antialiased overlays into 32 bit BGRX frames on the CPU, so overlays show in
+/// every consumer of a frame rather than only on screen. Lines, circle outlines and
+/// discs are all distance shapes, a round capped segment whose distance may be taken
+/// around a ring, so one kernel computes the coverage of every shape, four pixels at
+/// a time with SSE2, over the row spans the shape can touch. Text uses a built in
+/// 5x7 font, each font pixel a square whose overlap with the frame pixels gives their
+/// coverage. Coverage rows are blended with the color four pixels at a time. The
+/// rectangles written since the frame began are tracked, so consumers can restore or
+/// send only those.
+/// </summary>
+class OverlayCompositor
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    OverlayCompositor();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~OverlayCompositor();
+
+public:
+    /// <summary>
+    /// Start drawing into a frame and clear the dirty rectangles
+    /// </summary>
+    /// <param name="pPixels">The pointer to BGRX pixels, rows packed</param>
+    /// <param name="width">Frame width</param>
+    /// <param name="height">Frame height</param>
+    void BeginFrame(UINT* pPixels, UINT width, UINT height);
+
+    /// <summary>
+    /// Draw a line with round caps
+    /// </summary>
+    /// <param name="color">BGR color with opacity in the top byte</param>
+    void DrawLine(FLOAT x0, FLOAT y0, FLOAT x1, FLOAT y1, FLOAT width, UINT color);
+
+    /// <summary>
+    /// Draw the outline of a circle
+    /// </summary>
+    /// <param name="color">BGR color with opacity in the top byte</param>
+    void DrawCircle(FLOAT x, FLOAT y, FLOAT radius, FLOAT width, UINT color);
+
+    /// <summary>
+    /// Draw a filled circle
+    /// </summary>
+    /// <param name="color">BGR color with opacity in the top byte</param>
+    void FillCircle(FLOAT x, FLOAT y, FLOAT radius, UINT color);
+
+    /// <summary>
+    /// Draw a line of text. Lower case letters are drawn as capitals, characters missing from the font as blanks
+    /// </summary>
+    /// <param name="x">Left edge</param>
+    /// <param name="y">Top edge</param>
+    /// <param name="pText">Text to draw</param>
+    /// <param name="cellSize">Size of a font pixel, a character is 6 cells wide and 7 high</param>
+    /// <param name="color">BGR color with opacity in the top byte</param>
+    void DrawLabel(FLOAT x, FLOAT y, const char* pText, FLOAT cellSize, UINT color);
+
+    /// <summary>
+    /// Draw the items of an overlay list, scaling their source image positions to the frame
+    /// </summary>
+    void Draw(const OverlayList& overlay);
+
+    /// <summary>
+    /// Get the rectangles written since the frame began. Overlapping rectangles are merged
+    /// </summary>
+    const std::vector<OverlayRect>& GetDirtyRects() const
+    {
+        return m_dirtyRects;
+    }
+
+    /// <summary>
+    /// Get the rectangle bounding all dirty rectangles, empty if nothing was drawn
+    /// </summary>
+    OverlayRect GetDirtyBounds() const;
+
+private:
+    /// <summary>
+    /// Round capped segment from a along d, distances taken around a ring of the given radius
+    /// </summary>
+    struct DistanceShape
+    {
+        FLOAT   ax;
+        FLOAT   ay;
+        FLOAT   dx;
+        FLOAT   dy;
+        FLOAT   invLength2;     // Reciprocal squared length of d, zero for a point
+        FLOAT   ring;           // Ring radius, zero for segments and discs
+        FLOAT   halfWidth;
+    };
+
+    /// <summary>
+    /// Rasterize a distance shape
+    /// </summary>
+    void DrawShape(const DistanceShape& shape, UINT color);
+
+    /// <summary>
+    /// Compute the opacity of a run of pixels in a row for a distance shape
+    /// </summary>
+    /// <param name="shape">Shape to cover</param>
+    /// <param name="x">First pixel</param>
+    /// <param name="y">Row</param>
+    /// <param name="count">Number of pixels</param>
+    /// <param name="alpha">Opacity of full coverage, 0 to 255</param>
+    /// <param name="pCoverage">Receives the opacity per pixel, rounded up to a multiple of four</param>
+    static void CoverSpan(const DistanceShape& shape, int x, int y, int count, FLOAT alpha, BYTE* pCoverage);
+
+    /// <summary>
+    /// Blend a color into a run of pixels
+    /// </summary>
+    /// <param name="pPixels">The pointer to the first pixel</param>
+    /// <param name="pCoverage">Opacity per pixel</param>
+    /// <param name="count">Number of pixels</param>
+    /// <param name="color">BGR color</param>
+    static void BlendSpan(UINT* pPixels, const BYTE* pCoverage, int count, UINT color);
+
+    /// <summary>
+    /// Add a rectangle within the frame to the dirty rectangles
+    /// </summary>
+    void AddDirtyRect(OverlayRect rect);
+
+private:
+    UINT*                       m_pPixels;
+    UINT                        m_width;
+    UINT                        m_height;
+
+    std::vector<BYTE>           m_coverage;         // One row of opacities
+    std::vector<FLOAT>          m_textCoverage;     // Coverage of the text being drawn
+    std::vector<OverlayRect>    m_dirtyRects;
+};
@@ -0,0 +1,347 @@
+//------------------------------------------------------------------------------
+// <copyright file="OverlayList.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "OverlayList.h"
+
+#define BONE_WIDTH                      2.0f        // Output pixels
+#define JOINT_RADIUS                    2.0f        // Source pixels
+#define POSITION_RADIUS                 5.0f        // Source pixels
+#define DETECTION_WIDTH                 1.0f        // Output pixels
+#define TRACK_WIDTH                     1.5f        // Output pixels
+#define TRACK_LABEL_CELL                1.0f        // Output pixels per font pixel
+#define TRAJECTORY_WIDTH                1.5f        // Output pixels
+#define TRAJECTORY_SEGMENTS             12
+#define TRAJECTORY_HORIZON              1.0f        // Seconds drawn ahead when no landing is predicted
+#define LANDING_RADIUS                  3.0f        // Source pixels
+
+// Colors are BGR with opacity in the top byte, as the skeleton brushes of the viewer
+#define BONE_TRACKED_COLOR              0xFF008000
+#define BONE_INFERRED_COLOR             0xFF808080
+#define JOINT_TRACKED_COLOR             0xFF90EE90
+#define JOINT_INFERRED_COLOR            0xFFFFFF00
+#define POSITION_COLOR                  0xFF008000
+#define DETECTION_COLOR                 0x80FFFFFF
+#define TRACK_COLOR                     0xFF00FF00
+#define TRACK_COASTING_COLOR            0xFFFFFF00
+#define TRAJECTORY_COLOR                0xC000FFFF
+#define LANDING_COLOR                   0xFFFF0000
+
+// Bones of a skeleton, in the order the viewer draws them
+static const NUI_SKELETON_POSITION_INDEX SkeletonBones[][2] =
+{
+    // Torso
+    {NUI_SKELETON_POSITION_HEAD,            NUI_SKELETON_POSITION_SHOULDER_CENTER},
+    {NUI_SKELETON_POSITION_SHOULDER_CENTER, NUI_SKELETON_POSITION_SHOULDER_LEFT},
+    {NUI_SKELETON_POSITION_SHOULDER_CENTER, NUI_SKELETON_POSITION_SHOULDER_RIGHT},
+    {NUI_SKELETON_POSITION_SHOULDER_CENTER, NUI_SKELETON_POSITION_SPINE},
+    {NUI_SKELETON_POSITION_SPINE,           NUI_SKELETON_POSITION_HIP_CENTER},
+    {NUI_SKELETON_POSITION_HIP_CENTER,      NUI_SKELETON_POSITION_HIP_LEFT},
+    {NUI_SKELETON_POSITION_HIP_CENTER,      NUI_SKELETON_POSITION_HIP_RIGHT},
+
+    // Left arm
+    {NUI_SKELETON_POSITION_SHOULDER_LEFT,   NUI_SKELETON_POSITION_ELBOW_LEFT},
+    {NUI_SKELETON_POSITION_ELBOW_LEFT,      NUI_SKELETON_POSITION_WRIST_LEFT},
+    {NUI_SKELETON_POSITION_WRIST_LEFT,      NUI_SKELETON_POSITION_HAND_LEFT},
+
+    // Right arm
+    {NUI_SKELETON_POSITION_SHOULDER_RIGHT,  NUI_SKELETON_POSITION_ELBOW_RIGHT},
+    {NUI_SKELETON_POSITION_ELBOW_RIGHT,     NUI_SKELETON_POSITION_WRIST_RIGHT},
+    {NUI_SKELETON_POSITION_WRIST_RIGHT,     NUI_SKELETON_POSITION_HAND_RIGHT},
+
+    // Left leg
+    {NUI_SKELETON_POSITION_HIP_LEFT,        NUI_SKELETON_POSITION_KNEE_LEFT},
+    {NUI_SKELETON_POSITION_KNEE_LEFT,       NUI_SKELETON_POSITION_ANKLE_LEFT},
+    {NUI_SKELETON_POSITION_ANKLE_LEFT,      NUI_SKELETON_POSITION_FOOT_LEFT},
+
+    // Right leg
+    {NUI_SKELETON_POSITION_HIP_RIGHT,       NUI_SKELETON_POSITION_KNEE_RIGHT},
+    {NUI_SKELETON_POSITION_KNEE_RIGHT,      NUI_SKELETON_POSITION_ANKLE_RIGHT},
+    {NUI_SKELETON_POSITION_ANKLE_RIGHT,     NUI_SKELETON_POSITION_FOOT_RIGHT},
+};
+
+/// <summary>
+/// Constructor
+/// </summary>
+OverlayList::OverlayList()
+    : m_sourceWidth(0)
+    , m_sourceHeight(0)
+{
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+OverlayList::~OverlayList()
+{
+}
+
+/// <summary>
+/// Remove all items
+/// </summary>
+void OverlayList::Clear()
+{
+    m_items.clear();
+}
+
+/// <summary>
+/// Exchange the items and source size with another list without copying
+/// </summary>
+void OverlayList::Swap(OverlayList& other)
+{
+    UINT width  = m_sourceWidth;
+    UINT height = m_sourceHeight;
+
+    m_sourceWidth        = other.m_sourceWidth;
+    m_sourceHeight       = other.m_sourceHeight;
+    other.m_sourceWidth  = width;
+    other.m_sourceHeight = height;
+
+    m_items.swap(other.m_items);
+}
+
+/// <summary>
+/// Set the size of the image the item positions refer to
+/// </summary>
+/// <param name="width">Source image width</param>
+/// <param name="height">Source image height</param>
+void OverlayList::SetSourceSize(UINT width, UINT height)
+{
+    m_sourceWidth  = width;
+    m_sourceHeight = height;
+}
+
+/// <summary>
+/// Add a line with round caps
+/// </summary>
+void OverlayList::AddLine(FLOAT x0, FLOAT y0, FLOAT x1, FLOAT y1, FLOAT width, UINT color)
+{
+    OverlayItem& item = AddItem(OverlayItemLine, color);
+    item.x0    = x0;
+    item.y0    = y0;
+    item.x1    = x1;
+    item.y1    = y1;
+    item.width = width;
+}
+
+/// <summary>
+/// Add the outline of a circle
+/// </summary>
+void OverlayList::AddCircle(FLOAT x, FLOAT y, FLOAT radius, FLOAT width, UINT color)
+{
+    OverlayItem& item = AddItem(OverlayItemCircle, color);
+    item.x0     = x;
+    item.y0     = y;
+    item.radius = radius;
+    item.width  = width;
+}
+
+/// <summary>
+/// Add a filled circle
+/// </summary>
+void OverlayList::AddDisc(FLOAT x, FLOAT y, FLOAT radius, UINT color)
+{
+    OverlayItem& item = AddItem(OverlayItemDisc, color);
+    item.x0     = x;
+    item.y0     = y;
+    item.radius = radius;
+}
+
+/// <summary>
+/// Add a line of text
+/// </summary>
+/// <param name="x">Left edge in source pixels</param>
+/// <param name="y">Top edge in source pixels</param>
+/// <param name="pText">Text, cut at OVERLAY_TEXT_LENGTH - 1 characters</param>
+/// <param name="cellSize">Size of a font cell in output pixels</param>
+/// <param name="color">Text color</param>
+void OverlayList::AddText(FLOAT x, FLOAT y, const char* pText, FLOAT cellSize, UINT color)
+{
+    OverlayItem& item = AddItem(OverlayItemText, color);
+    item.x0    = x;
+    item.y0    = y;
+    item.width = cellSize;
+
+    UINT length = 0;
+    while (pText && pText[length] && length < OVERLAY_TEXT_LENGTH - 1)
+    {
+        item.text[length] = pText[length];
+        ++length;
+    }
+    item.text[length] = '\0';
+}
+
+/// <summary>
+/// Add the bones and joints of the tracked skeletons, and a mark for skeletons with only a position
+/// </summary>
+/// <param name="skeletons">Skeletons projected by the skeleton store</param>
+void OverlayList::AddSkeletons(const SkeletonStore& skeletons)
+{
+    for (UINT i = 0; i < NUI_SKELETON_COUNT; i++)
+    {
+        UINT position = SkeletonStore::GetPointIndex(i, SKELETON_STORE_POSITION);
+
+        if (NUI_SKELETON_TRACKED == skeletons.GetTrackingState(i))
+        {
+            AddSkeleton(skeletons, i);
+        }
+        else if (NUI_SKELETON_POSITION_ONLY == skeletons.GetTrackingState(i) &&
+                 NUI_SKELETON_POSITION_NOT_TRACKED != skeletons.GetPointState(position))
+        {
+            AddCircle(skeletons.GetDepthX()[position] * m_sourceWidth, skeletons.GetDepthY()[position] * m_sourceHeight, POSITION_RADIUS, BONE_WIDTH, POSITION_COLOR);
+        }
+    }
+}
+
+/// <summary>
+/// Add the bones and joints of a skeleton
+/// </summary>
+/// <param name="skeletons">Skeletons projected by the skeleton store</param>
+/// <param name="skeleton">Skeleton index</param>
+void OverlayList::AddSkeleton(const SkeletonStore& skeletons, UINT skeleton)
+{
+    // Joints are projected as fractions of the depth image, bones share them
+    UINT         base   = SkeletonStore::GetPointIndex(skeleton, 0);
+    const FLOAT* pX     = skeletons.GetDepthX() + base;
+    const FLOAT* pY     = skeletons.GetDepthY() + base;
+    FLOAT        width  = (FLOAT)m_sourceWidth;
+    FLOAT        height = (FLOAT)m_sourceHeight;
+
+    for (size_t i = 0; i < sizeof(SkeletonBones) / sizeof(SkeletonBones[0]); i++)
+    {
+        NUI_SKELETON_POSITION_INDEX joint0 = SkeletonBones[i][0];
+        NUI_SKELETON_POSITION_INDEX joint1 = SkeletonBones[i][1];
+
+        NUI_SKELETON_POSITION_TRACKING_STATE state0 = skeletons.GetPointState(base + joint0);
+        NUI_SKELETON_POSITION_TRACKING_STATE state1 = skeletons.GetPointState(base + joint1);
+
+        // Bones between two inferred joints are not drawn, as in the viewer
+        if (NUI_SKELETON_POSITION_NOT_TRACKED == state0 || NUI_SKELETON_POSITION_NOT_TRACKED == state1 ||
+            (NUI_SKELETON_POSITION_INFERRED == state0 && NUI_SKELETON_POSITION_INFERRED == state1))
+        {
+            continue;
+        }
+
+        bool tracked = NUI_SKELETON_POSITION_TRACKED == state0 && NUI_SKELETON_POSITION_TRACKED == state1;
+        AddLine(pX[joint0] * width, pY[joint0] * height, pX[joint1] * width, pY[joint1] * height, BONE_WIDTH, tracked ? BONE_TRACKED_COLOR : BONE_INFERRED_COLOR);
+    }
+
+    for (UINT i = 0; i < NUI_SKELETON_POSITION_COUNT; i++)
+    {
+        NUI_SKELETON_POSITION_TRACKING_STATE state = skeletons.GetPointState(base + i);
+        if (NUI_SKELETON_POSITION_NOT_TRACKED != state)
+        {
+            AddDisc(pX[i] * width, pY[i] * height, JOINT_RADIUS, NUI_SKELETON_POSITION_TRACKED == state ? JOINT_TRACKED_COLOR : JOINT_INFERRED_COLOR);
+        }
+    }
+}
+
+/// <summary>
+/// Add the outlines of ball detections
+/// </summary>
+void OverlayList::AddDetections(const std::vector<BallDetection>& detections)
+{
+    for (size_t i = 0; i < detections.size(); i++)
+    {
+        AddCircle(detections[i].imageX, detections[i].imageY, detections[i].imageRadius, DETECTION_WIDTH, DETECTION_COLOR);
+    }
+}
+
+/// <summary>
+/// Add the outlines and IDs of confirmed ball tracks
+/// </summary>
+void OverlayList::AddTracks(const std::vector<BallTrack>& tracks)
+{
+    for (size_t i = 0; i < tracks.size(); i++)
+    {
+        const BallTrack& track = tracks[i];
+        if (!track.confirmed)
+        {
+            continue;
+        }
+
+        // Tracks coasting through an occlusion are drawn in another color
+        UINT color = track.updated ? TRACK_COLOR : TRACK_COASTING_COLOR;
+        AddCircle(track.imageX, track.imageY, track.imageRadius, TRACK_WIDTH, color);
+
+        // Format the ID backwards from the end of the label
+        char  label[OVERLAY_TEXT_LENGTH];
+        char* pDigit = label + OVERLAY_TEXT_LENGTH - 1;
+        UINT  id     = track.id;
+
+        *pDigit = '\0';
+        do
+        {
+            *--pDigit = (char)('0' + id % 10);
+            id /= 10;
+        } while (id);
+
+        AddText(track.imageX + track.imageRadius, track.imageY - track.imageRadius, pDigit, TRACK_LABEL_CELL, color);
+    }
+}
+
+/// <summary>
+/// Add the predicted paths and landing points of fitted trajectories
+/// </summary>
+/// <param name="predictor">Predictor holding the trajectories</param>
+/// <param name="detector">Detector which projects ball centers to the depth image</param>
+void OverlayList::AddTrajectories(const TrajectoryPredictor& predictor, const BallDetector& detector)
+{
+    const std::vector<BallTrajectory>& trajectories = predictor.GetTrajectories();
+
+    for (size_t i = 0; i < trajectories.size(); i++)
+    {
+        const BallTrajectory& trajectory = trajectories[i];
+        if (!trajectory.valid)
+        {
+            continue;
+        }
+
+        // Path from the last sample to the landing, or a fixed time ahead
+        FLOAT horizon = TRAJECTORY_HORIZON;
+        if (trajectory.landing.valid && trajectory.landing.timeToImpact < horizon)
+        {
+            horizon = trajectory.landing.timeToImpact;
+        }
+
+        FLOAT previousX = 0.0f, previousY = 0.0f, radius;
+        bool  previous  = false;
+        for (int step = 0; step <= TRAJECTORY_SEGMENTS; step++)
+        {
+            LONGLONG timestamp = trajectory.lastTimestamp + (LONGLONG)(horizon * 1000.0f * step / TRAJECTORY_SEGMENTS);
+
+            FLOAT x, y;
+            bool  projected = detector.ProjectToImage(predictor.PredictPosition(trajectory, timestamp), x, y, radius);
+            if (projected && previous)
+            {
+                AddLine(previousX, previousY, x, y, TRAJECTORY_WIDTH, TRAJECTORY_COLOR);
+            }
+
+            previousX = x;
+            previousY = y;
+            previous  = projected;
+        }
+
+        FLOAT x, y;
+        if (trajectory.landing.valid && detector.ProjectToImage(trajectory.landing.point, x, y, radius))
+        {
+            AddDisc(x, y, LANDING_RADIUS, LANDING_COLOR);
+        }
+    }
+}
+
+/// <summary>
+/// Add an item and return it for the caller to fill
+/// </summary>
+OverlayItem& OverlayList::AddItem(OverlayItemType type, UINT color)
+{
+    m_items.push_back(OverlayItem());
+
+    OverlayItem& item = m_items.back();
+    memset(&item, 0, sizeof(item));
+    item.type  = type;
+    item.color = color;
+    return item;
+}
@@ -0,0 +1,172 @@
+//------------------------------------------------------------------------------
+// <copyright file="OverlayList.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include "NuiTypes.h"
+#include "BallDetector.h"
+#include "BallTracker.h"
+#include "TrajectoryPredictor.h"
+#include "SkeletonStore.h"
+
+#define OVERLAY_TEXT_LENGTH     16
+
+/// <summary>
+/// Kind of overlay item
+/// </summary>
+enum OverlayItemType
+{
+    OverlayItemLine,
+    OverlayItemCircle,
+    OverlayItemDisc,
+    OverlayItemText
+};
+
+/// <summary>
+/// One shape of an overlay. Positions and radii are in source image pixels,
+/// line widths and text cells in output pixels
+/// </summary>
+struct OverlayItem
+{
+    OverlayItemType type;
+    FLOAT           x0;         // Line start, circle center or text top left
+    FLOAT           y0;
+    FLOAT           x1;         // Line end
+    FLOAT           y1;
+    FLOAT           radius;     // Circle and disc radius
+    FLOAT           width;      // Line and circle width, text cell size
+    UINT            color;      // BGR with opacity in the top byte
+    char            text[OVERLAY_TEXT_LENGTH];
+};
+
+/// <summary>
+/// Overlay recorded as a list of shapes, so it can be handed to another thread and
+/// drawn by an OverlayCompositor into any frame showing the source image, whatever
+/// the frame's size. Builds the shapes of skeletons, ball detections, tracks and
+/// trajectories.
+/// </summary>
+class OverlayList
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    OverlayList();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~OverlayList();
+
+public:
+    /// <summary>
+    /// Remove all items
+    /// </summary>
+    void Clear();
+
+    /// <summary>
+    /// Exchange the items and source size with another list without copying
+    /// </summary>
+    void Swap(OverlayList& other);
+
+    /// <summary>
+    /// Set the size of the image the item positions refer to
+    /// </summary>
+    /// <param name="width">Source image width</param>
+    /// <param name="height">Source image height</param>
+    void SetSourceSize(UINT width, UINT height);
+
+    /// <summary>
+    /// Get source image width
+    /// </summary>
+    UINT GetSourceWidth() const
+    {
+        return m_sourceWidth;
+    }
+
+    /// <summary>
+    /// Get source image height
+    /// </summary>
+    UINT GetSourceHeight() const
+    {
+        return m_sourceHeight;
+    }
+
+    /// <summary>
+    /// Get the items in drawing order
+    /// </summary>
+    const std::vector<OverlayItem>& GetItems() const
+    {
+        return m_items;
+    }
+
+    /// <summary>
+    /// Add a line with round caps
+    /// </summary>
+    void AddLine(FLOAT x0, FLOAT y0, FLOAT x1, FLOAT y1, FLOAT width, UINT color);
+
+    /// <summary>
+    /// Add the outline of a circle
+    /// </summary>
+    void AddCircle(FLOAT x, FLOAT y, FLOAT radius, FLOAT width, UINT color);
+
+    /// <summary>
+    /// Add a filled circle
+    /// </summary>
+    void AddDisc(FLOAT x, FLOAT y, FLOAT radius, UINT color);
+
+    /// <summary>
+    /// Add a line of text
+    /// </summary>
+    /// <param name="x">Left edge in source pixels</param>
+    /// <param name="y">Top edge in source pixels</param>
+    /// <param name="pText">Text, cut at OVERLAY_TEXT_LENGTH - 1 characters</param>
+    /// <param name="cellSize">Size of a font cell in output pixels</param>
+    /// <param name="color">Text color</param>
+    void AddText(FLOAT x, FLOAT y, const char* pText, FLOAT cellSize, UINT color);
+
+    /// <summary>
+    /// Add the bones and joints of the tracked skeletons, and a mark for skeletons with only a position
+    /// </summary>
+    /// <param name="skeletons">Skeletons projected by the skeleton store</param>
+    void AddSkeletons(const SkeletonStore& skeletons);
+
+    /// <summary>
+    /// Add the bones and joints of a skeleton
+    /// </summary>
+    /// <param name="skeletons">Skeletons projected by the skeleton store</param>
+    /// <param name="skeleton">Skeleton index</param>
+    void AddSkeleton(const SkeletonStore& skeletons, UINT skeleton);
+
+    /// <summary>
+    /// Add the outlines of ball detections
+    /// </summary>
+    void AddDetections(const std::vector<BallDetection>& detections);
+
+    /// <summary>
+    /// Add the outlines and IDs of confirmed ball tracks
+    /// </summary>
+    void AddTracks(const std::vector<BallTrack>& tracks);
+
+    /// <summary>
+    /// Add the predicted paths and landing points of fitted trajectories
+    /// </summary>
+    /// <param name="predictor">Predictor holding the trajectories</param>
+    /// <param name="detector">Detector which projects ball centers to the depth image</param>
+    void AddTrajectories(const TrajectoryPredictor& predictor, const BallDetector& detector);
+
+private:
+    /// <summary>
+    /// Add an item and return it for the caller to fill
+    /// </summary>
+    OverlayItem& AddItem(OverlayItemType type, UINT color);
+
+private:
+    UINT                        m_sourceWidth;
+    UINT                        m_sourceHeight;
+    std::vector<OverlayItem>    m_items;
+};
@@ -0,0 +1,164 @@
+//------------------------------------------------------------------------------
+// <copyright file="PackedBitmask.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include <string.h>
+#include "PackedBitmask.h"
+
+/// <summary>
+/// Count bits set in a word
+/// </summary>
+static inline UINT CountBits(ULONGLONG word)
+{
+    UINT count = 0;
+    while (word)
+    {
+        word &= word - 1;
+        ++count;
+    }
+    return count;
+}
+
+/// <summary>
+/// Constructor
+/// </summary>
+PackedBitmask::PackedBitmask()
+    : m_width(0)
+    , m_height(0)
+    , m_wordsPerRow(0)
+    , m_wordCount(0)
+    , m_pWords(nullptr)
+{
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+PackedBitmask::~PackedBitmask()
+{
+    delete[] m_pWords;
+}
+
+/// <summary>
+/// Resize the mask. Existing content is discarded when the size changes
+/// </summary>
+/// <param name="width">Width of mask in pixels</param>
+/// <param name="height">Height of mask in pixels</param>
+void PackedBitmask::Resize(UINT width, UINT height)
+{
+    if (m_width == width && m_height == height)
+    {
+        return;
+    }
+
+    delete[] m_pWords;
+    m_pWords = nullptr;
+
+    m_width       = width;
+    m_height      = height;
+    m_wordsPerRow = (width + BITS_PER_MASK_WORD - 1) / BITS_PER_MASK_WORD;
+    m_wordCount   = m_wordsPerRow * height;
+
+    if (0 != m_wordCount)
+    {
+        m_pWords = new ULONGLONG[m_wordCount];
+        Clear();
+    }
+}
+
+/// <summary>
+/// Clear all bits
+/// </summary>
+void PackedBitmask::Clear()
+{
+    if (m_pWords)
+    {
+        ZeroMemory(m_pWords, m_wordCount * sizeof(ULONGLONG));
+    }
+}
+
+/// <summary>
+/// Copy size and content of another mask
+/// </summary>
+/// <param name="other">Mask to copy from</param>
+void PackedBitmask::CopyFrom(const PackedBitmask& other)
+{
+    Resize(other.m_width, other.m_height);
+    if (m_pWords)
+    {
+        memcpy(m_pWords, other.m_pWords, m_wordCount * sizeof(ULONGLONG));
+    }
+}
+
+/// <summary>
+/// Copy the bits of a rectangle from a mask of the same size. Bits outside the rectangle are kept
+/// </summary>
+/// <param name="other">Mask to copy from</param>
+/// <param name="left">Left column, inclusive</param>
+/// <param name="top">Top row, inclusive</param>
+/// <param name="right">Right column, inclusive</param>
+/// <param name="bottom">Bottom row, inclusive</param>
+void PackedBitmask::CopyRect(const PackedBitmask& other, UINT left, UINT top, UINT right, UINT bottom)
+{
+    if (other.m_width != m_width || other.m_height != m_height || 0 == m_wordCount)
+    {
+        return;
+    }
+
+    if (right >= m_width)
+    {
+        right = m_width - 1;
+    }
+    if (bottom >= m_height)
+    {
+        bottom = m_height - 1;
+    }
+    if (left > right || top > bottom)
+    {
+        return;
+    }
+
+    UINT firstWord = left  / BITS_PER_MASK_WORD;
+    UINT lastWord  = right / BITS_PER_MASK_WORD;
+
+    // Bits of the first and last word that lie inside the rectangle
+    ULONGLONG firstMask = ~0ULL << (left % BITS_PER_MASK_WORD);
+    ULONGLONG lastMask  = ~0ULL >> (BITS_PER_MASK_WORD - 1 - right % BITS_PER_MASK_WORD);
+
+    for (UINT y = top; y <= bottom; y++)
+    {
+        ULONGLONG*       pRow   = GetRow(y);
+        const ULONGLONG* pOther = other.GetRow(y);
+
+        for (UINT w = firstWord; w <= lastWord; w++)
+        {
+            ULONGLONG select = ~0ULL;
+            if (w == firstWord)
+            {
+                select &= firstMask;
+            }
+            if (w == lastWord)
+            {
+                select &= lastMask;
+            }
+
+            pRow[w] = (pRow[w] & ~select) | (pOther[w] & select);
+        }
+    }
+}
+
+/// <summary>
+/// Count set pixels in the whole mask
+/// </summary>
+/// <returns>Number of set pixels</returns>
+UINT PackedBitmask::CountSet() const
+{
+    UINT count = 0;
+    for (UINT i = 0; i < m_wordCount; i++)
+    {
+        count += CountBits(m_pWords[i]);
+    }
+    return count;
+}
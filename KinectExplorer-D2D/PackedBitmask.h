@@ -0,0 +1,140 @@
+//------------------------------------------------------------------------------
+// <copyright file="PackedBitmask.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include "NuiTypes.h"
+
+#define BITS_PER_MASK_WORD  64
+
+/// <summary>
+/// One bit per pixel image mask. Each row starts on a 64-bit word boundary and
+/// pixel x of a row is stored in bit (x % 64) of word (x / 64).
+/// </summary>
+class PackedBitmask
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    PackedBitmask();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~PackedBitmask();
+
+private:
+    /// <summary>
+    /// Not copyable, use CopyFrom to copy the bits
+    /// </summary>
+    PackedBitmask(const PackedBitmask&) = delete;
+    PackedBitmask& operator=(const PackedBitmask&) = delete;
+
+public:
+    /// <summary>
+    /// Resize the mask. Existing content is discarded when the size changes
+    /// </summary>
+    /// <param name="width">Width of mask in pixels</param>
+    /// <param name="height">Height of mask in pixels</param>
+    void Resize(UINT width, UINT height);
+
+    /// <summary>
+    /// Clear all bits
+    /// </summary>
+    void Clear();
+
+    /// <summary>
+    /// Copy size and content of another mask
+    /// </summary>
+    /// <param name="other">Mask to copy from</param>
+    void CopyFrom(const PackedBitmask& other);
+
+    /// <summary>
+    /// Copy the bits of a rectangle from a mask of the same size. Bits outside the rectangle are kept
+    /// </summary>
+    /// <param name="other">Mask to copy from</param>
+    /// <param name="left">Left column, inclusive</param>
+    /// <param name="top">Top row, inclusive</param>
+    /// <param name="right">Right column, inclusive</param>
+    /// <param name="bottom">Bottom row, inclusive</param>
+    void CopyRect(const PackedBitmask& other, UINT left, UINT top, UINT right, UINT bottom);
+
+    /// <summary>
+    /// Get width of mask in pixels
+    /// </summary>
+    UINT GetWidth() const
+    {
+        return m_width;
+    }
+
+    /// <summary>
+    /// Get height of mask in pixels
+    /// </summary>
+    UINT GetHeight() const
+    {
+        return m_height;
+    }
+
+    /// <summary>
+    /// Get number of 64-bit words in each row
+    /// </summary>
+    UINT GetWordsPerRow() const
+    {
+        return m_wordsPerRow;
+    }
+
+    /// <summary>
+    /// Get the words of a row
+    /// </summary>
+    /// <param name="y">Row index</param>
+    ULONGLONG* GetRow(UINT y)
+    {
+        return m_pWords + y * m_wordsPerRow;
+    }
+
+    /// <summary>
+    /// Get the words of a row
+    /// </summary>
+    /// <param name="y">Row index</param>
+    const ULONGLONG* GetRow(UINT y) const
+    {
+        return m_pWords + y * m_wordsPerRow;
+    }
+
+    /// <summary>
+    /// Test a single pixel
+    /// </summary>
+    /// <param name="x">Column of pixel</param>
+    /// <param name="y">Row of pixel</param>
+    bool Test(UINT x, UINT y) const
+    {
+        return 0 != ((GetRow(y)[x / BITS_PER_MASK_WORD] >> (x % BITS_PER_MASK_WORD)) & 1);
+    }
+
+    /// <summary>
+    /// Set a single pixel
+    /// </summary>
+    /// <param name="x">Column of pixel</param>
+    /// <param name="y">Row of pixel</param>
+    void Set(UINT x, UINT y)
+    {
+        GetRow(y)[x / BITS_PER_MASK_WORD] |= (1ULL << (x % BITS_PER_MASK_WORD));
+    }
+
+    /// <summary>
+    /// Count set pixels in the whole mask
+    /// </summary>
+    /// <returns>Number of set pixels</returns>
+    UINT CountSet() const;
+
+private:
+    UINT        m_width;
+    UINT        m_height;
+    UINT        m_wordsPerRow;
+    UINT        m_wordCount;
+    ULONGLONG*  m_pWords;
+};
@@ -0,0 +1,159 @@
+//------------------------------------------------------------------------------
+// <copyright file="ParallelBands.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "ParallelBands.h"
+
+#define MAX_BAND_THREADS    16
+
+/// <summary>
+/// Constructor
+/// </summary>
+/// <param name="threadCount">Total number of threads including the caller. Zero to use all hardware threads</param>
+ParallelBands::ParallelBands(UINT threadCount)
+    : m_pTask(nullptr)
+    , m_bandCount(0)
+    , m_nextBand(0)
+    , m_doneBands(0)
+    , m_jobId(0)
+    , m_exit(false)
+{
+    if (0 == threadCount)
+    {
+        threadCount = std::thread::hardware_concurrency();
+    }
+
+    threadCount = threadCount < 1 ? 1 : (threadCount > MAX_BAND_THREADS ? MAX_BAND_THREADS : threadCount);
+
+    for (UINT i = 1; i < threadCount; i++)
+    {
+        m_workers.push_back(std::thread(&ParallelBands::WorkerProc, this));
+    }
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+ParallelBands::~ParallelBands()
+{
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_exit = true;
+    }
+    m_jobReady.notify_all();
+
+    for (size_t i = 0; i < m_workers.size(); i++)
+    {
+        m_workers[i].join();
+    }
+}
+
+/// <summary>
+/// Run a task once for every band on a pool, or on the calling thread without one
+/// </summary>
+/// <param name="pParallel">The pointer to the pool, or nullptr</param>
+/// <param name="bandCount">Number of bands</param>
+/// <param name="task">Task called with the band index</param>
+void ParallelBands::Run(ParallelBands* pParallel, UINT bandCount, const std::function<void(UINT)>& task)
+{
+    if (pParallel)
+    {
+        pParallel->Run(bandCount, task);
+        return;
+    }
+
+    for (UINT band = 0; band < bandCount; band++)
+    {
+        task(band);
+    }
+}
+
+/// <summary>
+/// Run a task once for every band and wait for all bands to finish
+/// </summary>
+/// <param name="bandCount">Number of bands</param>
+/// <param name="task">Task called with the band index</param>
+void ParallelBands::Run(UINT bandCount, const std::function<void(UINT)>& task)
+{
+    if (0 == bandCount)
+    {
+        return;
+    }
+
+    // Nothing to share. Avoid waking the workers
+    if (m_workers.empty() || 1 == bandCount)
+    {
+        for (UINT band = 0; band < bandCount; band++)
+        {
+            task(band);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_pTask     = &task;
+        m_bandCount = bandCount;
+        m_nextBand  = 0;
+        m_doneBands = 0;
+        ++m_jobId;
+    }
+    m_jobReady.notify_all();
+
+    RunBands();
+
+    // Wait for bands still running on workers
+    std::unique_lock<std::mutex> lock(m_lock);
+    m_jobDone.wait(lock, [this] { return m_doneBands.load() == m_bandCount; });
+    m_pTask = nullptr;
+}
+
+/// <summary>
+/// Take and run bands of the current job until none is left
+/// </summary>
+void ParallelBands::RunBands()
+{
+    for (;;)
+    {
+        UINT band = m_nextBand++;
+        if (band >= m_bandCount)
+        {
+            break;
+        }
+
+        (*m_pTask)(band);
+
+        if (++m_doneBands == m_bandCount)
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_jobDone.notify_all();
+        }
+    }
+}
+
+/// <summary>
+/// Worker thread procedure
+/// </summary>
+void ParallelBands::WorkerProc()
+{
+    ULONGLONG lastJob = 0;
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_jobReady.wait(lock, [this, lastJob] { return m_exit || (m_jobId != lastJob && m_pTask); });
+
+            if (m_exit)
+            {
+                break;
+            }
+
+            lastJob = m_jobId;
+        }
+
+        RunBands();
+    }
+}
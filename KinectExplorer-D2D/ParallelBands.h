@@ -0,0 +1,94 @@
+//------------------------------------------------------------------------------
+// <copyright file="ParallelBands.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "NuiTypes.h"
+
+/// <summary>
+/// Small pool of persistent worker threads which runs a task over a number of
+/// independent bands, typically horizontal strips of an image. The calling thread
+/// works on bands as well and Run returns once every band is done. One pool serves
+/// all the stages of a thread, which take it by pointer, so the workers are not
+/// multiplied. Run must not be called from two threads at once.
+/// </summary>
+class ParallelBands
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    /// <param name="threadCount">Total number of threads including the caller. Zero to use all hardware threads</param>
+    ParallelBands(UINT threadCount = 0);
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~ParallelBands();
+
+public:
+    /// <summary>
+    /// Run a task once for every band and wait for all bands to finish
+    /// </summary>
+    /// <param name="bandCount">Number of bands</param>
+    /// <param name="task">Task called with the band index</param>
+    void Run(UINT bandCount, const std::function<void(UINT)>& task);
+
+    /// <summary>
+    /// Run a task once for every band on a pool, or on the calling thread without one
+    /// </summary>
+    /// <param name="pParallel">The pointer to the pool, or nullptr</param>
+    /// <param name="bandCount">Number of bands</param>
+    /// <param name="task">Task called with the band index</param>
+    static void Run(ParallelBands* pParallel, UINT bandCount, const std::function<void(UINT)>& task);
+
+    /// <summary>
+    /// Get total number of threads including the caller
+    /// </summary>
+    UINT GetThreadCount() const
+    {
+        return (UINT)m_workers.size() + 1;
+    }
+
+    /// <summary>
+    /// Get total number of threads of a pool, one without a pool
+    /// </summary>
+    /// <param name="pParallel">The pointer to the pool, or nullptr</param>
+    static UINT GetThreadCount(const ParallelBands* pParallel)
+    {
+        return pParallel ? pParallel->GetThreadCount() : 1;
+    }
+
+private:
+    /// <summary>
+    /// Worker thread procedure
+    /// </summary>
+    void WorkerProc();
+
+    /// <summary>
+    /// Take and run bands of the current job until none is left
+    /// </summary>
+    void RunBands();
+
+private:
+    std::vector<std::thread>        m_workers;
+    std::mutex                      m_lock;
+    std::condition_variable         m_jobReady;
+    std::condition_variable         m_jobDone;
+
+    const std::function<void(UINT)>* m_pTask;
+    UINT                            m_bandCount;
+    std::atomic<UINT>               m_nextBand;
+    std::atomic<UINT>               m_doneBands;
+    ULONGLONG                       m_jobId;
+    bool                            m_exit;
+};
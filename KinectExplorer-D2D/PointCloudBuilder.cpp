@@ -0,0 +1,366 @@
+//------------------------------------------------------------------------------
+// <copyright file="PointCloudBuilder.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "PointCloudBuilder.h"
+
+#define MILLIMETERS_TO_METERS   0.001f
+
+/// <summary>
+/// Constructor
+/// </summary>
+PointCloudBuilder::PointCloudBuilder()
+    : m_pRays(nullptr)
+    , m_width(0)
+    , m_height(0)
+    , m_pointCount(0)
+    , m_rotationVersion(0)
+{
+    for (int i = 0; i < RAY_TABLE_COUNT; i++)
+    {
+        m_rayTables[i].width           = 0;
+        m_rayTables[i].height          = 0;
+        m_rayTables[i].rotationVersion = 0;
+    }
+
+    for (int row = 0; row < 3; row++)
+    {
+        for (int col = 0; col < 3; col++)
+        {
+            m_rotation[row][col] = (row == col) ? 1.0f : 0.0f;
+        }
+    }
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+PointCloudBuilder::~PointCloudBuilder()
+{
+}
+
+/// <summary>
+/// Select the depth image resolution. The ray table is built on first use
+/// </summary>
+/// <param name="resolution">Depth image resolution</param>
+/// <returns>Indicates success or failure</returns>
+HRESULT PointCloudBuilder::SetResolution(NUI_IMAGE_RESOLUTION resolution)
+{
+    if (resolution < NUI_IMAGE_RESOLUTION_80x60 || resolution > NUI_IMAGE_RESOLUTION_1280x960)
+    {
+        return E_INVALIDARG;
+    }
+
+    DWORD width, height;
+    NuiImageResolutionToSize(resolution, width, height);
+
+    RayTable& table = m_rayTables[resolution];
+    if (table.width != width || table.height != height || table.rotationVersion != m_rotationVersion)
+    {
+        BuildRayTable(table, width, height);
+    }
+
+    m_pRays  = &table;
+    m_width  = width;
+    m_height = height;
+
+    ReserveOutput();
+    return S_OK;
+}
+
+/// <summary>
+/// Fill a ray table for an image size
+/// </summary>
+/// <param name="table">Table to fill</param>
+/// <param name="width">Image width</param>
+/// <param name="height">Image height</param>
+void PointCloudBuilder::BuildRayTable(RayTable& table, UINT width, UINT height)
+{
+    table.width  = width;
+    table.height = height;
+    table.rayX.resize(width * height);
+    table.rayY.resize(width * height);
+    table.rayZ.resize(width * height);
+
+    // Same projection as NuiTransformDepthImageToSkeleton. The nominal focal length is given for 320x240
+    FLOAT scaleX = (320.0f / width)  * NUI_CAMERA_DEPTH_NOMINAL_INVERSE_FOCAL_LENGTH_IN_PIXELS;
+    FLOAT scaleY = (240.0f / height) * NUI_CAMERA_DEPTH_NOMINAL_INVERSE_FOCAL_LENGTH_IN_PIXELS;
+
+    const FLOAT (*r)[3] = m_rotation;
+
+    for (UINT y = 0; y < height; y++)
+    {
+        FLOAT cameraY = -((FLOAT)y - height / 2.0f) * scaleY;
+
+        // The camera ray is (cameraX, cameraY, 1), the rotation makes each output axis linear in cameraX
+        FLOAT baseX = r[0][1] * cameraY + r[0][2];
+        FLOAT baseY = r[1][1] * cameraY + r[1][2];
+        FLOAT baseZ = r[2][1] * cameraY + r[2][2];
+
+        for (UINT x = 0; x < width; x++)
+        {
+            UINT  index   = y * width + x;
+            FLOAT cameraX = ((FLOAT)x - width / 2.0f) * scaleX;
+
+            table.rayX[index] = baseX + r[0][0] * cameraX;
+            table.rayY[index] = baseY + r[1][0] * cameraX;
+            table.rayZ[index] = baseZ + r[2][0] * cameraX;
+        }
+    }
+
+    table.rotationVersion = m_rotationVersion;
+}
+
+/// <summary>
+/// Set the rotation from camera space to the output frame. The table of the selected
+/// resolution is rebuilt now, tables of other resolutions when they are selected again
+/// </summary>
+/// <param name="rotation">Row major rotation matrix, output = rotation * camera</param>
+void PointCloudBuilder::SetRotation(const FLOAT rotation[3][3])
+{
+    for (int row = 0; row < 3; row++)
+    {
+        for (int col = 0; col < 3; col++)
+        {
+            m_rotation[row][col] = rotation[row][col];
+        }
+    }
+
+    ++m_rotationVersion;
+
+    if (m_pRays)
+    {
+        BuildRayTable(*m_pRays, m_width, m_height);
+    }
+}
+
+/// <summary>
+/// Rotate an output frame point back to camera space
+/// </summary>
+/// <param name="point">Point in the output frame</param>
+/// <returns>Camera space point</returns>
+Vector4 PointCloudBuilder::ToCamera(const Vector4& point) const
+{
+    // The inverse of a rotation is its transpose
+    Vector4 camera;
+    camera.x = m_rotation[0][0] * point.x + m_rotation[1][0] * point.y + m_rotation[2][0] * point.z;
+    camera.y = m_rotation[0][1] * point.x + m_rotation[1][1] * point.y + m_rotation[2][1] * point.z;
+    camera.z = m_rotation[0][2] * point.x + m_rotation[1][2] * point.y + m_rotation[2][2] * point.z;
+    camera.w = point.w;
+    return camera;
+}
+
+/// <summary>
+/// Rotate a camera space point or direction to the output frame
+/// </summary>
+/// <param name="point">Camera space point</param>
+/// <returns>Point in the output frame</returns>
+Vector4 PointCloudBuilder::ToOutput(const Vector4& point) const
+{
+    Vector4 output;
+    output.x = m_rotation[0][0] * point.x + m_rotation[0][1] * point.y + m_rotation[0][2] * point.z;
+    output.y = m_rotation[1][0] * point.x + m_rotation[1][1] * point.y + m_rotation[1][2] * point.z;
+    output.z = m_rotation[2][0] * point.x + m_rotation[2][1] * point.y + m_rotation[2][2] * point.z;
+    output.w = point.w;
+    return output;
+}
+
+/// <summary>
+/// Make sure the output arrays can hold a point per pixel
+/// </summary>
+void PointCloudBuilder::ReserveOutput()
+{
+    UINT count = m_width * m_height;
+    if (m_x.size() < count)
+    {
+        m_x.resize(count);
+        m_y.resize(count);
+        m_z.resize(count);
+        m_pixelIndex.resize(count);
+    }
+}
+
+/// <summary>
+/// Convert a single pixel
+/// </summary>
+/// <param name="x">Column of pixel</param>
+/// <param name="y">Row of pixel</param>
+/// <param name="depth">Depth in millimeters</param>
+/// <returns>Point in meters in the output frame</returns>
+Vector4 PointCloudBuilder::ToPoint(UINT x, UINT y, USHORT depth) const
+{
+    Vector4 point = {0.0f, 0.0f, 0.0f, 1.0f};
+    if (m_pRays && x < m_width && y < m_height)
+    {
+        UINT  index  = y * m_width + x;
+        FLOAT meters = depth * MILLIMETERS_TO_METERS;
+
+        point.x = m_pRays->rayX[index] * meters;
+        point.y = m_pRays->rayY[index] * meters;
+        point.z = m_pRays->rayZ[index] * meters;
+    }
+    return point;
+}
+
+/// <summary>
+/// Convert every pixel of a depth frame. Unknown depths produce points at the origin
+/// </summary>
+/// <param name="pDepth">The pointer to depth pixels</param>
+/// <returns>Number of points, equal to the number of pixels</returns>
+UINT PointCloudBuilder::BuildDense(const NUI_DEPTH_IMAGE_PIXEL* pDepth)
+{
+    m_pointCount = 0;
+    if (!m_pRays || !pDepth)
+    {
+        return 0;
+    }
+
+    UINT count = m_width * m_height;
+    const FLOAT* pRayX = &m_pRays->rayX[0];
+    const FLOAT* pRayY = &m_pRays->rayY[0];
+    const FLOAT* pRayZ = &m_pRays->rayZ[0];
+    FLOAT* pX = &m_x[0];
+    FLOAT* pY = &m_y[0];
+    FLOAT* pZ = &m_z[0];
+
+    UINT i = 0;
+
+#ifdef NUI_USE_SSE2
+    const __m128 scale = _mm_set1_ps(MILLIMETERS_TO_METERS);
+
+    for (; i + 4 <= count; i += 4)
+    {
+        // Depth is the high word of each pixel
+        __m128i pixels = _mm_loadu_si128((const __m128i*)(pDepth + i));
+        __m128  meters = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(pixels, 16)), scale);
+
+        _mm_storeu_ps(pX + i, _mm_mul_ps(_mm_loadu_ps(pRayX + i), meters));
+        _mm_storeu_ps(pY + i, _mm_mul_ps(_mm_loadu_ps(pRayY + i), meters));
+        _mm_storeu_ps(pZ + i, _mm_mul_ps(_mm_loadu_ps(pRayZ + i), meters));
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        FLOAT meters = pDepth[i].depth * MILLIMETERS_TO_METERS;
+        pX[i] = pRayX[i] * meters;
+        pY[i] = pRayY[i] * meters;
+        pZ[i] = pRayZ[i] * meters;
+    }
+
+    m_pointCount = count;
+    return count;
+}
+
+/// <summary>
+/// Convert only masked pixels with known depth
+/// </summary>
+/// <param name="pDepth">The pointer to depth pixels</param>
+/// <param name="mask">Mask selecting pixels to convert</param>
+/// <returns>Number of points</returns>
+UINT PointCloudBuilder::BuildMasked(const NUI_DEPTH_IMAGE_PIXEL* pDepth, const PackedBitmask& mask)
+{
+    return BuildMasked(pDepth, mask, 0, 0, m_width - 1, m_height - 1);
+}
+
+/// <summary>
+/// Convert masked pixels with known depth inside a rectangle
+/// </summary>
+/// <param name="pDepth">The pointer to depth pixels</param>
+/// <param name="mask">Mask selecting pixels to convert</param>
+/// <param name="left">Left column, inclusive</param>
+/// <param name="top">Top row, inclusive</param>
+/// <param name="right">Right column, inclusive</param>
+/// <param name="bottom">Bottom row, inclusive</param>
+/// <returns>Number of points</returns>
+UINT PointCloudBuilder::BuildMasked(const NUI_DEPTH_IMAGE_PIXEL* pDepth, const PackedBitmask& mask, UINT left, UINT top, UINT right, UINT bottom)
+{
+    m_pointCount = 0;
+    if (!m_pRays || !pDepth || mask.GetWidth() != m_width || mask.GetHeight() != m_height)
+    {
+        return 0;
+    }
+
+    if (right >= m_width)
+    {
+        right = m_width - 1;
+    }
+    if (bottom >= m_height)
+    {
+        bottom = m_height - 1;
+    }
+    if (left > right || top > bottom)
+    {
+        return 0;
+    }
+
+    const FLOAT* pRayX = &m_pRays->rayX[0];
+    const FLOAT* pRayY = &m_pRays->rayY[0];
+    const FLOAT* pRayZ = &m_pRays->rayZ[0];
+    UINT count = 0;
+
+    for (UINT y = top; y <= bottom; y++)
+    {
+        const ULONGLONG* pMaskRow = mask.GetRow(y);
+        UINT rowBase = y * m_width;
+
+        // Walk aligned groups of four pixels and skip empty groups
+        for (UINT x = left & ~3u; x <= right; x += 4)
+        {
+            UINT bits = (UINT)(pMaskRow[x / BITS_PER_MASK_WORD] >> (x % BITS_PER_MASK_WORD)) & 0xF;
+
+            // Clip the group to the rectangle
+            if (x < left)
+            {
+                bits &= 0xFu << (left - x);
+            }
+            if (x + 3 > right)
+            {
+                bits &= 0xFu >> (x + 3 - right);
+            }
+
+            if (0 == bits)
+            {
+                continue;
+            }
+
+            UINT  index = rowBase + x;
+            FLOAT px[4], py[4], pz[4];
+
+#ifdef NUI_USE_SSE2
+            __m128i pixels = _mm_loadu_si128((const __m128i*)(pDepth + index));
+            __m128  meters = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(pixels, 16)), _mm_set1_ps(MILLIMETERS_TO_METERS));
+
+            _mm_storeu_ps(px, _mm_mul_ps(_mm_loadu_ps(pRayX + index), meters));
+            _mm_storeu_ps(py, _mm_mul_ps(_mm_loadu_ps(pRayY + index), meters));
+            _mm_storeu_ps(pz, _mm_mul_ps(_mm_loadu_ps(pRayZ + index), meters));
+#else
+            for (UINT lane = 0; lane < 4; lane++)
+            {
+                FLOAT meters = pDepth[index + lane].depth * MILLIMETERS_TO_METERS;
+                px[lane] = pRayX[index + lane] * meters;
+                py[lane] = pRayY[index + lane] * meters;
+                pz[lane] = pRayZ[index + lane] * meters;
+            }
+#endif
+
+            // Append selected lanes with known depth
+            for (UINT lane = 0; lane < 4; lane++)
+            {
+                if (((bits >> lane) & 1) && 0 != pDepth[index + lane].depth)
+                {
+                    m_x[count]          = px[lane];
+                    m_y[count]          = py[lane];
+                    m_z[count]          = pz[lane];
+                    m_pixelIndex[count] = index + lane;
+                    ++count;
+                }
+            }
+        }
+    }
+
+    m_pointCount = count;
+    return count;
+}
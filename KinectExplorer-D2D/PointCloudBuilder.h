@@ -0,0 +1,197 @@
+//------------------------------------------------------------------------------
+// <copyright file="PointCloudBuilder.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include "NuiTypes.h"
+#include "PackedBitmask.h"
+
+#define RAY_TABLE_COUNT     4   // One table per depth image resolution
+
+/// <summary>
+/// Converts depth pixels to points in meters without calling into the
+/// SDK. A table holding the ray direction of every pixel is computed once per image
+/// resolution, so converting a pixel is three multiplies by its depth. Points are
+/// written as separate x, y and z arrays. A rotation set on the builder, such as
+/// the sensor tilt, is baked into the rays, so points come out in the rotated frame
+/// at no extra cost per point.
+/// </summary>
+class PointCloudBuilder
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    PointCloudBuilder();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~PointCloudBuilder();
+
+public:
+    /// <summary>
+    /// Select the depth image resolution. The ray table is built on first use
+    /// </summary>
+    /// <param name="resolution">Depth image resolution</param>
+    /// <returns>Indicates success or failure</returns>
+    HRESULT SetResolution(NUI_IMAGE_RESOLUTION resolution);
+
+    /// <summary>
+    /// Set the rotation from camera space to the output frame. The table of the selected
+    /// resolution is rebuilt now, tables of other resolutions when they are selected again
+    /// </summary>
+    /// <param name="rotation">Row major rotation matrix, output = rotation * camera</param>
+    void SetRotation(const FLOAT rotation[3][3]);
+
+    /// <summary>
+    /// Rotate an output frame point back to camera space
+    /// </summary>
+    /// <param name="point">Point in the output frame</param>
+    /// <returns>Camera space point</returns>
+    Vector4 ToCamera(const Vector4& point) const;
+
+    /// <summary>
+    /// Rotate a camera space point or direction to the output frame
+    /// </summary>
+    /// <param name="point">Camera space point</param>
+    /// <returns>Point in the output frame</returns>
+    Vector4 ToOutput(const Vector4& point) const;
+
+    /// <summary>
+    /// Convert every pixel of a depth frame. Unknown depths produce points at the origin
+    /// </summary>
+    /// <param name="pDepth">The pointer to depth pixels</param>
+    /// <returns>Number of points, equal to the number of pixels</returns>
+    UINT BuildDense(const NUI_DEPTH_IMAGE_PIXEL* pDepth);
+
+    /// <summary>
+    /// Convert only masked pixels with known depth
+    /// </summary>
+    /// <param name="pDepth">The pointer to depth pixels</param>
+    /// <param name="mask">Mask selecting pixels to convert</param>
+    /// <returns>Number of points</returns>
+    UINT BuildMasked(const NUI_DEPTH_IMAGE_PIXEL* pDepth, const PackedBitmask& mask);
+
+    /// <summary>
+    /// Convert masked pixels with known depth inside a rectangle
+    /// </summary>
+    /// <param name="pDepth">The pointer to depth pixels</param>
+    /// <param name="mask">Mask selecting pixels to convert</param>
+    /// <param name="left">Left column, inclusive</param>
+    /// <param name="top">Top row, inclusive</param>
+    /// <param name="right">Right column, inclusive</param>
+    /// <param name="bottom">Bottom row, inclusive</param>
+    /// <returns>Number of points</returns>
+    UINT BuildMasked(const NUI_DEPTH_IMAGE_PIXEL* pDepth, const PackedBitmask& mask, UINT left, UINT top, UINT right, UINT bottom);
+
+    /// <summary>
+    /// Convert a single pixel
+    /// </summary>
+    /// <param name="x">Column of pixel</param>
+    /// <param name="y">Row of pixel</param>
+    /// <param name="depth">Depth in millimeters</param>
+    /// <returns>Point in meters in the output frame</returns>
+    Vector4 ToPoint(UINT x, UINT y, USHORT depth) const;
+
+    /// <summary>
+    /// Get number of points produced by the last build
+    /// </summary>
+    UINT GetPointCount() const
+    {
+        return m_pointCount;
+    }
+
+    /// <summary>
+    /// Get x coordinates of the points
+    /// </summary>
+    const FLOAT* GetX() const
+    {
+        return m_x.empty() ? nullptr : &m_x[0];
+    }
+
+    /// <summary>
+    /// Get y coordinates of the points
+    /// </summary>
+    const FLOAT* GetY() const
+    {
+        return m_y.empty() ? nullptr : &m_y[0];
+    }
+
+    /// <summary>
+    /// Get z coordinates of the points
+    /// </summary>
+    const FLOAT* GetZ() const
+    {
+        return m_z.empty() ? nullptr : &m_z[0];
+    }
+
+    /// <summary>
+    /// Get pixel index (y * width + x) of each point produced by a masked build
+    /// </summary>
+    const UINT* GetPixelIndex() const
+    {
+        return m_pixelIndex.empty() ? nullptr : &m_pixelIndex[0];
+    }
+
+    /// <summary>
+    /// Get width of the selected resolution
+    /// </summary>
+    UINT GetWidth() const
+    {
+        return m_width;
+    }
+
+    /// <summary>
+    /// Get height of the selected resolution
+    /// </summary>
+    UINT GetHeight() const
+    {
+        return m_height;
+    }
+
+private:
+    /// <summary>
+    /// Ray directions of every pixel for one resolution
+    /// </summary>
+    struct RayTable
+    {
+        UINT                width;
+        UINT                height;
+        UINT                rotationVersion;
+        std::vector<FLOAT>  rayX;
+        std::vector<FLOAT>  rayY;
+        std::vector<FLOAT>  rayZ;
+    };
+
+    /// <summary>
+    /// Fill a ray table for an image size
+    /// </summary>
+    /// <param name="table">Table to fill</param>
+    /// <param name="width">Image width</param>
+    /// <param name="height">Image height</param>
+    void BuildRayTable(RayTable& table, UINT width, UINT height);
+
+    /// <summary>
+    /// Make sure the output arrays can hold a point per pixel
+    /// </summary>
+    void ReserveOutput();
+
+private:
+    RayTable    m_rayTables[RAY_TABLE_COUNT];
+    RayTable*   m_pRays;
+    UINT        m_width;
+    UINT        m_height;
+    UINT        m_pointCount;
+    FLOAT       m_rotation[3][3];
+    UINT        m_rotationVersion;
+
+    std::vector<FLOAT>  m_x;
+    std::vector<FLOAT>  m_y;
+    std::vector<FLOAT>  m_z;
+    std::vector<UINT>   m_pixelIndex;
+};
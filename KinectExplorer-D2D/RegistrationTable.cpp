@@ -0,0 +1,379 @@
+//------------------------------------------------------------------------------
+// <copyright file="RegistrationTable.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include <fstream>
+#include "RegistrationTable.h"
+
+#define COORDINATE_FRACTION         8.0f        // Coordinates are stored times 8
+#define REGISTRATION_FILE_MAGIC     0x4745524B  // "KREG"
+#define REGISTRATION_FILE_VERSION   1
+
+// Boundary depths in millimeters, from the near mode minimum to the default mode maximum
+static const USHORT BoundaryDepths[REGISTRATION_BOUNDARY_COUNT] = {400, 800, 1400, 2400, 4000};
+
+struct RegistrationFileHeader
+{
+    DWORD magic;
+    DWORD version;
+    DWORD depthResolution;
+    DWORD colorResolution;
+    DWORD boundaryCount;
+};
+
+/// <summary>
+/// Constructor
+/// </summary>
+RegistrationTable::RegistrationTable()
+    : m_depthResolution(NUI_IMAGE_RESOLUTION_INVALID)
+    , m_colorResolution(NUI_IMAGE_RESOLUTION_INVALID)
+    , m_width(0)
+    , m_height(0)
+    , m_colorWidth(0)
+    , m_colorHeight(0)
+    , m_filled(0)
+{
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+RegistrationTable::~RegistrationTable()
+{
+}
+
+/// <summary>
+/// Allocate an empty table for a resolution pair
+/// </summary>
+/// <param name="depthResolution">Depth image resolution</param>
+/// <param name="colorResolution">Color image resolution</param>
+/// <returns>Indicates success or failure</returns>
+HRESULT RegistrationTable::Initialize(NUI_IMAGE_RESOLUTION depthResolution, NUI_IMAGE_RESOLUTION colorResolution)
+{
+    if (depthResolution < NUI_IMAGE_RESOLUTION_80x60 || depthResolution > NUI_IMAGE_RESOLUTION_1280x960
+        || colorResolution < NUI_IMAGE_RESOLUTION_80x60 || colorResolution > NUI_IMAGE_RESOLUTION_1280x960)
+    {
+        return E_INVALIDARG;
+    }
+
+    DWORD width, height, colorWidth, colorHeight;
+    NuiImageResolutionToSize(depthResolution, width, height);
+    NuiImageResolutionToSize(colorResolution, colorWidth, colorHeight);
+
+    m_depthResolution = depthResolution;
+    m_colorResolution = colorResolution;
+    m_width           = width;
+    m_height          = height;
+    m_colorWidth      = colorWidth;
+    m_colorHeight     = colorHeight;
+    m_filled          = 0;
+
+    for (UINT i = 0; i < REGISTRATION_BOUNDARY_COUNT; i++)
+    {
+        m_colorX[i].assign(width * height, 0);
+        m_colorY[i].assign(width * height, 0);
+    }
+
+    return S_OK;
+}
+
+/// <summary>
+/// Get the depth sampled by a boundary
+/// </summary>
+/// <param name="boundary">Boundary index</param>
+/// <returns>Depth in millimeters</returns>
+USHORT RegistrationTable::GetBoundaryDepth(UINT boundary) const
+{
+    return boundary < REGISTRATION_BOUNDARY_COUNT ? BoundaryDepths[boundary] : 0;
+}
+
+/// <summary>
+/// Fill one boundary from color coordinates of every depth pixel at the boundary depth
+/// </summary>
+/// <param name="boundary">Boundary index</param>
+/// <param name="pColorCoordinates">Color x and y of each depth pixel in row order, as returned by the SDK</param>
+/// <returns>Indicates success or failure</returns>
+HRESULT RegistrationTable::SetBoundaryMapping(UINT boundary, const LONG* pColorCoordinates)
+{
+    if (boundary >= REGISTRATION_BOUNDARY_COUNT || !pColorCoordinates || 0 == m_width)
+    {
+        return E_INVALIDARG;
+    }
+
+    UINT count = m_width * m_height;
+    for (UINT i = 0; i < count; i++)
+    {
+        // Coordinates far outside the color image are clamped, they are rejected when mapping anyway
+        LONG x = pColorCoordinates[2 * i]     * (LONG)COORDINATE_FRACTION;
+        LONG y = pColorCoordinates[2 * i + 1] * (LONG)COORDINATE_FRACTION;
+
+        m_colorX[boundary][i] = (SHORT)(x < -32767 ? -32767 : (x > 32767 ? 32767 : x));
+        m_colorY[boundary][i] = (SHORT)(y < -32767 ? -32767 : (y > 32767 ? 32767 : y));
+    }
+
+    m_filled |= 1u << boundary;
+    return S_OK;
+}
+
+/// <summary>
+/// Check if every boundary was filled
+/// </summary>
+bool RegistrationTable::IsValid() const
+{
+    return 0 != m_width && ((1u << REGISTRATION_BOUNDARY_COUNT) - 1) == m_filled;
+}
+
+/// <summary>
+/// Find the band holding a depth
+/// </summary>
+UINT RegistrationTable::FindBand(USHORT depth) const
+{
+    // Depths outside the sampled range extrapolate from the outer bands
+    UINT band = 0;
+    while (band + 2 < REGISTRATION_BOUNDARY_COUNT && depth > BoundaryDepths[band + 1])
+    {
+        ++band;
+    }
+    return band;
+}
+
+/// <summary>
+/// Map a single depth pixel
+/// </summary>
+/// <param name="x">Column of depth pixel</param>
+/// <param name="y">Row of depth pixel</param>
+/// <param name="depth">Depth in millimeters</param>
+/// <param name="colorX">Receives the color column</param>
+/// <param name="colorY">Receives the color row</param>
+/// <returns>False if the pixel has no depth or maps outside the color image</returns>
+bool RegistrationTable::MapPixel(UINT x, UINT y, USHORT depth, FLOAT& colorX, FLOAT& colorY) const
+{
+    if (!IsValid() || 0 == depth || x >= m_width || y >= m_height)
+    {
+        return false;
+    }
+
+    UINT  band        = FindBand(depth);
+    UINT  index       = y * m_width + x;
+    FLOAT nearInverse = 1.0f / BoundaryDepths[band];
+    FLOAT farInverse  = 1.0f / BoundaryDepths[band + 1];
+    FLOAT weight      = (1.0f / depth - nearInverse) / (farInverse - nearInverse);
+
+    FLOAT x0 = m_colorX[band][index], x1 = m_colorX[band + 1][index];
+    FLOAT y0 = m_colorY[band][index], y1 = m_colorY[band + 1][index];
+
+    colorX = (x0 + weight * (x1 - x0)) / COORDINATE_FRACTION;
+    colorY = (y0 + weight * (y1 - y0)) / COORDINATE_FRACTION;
+
+    return colorX >= 0.0f && colorY >= 0.0f && colorX < m_colorWidth && colorY < m_colorHeight;
+}
+
+/// <summary>
+/// Gather the color of every depth pixel inside a rectangle
+/// </summary>
+/// <param name="pDepth">The pointer to depth pixels</param>
+/// <param name="pColor">The pointer to the BGRX color image of the table color resolution</param>
+/// <param name="left">Left column, inclusive</param>
+/// <param name="top">Top row, inclusive</param>
+/// <param name="right">Right column, inclusive</param>
+/// <param name="bottom">Bottom row, inclusive</param>
+/// <param name="bandDepth">Depth choosing the band, typically the blob mean depth in millimeters</param>
+/// <param name="pPatch">Receives one BGRX pixel with REGISTRATION_MAPPED set per depth pixel in row order. Unmapped pixels are REGISTRATION_UNMAPPED</param>
+/// <returns>Number of mapped pixels</returns>
+UINT RegistrationTable::GatherColor(const NUI_DEPTH_IMAGE_PIXEL* pDepth, const UINT* pColor, UINT left, UINT top, UINT right, UINT bottom, USHORT bandDepth, UINT* pPatch) const
+{
+    if (!IsValid() || !pDepth || !pColor || !pPatch || right >= m_width || bottom >= m_height || left > right || top > bottom)
+    {
+        return 0;
+    }
+
+    // A blob spans little depth, so one band serves the whole patch and the inner loop has no branches
+    UINT  band  = FindBand(bandDepth);
+    FLOAT nearInverse = 1.0f / BoundaryDepths[band];
+    FLOAT scale       = 1.0f / (1.0f / BoundaryDepths[band + 1] - nearInverse);
+
+    const SHORT* pX0 = &m_colorX[band][0];
+    const SHORT* pX1 = &m_colorX[band + 1][0];
+    const SHORT* pY0 = &m_colorY[band][0];
+    const SHORT* pY1 = &m_colorY[band + 1][0];
+
+    UINT mapped = 0;
+
+#ifdef NUI_USE_SSE2
+    const __m128 one         = _mm_set1_ps(1.0f);
+    const __m128 nearInv     = _mm_set1_ps(nearInverse);
+    const __m128 bandScale   = _mm_set1_ps(scale);
+    const __m128 fraction    = _mm_set1_ps(1.0f / COORDINATE_FRACTION);
+    const __m128 half        = _mm_set1_ps(0.5f);
+    const __m128 zero        = _mm_setzero_ps();
+    const __m128 colorWidth  = _mm_set1_ps((FLOAT)m_colorWidth);
+    const __m128 colorHeight = _mm_set1_ps((FLOAT)m_colorHeight);
+#endif
+
+    for (UINT y = top; y <= bottom; y++)
+    {
+        UINT x = left;
+
+#ifdef NUI_USE_SSE2
+        for (; x + 4 <= right + 1; x += 4)
+        {
+            UINT index = y * m_width + x;
+
+            // Depth is the high word of each pixel
+            __m128i pixels = _mm_loadu_si128((const __m128i*)(pDepth + index));
+            __m128  depth  = _mm_cvtepi32_ps(_mm_srli_epi32(pixels, 16));
+            __m128  known  = _mm_cmpneq_ps(depth, zero);
+            __m128  weight = _mm_mul_ps(_mm_sub_ps(_mm_div_ps(one, _mm_or_ps(depth, _mm_andnot_ps(known, one))), nearInv), bandScale);
+
+            // Sign extend four boundary coordinates of each table
+            __m128i rawX0 = _mm_loadl_epi64((const __m128i*)(pX0 + index));
+            __m128i rawX1 = _mm_loadl_epi64((const __m128i*)(pX1 + index));
+            __m128i rawY0 = _mm_loadl_epi64((const __m128i*)(pY0 + index));
+            __m128i rawY1 = _mm_loadl_epi64((const __m128i*)(pY1 + index));
+
+            __m128 x0 = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(rawX0, rawX0), 16));
+            __m128 x1 = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(rawX1, rawX1), 16));
+            __m128 y0 = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(rawY0, rawY0), 16));
+            __m128 y1 = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(rawY1, rawY1), 16));
+
+            __m128 colorX = _mm_mul_ps(_mm_add_ps(x0, _mm_mul_ps(weight, _mm_sub_ps(x1, x0))), fraction);
+            __m128 colorY = _mm_mul_ps(_mm_add_ps(y0, _mm_mul_ps(weight, _mm_sub_ps(y1, y0))), fraction);
+
+            // Round to nearest and keep lanes inside the color image
+            colorX = _mm_add_ps(colorX, half);
+            colorY = _mm_add_ps(colorY, half);
+
+            __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(colorX, zero), _mm_cmplt_ps(colorX, colorWidth)),
+                                       _mm_and_ps(_mm_cmpge_ps(colorY, zero), _mm_cmplt_ps(colorY, colorHeight)));
+            int lanes = _mm_movemask_ps(_mm_and_ps(inside, known));
+
+            __m128 rowIndex = _mm_cvtepi32_ps(_mm_cvttps_epi32(colorY));
+            __m128 colIndex = _mm_cvtepi32_ps(_mm_cvttps_epi32(colorX));
+
+            // Indices stay below 2^24, exact in single precision
+            int colorIndex[4];
+            _mm_storeu_si128((__m128i*)colorIndex, _mm_cvtps_epi32(_mm_add_ps(_mm_mul_ps(rowIndex, colorWidth), colIndex)));
+
+            UINT* pOut = pPatch + (y - top) * (right - left + 1) + (x - left);
+            for (int lane = 0; lane < 4; lane++)
+            {
+                if (lanes & (1 << lane))
+                {
+                    pOut[lane] = pColor[colorIndex[lane]] | REGISTRATION_MAPPED;
+                    ++mapped;
+                }
+                else
+                {
+                    pOut[lane] = REGISTRATION_UNMAPPED;
+                }
+            }
+        }
+#endif
+
+        for (; x <= right; x++)
+        {
+            UINT   index = y * m_width + x;
+            USHORT depth = pDepth[index].depth;
+            UINT*  pOut  = pPatch + (y - top) * (right - left + 1) + (x - left);
+
+            *pOut = REGISTRATION_UNMAPPED;
+            if (0 == depth)
+            {
+                continue;
+            }
+
+            FLOAT weight = (1.0f / depth - nearInverse) * scale;
+            FLOAT colorX = (pX0[index] + weight * (pX1[index] - pX0[index])) / COORDINATE_FRACTION + 0.5f;
+            FLOAT colorY = (pY0[index] + weight * (pY1[index] - pY0[index])) / COORDINATE_FRACTION + 0.5f;
+
+            if (colorX >= 0.0f && colorY >= 0.0f && colorX < m_colorWidth && colorY < m_colorHeight)
+            {
+                *pOut = pColor[(UINT)colorY * m_colorWidth + (UINT)colorX] | REGISTRATION_MAPPED;
+                ++mapped;
+            }
+        }
+    }
+
+    return mapped;
+}
+
+/// <summary>
+/// Save table to file
+/// </summary>
+/// <param name="path">Path of file to write</param>
+/// <returns>Indicates success or failure</returns>
+HRESULT RegistrationTable::Save(const char* path) const
+{
+    if (!IsValid())
+    {
+        return E_FAIL;
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        return E_FAIL;
+    }
+
+    RegistrationFileHeader header = {REGISTRATION_FILE_MAGIC, REGISTRATION_FILE_VERSION, (DWORD)m_depthResolution, (DWORD)m_colorResolution, REGISTRATION_BOUNDARY_COUNT};
+    std::streamsize arraySize = (std::streamsize)(m_width * m_height * sizeof(SHORT));
+
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)BoundaryDepths, sizeof(BoundaryDepths));
+    for (UINT i = 0; i < REGISTRATION_BOUNDARY_COUNT; i++)
+    {
+        file.write((const char*)&m_colorX[i][0], arraySize);
+        file.write((const char*)&m_colorY[i][0], arraySize);
+    }
+
+    return file ? S_OK : E_FAIL;
+}
+
+/// <summary>
+/// Load table from file
+/// </summary>
+/// <param name="path">Path of file to read</param>
+/// <returns>Indicates success or failure</returns>
+HRESULT RegistrationTable::Load(const char* path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return E_FAIL;
+    }
+
+    RegistrationFileHeader header;
+    USHORT depths[REGISTRATION_BOUNDARY_COUNT];
+    if (!file.read((char*)&header, sizeof(header)) || !file.read((char*)depths, sizeof(depths)))
+    {
+        return E_FAIL;
+    }
+
+    // Tables sampled at other depths can not be interpolated with this layout
+    if (REGISTRATION_FILE_MAGIC != header.magic || REGISTRATION_FILE_VERSION != header.version
+        || REGISTRATION_BOUNDARY_COUNT != header.boundaryCount || 0 != memcmp(depths, BoundaryDepths, sizeof(depths)))
+    {
+        return E_FAIL;
+    }
+
+    HRESULT hr = Initialize((NUI_IMAGE_RESOLUTION)header.depthResolution, (NUI_IMAGE_RESOLUTION)header.colorResolution);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    std::streamsize arraySize = (std::streamsize)(m_width * m_height * sizeof(SHORT));
+    for (UINT i = 0; i < REGISTRATION_BOUNDARY_COUNT; i++)
+    {
+        if (!file.read((char*)&m_colorX[i][0], arraySize) || !file.read((char*)&m_colorY[i][0], arraySize))
+        {
+            m_filled = 0;
+            return E_FAIL;
+        }
+    }
+
+    m_filled = (1u << REGISTRATION_BOUNDARY_COUNT) - 1;
+    return S_OK;
+}
@@ -0,0 +1,163 @@
+//------------------------------------------------------------------------------
+// <copyright file="RegistrationTable.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include "NuiTypes.h"
+
+#define REGISTRATION_BOUNDARY_COUNT 5           // Depths sampled per pixel, four bands between them
+#define REGISTRATION_MAPPED         0xFF000000  // Set in the unused X byte of every gathered pixel
+#define REGISTRATION_UNMAPPED       0           // Gathered value of unmapped pixels, distinct from black
+
+/// <summary>
+/// Cached mapping from depth pixels to color pixels. For a few boundary depths the
+/// color coordinate of every depth pixel is stored in 1/8 pixel fixed point. Color
+/// parallax is close to linear in inverse depth, so a depth between two boundaries
+/// is mapped by interpolating in 1/depth. The table is filled once from the SDK
+/// mapping, or from recorded SDK output, and saved to file so it is loaded at
+/// startup instead of recomputed.
+/// </summary>
+class RegistrationTable
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    RegistrationTable();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~RegistrationTable();
+
+public:
+    /// <summary>
+    /// Allocate an empty table for a resolution pair
+    /// </summary>
+    /// <param name="depthResolution">Depth image resolution</param>
+    /// <param name="colorResolution">Color image resolution</param>
+    /// <returns>Indicates success or failure</returns>
+    HRESULT Initialize(NUI_IMAGE_RESOLUTION depthResolution, NUI_IMAGE_RESOLUTION colorResolution);
+
+    /// <summary>
+    /// Get the depth sampled by a boundary
+    /// </summary>
+    /// <param name="boundary">Boundary index</param>
+    /// <returns>Depth in millimeters</returns>
+    USHORT GetBoundaryDepth(UINT boundary) const;
+
+    /// <summary>
+    /// Fill one boundary from color coordinates of every depth pixel at the boundary depth
+    /// </summary>
+    /// <param name="boundary">Boundary index</param>
+    /// <param name="pColorCoordinates">Color x and y of each depth pixel in row order, as returned by the SDK</param>
+    /// <returns>Indicates success or failure</returns>
+    HRESULT SetBoundaryMapping(UINT boundary, const LONG* pColorCoordinates);
+
+    /// <summary>
+    /// Check if every boundary was filled
+    /// </summary>
+    bool IsValid() const;
+
+    /// <summary>
+    /// Check if the table maps a resolution pair
+    /// </summary>
+    bool Matches(NUI_IMAGE_RESOLUTION depthResolution, NUI_IMAGE_RESOLUTION colorResolution) const
+    {
+        return IsValid() && depthResolution == m_depthResolution && colorResolution == m_colorResolution;
+    }
+
+    /// <summary>
+    /// Get the width of the depth image mapped
+    /// </summary>
+    UINT GetWidth() const
+    {
+        return m_width;
+    }
+
+    /// <summary>
+    /// Get the height of the depth image mapped
+    /// </summary>
+    UINT GetHeight() const
+    {
+        return m_height;
+    }
+
+    /// <summary>
+    /// Get the width of the color image mapped to
+    /// </summary>
+    UINT GetColorWidth() const
+    {
+        return m_colorWidth;
+    }
+
+    /// <summary>
+    /// Get the height of the color image mapped to
+    /// </summary>
+    UINT GetColorHeight() const
+    {
+        return m_colorHeight;
+    }
+
+    /// <summary>
+    /// Map a single depth pixel
+    /// </summary>
+    /// <param name="x">Column of depth pixel</param>
+    /// <param name="y">Row of depth pixel</param>
+    /// <param name="depth">Depth in millimeters</param>
+    /// <param name="colorX">Receives the color column</param>
+    /// <param name="colorY">Receives the color row</param>
+    /// <returns>False if the pixel has no depth or maps outside the color image</returns>
+    bool MapPixel(UINT x, UINT y, USHORT depth, FLOAT& colorX, FLOAT& colorY) const;
+
+    /// <summary>
+    /// Gather the color of every depth pixel inside a rectangle
+    /// </summary>
+    /// <param name="pDepth">The pointer to depth pixels</param>
+    /// <param name="pColor">The pointer to the BGRX color image of the table color resolution</param>
+    /// <param name="left">Left column, inclusive</param>
+    /// <param name="top">Top row, inclusive</param>
+    /// <param name="right">Right column, inclusive</param>
+    /// <param name="bottom">Bottom row, inclusive</param>
+    /// <param name="bandDepth">Depth choosing the band, typically the blob mean depth in millimeters</param>
+    /// <param name="pPatch">Receives one BGRX pixel with REGISTRATION_MAPPED set per depth pixel in row order. Unmapped pixels are REGISTRATION_UNMAPPED</param>
+    /// <returns>Number of mapped pixels</returns>
+    UINT GatherColor(const NUI_DEPTH_IMAGE_PIXEL* pDepth, const UINT* pColor, UINT left, UINT top, UINT right, UINT bottom, USHORT bandDepth, UINT* pPatch) const;
+
+    /// <summary>
+    /// Save table to file
+    /// </summary>
+    /// <param name="path">Path of file to write</param>
+    /// <returns>Indicates success or failure</returns>
+    HRESULT Save(const char* path) const;
+
+    /// <summary>
+    /// Load table from file
+    /// </summary>
+    /// <param name="path">Path of file to read</param>
+    /// <returns>Indicates success or failure</returns>
+    HRESULT Load(const char* path);
+
+private:
+    /// <summary>
+    /// Find the band holding a depth
+    /// </summary>
+    UINT FindBand(USHORT depth) const;
+
+private:
+    NUI_IMAGE_RESOLUTION    m_depthResolution;
+    NUI_IMAGE_RESOLUTION    m_colorResolution;
+    UINT                    m_width;
+    UINT                    m_height;
+    UINT                    m_colorWidth;
+    UINT                    m_colorHeight;
+    UINT                    m_filled;           // Bit per boundary that was set
+
+    // Color coordinates times 8 at each boundary depth, one entry per depth pixel
+    std::vector<SHORT>      m_colorX[REGISTRATION_BOUNDARY_COUNT];
+    std::vector<SHORT>      m_colorY[REGISTRATION_BOUNDARY_COUNT];
+};
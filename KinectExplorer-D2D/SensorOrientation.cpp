@@ -0,0 +1,151 @@
+//------------------------------------------------------------------------------
+// <copyright file="SensorOrientation.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include <cmath>
+#include "SensorOrientation.h"
+
+#define DEGREES_TO_RADIANS      0.0174532925f
+#define MINIMUM_READING         0.5f        // Smaller accelerometer readings are not gravity
+#define SMOOTHING_FACTOR        0.2f        // Weight of a new reading
+#define REBUILD_COSINE          0.99996f    // Rotation follows once up has moved about half a degree
+
+/// <summary>
+/// Scale a direction to unit length
+/// </summary>
+/// <returns>Length before scaling</returns>
+static inline FLOAT Normalize(FLOAT v[3])
+{
+    FLOAT length = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    if (length > 0.0f)
+    {
+        v[0] /= length;
+        v[1] /= length;
+        v[2] /= length;
+    }
+    return length;
+}
+
+/// <summary>
+/// Constructor
+/// </summary>
+SensorOrientation::SensorOrientation()
+{
+    Reset();
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+SensorOrientation::~SensorOrientation()
+{
+}
+
+/// <summary>
+/// Go back to the camera frame and forget the readings
+/// </summary>
+void SensorOrientation::Reset()
+{
+    for (int row = 0; row < 3; row++)
+    {
+        m_up[row]        = (1 == row) ? 1.0f : 0.0f;
+        m_appliedUp[row] = m_up[row];
+
+        for (int col = 0; col < 3; col++)
+        {
+            m_rotation[row][col] = (row == col) ? 1.0f : 0.0f;
+        }
+    }
+
+    m_elevation  = 0;
+    m_hasReading = false;
+}
+
+/// <summary>
+/// Update with the latest sensor readings
+/// </summary>
+/// <param name="reading">Gravity in camera space in units of g, all zero if there is no reading</param>
+/// <param name="elevation">Motor elevation angle in degrees</param>
+/// <returns>True if the rotation changed</returns>
+bool SensorOrientation::Update(const Vector4& reading, LONG elevation)
+{
+    FLOAT up[3] = { -reading.x, -reading.y, -reading.z };
+
+    // Without an accelerometer reading the motor angle still gives the pitch
+    if (Normalize(up) < MINIMUM_READING)
+    {
+        FLOAT pitch = elevation * DEGREES_TO_RADIANS;
+        up[0] = 0.0f;
+        up[1] = cosf(pitch);
+        up[2] = sinf(pitch);
+    }
+
+    // The motor moved, follow the new reading at once instead of smoothing toward it
+    if (!m_hasReading || elevation != m_elevation)
+    {
+        m_up[0] = up[0];
+        m_up[1] = up[1];
+        m_up[2] = up[2];
+    }
+    else
+    {
+        m_up[0] += (up[0] - m_up[0]) * SMOOTHING_FACTOR;
+        m_up[1] += (up[1] - m_up[1]) * SMOOTHING_FACTOR;
+        m_up[2] += (up[2] - m_up[2]) * SMOOTHING_FACTOR;
+        Normalize(m_up);
+    }
+
+    m_elevation  = elevation;
+    m_hasReading = true;
+
+    // Sensor noise must not rebuild ray tables every frame
+    if (m_up[0] * m_appliedUp[0] + m_up[1] * m_appliedUp[1] + m_up[2] * m_appliedUp[2] > REBUILD_COSINE)
+    {
+        return false;
+    }
+
+    m_appliedUp[0] = m_up[0];
+    m_appliedUp[1] = m_up[1];
+    m_appliedUp[2] = m_up[2];
+
+    // Level forward direction: the camera z axis with its up component removed
+    FLOAT forward[3] = { -m_up[2] * m_up[0], -m_up[2] * m_up[1], 1.0f - m_up[2] * m_up[2] };
+    if (Normalize(forward) <= 0.0f)
+    {
+        return false;   // Looking straight up or down, keep the previous rotation
+    }
+
+    FLOAT side[3] =
+    {
+        m_up[1] * forward[2] - m_up[2] * forward[1],
+        m_up[2] * forward[0] - m_up[0] * forward[2],
+        m_up[0] * forward[1] - m_up[1] * forward[0]
+    };
+
+    // Rows are the aligned axes expressed in camera space
+    for (int col = 0; col < 3; col++)
+    {
+        m_rotation[0][col] = side[col];
+        m_rotation[1][col] = m_up[col];
+        m_rotation[2][col] = forward[col];
+    }
+
+    return true;
+}
+
+/// <summary>
+/// Get the rotation
+/// </summary>
+/// <param name="rotation">Receives the row major matrix, aligned = rotation * camera</param>
+void SensorOrientation::GetRotation(FLOAT rotation[3][3]) const
+{
+    for (int row = 0; row < 3; row++)
+    {
+        for (int col = 0; col < 3; col++)
+        {
+            rotation[row][col] = m_rotation[row][col];
+        }
+    }
+}
@@ -0,0 +1,58 @@
+//------------------------------------------------------------------------------
+// <copyright file="SensorOrientation.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include "NuiTypes.h"
+
+/// <summary>
+/// Rotation from camera space to a gravity aligned frame. The y axis of the frame
+/// points up and its z axis is the camera view direction made level, so only the
+/// sensor pitch and roll are removed. The accelerometer reading is smoothed, and a
+/// change of the motor elevation angle makes it follow the new reading at once. The
+/// rotation is only replaced when the up direction has moved noticeably, so the
+/// ray tables depending on it are rebuilt on a tilt and not on sensor noise.
+/// </summary>
+class SensorOrientation
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    SensorOrientation();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~SensorOrientation();
+
+public:
+    /// <summary>
+    /// Update with the latest sensor readings
+    /// </summary>
+    /// <param name="reading">Gravity in camera space in units of g, all zero if there is no reading</param>
+    /// <param name="elevation">Motor elevation angle in degrees</param>
+    /// <returns>True if the rotation changed</returns>
+    bool Update(const Vector4& reading, LONG elevation);
+
+    /// <summary>
+    /// Go back to the camera frame and forget the readings
+    /// </summary>
+    void Reset();
+
+    /// <summary>
+    /// Get the rotation
+    /// </summary>
+    /// <param name="rotation">Receives the row major matrix, aligned = rotation * camera</param>
+    void GetRotation(FLOAT rotation[3][3]) const;
+
+private:
+    FLOAT   m_up[3];            // Smoothed up direction in camera space
+    FLOAT   m_appliedUp[3];     // Up direction the rotation was built from
+    FLOAT   m_rotation[3][3];
+    LONG    m_elevation;
+    bool    m_hasReading;
+};
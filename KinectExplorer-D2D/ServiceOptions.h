@@ -0,0 +1,36 @@
+//------------------------------------------------------------------------------
+// <copyright file="ServiceOptions.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include "NuiTypes.h"
+
+#define SERVICE_ADDRESS_SIZE        16              // Dotted IPv4 address and its terminator
+#define DEFAULT_PREVIEW_ADDRESS     "127.0.0.1"     // Only browsers on this machine
+#define DEFAULT_PREVIEW_PORT        5801
+#define DEFAULT_PUBLISH_ADDRESS     "127.0.0.1"     // Controller on this machine
+#define DEFAULT_PUBLISH_PORT        5800
+
+/// <summary>
+/// Services every sensor window offers to other programs. All of them are off
+/// unless asked for on the command line:
+///
+///   -preview[=address:port]   MJPEG depth preview for browsers, loopback by default
+///   -publish[=address:port]   UDP ball detections for a controller, loopback by default
+///   -framebus                 Depth, color and skeleton frames in shared memory for other processes
+///
+/// Each sensor adds its index to the ports, so several sensors do not collide.
+/// </summary>
+struct ServiceOptions
+{
+    bool    preview;
+    char    previewAddress[SERVICE_ADDRESS_SIZE];
+    USHORT  previewPort;
+    bool    publish;
+    char    publishAddress[SERVICE_ADDRESS_SIZE];
+    USHORT  publishPort;
+    bool    frameBus;
+};
@@ -0,0 +1,209 @@
+//------------------------------------------------------------------------------
+// <copyright file="SharedMemory.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "SharedMemory.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define INVALID_HANDLE_VALUE_INT    ((intptr_t)-1)
+#define SHARED_MEMORY_MODE          0600    // Owner only, readers trust what is written into the region
+
+/// <summary>
+/// Constructor
+/// </summary>
+SharedMemory::SharedMemory()
+    : m_pData(nullptr)
+    , m_size(0)
+    , m_handle(INVALID_HANDLE_VALUE_INT)
+    , m_owner(false)
+{
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+SharedMemory::~SharedMemory()
+{
+    Close();
+}
+
+/// <summary>
+/// Create a zero filled region
+/// </summary>
+/// <param name="name">Region name without path or prefix</param>
+/// <param name="size">Size in bytes</param>
+/// <returns>Indicates success or failure</returns>
+HRESULT SharedMemory::Create(const char* name, size_t size)
+{
+    Close();
+
+    if (!name || 0 == size)
+    {
+        return E_INVALIDARG;
+    }
+
+#ifdef _WIN32
+    m_name = name;
+
+    ULONGLONG total    = size;
+    HANDLE    hMapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, (DWORD)(total >> 32), (DWORD)total, name);
+    if (!hMapping)
+    {
+        return E_FAIL;
+    }
+    m_handle = (intptr_t)hMapping;
+
+    // Another process still maps an older region of this name, its size may not match
+    if (ERROR_ALREADY_EXISTS == GetLastError())
+    {
+        Close();
+        return E_FAIL;
+    }
+
+    m_pData = MapViewOfFile(hMapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+#else
+    m_name = std::string("/") + name;
+
+    // A region left by a crashed producer is replaced, readers still mapping it keep the old one
+    shm_unlink(m_name.c_str());
+
+    int fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, SHARED_MEMORY_MODE);
+    if (fd < 0)
+    {
+        return E_FAIL;
+    }
+    m_handle = fd;
+    m_owner  = true;
+
+    if (0 != ftruncate(fd, (off_t)size))
+    {
+        Close();
+        return E_FAIL;
+    }
+
+    m_pData = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (MAP_FAILED == m_pData)
+    {
+        m_pData = nullptr;
+    }
+#endif
+
+    if (!m_pData)
+    {
+        Close();
+        return E_FAIL;
+    }
+
+    m_size  = size;
+    m_owner = true;
+    return S_OK;
+}
+
+/// <summary>
+/// Map a region created by another process
+/// </summary>
+/// <param name="name">Region name without path or prefix</param>
+/// <returns>Indicates success or failure</returns>
+HRESULT SharedMemory::Open(const char* name)
+{
+    Close();
+
+    if (!name)
+    {
+        return E_INVALIDARG;
+    }
+
+#ifdef _WIN32
+    m_name = name;
+
+    HANDLE hMapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name);
+    if (!hMapping)
+    {
+        return E_FAIL;
+    }
+    m_handle = (intptr_t)hMapping;
+
+    m_pData = MapViewOfFile(hMapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (m_pData)
+    {
+        MEMORY_BASIC_INFORMATION info;
+        VirtualQuery(m_pData, &info, sizeof(info));
+        m_size = info.RegionSize;
+    }
+#else
+    m_name = std::string("/") + name;
+
+    int fd = shm_open(m_name.c_str(), O_RDWR, 0);
+    if (fd < 0)
+    {
+        return E_FAIL;
+    }
+    m_handle = fd;
+
+    struct stat status;
+    if (0 == fstat(fd, &status) && status.st_size > 0)
+    {
+        m_pData = mmap(nullptr, (size_t)status.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (MAP_FAILED == m_pData)
+        {
+            m_pData = nullptr;
+        }
+        m_size = (size_t)status.st_size;
+    }
+#endif
+
+    if (!m_pData)
+    {
+        Close();
+        return E_FAIL;
+    }
+
+    return S_OK;
+}
+
+/// <summary>
+/// Unmap the region, and remove its name if this object created it
+/// </summary>
+void SharedMemory::Close()
+{
+#ifdef _WIN32
+    if (m_pData)
+    {
+        UnmapViewOfFile(m_pData);
+    }
+
+    if (INVALID_HANDLE_VALUE_INT != m_handle)
+    {
+        CloseHandle((HANDLE)m_handle);
+    }
+#else
+    if (m_pData)
+    {
+        munmap(m_pData, m_size);
+    }
+
+    if (INVALID_HANDLE_VALUE_INT != m_handle)
+    {
+        close((int)m_handle);
+    }
+
+    if (m_owner)
+    {
+        shm_unlink(m_name.c_str());
+    }
+#endif
+
+    m_pData  = nullptr;
+    m_size   = 0;
+    m_handle = INVALID_HANDLE_VALUE_INT;
+    m_owner  = false;
+    m_name.clear();
+}
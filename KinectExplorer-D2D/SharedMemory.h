@@ -0,0 +1,76 @@
+//------------------------------------------------------------------------------
+// <copyright file="SharedMemory.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include "NuiTypes.h"
+
+/// <summary>
+/// Named memory region mapped into several local processes, a file mapping on
+/// Windows and a POSIX shared memory object elsewhere. The creator owns the name
+/// and removes it when closed, processes which opened it keep their mapping. Only
+/// processes of the creating user may map the region: the POSIX object is created
+/// with mode 0600 and the file mapping with the default security of the creator.
+/// </summary>
+class SharedMemory
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    SharedMemory();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~SharedMemory();
+
+public:
+    /// <summary>
+    /// Create a zero filled region
+    /// </summary>
+    /// <param name="name">Region name without path or prefix</param>
+    /// <param name="size">Size in bytes</param>
+    /// <returns>Indicates success or failure</returns>
+    HRESULT Create(const char* name, size_t size);
+
+    /// <summary>
+    /// Map a region created by another process
+    /// </summary>
+    /// <param name="name">Region name without path or prefix</param>
+    /// <returns>Indicates success or failure</returns>
+    HRESULT Open(const char* name);
+
+    /// <summary>
+    /// Unmap the region, and remove its name if this object created it
+    /// </summary>
+    void Close();
+
+    /// <summary>
+    /// Get the mapped bytes, nullptr if nothing is mapped
+    /// </summary>
+    void* GetData() const
+    {
+        return m_pData;
+    }
+
+    /// <summary>
+    /// Get size of the mapped region in bytes
+    /// </summary>
+    size_t GetSize() const
+    {
+        return m_size;
+    }
+
+private:
+    void*       m_pData;
+    size_t      m_size;
+    intptr_t    m_handle;       // File mapping HANDLE on Windows, file descriptor elsewhere
+    bool        m_owner;
+    std::string m_name;
+};
@@ -0,0 +1,185 @@
+//------------------------------------------------------------------------------
+// <copyright file="SkeletonStore.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "SkeletonStore.h"
+#include <cfloat>
+#include <string.h>
+
+#define MINIMUM_PROJECTED_DEPTH     FLT_EPSILON // Meters, as the SDK transform
+#define METERS_TO_MILLIMETERS       1000.0f
+
+// Skeleton space is depth camera space, the nominal focal length is given at 320x240
+#define DEPTH_SCALE_X               (NUI_CAMERA_DEPTH_NOMINAL_FOCAL_LENGTH_IN_PIXELS / 320.0f)
+#define DEPTH_SCALE_Y               (NUI_CAMERA_DEPTH_NOMINAL_FOCAL_LENGTH_IN_PIXELS / 240.0f)
+
+/// <summary>
+/// Constructor
+/// </summary>
+SkeletonStore::SkeletonStore()
+{
+    Clear();
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+SkeletonStore::~SkeletonStore()
+{
+}
+
+/// <summary>
+/// Convert and project a skeleton frame
+/// </summary>
+/// <param name="frame">Smoothed skeleton frame</param>
+/// <param name="pRegistration">The pointer to the depth to color mapping, or nullptr to use depth coordinates for color</param>
+void SkeletonStore::Update(const NUI_SKELETON_FRAME& frame, const RegistrationTable* pRegistration)
+{
+    // Gather the joints of every skeleton into the point arrays
+    for (UINT i = 0; i < NUI_SKELETON_COUNT; i++)
+    {
+        const NUI_SKELETON_DATA& skeleton = frame.SkeletonData[i];
+
+        m_trackingStates[i] = skeleton.eTrackingState;
+        m_trackingIDs[i]    = skeleton.dwTrackingID;
+
+        UINT base = GetPointIndex(i, 0);
+        for (UINT joint = 0; joint < NUI_SKELETON_POSITION_COUNT; joint++)
+        {
+            const Vector4& point = skeleton.SkeletonPositions[joint];
+
+            // Joints are only reported for fully tracked skeletons
+            bool tracked = NUI_SKELETON_TRACKED == skeleton.eTrackingState && point.z > MINIMUM_PROJECTED_DEPTH;
+
+            m_x[base + joint]      = tracked ? point.x : 0.0f;
+            m_y[base + joint]      = tracked ? point.y : 0.0f;
+            m_z[base + joint]      = tracked ? point.z : 0.0f;
+            m_states[base + joint] = (BYTE)(tracked ? skeleton.eSkeletonPositionTrackingState[joint] : NUI_SKELETON_POSITION_NOT_TRACKED);
+        }
+
+        bool located = NUI_SKELETON_NOT_TRACKED != skeleton.eTrackingState && skeleton.Position.z > MINIMUM_PROJECTED_DEPTH;
+
+        m_x[base + SKELETON_STORE_POSITION]      = located ? skeleton.Position.x : 0.0f;
+        m_y[base + SKELETON_STORE_POSITION]      = located ? skeleton.Position.y : 0.0f;
+        m_z[base + SKELETON_STORE_POSITION]      = located ? skeleton.Position.z : 0.0f;
+        m_states[base + SKELETON_STORE_POSITION] = (BYTE)(located ? NUI_SKELETON_POSITION_TRACKED : NUI_SKELETON_POSITION_NOT_TRACKED);
+    }
+
+    ProjectToDepth();
+    MapToColor(pRegistration);
+
+    m_valid = true;
+}
+
+/// <summary>
+/// Forget the skeletons, for example while tracking is paused
+/// </summary>
+void SkeletonStore::Clear()
+{
+    m_valid = false;
+
+    for (UINT i = 0; i < NUI_SKELETON_COUNT; i++)
+    {
+        m_trackingStates[i] = NUI_SKELETON_NOT_TRACKED;
+        m_trackingIDs[i]    = 0;
+    }
+
+    // Padding points stay zero and not tracked for good
+    memset(m_x,      0, sizeof(m_x));
+    memset(m_y,      0, sizeof(m_y));
+    memset(m_z,      0, sizeof(m_z));
+    memset(m_states, NUI_SKELETON_POSITION_NOT_TRACKED, sizeof(m_states));
+    memset(m_depthX, 0, sizeof(m_depthX));
+    memset(m_depthY, 0, sizeof(m_depthY));
+    memset(m_depth,  0, sizeof(m_depth));
+    memset(m_colorX, 0, sizeof(m_colorX));
+    memset(m_colorY, 0, sizeof(m_colorY));
+}
+
+/// <summary>
+/// Project every point to the depth image
+/// </summary>
+void SkeletonStore::ProjectToDepth()
+{
+    UINT i = 0;
+
+#ifdef NUI_USE_SSE2
+    const __m128 half    = _mm_set1_ps(0.5f);
+    const __m128 scaleX  = _mm_set1_ps(DEPTH_SCALE_X);
+    const __m128 scaleY  = _mm_set1_ps(DEPTH_SCALE_Y);
+    const __m128 minimum = _mm_set1_ps(MINIMUM_PROJECTED_DEPTH);
+    const __m128 toMm    = _mm_set1_ps(METERS_TO_MILLIMETERS);
+
+    for (; i + 4 <= SKELETON_STORE_POINTS; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(m_x + i);
+        __m128 y = _mm_loadu_ps(m_y + i);
+        __m128 z = _mm_loadu_ps(m_z + i);
+
+        // Points at or behind the camera get zero, the division by zero is masked away
+        __m128 valid   = _mm_cmpgt_ps(z, minimum);
+        __m128 inverse = _mm_and_ps(valid, _mm_div_ps(_mm_set1_ps(1.0f), z));
+
+        __m128 u = _mm_add_ps(half, _mm_mul_ps(_mm_mul_ps(x, scaleX), inverse));
+        __m128 v = _mm_sub_ps(half, _mm_mul_ps(_mm_mul_ps(y, scaleY), inverse));
+
+        _mm_storeu_ps(m_depthX + i, _mm_and_ps(valid, u));
+        _mm_storeu_ps(m_depthY + i, _mm_and_ps(valid, v));
+
+        __m128i millimeters = _mm_cvttps_epi32(_mm_and_ps(valid, _mm_mul_ps(z, toMm)));
+        _mm_storel_epi64((__m128i*)(m_depth + i), _mm_packs_epi32(millimeters, millimeters));
+    }
+#endif
+
+    for (; i < SKELETON_STORE_POINTS; i++)
+    {
+        if (m_z[i] > MINIMUM_PROJECTED_DEPTH)
+        {
+            FLOAT inverse = 1.0f / m_z[i];
+            m_depthX[i] = 0.5f + m_x[i] * DEPTH_SCALE_X * inverse;
+            m_depthY[i] = 0.5f - m_y[i] * DEPTH_SCALE_Y * inverse;
+            m_depth[i]  = (USHORT)(m_z[i] * METERS_TO_MILLIMETERS);
+        }
+        else
+        {
+            m_depthX[i] = 0.0f;
+            m_depthY[i] = 0.0f;
+            m_depth[i]  = 0;
+        }
+    }
+}
+
+/// <summary>
+/// Map the tracked points from the depth image to the color image
+/// </summary>
+/// <param name="pRegistration">The pointer to the depth to color mapping, or nullptr for none</param>
+void SkeletonStore::MapToColor(const RegistrationTable* pRegistration)
+{
+    bool  mapped      = pRegistration && pRegistration->IsValid();
+    FLOAT depthWidth  = mapped ? (FLOAT)pRegistration->GetWidth()  : 0.0f;
+    FLOAT depthHeight = mapped ? (FLOAT)pRegistration->GetHeight() : 0.0f;
+    FLOAT colorScaleX = mapped ? 1.0f / pRegistration->GetColorWidth()  : 0.0f;
+    FLOAT colorScaleY = mapped ? 1.0f / pRegistration->GetColorHeight() : 0.0f;
+
+    for (UINT i = 0; i < SKELETON_STORE_POINTS; i++)
+    {
+        // Points the table cannot map keep their depth coordinates, as the viewer always did
+        m_colorX[i] = m_depthX[i];
+        m_colorY[i] = m_depthY[i];
+
+        if (!mapped || NUI_SKELETON_POSITION_NOT_TRACKED == m_states[i] ||
+            m_depthX[i] < 0.0f || m_depthY[i] < 0.0f || m_depthX[i] >= 1.0f || m_depthY[i] >= 1.0f)
+        {
+            continue;
+        }
+
+        FLOAT colorX, colorY;
+        if (pRegistration->MapPixel((UINT)(m_depthX[i] * depthWidth), (UINT)(m_depthY[i] * depthHeight), m_depth[i], colorX, colorY))
+        {
+            m_colorX[i] = colorX * colorScaleX;
+            m_colorY[i] = colorY * colorScaleY;
+        }
+    }
+}
@@ -0,0 +1,181 @@
+//------------------------------------------------------------------------------
+// <copyright file="SkeletonStore.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include "NuiTypes.h"
+#include "RegistrationTable.h"
+
+#define SKELETON_STORE_JOINTS       (NUI_SKELETON_POSITION_COUNT + 1)   // Joints of a skeleton followed by its position
+#define SKELETON_STORE_POSITION     NUI_SKELETON_POSITION_COUNT         // Joint index of the skeleton position
+#define SKELETON_STORE_POINTS       ((NUI_SKELETON_COUNT * SKELETON_STORE_JOINTS + 3) & ~3)
+
+/// <summary>
+/// Skeleton frame converted once into arrays of x, y, z and tracking state, one entry
+/// per joint and skeleton position of every skeleton, with all points projected to
+/// depth and color image coordinates in one vectorized pass. The chooser, viewers and
+/// overlays read the same projections instead of transforming each joint on their own.
+/// Image coordinates are fractions of the image size, so they serve any resolution.
+/// </summary>
+class SkeletonStore
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    SkeletonStore();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~SkeletonStore();
+
+public:
+    /// <summary>
+    /// Convert and project a skeleton frame
+    /// </summary>
+    /// <param name="frame">Smoothed skeleton frame</param>
+    /// <param name="pRegistration">The pointer to the depth to color mapping, or nullptr to use depth coordinates for color</param>
+    void Update(const NUI_SKELETON_FRAME& frame, const RegistrationTable* pRegistration);
+
+    /// <summary>
+    /// Forget the skeletons, for example while tracking is paused
+    /// </summary>
+    void Clear();
+
+    /// <summary>
+    /// Check if a frame was stored since the last clear
+    /// </summary>
+    bool IsValid() const
+    {
+        return m_valid;
+    }
+
+    /// <summary>
+    /// Get the index of a joint in the point arrays
+    /// </summary>
+    /// <param name="skeleton">Skeleton index</param>
+    /// <param name="joint">Joint index, or SKELETON_STORE_POSITION for the skeleton position</param>
+    static UINT GetPointIndex(UINT skeleton, UINT joint)
+    {
+        return skeleton * SKELETON_STORE_JOINTS + joint;
+    }
+
+    /// <summary>
+    /// Get the tracking state of a skeleton
+    /// </summary>
+    NUI_SKELETON_TRACKING_STATE GetTrackingState(UINT skeleton) const
+    {
+        return m_trackingStates[skeleton];
+    }
+
+    /// <summary>
+    /// Get the tracking ID of a skeleton
+    /// </summary>
+    DWORD GetTrackingID(UINT skeleton) const
+    {
+        return m_trackingIDs[skeleton];
+    }
+
+    /// <summary>
+    /// Get the tracking state of a point. Points which cannot be projected are not tracked
+    /// </summary>
+    NUI_SKELETON_POSITION_TRACKING_STATE GetPointState(UINT index) const
+    {
+        return (NUI_SKELETON_POSITION_TRACKING_STATE)m_states[index];
+    }
+
+    /// <summary>
+    /// Get the skeleton space x of every point in meters, SKELETON_STORE_POINTS entries
+    /// </summary>
+    const FLOAT* GetX() const
+    {
+        return m_x;
+    }
+
+    /// <summary>
+    /// Get the skeleton space y of every point in meters
+    /// </summary>
+    const FLOAT* GetY() const
+    {
+        return m_y;
+    }
+
+    /// <summary>
+    /// Get the skeleton space z of every point in meters
+    /// </summary>
+    const FLOAT* GetZ() const
+    {
+        return m_z;
+    }
+
+    /// <summary>
+    /// Get the depth image column of every point as a fraction of the image width
+    /// </summary>
+    const FLOAT* GetDepthX() const
+    {
+        return m_depthX;
+    }
+
+    /// <summary>
+    /// Get the depth image row of every point as a fraction of the image height
+    /// </summary>
+    const FLOAT* GetDepthY() const
+    {
+        return m_depthY;
+    }
+
+    /// <summary>
+    /// Get the depth of every point in millimeters, zero if not projected
+    /// </summary>
+    const USHORT* GetDepth() const
+    {
+        return m_depth;
+    }
+
+    /// <summary>
+    /// Get the color image column of every point as a fraction of the image width
+    /// </summary>
+    const FLOAT* GetColorX() const
+    {
+        return m_colorX;
+    }
+
+    /// <summary>
+    /// Get the color image row of every point as a fraction of the image height
+    /// </summary>
+    const FLOAT* GetColorY() const
+    {
+        return m_colorY;
+    }
+
+private:
+    /// <summary>
+    /// Project every point to the depth image
+    /// </summary>
+    void ProjectToDepth();
+
+    /// <summary>
+    /// Map the tracked points from the depth image to the color image
+    /// </summary>
+    /// <param name="pRegistration">The pointer to the depth to color mapping, or nullptr for none</param>
+    void MapToColor(const RegistrationTable* pRegistration);
+
+private:
+    bool                        m_valid;
+    NUI_SKELETON_TRACKING_STATE m_trackingStates[NUI_SKELETON_COUNT];
+    DWORD                       m_trackingIDs[NUI_SKELETON_COUNT];
+
+    FLOAT                       m_x[SKELETON_STORE_POINTS];
+    FLOAT                       m_y[SKELETON_STORE_POINTS];
+    FLOAT                       m_z[SKELETON_STORE_POINTS];
+    BYTE                        m_states[SKELETON_STORE_POINTS];
+    FLOAT                       m_depthX[SKELETON_STORE_POINTS];
+    FLOAT                       m_depthY[SKELETON_STORE_POINTS];
+    USHORT                      m_depth[SKELETON_STORE_POINTS];
+    FLOAT                       m_colorX[SKELETON_STORE_POINTS];
+    FLOAT                       m_colorY[SKELETON_STORE_POINTS];
+};
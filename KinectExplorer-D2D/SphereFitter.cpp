@@ -0,0 +1,414 @@
+//------------------------------------------------------------------------------
+// <copyright file="SphereFitter.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include <chrono>
+#include <cmath>
+#include "SphereFitter.h"
+
+#define DEFAULT_INLIER_TOLERANCE    0.02f   // Meters
+#define DEFAULT_MINIMUM_INLIER      0.5f
+#define DEFAULT_TIME_BUDGET         500     // Microseconds per candidate
+#define MINIMUM_FIT_POINTS          8
+#define MAX_SCORING_POINTS          256
+#define MAX_ITERATIONS              200
+#define RANSAC_CONFIDENCE           0.99
+#define BUDGET_CHECK_INTERVAL       4
+#define REFINE_ITERATIONS           5
+#define MAX_REFINE_POINTS           1024    // Bounds the cost of an iteration like the scoring subsample
+#define PADDING_COORDINATE          1.0e6f  // Never within tolerance of any sphere
+
+/// <summary>
+/// Constructor
+/// </summary>
+SphereFitter::SphereFitter()
+    : m_radius(DEFAULT_BALL_RADIUS)
+    , m_tolerance(DEFAULT_INLIER_TOLERANCE)
+    , m_minimumInlierRatio(DEFAULT_MINIMUM_INLIER)
+    , m_timeBudget(DEFAULT_TIME_BUDGET)
+    , m_randomState(0x2545F491)
+    , m_pX(nullptr)
+    , m_pY(nullptr)
+    , m_pZ(nullptr)
+    , m_count(0)
+    , m_scoreCount(0)
+{
+    m_scoreX.resize(MAX_SCORING_POINTS);
+    m_scoreY.resize(MAX_SCORING_POINTS);
+    m_scoreZ.resize(MAX_SCORING_POINTS);
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+SphereFitter::~SphereFitter()
+{
+}
+
+/// <summary>
+/// Set the known sphere radius
+/// </summary>
+/// <param name="radius">Radius in meters</param>
+void SphereFitter::SetRadius(FLOAT radius)
+{
+    m_radius = radius;
+}
+
+/// <summary>
+/// Set the largest distance from the surface for a point to be an inlier
+/// </summary>
+/// <param name="tolerance">Distance in meters</param>
+void SphereFitter::SetInlierTolerance(FLOAT tolerance)
+{
+    m_tolerance = tolerance;
+}
+
+/// <summary>
+/// Set the time budget of a single fit
+/// </summary>
+/// <param name="microseconds">Budget in microseconds</param>
+void SphereFitter::SetTimeBudget(UINT microseconds)
+{
+    m_timeBudget = microseconds;
+}
+
+/// <summary>
+/// Set the smallest inlier ratio of an accepted fit
+/// </summary>
+/// <param name="ratio">Ratio between 0 and 1</param>
+void SphereFitter::SetMinimumInlierRatio(FLOAT ratio)
+{
+    m_minimumInlierRatio = ratio;
+}
+
+/// <summary>
+/// Draw a random index below a bound
+/// </summary>
+UINT SphereFitter::NextRandom(UINT bound)
+{
+    // xorshift32, deterministic so results are repeatable between runs
+    m_randomState ^= m_randomState << 13;
+    m_randomState ^= m_randomState >> 17;
+    m_randomState ^= m_randomState << 5;
+    return m_randomState % bound;
+}
+
+/// <summary>
+/// Fit a sphere to points given as separate coordinate arrays
+/// </summary>
+/// <param name="pX">X coordinates in meters</param>
+/// <param name="pY">Y coordinates in meters</param>
+/// <param name="pZ">Z coordinates in meters</param>
+/// <param name="count">Number of points</param>
+/// <param name="result">Receives the fit</param>
+/// <returns>True if a sphere with enough support was found</returns>
+bool SphereFitter::Fit(const FLOAT* pX, const FLOAT* pY, const FLOAT* pZ, UINT count, SphereFit& result)
+{
+    ZeroMemory(&result, sizeof(result));
+
+    if (count < MINIMUM_FIT_POINTS)
+    {
+        return false;
+    }
+
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(m_timeBudget);
+
+    m_pX    = pX;
+    m_pY    = pY;
+    m_pZ    = pZ;
+    m_count = count;
+
+    // Score hypotheses on an even subsample so the cost per hypothesis is bounded
+    UINT stride  = (count + MAX_SCORING_POINTS - 1) / MAX_SCORING_POINTS;
+    m_scoreCount = 0;
+    for (UINT i = 0; i < count; i += stride)
+    {
+        m_scoreX[m_scoreCount] = pX[i];
+        m_scoreY[m_scoreCount] = pY[i];
+        m_scoreZ[m_scoreCount] = pZ[i];
+        ++m_scoreCount;
+    }
+
+    for (UINT i = m_scoreCount; i % 4; i++)
+    {
+        m_scoreX[i] = m_scoreY[i] = m_scoreZ[i] = PADDING_COORDINATE;
+    }
+
+    FLOAT bestCenter[3] = {0.0f, 0.0f, 0.0f};
+    UINT  bestInliers   = 0;
+    UINT  needed        = MAX_ITERATIONS;
+    UINT  iteration     = 0;
+
+    for (; iteration < needed; iteration++)
+    {
+        if (0 == iteration % BUDGET_CHECK_INTERVAL && iteration > 0 && std::chrono::steady_clock::now() > deadline)
+        {
+            break;
+        }
+
+        UINT a = NextRandom(m_scoreCount);
+        UINT b = NextRandom(m_scoreCount);
+        UINT c = NextRandom(m_scoreCount);
+        if (a == b || b == c || a == c)
+        {
+            continue;
+        }
+
+        FLOAT center[3];
+        if (!CenterFromSample(a, b, c, center))
+        {
+            continue;
+        }
+
+        UINT inliers = CountInliers(center);
+        if (inliers > bestInliers)
+        {
+            bestInliers   = inliers;
+            bestCenter[0] = center[0];
+            bestCenter[1] = center[1];
+            bestCenter[2] = center[2];
+
+            // Stop early once enough hypotheses were drawn for the observed inlier ratio
+            double ratio = (double)inliers / m_scoreCount;
+            double miss  = 1.0 - ratio * ratio * ratio;
+            if (miss <= 0.0)
+            {
+                needed = iteration + 1;
+            }
+            else if (miss < 1.0)
+            {
+                double estimate = log(1.0 - RANSAC_CONFIDENCE) / log(miss);
+                if (estimate < needed)
+                {
+                    needed = (UINT)estimate + 1;
+                }
+            }
+        }
+    }
+
+    result.iterations = iteration;
+
+    if (0 == bestInliers)
+    {
+        return false;
+    }
+
+    Refine(bestCenter, deadline, result);
+
+    result.valid = (result.inlierRatio >= m_minimumInlierRatio);
+    return result.valid;
+}
+
+/// <summary>
+/// Compute the center of a sphere with the known radius through three points
+/// </summary>
+/// <returns>False if the points do not fit on such a sphere</returns>
+bool SphereFitter::CenterFromSample(UINT a, UINT b, UINT c, FLOAT center[3]) const
+{
+    FLOAT p[3] = {m_scoreX[a], m_scoreY[a], m_scoreZ[a]};
+    FLOAT u[3] = {m_scoreX[b] - p[0], m_scoreY[b] - p[1], m_scoreZ[b] - p[2]};
+    FLOAT v[3] = {m_scoreX[c] - p[0], m_scoreY[c] - p[1], m_scoreZ[c] - p[2]};
+
+    // Normal of the sample plane
+    FLOAT n[3] = {u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0]};
+    FLOAT nn   = n[0] * n[0] + n[1] * n[1] + n[2] * n[2];
+    if (nn < 1.0e-10f)
+    {
+        return false;   // Collinear sample
+    }
+
+    // Circumcenter of the sample triangle: p + ((|u|^2 v - |v|^2 u) x n) / (2 |n|^2)
+    FLOAT uu   = u[0] * u[0] + u[1] * u[1] + u[2] * u[2];
+    FLOAT vv   = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+    FLOAT w[3] = {uu * v[0] - vv * u[0], uu * v[1] - vv * u[1], uu * v[2] - vv * u[2]};
+    FLOAT k    = 0.5f / nn;
+
+    FLOAT offset[3] = {(w[1] * n[2] - w[2] * n[1]) * k, (w[2] * n[0] - w[0] * n[2]) * k, (w[0] * n[1] - w[1] * n[0]) * k};
+    FLOAT rho2      = offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2];
+    FLOAT r2        = m_radius * m_radius;
+    if (rho2 > r2)
+    {
+        return false;   // Sample circle wider than the ball
+    }
+
+    // Two centers lie on the plane normal. The camera sees the front of the ball, so take the farther one
+    FLOAT h     = sqrtf((r2 - rho2) / nn);
+    FLOAT cc[3] = {p[0] + offset[0], p[1] + offset[1], p[2] + offset[2]};
+    FLOAT c1[3] = {cc[0] + n[0] * h, cc[1] + n[1] * h, cc[2] + n[2] * h};
+    FLOAT c2[3] = {cc[0] - n[0] * h, cc[1] - n[1] * h, cc[2] - n[2] * h};
+
+    bool first = (c1[0] * c1[0] + c1[1] * c1[1] + c1[2] * c1[2]) > (c2[0] * c2[0] + c2[1] * c2[1] + c2[2] * c2[2]);
+    const FLOAT* chosen = first ? c1 : c2;
+
+    center[0] = chosen[0];
+    center[1] = chosen[1];
+    center[2] = chosen[2];
+    return true;
+}
+
+/// <summary>
+/// Count points of the scoring set within tolerance of a sphere surface
+/// </summary>
+UINT SphereFitter::CountInliers(const FLOAT center[3]) const
+{
+    UINT inliers = 0;
+
+#ifdef NUI_USE_SSE2
+    static const BYTE bitCount[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+
+    const __m128 cx        = _mm_set1_ps(center[0]);
+    const __m128 cy        = _mm_set1_ps(center[1]);
+    const __m128 cz        = _mm_set1_ps(center[2]);
+    const __m128 radius    = _mm_set1_ps(m_radius);
+    const __m128 tolerance = _mm_set1_ps(m_tolerance);
+    const __m128 signMask  = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+    for (UINT i = 0; i < m_scoreCount; i += 4)
+    {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(&m_scoreX[i]), cx);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(&m_scoreY[i]), cy);
+        __m128 dz = _mm_sub_ps(_mm_loadu_ps(&m_scoreZ[i]), cz);
+
+        __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+        __m128 error    = _mm_and_ps(_mm_sub_ps(distance, radius), signMask);
+
+        inliers += bitCount[_mm_movemask_ps(_mm_cmplt_ps(error, tolerance))];
+    }
+#else
+    for (UINT i = 0; i < m_scoreCount; i++)
+    {
+        FLOAT dx = m_scoreX[i] - center[0];
+        FLOAT dy = m_scoreY[i] - center[1];
+        FLOAT dz = m_scoreZ[i] - center[2];
+
+        if (fabsf(sqrtf(dx * dx + dy * dy + dz * dz) - m_radius) < m_tolerance)
+        {
+            ++inliers;
+        }
+    }
+#endif
+
+    return inliers;
+}
+
+/// <summary>
+/// Refine a center by least squares over the inliers of an even subsample of the points
+/// </summary>
+/// <param name="center">Center to refine, receives the refined center</param>
+/// <param name="deadline">Time after which no further iteration starts</param>
+/// <param name="result">Receives the fit</param>
+void SphereFitter::Refine(FLOAT center[3], std::chrono::steady_clock::time_point deadline, SphereFit& result) const
+{
+    double c[3] = {center[0], center[1], center[2]};
+
+    // Every pass touches at most MAX_REFINE_POINTS points, the support is measured on the same ones
+    UINT stride  = (m_count + MAX_REFINE_POINTS - 1) / MAX_REFINE_POINTS;
+    UINT sampled = (m_count + stride - 1) / stride;
+
+    for (int iteration = 0; iteration < REFINE_ITERATIONS; iteration++)
+    {
+        // The first iteration always runs, a fit past the deadline still gets one correction
+        if (iteration > 0 && std::chrono::steady_clock::now() > deadline)
+        {
+            break;
+        }
+
+        // Gauss-Newton on r_i = |p_i - c| - radius. Jacobian row is (c - p_i) / |p_i - c|
+        double jtj[3][3] = {{0}};
+        double jtr[3]    = {0};
+        UINT   used      = 0;
+
+        for (UINT i = 0; i < m_count; i += stride)
+        {
+            double d[3] = {c[0] - m_pX[i], c[1] - m_pY[i], c[2] - m_pZ[i]};
+            double distance = sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+            double residual = distance - m_radius;
+
+            if (distance < 1.0e-9 || fabs(residual) > m_tolerance)
+            {
+                continue;
+            }
+
+            double j[3] = {d[0] / distance, d[1] / distance, d[2] / distance};
+            for (int r = 0; r < 3; r++)
+            {
+                for (int col = 0; col < 3; col++)
+                {
+                    jtj[r][col] += j[r] * j[col];
+                }
+                jtr[r] += j[r] * residual;
+            }
+            ++used;
+        }
+
+        if (used < MINIMUM_FIT_POINTS)
+        {
+            break;
+        }
+
+        // Solve jtj * delta = -jtr by Cramer's rule
+        double det = jtj[0][0] * (jtj[1][1] * jtj[2][2] - jtj[1][2] * jtj[2][1])
+                   - jtj[0][1] * (jtj[1][0] * jtj[2][2] - jtj[1][2] * jtj[2][0])
+                   + jtj[0][2] * (jtj[1][0] * jtj[2][1] - jtj[1][1] * jtj[2][0]);
+        if (fabs(det) < 1.0e-12)
+        {
+            break;
+        }
+
+        double delta[3];
+        for (int col = 0; col < 3; col++)
+        {
+            double m[3][3];
+            for (int r = 0; r < 3; r++)
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    m[r][k] = (k == col) ? -jtr[r] : jtj[r][k];
+                }
+            }
+
+            delta[col] = (m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+                        - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+                        + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0])) / det;
+        }
+
+        c[0] += delta[0];
+        c[1] += delta[1];
+        c[2] += delta[2];
+
+        if (delta[0] * delta[0] + delta[1] * delta[1] + delta[2] * delta[2] < 1.0e-10)
+        {
+            break;
+        }
+    }
+
+    // Final support and residual over the subsample
+    UINT   inliers = 0;
+    double sumSq   = 0.0;
+    for (UINT i = 0; i < m_count; i += stride)
+    {
+        double dx = m_pX[i] - c[0];
+        double dy = m_pY[i] - c[1];
+        double dz = m_pZ[i] - c[2];
+        double residual = sqrt(dx * dx + dy * dy + dz * dz) - m_radius;
+
+        if (fabs(residual) < m_tolerance)
+        {
+            ++inliers;
+            sumSq += residual * residual;
+        }
+    }
+
+    center[0] = (FLOAT)c[0];
+    center[1] = (FLOAT)c[1];
+    center[2] = (FLOAT)c[2];
+
+    result.center.x    = center[0];
+    result.center.y    = center[1];
+    result.center.z    = center[2];
+    result.center.w    = 1.0f;
+    result.inlierRatio = (FLOAT)inliers / sampled;
+    result.residual    = inliers ? (FLOAT)sqrt(sumSq / inliers) : 0.0f;
+}
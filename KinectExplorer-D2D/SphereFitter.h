@@ -0,0 +1,134 @@
+//------------------------------------------------------------------------------
+// <copyright file="SphereFitter.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+#include "NuiTypes.h"
+
+#define DEFAULT_BALL_RADIUS     0.3175f // Meters, the 25 inch game ball
+
+/// <summary>
+/// Result of fitting a sphere to a point set
+/// </summary>
+struct SphereFit
+{
+    bool    valid;
+    Vector4 center;         // Meters
+    FLOAT   inlierRatio;    // Fraction of points within tolerance of the surface, estimated on a subsample of large sets
+    FLOAT   residual;       // RMS distance of inliers to the surface, meters
+    UINT    iterations;     // RANSAC hypotheses evaluated
+};
+
+/// <summary>
+/// Fits a sphere of known radius to the visible surface points of a ball candidate.
+/// RANSAC draws three points, solves for the center behind the surface, and scores
+/// hypotheses four points at a time. Sampling stops as soon as the expected number
+/// of hypotheses is reached or the time budget runs out. The best hypothesis is then
+/// refined by Gauss-Newton least squares on the inliers of a bounded subsample, with
+/// the deadline checked between iterations, so large blobs stay within the budget.
+/// </summary>
+class SphereFitter
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    SphereFitter();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~SphereFitter();
+
+public:
+    /// <summary>
+    /// Fit a sphere to points given as separate coordinate arrays
+    /// </summary>
+    /// <param name="pX">X coordinates in meters</param>
+    /// <param name="pY">Y coordinates in meters</param>
+    /// <param name="pZ">Z coordinates in meters</param>
+    /// <param name="count">Number of points</param>
+    /// <param name="result">Receives the fit</param>
+    /// <returns>True if a sphere with enough support was found</returns>
+    bool Fit(const FLOAT* pX, const FLOAT* pY, const FLOAT* pZ, UINT count, SphereFit& result);
+
+    /// <summary>
+    /// Set the known sphere radius
+    /// </summary>
+    /// <param name="radius">Radius in meters</param>
+    void SetRadius(FLOAT radius);
+
+    /// <summary>
+    /// Get the known sphere radius
+    /// </summary>
+    FLOAT GetRadius() const
+    {
+        return m_radius;
+    }
+
+    /// <summary>
+    /// Set the largest distance from the surface for a point to be an inlier
+    /// </summary>
+    /// <param name="tolerance">Distance in meters</param>
+    void SetInlierTolerance(FLOAT tolerance);
+
+    /// <summary>
+    /// Set the time budget of a single fit
+    /// </summary>
+    /// <param name="microseconds">Budget in microseconds</param>
+    void SetTimeBudget(UINT microseconds);
+
+    /// <summary>
+    /// Set the smallest inlier ratio of an accepted fit
+    /// </summary>
+    /// <param name="ratio">Ratio between 0 and 1</param>
+    void SetMinimumInlierRatio(FLOAT ratio);
+
+private:
+    /// <summary>
+    /// Compute the center of a sphere with the known radius through three points
+    /// </summary>
+    /// <returns>False if the points do not fit on such a sphere</returns>
+    bool CenterFromSample(UINT a, UINT b, UINT c, FLOAT center[3]) const;
+
+    /// <summary>
+    /// Count points of the scoring set within tolerance of a sphere surface
+    /// </summary>
+    UINT CountInliers(const FLOAT center[3]) const;
+
+    /// <summary>
+    /// Refine a center by least squares over the inliers of an even subsample of the points
+    /// </summary>
+    /// <param name="center">Center to refine, receives the refined center</param>
+    /// <param name="deadline">Time after which no further iteration starts</param>
+    /// <param name="result">Receives the fit</param>
+    void Refine(FLOAT center[3], std::chrono::steady_clock::time_point deadline, SphereFit& result) const;
+
+    /// <summary>
+    /// Draw a random index below a bound
+    /// </summary>
+    UINT NextRandom(UINT bound);
+
+private:
+    FLOAT   m_radius;
+    FLOAT   m_tolerance;
+    FLOAT   m_minimumInlierRatio;
+    UINT    m_timeBudget;
+    UINT    m_randomState;
+
+    const FLOAT*        m_pX;
+    const FLOAT*        m_pY;
+    const FLOAT*        m_pZ;
+    UINT                m_count;
+
+    // Evenly subsampled copy of the points used to score hypotheses, padded to a multiple of four
+    std::vector<FLOAT>  m_scoreX;
+    std::vector<FLOAT>  m_scoreY;
+    std::vector<FLOAT>  m_scoreZ;
+    UINT                m_scoreCount;
+};
@@ -0,0 +1,386 @@
+//------------------------------------------------------------------------------
+// <copyright file="TcpSocket.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+// Winsock 2 must come before anything that pulls in windows.h and with it winsock 1
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#define CloseSocket         closesocket
+#define SOCKET_WOULD_BLOCK  (WSAEWOULDBLOCK == WSAGetLastError())
+#define SEND_FLAGS          0
+typedef SOCKET NativeSocket;
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define CloseSocket         close
+#define SOCKET_WOULD_BLOCK  (EAGAIN == errno || EWOULDBLOCK == errno)
+#define SEND_FLAGS          MSG_NOSIGNAL    // A closed peer fails the call instead of raising SIGPIPE
+typedef int NativeSocket;
+#endif
+
+#include <chrono>
+#include "TcpSocket.h"
+
+#define INVALID_SOCKET_VALUE    ((intptr_t)-1)
+#define LISTEN_BACKLOG          4
+
+/// <summary>
+/// Constructor
+/// </summary>
+TcpSocket::TcpSocket()
+    : m_socket(INVALID_SOCKET_VALUE)
+    , m_open(false)
+    , m_started(false)
+{
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+TcpSocket::~TcpSocket()
+{
+    Close();
+}
+
+/// <summary>
+/// Close the socket and start Winsock for a new one
+/// </summary>
+HRESULT TcpSocket::Startup()
+{
+    Close();
+
+#ifdef _WIN32
+    WSADATA data;
+    if (0 != WSAStartup(MAKEWORD(2, 2), &data))
+    {
+        return E_FAIL;
+    }
+    m_started = true;
+#endif
+
+    return S_OK;
+}
+
+/// <summary>
+/// Take a native socket and make it non-blocking
+/// </summary>
+HRESULT TcpSocket::Attach(intptr_t socket)
+{
+    m_socket = socket;
+
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    if (0 != ioctlsocket((NativeSocket)socket, FIONBIO, &nonBlocking))
+    {
+        Close();
+        return E_FAIL;
+    }
+#else
+    if (fcntl((NativeSocket)socket, F_SETFL, fcntl((NativeSocket)socket, F_GETFL, 0) | O_NONBLOCK) < 0)
+    {
+        Close();
+        return E_FAIL;
+    }
+#endif
+
+    m_open = true;
+    return S_OK;
+}
+
+/// <summary>
+/// Create a socket which listens on a local address and port
+/// </summary>
+/// <param name="address">Local IPv4 address in dotted form, 127.0.0.1 to accept only this machine</param>
+/// <param name="port">Local port</param>
+/// <returns>Indicates success or failure</returns>
+HRESULT TcpSocket::Listen(const char* address, USHORT port)
+{
+    HRESULT hr = Startup();
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    NativeSocket s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+#ifdef _WIN32
+    if (INVALID_SOCKET == s)
+#else
+    if (s < 0)
+#endif
+    {
+        Close();
+        return E_FAIL;
+    }
+
+    hr = Attach((intptr_t)s);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+#ifdef _WIN32
+    // No other process may bind the same port and take over the connections
+    int exclusive = 1;
+    setsockopt(s, SOL_SOCKET, SO_EXCLUSIVEADDRUSE, (const char*)&exclusive, sizeof(exclusive));
+#endif
+
+    sockaddr_in local;
+    ZeroMemory(&local, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_port   = htons(port);
+
+    if (!address || 1 != inet_pton(AF_INET, address, &local.sin_addr) ||
+        0 != bind(s, (const sockaddr*)&local, sizeof(local)) || 0 != listen(s, LISTEN_BACKLOG))
+    {
+        Close();
+        return E_FAIL;
+    }
+
+    return S_OK;
+}
+
+/// <summary>
+/// Connect to a listening socket
+/// </summary>
+/// <param name="address">Remote IPv4 address in dotted form</param>
+/// <param name="port">Remote port</param>
+/// <param name="timeout">Longest wait in milliseconds</param>
+/// <returns>S_OK if connected, or a failure code</returns>
+HRESULT TcpSocket::Connect(const char* address, USHORT port, UINT timeout)
+{
+    HRESULT hr = Startup();
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    NativeSocket s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+#ifdef _WIN32
+    if (INVALID_SOCKET == s)
+#else
+    if (s < 0)
+#endif
+    {
+        Close();
+        return E_FAIL;
+    }
+
+    hr = Attach((intptr_t)s);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    sockaddr_in remote;
+    ZeroMemory(&remote, sizeof(remote));
+    remote.sin_family = AF_INET;
+    remote.sin_port   = htons(port);
+
+    if (!address || 1 != inet_pton(AF_INET, address, &remote.sin_addr))
+    {
+        Close();
+        return E_FAIL;
+    }
+
+    if (0 != connect(s, (const sockaddr*)&remote, sizeof(remote)))
+    {
+        // The socket is non-blocking, so the connection completes once it turns writable
+#ifdef _WIN32
+        bool pending = SOCKET_WOULD_BLOCK;
+#else
+        bool pending = EINPROGRESS == errno;
+#endif
+        int       error  = 0;
+        socklen_t length = sizeof(error);
+
+        if (!pending || S_OK != Wait(true, timeout) ||
+            0 != getsockopt(s, SOL_SOCKET, SO_ERROR, (char*)&error, &length) || 0 != error)
+        {
+            Close();
+            return E_FAIL;
+        }
+    }
+
+    int noDelay = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+
+    return S_OK;
+}
+
+/// <summary>
+/// Accept a connection on a listening socket
+/// </summary>
+/// <param name="connection">Receives the connection</param>
+/// <param name="timeout">Longest wait in milliseconds</param>
+/// <returns>S_OK if a connection was accepted, S_FALSE on timeout, or a failure code</returns>
+HRESULT TcpSocket::Accept(TcpSocket& connection, UINT timeout)
+{
+    HRESULT hr = Wait(false, timeout);
+    if (S_OK != hr)
+    {
+        return hr;
+    }
+
+    hr = connection.Startup();
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    NativeSocket s = accept((NativeSocket)m_socket, nullptr, nullptr);
+#ifdef _WIN32
+    if (INVALID_SOCKET == s)
+#else
+    if (s < 0)
+#endif
+    {
+        connection.Close();
+        return SOCKET_WOULD_BLOCK ? S_FALSE : E_FAIL;
+    }
+
+    // Frames go out as soon as they are written
+    int noDelay = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+
+    return connection.Attach((intptr_t)s);
+}
+
+/// <summary>
+/// Close the socket
+/// </summary>
+void TcpSocket::Close()
+{
+    if (INVALID_SOCKET_VALUE != m_socket)
+    {
+        CloseSocket((NativeSocket)m_socket);
+        m_socket = INVALID_SOCKET_VALUE;
+    }
+
+#ifdef _WIN32
+    if (m_started)
+    {
+        WSACleanup();
+    }
+#endif
+
+    m_started = false;
+    m_open    = false;
+}
+
+/// <summary>
+/// Wait until the socket is readable or writable
+/// </summary>
+/// <returns>S_OK if ready, S_FALSE on timeout, or a failure code</returns>
+HRESULT TcpSocket::Wait(bool write, UINT timeout)
+{
+    if (!m_open)
+    {
+        return E_FAIL;
+    }
+
+    fd_set ready;
+    FD_ZERO(&ready);
+    FD_SET((NativeSocket)m_socket, &ready);
+
+    timeval wait;
+    wait.tv_sec  = timeout / 1000;
+    wait.tv_usec = (timeout % 1000) * 1000;
+
+    int count = select((int)m_socket + 1, write ? nullptr : &ready, write ? &ready : nullptr, nullptr, &wait);
+    if (count < 0)
+    {
+        return E_FAIL;
+    }
+
+    return 0 == count ? S_FALSE : S_OK;
+}
+
+/// <summary>
+/// Send all bytes of a buffer
+/// </summary>
+/// <param name="pData">The pointer to bytes to send</param>
+/// <param name="size">Number of bytes to send</param>
+/// <param name="timeout">Longest wait in milliseconds</param>
+/// <returns>S_OK if all bytes were sent, S_FALSE if only part was sent before the timeout, or a failure code</returns>
+HRESULT TcpSocket::Send(const void* pData, UINT size, UINT timeout)
+{
+    if (!m_open)
+    {
+        return E_FAIL;
+    }
+
+    const char* pBytes   = (const char*)pData;
+    auto        deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+
+    while (size > 0)
+    {
+        int sent = (int)send((NativeSocket)m_socket, pBytes, size, SEND_FLAGS);
+        if (sent > 0)
+        {
+            pBytes += sent;
+            size   -= (UINT)sent;
+            continue;
+        }
+
+        if (sent < 0 && !SOCKET_WOULD_BLOCK)
+        {
+            return E_FAIL;
+        }
+
+        // The send buffer is full, wait for the peer to take some of it
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+        {
+            return S_FALSE;
+        }
+
+        HRESULT hr = Wait(true, (UINT)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count() + 1);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+    }
+
+    return S_OK;
+}
+
+/// <summary>
+/// Receive the bytes which arrived
+/// </summary>
+/// <param name="pBuffer">The pointer to buffer receiving the bytes</param>
+/// <param name="capacity">Size of the buffer in bytes</param>
+/// <param name="timeout">Longest wait in milliseconds</param>
+/// <param name="size">Receives number of bytes received</param>
+/// <returns>S_OK if bytes arrived, S_FALSE on timeout, or a failure code if the connection was closed</returns>
+HRESULT TcpSocket::Receive(void* pBuffer, UINT capacity, UINT timeout, UINT& size)
+{
+    size = 0;
+
+    HRESULT hr = Wait(false, timeout);
+    if (S_OK != hr)
+    {
+        return hr;
+    }
+
+    int received = (int)recv((NativeSocket)m_socket, (char*)pBuffer, capacity, 0);
+    if (received < 0)
+    {
+        return SOCKET_WOULD_BLOCK ? S_FALSE : E_FAIL;
+    }
+    if (0 == received)
+    {
+        return E_FAIL;
+    }
+
+    size = (UINT)received;
+    return S_OK;
+}
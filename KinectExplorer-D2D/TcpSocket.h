@@ -0,0 +1,109 @@
+//------------------------------------------------------------------------------
+// <copyright file="TcpSocket.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include "NuiTypes.h"
+
+/// <summary>
+/// Non-blocking IPv4 TCP socket on Winsock or BSD sockets, either a listener or an
+/// accepted connection. Every call waits at most its timeout, so a stalled peer
+/// cannot hold up the thread serving the other connections.
+/// </summary>
+class TcpSocket
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    TcpSocket();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~TcpSocket();
+
+public:
+    /// <summary>
+    /// Create a socket which listens on a local address and port
+    /// </summary>
+    /// <param name="address">Local IPv4 address in dotted form, 127.0.0.1 to accept only this machine</param>
+    /// <param name="port">Local port</param>
+    /// <returns>Indicates success or failure</returns>
+    HRESULT Listen(const char* address, USHORT port);
+
+    /// <summary>
+    /// Connect to a listening socket
+    /// </summary>
+    /// <param name="address">Remote IPv4 address in dotted form</param>
+    /// <param name="port">Remote port</param>
+    /// <param name="timeout">Longest wait in milliseconds</param>
+    /// <returns>S_OK if connected, or a failure code</returns>
+    HRESULT Connect(const char* address, USHORT port, UINT timeout);
+
+    /// <summary>
+    /// Accept a connection on a listening socket
+    /// </summary>
+    /// <param name="connection">Receives the connection</param>
+    /// <param name="timeout">Longest wait in milliseconds</param>
+    /// <returns>S_OK if a connection was accepted, S_FALSE on timeout, or a failure code</returns>
+    HRESULT Accept(TcpSocket& connection, UINT timeout);
+
+    /// <summary>
+    /// Close the socket
+    /// </summary>
+    void Close();
+
+    /// <summary>
+    /// Indicates whether the socket is open
+    /// </summary>
+    bool IsOpen() const
+    {
+        return m_open;
+    }
+
+    /// <summary>
+    /// Send all bytes of a buffer
+    /// </summary>
+    /// <param name="pData">The pointer to bytes to send</param>
+    /// <param name="size">Number of bytes to send</param>
+    /// <param name="timeout">Longest wait in milliseconds</param>
+    /// <returns>S_OK if all bytes were sent, S_FALSE if only part was sent before the timeout, or a failure code</returns>
+    HRESULT Send(const void* pData, UINT size, UINT timeout);
+
+    /// <summary>
+    /// Receive the bytes which arrived
+    /// </summary>
+    /// <param name="pBuffer">The pointer to buffer receiving the bytes</param>
+    /// <param name="capacity">Size of the buffer in bytes</param>
+    /// <param name="timeout">Longest wait in milliseconds</param>
+    /// <param name="size">Receives number of bytes received</param>
+    /// <returns>S_OK if bytes arrived, S_FALSE on timeout, or a failure code if the connection was closed</returns>
+    HRESULT Receive(void* pBuffer, UINT capacity, UINT timeout, UINT& size);
+
+private:
+    /// <summary>
+    /// Close the socket and start Winsock for a new one
+    /// </summary>
+    HRESULT Startup();
+
+    /// <summary>
+    /// Take a native socket and make it non-blocking
+    /// </summary>
+    HRESULT Attach(intptr_t socket);
+
+    /// <summary>
+    /// Wait until the socket is readable or writable
+    /// </summary>
+    /// <returns>S_OK if ready, S_FALSE on timeout, or a failure code</returns>
+    HRESULT Wait(bool write, UINT timeout);
+
+private:
+    intptr_t    m_socket;           // SOCKET on Windows, file descriptor elsewhere
+    bool        m_open;
+    bool        m_started;          // True if Winsock was started for this socket
+};
@@ -0,0 +1,187 @@
+//------------------------------------------------------------------------------
+// <copyright file="AssignmentSolverTest.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "TestCheck.h"
+#include "AssignmentSolver.h"
+#include <algorithm>
+#include <vector>
+
+#define RANDOM_TRIALS   300
+#define MAX_SIZE        6
+#define UNASSIGNED_COST 50.0f
+
+/// <summary>
+/// Small deterministic generator, so failures reproduce
+/// </summary>
+static UINT NextRandom(UINT& state)
+{
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+/// <summary>
+/// Total cost of an assignment as the solver minimizes it. Every row or column of the
+/// larger side left without a partner costs the unassigned cost
+/// </summary>
+static FLOAT TotalCost(const std::vector<FLOAT>& cost, UINT rows, UINT columns, const std::vector<int>& rowToColumn)
+{
+    FLOAT total    = 0.0f;
+    UINT  assigned = 0;
+    for (UINT row = 0; row < rows; row++)
+    {
+        if (UNASSIGNED != rowToColumn[row])
+        {
+            total += cost[row * columns + rowToColumn[row]];
+            assigned++;
+        }
+    }
+
+    UINT larger = rows > columns ? rows : columns;
+    return total + (larger - assigned) * UNASSIGNED_COST;
+}
+
+/// <summary>
+/// Lowest total cost by trying every assignment of rows to columns or to nothing
+/// </summary>
+static FLOAT BruteForce(const std::vector<FLOAT>& cost, UINT rows, UINT columns, std::vector<int>& rowToColumn, UINT row, std::vector<bool>& used)
+{
+    if (row == rows)
+    {
+        return TotalCost(cost, rows, columns, rowToColumn);
+    }
+
+    rowToColumn[row] = UNASSIGNED;
+    FLOAT best = BruteForce(cost, rows, columns, rowToColumn, row + 1, used);
+
+    for (UINT column = 0; column < columns; column++)
+    {
+        if (used[column] || cost[row * columns + column] >= UNASSIGNED_COST)
+        {
+            continue;
+        }
+        used[column] = true;
+        rowToColumn[row] = (int)column;
+        best = std::min(best, BruteForce(cost, rows, columns, rowToColumn, row + 1, used));
+        used[column] = false;
+    }
+
+    rowToColumn[row] = UNASSIGNED;
+    return best;
+}
+
+/// <summary>
+/// Check that a result is a valid matching which respects the unassigned cost
+/// </summary>
+static void CheckValid(const std::vector<FLOAT>& cost, UINT rows, UINT columns, const std::vector<int>& rowToColumn, UINT assigned)
+{
+    CHECK(rowToColumn.size() == rows);
+
+    std::vector<bool> used(columns, false);
+    UINT count = 0;
+    for (UINT row = 0; row < rows; row++)
+    {
+        int column = rowToColumn[row];
+        if (UNASSIGNED == column)
+        {
+            continue;
+        }
+
+        CHECK(column >= 0 && (UINT)column < columns);
+        if (column < 0 || (UINT)column >= columns)
+        {
+            continue;
+        }
+        CHECK(!used[column]);
+        CHECK(cost[row * columns + column] < UNASSIGNED_COST);
+        used[column] = true;
+        count++;
+    }
+    CHECK(count == assigned);
+}
+
+/// <summary>
+/// A known problem where the greedy choice is wrong
+/// </summary>
+static void TestKnown()
+{
+    const FLOAT cost[] =
+    {
+        1.0f, 2.0f, 9.0f,
+        2.0f, 9.0f, 9.0f,
+        9.0f, 9.0f, 3.0f,
+    };
+
+    AssignmentSolver solver;
+    std::vector<int> rowToColumn;
+    CHECK(3 == solver.Solve(cost, 3, 3, UNASSIGNED_COST, rowToColumn));
+    CHECK(1 == rowToColumn[0]);
+    CHECK(0 == rowToColumn[1]);
+    CHECK(2 == rowToColumn[2]);
+}
+
+/// <summary>
+/// Pairs at or above the unassigned cost are never made, and empty problems are fine
+/// </summary>
+static void TestGating()
+{
+    const FLOAT cost[] =
+    {
+        UNASSIGNED_COST, 4.0f,
+        UNASSIGNED_COST * 2.0f, UNASSIGNED_COST,
+    };
+
+    AssignmentSolver solver;
+    std::vector<int> rowToColumn;
+    CHECK(1 == solver.Solve(cost, 2, 2, UNASSIGNED_COST, rowToColumn));
+    CHECK(1 == rowToColumn[0]);
+    CHECK(UNASSIGNED == rowToColumn[1]);
+
+    CHECK(0 == solver.Solve(cost, 0, 2, UNASSIGNED_COST, rowToColumn));
+    CHECK(rowToColumn.empty());
+
+    CHECK(0 == solver.Solve(cost, 2, 0, UNASSIGNED_COST, rowToColumn));
+    CHECK(2 == rowToColumn.size() && UNASSIGNED == rowToColumn[0] && UNASSIGNED == rowToColumn[1]);
+}
+
+/// <summary>
+/// Random rectangular problems reach the brute force optimum, reusing one solver
+/// </summary>
+static void TestRandom()
+{
+    AssignmentSolver solver;
+    UINT state = 12345;
+
+    for (UINT trial = 0; trial < RANDOM_TRIALS; trial++)
+    {
+        UINT rows    = 1 + NextRandom(state) % MAX_SIZE;
+        UINT columns = 1 + NextRandom(state) % MAX_SIZE;
+
+        std::vector<FLOAT> cost(rows * columns);
+        for (size_t i = 0; i < cost.size(); i++)
+        {
+            // Some pairs are gated out, the rest cost less than leaving both unassigned
+            cost[i] = (0 == NextRandom(state) % 4) ? UNASSIGNED_COST * 3.0f : (FLOAT)(NextRandom(state) % 1000) / 10.0f;
+        }
+
+        std::vector<int> rowToColumn;
+        UINT assigned = solver.Solve(&cost[0], rows, columns, UNASSIGNED_COST, rowToColumn);
+        CheckValid(cost, rows, columns, rowToColumn, assigned);
+
+        std::vector<int>  bestRows(rows, UNASSIGNED);
+        std::vector<bool> used(columns, false);
+        FLOAT best = BruteForce(cost, rows, columns, bestRows, 0, used);
+        CHECK_NEAR(TotalCost(cost, rows, columns, rowToColumn), best, 1e-3);
+    }
+}
+
+int main()
+{
+    TestKnown();
+    TestGating();
+    TestRandom();
+
+    return TestResult("AssignmentSolverTest");
+}
@@ -0,0 +1,212 @@
+//------------------------------------------------------------------------------
+// <copyright file="BallTrackerTest.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "TestCheck.h"
+#include "BallTracker.h"
+#include <vector>
+
+#define WIDTH               640
+#define HEIGHT              480
+#define BALL_RADIUS         0.3175f     // Meters
+#define BACKGROUND_DEPTH    4000        // Millimeters
+#define FRAME_COUNT         45
+#define FRAME_INTERVAL      33          // Milliseconds
+#define BALL_COUNT          3
+#define OCCLUDED_BALL       2
+#define OCCLUDED_FIRST      20          // The occluded ball is missing from this frame
+#define OCCLUDED_LAST       23          // up to this frame
+#define POSITION_TOLERANCE  0.05f       // Meters
+#define VELOCITY_TOLERANCE  0.2f        // Meters per second
+#define CONFIRMATION_FRAMES 3           // Frames before tracks must be confirmed
+
+/// <summary>
+/// Center of a ball at a time. Ball 0 is thrown across, ball 1 rolls the other way
+/// behind it and crosses its path, ball 2 stands still and is hidden for a few frames
+/// </summary>
+static Vector4 BallCenter(UINT ball, FLOAT seconds)
+{
+    Vector4 center = { 0.0f, 0.0f, 0.0f, 1.0f };
+    switch (ball)
+    {
+    case 0:
+        center.x = -1.2f + 1.6f * seconds;
+        center.y = 0.6f + 1.0f * seconds - 1.47f * seconds * seconds;
+        center.z = 3.0f;
+        break;
+
+    case 1:
+        center.x = 1.2f - 1.6f * seconds;
+        center.z = 3.8f;
+        break;
+
+    default:
+        center.y = -0.8f;
+        center.z = 2.5f;
+        break;
+    }
+    return center;
+}
+
+/// <summary>
+/// Ray trace the visible balls into a depth frame and a foreground mask
+/// </summary>
+static void Render(const std::vector<Vector4>& balls, std::vector<NUI_DEPTH_IMAGE_PIXEL>& depth, PackedBitmask& mask)
+{
+    const FLOAT focal = WIDTH / (320.0f * NUI_CAMERA_DEPTH_NOMINAL_INVERSE_FOCAL_LENGTH_IN_PIXELS);
+
+    mask.Clear();
+    for (UINT y = 0; y < HEIGHT; y++)
+    {
+        for (UINT x = 0; x < WIDTH; x++)
+        {
+            FLOAT rayX = (x - WIDTH / 2.0f) / focal;
+            FLOAT rayY = -(y - HEIGHT / 2.0f) / focal;
+            FLOAT nearest = 0.0f;
+
+            for (size_t i = 0; i < balls.size(); i++)
+            {
+                const Vector4& c = balls[i];
+                FLOAT a = rayX * rayX + rayY * rayY + 1.0f;
+                FLOAT b = -2.0f * (rayX * c.x + rayY * c.y + c.z);
+                FLOAT d = b * b - 4.0f * a * (c.x * c.x + c.y * c.y + c.z * c.z - BALL_RADIUS * BALL_RADIUS);
+                if (d > 0.0f)
+                {
+                    FLOAT t = (-b - sqrtf(d)) / (2.0f * a);
+                    if (0.0f == nearest || t < nearest)
+                    {
+                        nearest = t;
+                    }
+                }
+            }
+
+            NUI_DEPTH_IMAGE_PIXEL& pixel = depth[y * WIDTH + x];
+            pixel.playerIndex = 0;
+            pixel.depth       = nearest > 0.0f ? (USHORT)(nearest * 1000.0f + 0.5f) : BACKGROUND_DEPTH;
+            if (nearest > 0.0f)
+            {
+                mask.Set(x, y);
+            }
+        }
+    }
+}
+
+int main()
+{
+    BallDetector detector;
+    detector.SetResolution(NUI_IMAGE_RESOLUTION_640x480);
+    detector.SetBallRadius(BALL_RADIUS);
+
+    BallTracker tracker;
+    std::vector<NUI_DEPTH_IMAGE_PIXEL> depth(WIDTH * HEIGHT);
+    PackedBitmask mask;
+    mask.Resize(WIDTH, HEIGHT);
+
+    UINT ballToId[BALL_COUNT] = { 0 };
+    UINT windowedFrames = 0;
+
+    for (UINT frame = 0; frame < FRAME_COUNT; frame++)
+    {
+        FLOAT seconds = frame * FRAME_INTERVAL / 1000.0f;
+        bool  hidden  = frame >= OCCLUDED_FIRST && frame <= OCCLUDED_LAST;
+
+        std::vector<Vector4> balls;
+        for (UINT ball = 0; ball < BALL_COUNT; ball++)
+        {
+            if (!(hidden && OCCLUDED_BALL == ball))
+            {
+                balls.push_back(BallCenter(ball, seconds));
+            }
+        }
+
+        Render(balls, depth, mask);
+        tracker.Update(detector, mask, &depth[0], 1000 + frame * FRAME_INTERVAL);
+
+        const BallTrackerMetrics& metrics = tracker.GetMetrics();
+        if (!metrics.fullFrame)
+        {
+            windowedFrames++;
+
+            // Overlapping windows of crossing balls are counted once
+            CHECK(metrics.pixelsProcessed > 0);
+            CHECK(metrics.pixelsProcessed <= metrics.pixelsTotal);
+        }
+
+        // Tracks are confirmed after a few hits and then follow the same ball for good
+        const std::vector<BallTrack>& tracks = tracker.GetTracks();
+        if (frame < CONFIRMATION_FRAMES)
+        {
+            continue;
+        }
+
+        UINT confirmed = 0;
+        for (size_t i = 0; i < tracks.size(); i++)
+        {
+            const BallTrack& track = tracks[i];
+            if (!track.confirmed)
+            {
+                continue;
+            }
+            confirmed++;
+
+            // Match the track to the closest true ball
+            UINT  nearestBall     = 0;
+            FLOAT nearestDistance = 0.0f;
+            for (UINT ball = 0; ball < BALL_COUNT; ball++)
+            {
+                Vector4 c  = BallCenter(ball, seconds);
+                FLOAT   dx = track.state[0][0] - c.x;
+                FLOAT   dy = track.state[1][0] - c.y;
+                FLOAT   dz = track.state[2][0] - c.z;
+                FLOAT   distance = sqrtf(dx * dx + dy * dy + dz * dz);
+                if (0 == ball || distance < nearestDistance)
+                {
+                    nearestBall     = ball;
+                    nearestDistance = distance;
+                }
+            }
+
+            CHECK(nearestDistance < POSITION_TOLERANCE);
+            CHECK(0 != track.id);
+            if (0 == ballToId[nearestBall])
+            {
+                ballToId[nearestBall] = track.id;
+            }
+            CHECK(ballToId[nearestBall] == track.id);
+
+            // The hidden ball coasts on its prediction instead of being dropped
+            if (OCCLUDED_BALL == nearestBall)
+            {
+                CHECK(track.updated == !hidden);
+            }
+        }
+        CHECK(BALL_COUNT == confirmed);
+    }
+
+    // Distinct balls keep distinct IDs
+    CHECK(ballToId[0] != ballToId[1] && ballToId[1] != ballToId[2] && ballToId[0] != ballToId[2]);
+
+    // The filter estimates velocity from positions alone
+    const FLOAT seconds = (FRAME_COUNT - 1) * FRAME_INTERVAL / 1000.0f;
+    const std::vector<BallTrack>& tracks = tracker.GetTracks();
+    for (size_t i = 0; i < tracks.size(); i++)
+    {
+        if (tracks[i].id == ballToId[0])
+        {
+            CHECK_NEAR(tracks[i].state[0][1], 1.6f, VELOCITY_TOLERANCE);
+            CHECK_NEAR(tracks[i].state[1][1], 1.0f - 2.94f * seconds, VELOCITY_TOLERANCE * 2.0f);
+        }
+        else if (tracks[i].id == ballToId[1])
+        {
+            CHECK_NEAR(tracks[i].state[0][1], -1.6f, VELOCITY_TOLERANCE);
+            CHECK_NEAR(tracks[i].state[1][1], 0.0f, VELOCITY_TOLERANCE);
+        }
+    }
+
+    // Most frames are searched only around the predicted balls
+    CHECK(windowedFrames > FRAME_COUNT / 2);
+
+    return TestResult("BallTrackerTest");
+}
@@ -0,0 +1,89 @@
+//------------------------------------------------------------------------------
+// <copyright file="ColorClassTableTest.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "TestCheck.h"
+#include "ColorClassTable.h"
+#include <stdio.h>
+
+#define TABLE_FILE  "ColorClassTableTest.bin"
+#define BALL_CLASS  0
+#define FIELD_CLASS 2
+
+/// <summary>
+/// Make a BGRX pixel
+/// </summary>
+static UINT Pixel(BYTE red, BYTE green, BYTE blue)
+{
+    return 0xFF000000u | ((UINT)red << 16) | ((UINT)green << 8) | blue;
+}
+
+/// <summary>
+/// Hue ranges, including one wrapping through red, select the saturated bright colors only
+/// </summary>
+static void TestRange()
+{
+    ColorClassTable table;
+    CHECK(table.AddRange(BALL_CLASS, 340.0f, 20.0f, 0.45f, 0.2f) > 0);
+    CHECK(table.AddRange(BALL_CLASS, 200.0f, 250.0f, 0.45f, 0.2f) > 0);
+    CHECK(0 == table.AddRange(COLOR_CLASS_COUNT, 0.0f, 360.0f, 0.0f, 0.0f));
+
+    const BYTE ball = 1 << BALL_CLASS;
+    CHECK(ball == table.Lookup(Pixel(220, 30, 30)));    // Red
+    CHECK(ball == table.Lookup(Pixel(200, 20, 60)));    // Crimson, across zero hue
+    CHECK(ball == table.Lookup(Pixel(30, 60, 200)));    // Blue
+    CHECK(0 == table.Lookup(Pixel(30, 200, 30)));       // Green
+    CHECK(0 == table.Lookup(Pixel(230, 200, 40)));      // Yellow
+    CHECK(0 == table.Lookup(Pixel(128, 120, 120)));     // Gray, not saturated
+    CHECK(0 == table.Lookup(Pixel(30, 4, 4)));          // Too dark
+    CHECK(0 == table.Lookup(Pixel(0, 0, 0)));
+
+    // A second class shares bins instead of replacing the first
+    table.AddRange(FIELD_CLASS, 0.0f, 360.0f, 0.0f, 0.0f);
+    CHECK((ball | (1 << FIELD_CLASS)) == table.Lookup(Pixel(220, 30, 30)));
+}
+
+/// <summary>
+/// Trained bins take the majority class, mixed bins stay empty, and the table survives a save and load
+/// </summary>
+static void TestTraining()
+{
+    ColorClassTable table;
+    for (UINT i = 0; i < 20; i++)
+    {
+        table.AddSample(Pixel(200, 100, 50), BALL_CLASS);
+        table.AddSample(Pixel(40, 160, 40), FIELD_CLASS);
+        table.AddSample(Pixel(90, 90, 200), i % 2 ? BALL_CLASS : COLOR_CLASS_NONE);
+    }
+    table.AddSample(Pixel(10, 10, 10), BALL_CLASS);
+
+    CHECK(2 == table.Build(5, 0.8f));
+    CHECK((1 << BALL_CLASS) == table.Lookup(Pixel(200, 100, 50)));
+    CHECK((1 << FIELD_CLASS) == table.Lookup(Pixel(40, 160, 40)));
+    CHECK(0 == table.Lookup(Pixel(90, 90, 200)));
+    CHECK(0 == table.Lookup(Pixel(10, 10, 10)));
+
+    CHECK(SUCCEEDED(table.Save(TABLE_FILE)));
+    ColorClassTable loaded;
+    CHECK(SUCCEEDED(loaded.Load(TABLE_FILE)));
+    remove(TABLE_FILE);
+
+    for (UINT bin = 0; bin < COLOR_TABLE_SIZE; bin++)
+    {
+        if (table.GetBins()[bin] != loaded.GetBins()[bin])
+        {
+            CHECK(table.GetBins()[bin] == loaded.GetBins()[bin]);
+            break;
+        }
+    }
+}
+
+int main()
+{
+    TestRange();
+    TestTraining();
+
+    return TestResult("ColorClassTableTest");
+}
@@ -0,0 +1,36 @@
+//------------------------------------------------------------------------------
+// <copyright file="DepthFilterScalar.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+// The depth filters compiled a second time without their SSE2 loops, inside namespace
+// Scalar, so DepthFilterTest can run both paths on the same frames in one process.
+// The headers the filter sources include come first and stay outside the namespace.
+
+#include <algorithm>
+#include "DepthFilterScalar.h"
+
+#undef NUI_USE_SSE2
+
+namespace Scalar
+{
+#include "DepthTemporalFilter.cpp"
+#include "DepthPrefilter.cpp"
+}
+
+/// <summary>
+/// Run the scalar prefilter over a sequence of 640x480 frames in place
+/// </summary>
+void ScalarPrefilterFrames(DepthFrames& frames, bool holeFill, bool flyingPixelRemoval, bool temporal)
+{
+    PrefilterFrames<Scalar::DepthPrefilter, Scalar::DepthTemporalFilter>(frames, holeFill, flyingPixelRemoval, temporal);
+}
+
+/// <summary>
+/// Run the scalar temporal filter alone over a sequence of frames in place
+/// </summary>
+void ScalarTemporalFilterFrames(DepthFrames& frames, UINT width, UINT height)
+{
+    TemporalFilterFrames<Scalar::DepthTemporalFilter>(frames, width, height);
+}
@@ -0,0 +1,55 @@
+//------------------------------------------------------------------------------
+// <copyright file="DepthFilterScalar.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include "NuiTypes.h"
+
+typedef std::vector<std::vector<NUI_DEPTH_IMAGE_PIXEL>> DepthFrames;
+
+/// <summary>
+/// Run a prefilter, with or without a temporal filter, over a sequence of 640x480 frames in place
+/// </summary>
+template <class Prefilter, class TemporalFilter>
+void PrefilterFrames(DepthFrames& frames, bool holeFill, bool flyingPixelRemoval, bool temporal)
+{
+    Prefilter      prefilter;
+    TemporalFilter temporalFilter;
+    prefilter.SetResolution(NUI_IMAGE_RESOLUTION_640x480);
+    prefilter.EnableHoleFill(holeFill);
+    prefilter.EnableFlyingPixelRemoval(flyingPixelRemoval);
+    prefilter.SetTemporalFilter(temporal ? &temporalFilter : nullptr);
+
+    for (UINT i = 0; i < frames.size(); i++)
+    {
+        prefilter.Process(&frames[i][0], (UINT)(frames[i].size() * sizeof(NUI_DEPTH_IMAGE_PIXEL)));
+    }
+}
+
+/// <summary>
+/// Run a temporal filter alone over a sequence of frames of any size in place
+/// </summary>
+template <class TemporalFilter>
+void TemporalFilterFrames(DepthFrames& frames, UINT width, UINT height)
+{
+    TemporalFilter temporalFilter;
+
+    for (UINT i = 0; i < frames.size(); i++)
+    {
+        temporalFilter.BeginFrame(width, height);
+        for (UINT y = 0; y < height; y++)
+        {
+            temporalFilter.ProcessRow(&frames[i][y * width], y);
+        }
+    }
+}
+
+/// <summary>
+/// The same runs with the filters built without SSE2, see DepthFilterScalar.cpp
+/// </summary>
+void ScalarPrefilterFrames(DepthFrames& frames, bool holeFill, bool flyingPixelRemoval, bool temporal);
+void ScalarTemporalFilterFrames(DepthFrames& frames, UINT width, UINT height);
@@ -0,0 +1,232 @@
+//------------------------------------------------------------------------------
+// <copyright file="DepthFilterTest.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "TestCheck.h"
+#include "DepthFilterScalar.h"
+#include "DepthPrefilter.h"
+#include "DepthTemporalFilter.h"
+#include <string.h>
+
+#define FRAME_WIDTH         640
+#define FRAME_HEIGHT        480
+#define FRAME_COUNT         6
+#define ODD_WIDTH           83          // Leaves a scalar tail after the 8 pixel loops
+#define ODD_HEIGHT          9
+#define SURFACE_DEPTH       2000        // Millimeters
+#define MAX_FILTERED_DEPTH  8191        // Millimeters, the temporal filter limit
+
+/// <summary>
+/// Small deterministic generator, so every run sees the same frames
+/// </summary>
+static UINT NextRandom(UINT& state)
+{
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+/// <summary>
+/// Make a sequence of noisy frames of a slowly moving slope, with holes, flying pixels,
+/// far pixels past the temporal filter limit, and player indices
+/// </summary>
+static DepthFrames MakeFrames(UINT width, UINT height, UINT& state)
+{
+    DepthFrames frames(FRAME_COUNT, std::vector<NUI_DEPTH_IMAGE_PIXEL>(width * height));
+
+    for (UINT i = 0; i < FRAME_COUNT; i++)
+    {
+        for (UINT y = 0; y < height; y++)
+        {
+            for (UINT x = 0; x < width; x++)
+            {
+                NUI_DEPTH_IMAGE_PIXEL& pixel = frames[i][y * width + x];
+                pixel.playerIndex = (USHORT)(NextRandom(state) % 8);
+                pixel.depth       = (USHORT)(800 + x * 8 + y * 4 + i * 3 + NextRandom(state) % 40);
+
+                UINT kind = NextRandom(state) % 100;
+                if (kind < 10)
+                {
+                    pixel.depth = 0;
+                }
+                else if (kind < 14)
+                {
+                    pixel.depth = (USHORT)(pixel.depth + 300 + NextRandom(state) % 2000);
+                }
+                else if (kind < 16)
+                {
+                    pixel.depth = (USHORT)(MAX_FILTERED_DEPTH + NextRandom(state) % 2000);
+                }
+            }
+        }
+    }
+
+    return frames;
+}
+
+/// <summary>
+/// Check if two frame sequences are identical byte for byte
+/// </summary>
+static bool Identical(const DepthFrames& a, const DepthFrames& b)
+{
+    for (UINT i = 0; i < a.size(); i++)
+    {
+        if (a[i].size() != b[i].size() || 0 != memcmp(&a[i][0], &b[i][0], a[i].size() * sizeof(NUI_DEPTH_IMAGE_PIXEL)))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// <summary>
+/// The SSE2 and scalar paths give the same output for every combination of stages
+/// </summary>
+static void TestPathsMatch()
+{
+    UINT state = 39;
+    DepthFrames frames = MakeFrames(FRAME_WIDTH, FRAME_HEIGHT, state);
+
+    for (UINT stages = 0; stages < 8; stages++)
+    {
+        bool holeFill           = 0 != (stages & 1);
+        bool flyingPixelRemoval = 0 != (stages & 2);
+        bool temporal           = 0 != (stages & 4);
+
+        DepthFrames vector = frames;
+        DepthFrames scalar = frames;
+        PrefilterFrames<DepthPrefilter, DepthTemporalFilter>(vector, holeFill, flyingPixelRemoval, temporal);
+        ScalarPrefilterFrames(scalar, holeFill, flyingPixelRemoval, temporal);
+        CHECK(Identical(vector, scalar));
+    }
+
+    // A width which is not a multiple of 8 runs the scalar tail after the SSE2 loop
+    state = 40;
+    DepthFrames odd = MakeFrames(ODD_WIDTH, ODD_HEIGHT, state);
+    DepthFrames vector = odd;
+    TemporalFilterFrames<DepthTemporalFilter>(vector, ODD_WIDTH, ODD_HEIGHT);
+    ScalarTemporalFilterFrames(odd, ODD_WIDTH, ODD_HEIGHT);
+    CHECK(Identical(vector, odd));
+}
+
+/// <summary>
+/// Make a flat 640x480 frame, with a 2x2 hole if asked. Each pixel of the hole has
+/// another hole pixel on one side across and one side down
+/// </summary>
+static std::vector<NUI_DEPTH_IMAGE_PIXEL> FlatFrame(UINT holeX, UINT holeY, bool hole)
+{
+    NUI_DEPTH_IMAGE_PIXEL surface = {0, SURFACE_DEPTH};
+    std::vector<NUI_DEPTH_IMAGE_PIXEL> frame(FRAME_WIDTH * FRAME_HEIGHT, surface);
+
+    for (UINT y = holeY; hole && y < holeY + 2; y++)
+    {
+        for (UINT x = holeX; x < holeX + 2; x++)
+        {
+            frame[y * FRAME_WIDTH + x].depth = 0;
+        }
+    }
+
+    return frame;
+}
+
+/// <summary>
+/// The prefilter removes flying pixels, keeps player indices, and fills holes from the
+/// previous frame
+/// </summary>
+static void TestPrefilter()
+{
+    const UINT holeX = 200;
+    const UINT holeY = 100;
+    const UINT frameBytes = FRAME_WIDTH * FRAME_HEIGHT * sizeof(NUI_DEPTH_IMAGE_PIXEL);
+
+    DepthPrefilter prefilter;
+    CHECK(SUCCEEDED(prefilter.SetResolution(NUI_IMAGE_RESOLUTION_640x480)));
+    prefilter.EnableHoleFill(true);
+    prefilter.EnableFlyingPixelRemoval(true);
+
+    // A spike between neighbours which agree, on a player
+    std::vector<NUI_DEPTH_IMAGE_PIXEL> frame = FlatFrame(holeX, holeY, true);
+    const UINT spike = 300 * FRAME_WIDTH + 400;
+    frame[spike].depth = SURFACE_DEPTH + 1000;
+    for (UINT i = spike - 2; i <= spike + 2; i++)
+    {
+        frame[i].playerIndex = 3;
+    }
+
+    std::vector<NUI_DEPTH_IMAGE_PIXEL> filtered = frame;
+    prefilter.Process(&filtered[0], frameBytes);
+
+    CHECK(0 == filtered[spike].depth);
+    CHECK(SURFACE_DEPTH == filtered[spike - 1].depth && SURFACE_DEPTH == filtered[spike + 1].depth);
+
+    bool playersKept = true;
+    for (UINT i = 0; i < frame.size(); i++)
+    {
+        playersKept = playersKept && filtered[i].playerIndex == frame[i].playerIndex;
+    }
+    CHECK(playersKept);
+
+    // Without a previous frame no two neighbours agree on a value for the hole
+    CHECK(0 == filtered[holeY * FRAME_WIDTH + holeX].depth);
+
+    // After a frame without the hole, the previous value agrees with a neighbour and fills it
+    prefilter.Reset();
+    std::vector<NUI_DEPTH_IMAGE_PIXEL> full = FlatFrame(holeX, holeY, false);
+    prefilter.Process(&full[0], frameBytes);
+
+    std::vector<NUI_DEPTH_IMAGE_PIXEL> holed = FlatFrame(holeX, holeY, true);
+    prefilter.Process(&holed[0], frameBytes);
+    CHECK(SURFACE_DEPTH == holed[holeY * FRAME_WIDTH + holeX].depth);
+    CHECK(SURFACE_DEPTH == holed[(holeY + 1) * FRAME_WIDTH + holeX + 1].depth);
+
+    // A reset forgets the previous frame
+    prefilter.Reset();
+    holed = FlatFrame(holeX, holeY, true);
+    prefilter.Process(&holed[0], frameBytes);
+    CHECK(0 == holed[holeY * FRAME_WIDTH + holeX].depth);
+}
+
+/// <summary>
+/// Steady pixels past the temporal filter limit come out clamped to it, and holes pass through
+/// </summary>
+static void TestTemporalClamp()
+{
+    DepthFrames frames(FRAME_COUNT, std::vector<NUI_DEPTH_IMAGE_PIXEL>(ODD_WIDTH * ODD_HEIGHT));
+    for (UINT i = 0; i < FRAME_COUNT; i++)
+    {
+        for (UINT p = 0; p < ODD_WIDTH * ODD_HEIGHT; p++)
+        {
+            frames[i][p].playerIndex = (USHORT)(p % 8);
+            frames[i][p].depth       = 0 == p % 5 ? 0 : (USHORT)(MAX_FILTERED_DEPTH + 1 + p % 1500);
+        }
+    }
+
+    std::vector<NUI_DEPTH_IMAGE_PIXEL> raw = frames[FRAME_COUNT - 1];
+    TemporalFilterFrames<DepthTemporalFilter>(frames, ODD_WIDTH, ODD_HEIGHT);
+
+    bool clamped     = true;
+    bool holesKept   = true;
+    bool playersKept = true;
+    for (UINT p = 0; p < ODD_WIDTH * ODD_HEIGHT; p++)
+    {
+        const NUI_DEPTH_IMAGE_PIXEL& pixel = frames[FRAME_COUNT - 1][p];
+        clamped     = clamped && (0 == raw[p].depth || MAX_FILTERED_DEPTH == pixel.depth);
+        holesKept   = holesKept && (0 != raw[p].depth || 0 == pixel.depth);
+        playersKept = playersKept && pixel.playerIndex == raw[p].playerIndex;
+    }
+
+    CHECK(clamped);
+    CHECK(holesKept);
+    CHECK(playersKept);
+}
+
+int main()
+{
+    TestPathsMatch();
+    TestPrefilter();
+    TestTemporalClamp();
+
+    return TestResult("DepthFilterTest");
+}
@@ -0,0 +1,88 @@
+//------------------------------------------------------------------------------
+// <copyright file="FrameBusTest.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "TestCheck.h"
+#include "FrameBus.h"
+
+#define BUS_NAME    "FrameBusTest"
+#define SLOT_COUNT  4
+#define FRAME_SIZE  64
+
+/// <summary>
+/// Make a frame of a few bytes filled with its frame number
+/// </summary>
+static FrameBusFrameInfo MakeFrame(UINT frameNumber, BYTE* pData)
+{
+    memset(pData, (int)frameNumber, FRAME_SIZE);
+
+    FrameBusFrameInfo info = {FrameBusColor, 4, 4, 16, FRAME_SIZE, frameNumber, 0};
+    return info;
+}
+
+/// <summary>
+/// Frames are only copied while a reader is registered, and a registered reader gets them in order
+/// </summary>
+static void TestPublish(const char* name)
+{
+    FrameBusWriter writer;
+    CHECK(SUCCEEDED(writer.Create(name, SLOT_COUNT, FRAME_SIZE)));
+
+    BYTE data[FRAME_SIZE];
+    CHECK(!writer.HasReaders());
+    CHECK(S_FALSE == writer.Publish(MakeFrame(1, data), data));
+
+    FrameBusReader reader;
+    CHECK(SUCCEEDED(reader.Open(name)));
+    CHECK(writer.HasReaders());
+
+    FrameBusFrame frame;
+    CHECK(S_FALSE == reader.Acquire(frame));
+
+    CHECK(S_OK == writer.Publish(MakeFrame(2, data), data));
+    CHECK(S_OK == writer.Publish(MakeFrame(3, data), data));
+
+    for (UINT frameNumber = 2; frameNumber <= 3; frameNumber++)
+    {
+        CHECK(S_OK == reader.Acquire(frame));
+        CHECK(frameNumber == frame.info.frameNumber);
+        CHECK(frameNumber == frame.pData[FRAME_SIZE - 1]);
+        CHECK(reader.Release(frame));
+    }
+    CHECK(S_FALSE == reader.Acquire(frame));
+
+    reader.Close();
+    CHECK(!writer.HasReaders());
+    CHECK(S_FALSE == writer.Publish(MakeFrame(4, data), data));
+}
+
+/// <summary>
+/// A reader beyond the reader table cannot open the bus, as the writer could not see it
+/// </summary>
+static void TestReaderTable(const char* name)
+{
+    FrameBusWriter writer;
+    CHECK(SUCCEEDED(writer.Create(name, SLOT_COUNT, FRAME_SIZE)));
+
+    FrameBusReader readers[FRAME_BUS_MAX_READERS];
+    for (UINT i = 0; i < FRAME_BUS_MAX_READERS; i++)
+    {
+        CHECK(SUCCEEDED(readers[i].Open(name)));
+    }
+
+    FrameBusReader extra;
+    CHECK(FAILED(extra.Open(name)));
+
+    readers[0].Close();
+    CHECK(SUCCEEDED(extra.Open(name)));
+}
+
+int main()
+{
+    TestPublish(BUS_NAME);
+    TestReaderTable(BUS_NAME);
+
+    return TestResult("FrameBusTest");
+}
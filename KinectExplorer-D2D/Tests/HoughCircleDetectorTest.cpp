@@ -0,0 +1,115 @@
+//------------------------------------------------------------------------------
+// <copyright file="HoughCircleDetectorTest.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "TestCheck.h"
+#include "HoughCircleDetector.h"
+#include "SphereFitter.h"
+#include <cmath>
+
+#define FRAME_WIDTH         640
+#define FRAME_HEIGHT        480
+#define WALL_DEPTH          4500        // Millimeters
+#define OCCLUDER_DEPTH      1500        // Millimeters, in front of the ball
+#define BALL_DEPTH          2500        // Millimeters, ball center
+#define BALL_X              321.3f      // Pixels, off the 2x2 cell grid
+#define BALL_Y              233.7f
+#define TOLERANCE           0.05f       // Share of the radius, votes scatter over about a tenth of it
+
+/// <summary>
+/// Draw a ball in front of a wall, and a box in front of the ball hiding every column
+/// left of occludedRight. Everything nearer than the wall is foreground
+/// </summary>
+static FLOAT DrawFrame(const BallScaleTable& table, int occludedRight, std::vector<NUI_DEPTH_IMAGE_PIXEL>& depth, PackedBitmask& mask)
+{
+    NUI_DEPTH_IMAGE_PIXEL wall = {0, WALL_DEPTH};
+    depth.assign(FRAME_WIDTH * FRAME_HEIGHT, wall);
+    mask.Resize(FRAME_WIDTH, FRAME_HEIGHT);
+    mask.Clear();
+
+    FLOAT radius = table.GetRadius(BALL_DEPTH);
+    FLOAT rim    = DEFAULT_BALL_RADIUS * 1000.0f;
+
+    for (int y = 0; y < FRAME_HEIGHT; y++)
+    {
+        for (int x = 0; x < FRAME_WIDTH; x++)
+        {
+            NUI_DEPTH_IMAGE_PIXEL& pixel = depth[y * FRAME_WIDTH + x];
+
+            // The box reaches from above the ball to below it
+            if (x < occludedRight && fabsf(y - BALL_Y) < 2.0f * radius)
+            {
+                pixel.depth = OCCLUDER_DEPTH;
+                mask.Set(x, y);
+                continue;
+            }
+
+            // Distance from the axis in millimeters at the depth of the center
+            FLOAT dx = (x - BALL_X) * BALL_DEPTH / table.GetFocalLength();
+            FLOAT dy = (y - BALL_Y) * BALL_DEPTH / table.GetFocalLength();
+            FLOAT squared = rim * rim - dx * dx - dy * dy;
+            if (squared >= 0.0f)
+            {
+                pixel.depth = (USHORT)(BALL_DEPTH - sqrtf(squared));
+                mask.Set(x, y);
+            }
+        }
+    }
+
+    return radius;
+}
+
+/// <summary>
+/// Find the ball and check that the strongest circle is where it was drawn
+/// </summary>
+/// <returns>Support of the circle, 0 if none was found</returns>
+static FLOAT DetectBall(const BallScaleTable& table, int occludedRight)
+{
+    std::vector<NUI_DEPTH_IMAGE_PIXEL> depth;
+    PackedBitmask mask;
+    FLOAT radius = DrawFrame(table, occludedRight, depth, mask);
+
+    HoughCircleDetector detector;
+    detector.Detect(mask, &depth[0], table);
+
+    CHECK(!detector.GetCircles().empty());
+    if (detector.GetCircles().empty())
+    {
+        return 0.0f;
+    }
+
+    const CircleDetection& circle = detector.GetCircles()[0];
+    CHECK_NEAR(circle.imageX, BALL_X, TOLERANCE * radius);
+    CHECK_NEAR(circle.imageY, BALL_Y, TOLERANCE * radius);
+    CHECK_NEAR(circle.imageRadius, radius, TOLERANCE * radius);
+    CHECK_NEAR(circle.depth, BALL_DEPTH, TOLERANCE * BALL_DEPTH);
+
+    return circle.support;
+}
+
+/// <summary>
+/// A ball with its left half behind a nearer box is found where it is, with less support
+/// than when it is fully visible. Its rim along the box is the far side of that edge
+/// and does not vote
+/// </summary>
+static void TestHalfHiddenBall(const BallScaleTable& table)
+{
+    FLOAT visible = DetectBall(table, 0);
+    FLOAT hidden  = DetectBall(table, (int)BALL_X);
+
+    CHECK(hidden >= 0.22f);
+    CHECK(hidden < 0.75f * visible);
+}
+
+int main()
+{
+    BallScaleTable table;
+    table.SetResolution(NUI_IMAGE_RESOLUTION_640x480);
+    table.SetBallRadius(DEFAULT_BALL_RADIUS);
+
+    TestHalfHiddenBall(table);
+
+    return TestResult("HoughCircleDetectorTest");
+}
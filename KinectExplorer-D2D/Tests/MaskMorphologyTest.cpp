@@ -0,0 +1,263 @@
+//------------------------------------------------------------------------------
+// <copyright file="MaskMorphologyTest.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "TestCheck.h"
+#include "MaskMorphology.h"
+#include <vector>
+
+#define MASK_HEIGHT     37
+
+typedef std::vector<BYTE> Grid;
+
+/// <summary>
+/// Small deterministic generator, so every run sees the same masks
+/// </summary>
+static UINT NextRandom(UINT& state)
+{
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+/// <summary>
+/// Fill a grid with random blobs, dense enough that erosion keeps some of them
+/// </summary>
+static Grid MakeGrid(UINT width, UINT height, UINT& state)
+{
+    Grid grid(width * height, 0);
+    for (UINT blob = 0; blob < width * height / 40; blob++)
+    {
+        int centerX = (int)(NextRandom(state) % width);
+        int centerY = (int)(NextRandom(state) % height);
+        int radius  = (int)(NextRandom(state) % 5);
+
+        for (int y = centerY - radius; y <= centerY + radius; y++)
+        {
+            for (int x = centerX - radius; x <= centerX + radius; x++)
+            {
+                if (x >= 0 && y >= 0 && x < (int)width && y < (int)height)
+                {
+                    grid[y * width + x] = 1;
+                }
+            }
+        }
+    }
+
+    return grid;
+}
+
+/// <summary>
+/// Copy a grid into a mask
+/// </summary>
+static void ToMask(const Grid& grid, UINT width, UINT height, PackedBitmask& mask)
+{
+    mask.Resize(width, height);
+    mask.Clear();
+    for (UINT y = 0; y < height; y++)
+    {
+        for (UINT x = 0; x < width; x++)
+        {
+            if (grid[y * width + x])
+            {
+                mask.Set(x, y);
+            }
+        }
+    }
+}
+
+/// <summary>
+/// Check if a mask holds the same pixels as a grid
+/// </summary>
+static bool Matches(const PackedBitmask& mask, const Grid& grid, UINT width, UINT height)
+{
+    if (mask.GetWidth() != width || mask.GetHeight() != height)
+    {
+        return false;
+    }
+
+    for (UINT y = 0; y < height; y++)
+    {
+        for (UINT x = 0; x < width; x++)
+        {
+            if (mask.Test(x, y) != (0 != grid[y * width + x]))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/// <summary>
+/// Erode or dilate a grid pixel by pixel by a rectangle, or by a 3x3 cross if cross is set.
+/// Outside pixels count as set for erosion and unset for dilation
+/// </summary>
+static Grid NaiveStep(const Grid& grid, UINT width, UINT height, int radiusX, int radiusY, bool cross, bool erode)
+{
+    Grid result(width * height, 0);
+    for (int y = 0; y < (int)height; y++)
+    {
+        for (int x = 0; x < (int)width; x++)
+        {
+            bool value = erode;
+            for (int dy = -radiusY; dy <= radiusY; dy++)
+            {
+                for (int dx = -radiusX; dx <= radiusX; dx++)
+                {
+                    if (cross && 0 != dx && 0 != dy)
+                    {
+                        continue;
+                    }
+
+                    int sx = x + dx;
+                    int sy = y + dy;
+                    if (sx < 0 || sy < 0 || sx >= (int)width || sy >= (int)height)
+                    {
+                        continue;
+                    }
+
+                    bool pixel = 0 != grid[sy * width + sx];
+                    value = erode ? (value && pixel) : (value || pixel);
+                }
+            }
+            result[y * width + x] = value ? 1 : 0;
+        }
+    }
+
+    return result;
+}
+
+/// <summary>
+/// Erode or dilate a grid the way the documented shapes are defined
+/// </summary>
+static Grid Naive(const Grid& grid, UINT width, UINT height, MORPHOLOGY_SHAPE shape, UINT radiusX, UINT radiusY, bool erode)
+{
+    if (MORPHOLOGY_RECTANGLE == shape)
+    {
+        return NaiveStep(grid, width, height, (int)radiusX, (int)radiusY, false, erode);
+    }
+
+    // The disc alternates 3x3 squares and crosses, starting with a square
+    Grid result = grid;
+    for (UINT step = 0; step < radiusX; step++)
+    {
+        result = NaiveStep(result, width, height, 1, 1, 0 != step % 2, erode);
+    }
+
+    return result;
+}
+
+/// <summary>
+/// Compare every operation with the naive reference on one size and element
+/// </summary>
+static void CompareWithNaive(UINT width, MORPHOLOGY_SHAPE shape, UINT radiusX, UINT radiusY)
+{
+    UINT state = width * 131 + radiusX * 17 + radiusY;
+    Grid grid  = MakeGrid(width, MASK_HEIGHT, state);
+
+    Grid eroded  = Naive(grid, width, MASK_HEIGHT, shape, radiusX, radiusY, true);
+    Grid dilated = Naive(grid, width, MASK_HEIGHT, shape, radiusX, radiusY, false);
+    Grid opened  = Naive(eroded, width, MASK_HEIGHT, shape, radiusX, radiusY, false);
+    Grid closed  = Naive(dilated, width, MASK_HEIGHT, shape, radiusX, radiusY, true);
+
+    MaskMorphology morphology;
+    PackedBitmask  source;
+    PackedBitmask  target;
+    ToMask(grid, width, MASK_HEIGHT, source);
+
+    morphology.Erode(source, target, shape, radiusX, radiusY);
+    CHECK(Matches(target, eroded, width, MASK_HEIGHT));
+
+    morphology.Dilate(source, target, shape, radiusX, radiusY);
+    CHECK(Matches(target, dilated, width, MASK_HEIGHT));
+
+    morphology.Open(source, target, shape, radiusX, radiusY);
+    CHECK(Matches(target, opened, width, MASK_HEIGHT));
+
+    morphology.Close(source, target, shape, radiusX, radiusY);
+    CHECK(Matches(target, closed, width, MASK_HEIGHT));
+
+    // In place gives the same result
+    morphology.Open(source, source, shape, radiusX, radiusY);
+    CHECK(Matches(source, opened, width, MASK_HEIGHT));
+
+    if (g_testFailures)
+    {
+        fprintf(stderr, "  width %u, %s, radius %u x %u\n", width, MORPHOLOGY_DISC == shape ? "disc" : "rectangle", radiusX, radiusY);
+    }
+}
+
+/// <summary>
+/// Widths around the 64 pixel words and radii of more than a word match the reference
+/// </summary>
+static void TestAgainstNaive()
+{
+    const UINT widths[] = {63, 64, 65, 129};
+
+    for (UINT i = 0; i < sizeof(widths) / sizeof(widths[0]) && 0 == g_testFailures; i++)
+    {
+        CompareWithNaive(widths[i], MORPHOLOGY_RECTANGLE, 1, 1);
+        CompareWithNaive(widths[i], MORPHOLOGY_RECTANGLE, 3, 2);
+        CompareWithNaive(widths[i], MORPHOLOGY_RECTANGLE, 70, 1);
+        CompareWithNaive(widths[i], MORPHOLOGY_RECTANGLE, 1, 40);
+        CompareWithNaive(widths[i], MORPHOLOGY_DISC, 1, 1);
+        CompareWithNaive(widths[i], MORPHOLOGY_DISC, 2, 2);
+        CompareWithNaive(widths[i], MORPHOLOGY_DISC, 5, 5);
+    }
+}
+
+/// <summary>
+/// The border does not erode blobs touching it, nor dilate from outside
+/// </summary>
+static void TestBorder()
+{
+    const UINT width = 65;
+
+    MaskMorphology morphology;
+    PackedBitmask  mask;
+    PackedBitmask  result;
+
+    // A full mask stays full under erosion, the outside counts as set
+    Grid full(width * MASK_HEIGHT, 1);
+    ToMask(full, width, MASK_HEIGHT, mask);
+    morphology.Erode(mask, result, MORPHOLOGY_RECTANGLE, 70, 3);
+    CHECK(width * MASK_HEIGHT == result.CountSet());
+    morphology.Erode(mask, result, MORPHOLOGY_DISC, 3, 3);
+    CHECK(width * MASK_HEIGHT == result.CountSet());
+
+    // An empty mask stays empty under dilation, the outside counts as unset
+    Grid empty(width * MASK_HEIGHT, 0);
+    ToMask(empty, width, MASK_HEIGHT, mask);
+    morphology.Dilate(mask, result, MORPHOLOGY_DISC, 3, 3);
+    CHECK(0 == result.CountSet());
+
+    // A corner pixel grows only into the mask, and the bits past the width stay clear
+    mask.Set(width - 1, MASK_HEIGHT - 1);
+    morphology.Dilate(mask, result, MORPHOLOGY_RECTANGLE, 1, 1);
+    CHECK(4 == result.CountSet());
+    CHECK(result.Test(width - 2, MASK_HEIGHT - 2));
+
+    // A block against the border survives opening by a square that fits it
+    Grid block(width * MASK_HEIGHT, 0);
+    for (UINT y = 0; y < 6; y++)
+    {
+        for (UINT x = width - 6; x < width; x++)
+        {
+            block[y * width + x] = 1;
+        }
+    }
+    ToMask(block, width, MASK_HEIGHT, mask);
+    morphology.Open(mask, result, MORPHOLOGY_RECTANGLE, 2, 2);
+    CHECK(Matches(result, block, width, MASK_HEIGHT));
+}
+
+int main()
+{
+    TestAgainstNaive();
+    TestBorder();
+
+    return TestResult("MaskMorphologyTest");
+}
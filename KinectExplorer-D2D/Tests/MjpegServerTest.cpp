@@ -0,0 +1,154 @@
+//------------------------------------------------------------------------------
+// <copyright file="MjpegServerTest.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "TestCheck.h"
+#include "MjpegServer.h"
+#include <chrono>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+
+#define SERVER_ADDRESS      "127.0.0.1"
+#define FIRST_PORT          18580
+#define PORT_ATTEMPTS       16
+#define FRAME_WIDTH         640
+#define FRAME_HEIGHT        480
+#define CONNECT_TIMEOUT     1000        // Milliseconds
+#define PART_TIMEOUT        3000        // Milliseconds
+#define PROMPT_PART_TIME    400         // Milliseconds, below the server's request timeout
+
+/// <summary>
+/// Start the server on the first free loopback port
+/// </summary>
+static USHORT StartServer(MjpegServer& server)
+{
+    for (USHORT port = FIRST_PORT; port < FIRST_PORT + PORT_ATTEMPTS; port++)
+    {
+        if (SUCCEEDED(server.Start(SERVER_ADDRESS, port)))
+        {
+            return port;
+        }
+    }
+
+    return 0;
+}
+
+/// <summary>
+/// Submit frames while reading the stream until the first multipart part has arrived
+/// </summary>
+/// <param name="server">Server to submit frames to</param>
+/// <param name="client">Connection which sent its request</param>
+/// <param name="part">Receives the JPEG data of the part</param>
+/// <returns>Milliseconds until the part arrived, or a negative number on timeout</returns>
+static double ReadFirstPart(MjpegServer& server, TcpSocket& client, std::string& part)
+{
+    std::vector<UINT> pixels(FRAME_WIDTH * FRAME_HEIGHT);
+    for (UINT i = 0; i < pixels.size(); i++)
+    {
+        BYTE level = (BYTE)(i % FRAME_WIDTH * 255 / FRAME_WIDTH);
+        pixels[i] = level | level << 8 | (255 - level) << 16;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::string received;
+
+    for (;;)
+    {
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (elapsed > PART_TIMEOUT)
+        {
+            return -1.0;
+        }
+
+        server.SubmitFrame(&pixels[0], FRAME_WIDTH, FRAME_HEIGHT, nullptr);
+
+        char buffer[4096];
+        UINT size;
+        HRESULT hr = client.Receive(buffer, sizeof(buffer), 10, size);
+        if (FAILED(hr))
+        {
+            return -1.0;
+        }
+        received.append(buffer, size);
+
+        // The part header gives the length of the JPEG data following it
+        size_t header = received.find("Content-Length: ");
+        size_t body   = received.find("\r\n\r\n", header);
+        if (std::string::npos == header || std::string::npos == body)
+        {
+            continue;
+        }
+
+        size_t length = (size_t)atoi(received.c_str() + header + 16);
+        if (received.size() >= body + 4 + length)
+        {
+            part = received.substr(body + 4, length);
+            return elapsed;
+        }
+    }
+}
+
+/// <summary>
+/// A browser style client gets the stream header and a complete JPEG part, even while
+/// another connection has not sent its request
+/// </summary>
+static void TestStream()
+{
+    MjpegServer server;
+    server.SetMaxFrameRate(100);
+
+    USHORT port = StartServer(server);
+    CHECK(0 != port);
+    if (0 == port)
+    {
+        return;
+    }
+
+    // A connection which never sends a request must not hold up the others
+    TcpSocket idle;
+    CHECK(SUCCEEDED(idle.Connect(SERVER_ADDRESS, port, CONNECT_TIMEOUT)));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    TcpSocket client;
+    CHECK(SUCCEEDED(client.Connect(SERVER_ADDRESS, port, CONNECT_TIMEOUT)));
+
+    static const char Request[] = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    CHECK(S_OK == client.Send(Request, sizeof(Request) - 1, CONNECT_TIMEOUT));
+
+    std::string part;
+    double elapsed = ReadFirstPart(server, client, part);
+    CHECK(elapsed >= 0.0);
+    CHECK(elapsed < PROMPT_PART_TIME);
+
+    // A JPEG starts with the start of image marker and ends with the end of image marker
+    CHECK(part.size() > 4);
+    if (part.size() > 4)
+    {
+        CHECK(0xFF == (BYTE)part[0] && 0xD8 == (BYTE)part[1]);
+        CHECK(0xFF == (BYTE)part[part.size() - 2] && 0xD9 == (BYTE)part[part.size() - 1]);
+    }
+
+    // The counters are updated once the frame went out to every client
+    MjpegServerStats stats = server.GetStats();
+    for (UINT wait = 0; 0 == stats.framesSent && wait < PART_TIMEOUT; wait += 10)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        stats = server.GetStats();
+    }
+
+    CHECK(1 == stats.clientCount);
+    CHECK(stats.framesSent >= 1);
+    CHECK(320 == stats.width && 240 == stats.height);
+
+    server.Stop();
+}
+
+int main()
+{
+    TestStream();
+
+    return TestResult("MjpegServerTest");
+}
@@ -0,0 +1,153 @@
+//------------------------------------------------------------------------------
+// <copyright file="PointCloudBuilderTest.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "TestCheck.h"
+#include "PointCloudBuilder.h"
+#include <vector>
+
+#define WIDTH       640
+#define HEIGHT      480
+#define TOLERANCE   1e-4    // Meters
+
+/// <summary>
+/// Reference projection, as NuiTransformDepthImageToSkeleton
+/// </summary>
+static Vector4 ReferencePoint(UINT x, UINT y, USHORT depth)
+{
+    FLOAT meters = depth / 1000.0f;
+    Vector4 point;
+    point.x = ((FLOAT)x - WIDTH / 2.0f) * (320.0f / WIDTH) * NUI_CAMERA_DEPTH_NOMINAL_INVERSE_FOCAL_LENGTH_IN_PIXELS * meters;
+    point.y = -((FLOAT)y - HEIGHT / 2.0f) * (240.0f / HEIGHT) * NUI_CAMERA_DEPTH_NOMINAL_INVERSE_FOCAL_LENGTH_IN_PIXELS * meters;
+    point.z = meters;
+    point.w = 1.0f;
+    return point;
+}
+
+/// <summary>
+/// Fill a depth frame with a ramp and a few unknown pixels
+/// </summary>
+static void MakeFrame(std::vector<NUI_DEPTH_IMAGE_PIXEL>& frame)
+{
+    frame.resize(WIDTH * HEIGHT);
+    for (UINT y = 0; y < HEIGHT; y++)
+    {
+        for (UINT x = 0; x < WIDTH; x++)
+        {
+            NUI_DEPTH_IMAGE_PIXEL& pixel = frame[y * WIDTH + x];
+            pixel.playerIndex = 0;
+            pixel.depth       = (0 == (x + y) % 11) ? 0 : (USHORT)(800 + x * 3 + y * 2);
+        }
+    }
+}
+
+/// <summary>
+/// Dense conversion matches the SDK projection for every pixel
+/// </summary>
+static void TestDense(const std::vector<NUI_DEPTH_IMAGE_PIXEL>& frame)
+{
+    PointCloudBuilder builder;
+    CHECK(SUCCEEDED(builder.SetResolution(NUI_IMAGE_RESOLUTION_640x480)));
+    CHECK(WIDTH * HEIGHT == builder.BuildDense(&frame[0]));
+
+    for (UINT i = 0; i < WIDTH * HEIGHT; i += 7)
+    {
+        Vector4 expected = ReferencePoint(i % WIDTH, i / WIDTH, frame[i].depth);
+        CHECK_NEAR(builder.GetX()[i], expected.x, TOLERANCE);
+        CHECK_NEAR(builder.GetY()[i], expected.y, TOLERANCE);
+        CHECK_NEAR(builder.GetZ()[i], expected.z, TOLERANCE);
+    }
+}
+
+/// <summary>
+/// Masked conversion inside a rectangle keeps only selected pixels with known depth, in scan order
+/// </summary>
+static void TestMasked(const std::vector<NUI_DEPTH_IMAGE_PIXEL>& frame)
+{
+    PointCloudBuilder builder;
+    builder.SetResolution(NUI_IMAGE_RESOLUTION_640x480);
+
+    PackedBitmask mask;
+    mask.Resize(WIDTH, HEIGHT);
+    for (UINT y = 0; y < HEIGHT; y++)
+    {
+        for (UINT x = 0; x < WIDTH; x++)
+        {
+            if (0 == (x * 7 + y * 3) % 5)
+            {
+                mask.Set(x, y);
+            }
+        }
+    }
+
+    const UINT left = 13, top = 20, right = 301, bottom = 250;
+    UINT count = builder.BuildMasked(&frame[0], mask, left, top, right, bottom);
+
+    UINT expected = 0;
+    for (UINT y = top; y <= bottom; y++)
+    {
+        for (UINT x = left; x <= right; x++)
+        {
+            UINT index = y * WIDTH + x;
+            if (!mask.Test(x, y) || 0 == frame[index].depth)
+            {
+                continue;
+            }
+
+            if (expected < count)
+            {
+                Vector4 point = ReferencePoint(x, y, frame[index].depth);
+                CHECK(index == builder.GetPixelIndex()[expected]);
+                CHECK_NEAR(builder.GetX()[expected], point.x, TOLERANCE);
+                CHECK_NEAR(builder.GetY()[expected], point.y, TOLERANCE);
+                CHECK_NEAR(builder.GetZ()[expected], point.z, TOLERANCE);
+            }
+            expected++;
+        }
+    }
+    CHECK(expected == count);
+}
+
+/// <summary>
+/// A rotation is baked into the rays and undone by ToCamera
+/// </summary>
+static void TestRotation(const std::vector<NUI_DEPTH_IMAGE_PIXEL>& frame)
+{
+    // Pitch of 30 degrees about the x axis
+    const FLOAT c = 0.8660254f, s = 0.5f;
+    const FLOAT rotation[3][3] = { { 1.0f, 0.0f, 0.0f }, { 0.0f, c, -s }, { 0.0f, s, c } };
+
+    PointCloudBuilder builder;
+    builder.SetResolution(NUI_IMAGE_RESOLUTION_640x480);
+    builder.SetRotation(rotation);
+    builder.BuildDense(&frame[0]);
+
+    for (UINT i = 0; i < WIDTH * HEIGHT; i += 13)
+    {
+        Vector4 camera   = ReferencePoint(i % WIDTH, i / WIDTH, frame[i].depth);
+        Vector4 expected = builder.ToOutput(camera);
+        CHECK_NEAR(builder.GetX()[i], expected.x, TOLERANCE);
+        CHECK_NEAR(builder.GetY()[i], expected.y, TOLERANCE);
+        CHECK_NEAR(builder.GetZ()[i], expected.z, TOLERANCE);
+
+        Vector4 point = builder.ToPoint(i % WIDTH, i / WIDTH, frame[i].depth);
+        Vector4 back  = builder.ToCamera(point);
+        CHECK_NEAR(back.x, camera.x, TOLERANCE);
+        CHECK_NEAR(back.y, camera.y, TOLERANCE);
+        CHECK_NEAR(back.z, camera.z, TOLERANCE);
+    }
+}
+
+int main()
+{
+    std::vector<NUI_DEPTH_IMAGE_PIXEL> frame;
+    MakeFrame(frame);
+
+    TestDense(frame);
+    TestMasked(frame);
+    TestRotation(frame);
+
+    return TestResult("PointCloudBuilderTest");
+}
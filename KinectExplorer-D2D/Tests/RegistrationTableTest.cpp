@@ -0,0 +1,153 @@
+//------------------------------------------------------------------------------
+// <copyright file="RegistrationTableTest.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "TestCheck.h"
+#include "RegistrationTable.h"
+#include <stdio.h>
+#include <vector>
+
+#define WIDTH           640
+#define HEIGHT          480
+#define TABLE_FILE      "RegistrationTableTest.bin"
+#define MAP_TOLERANCE   0.75f   // Pixels, boundaries are sampled to whole pixels
+#define PATCH_LEFT      101
+#define PATCH_TOP       50
+#define PATCH_RIGHT     300
+#define PATCH_BOTTOM    199
+#define PATCH_DEPTH     2020    // Millimeters
+
+/// <summary>
+/// Model of the sensor: the color camera sits 25 mm to the side, with its own focal
+/// length and a little radial distortion
+/// </summary>
+static void ModelMapping(UINT x, UINT y, FLOAT depth, FLOAT& colorX, FLOAT& colorY)
+{
+    const FLOAT depthFocal = 571.26f, colorFocal = 531.15f;
+
+    FLOAT u = ((x - WIDTH / 2.0f) / depthFocal * depth + 25.0f) / depth;
+    FLOAT v = (y - HEIGHT / 2.0f) / depthFocal;
+    FLOAT k = 1.0f + 0.05f * (u * u + v * v);
+
+    colorX = WIDTH / 2.0f + colorFocal * u * k;
+    colorY = HEIGHT / 2.0f + colorFocal * v * k + 3.0f;
+}
+
+/// <summary>
+/// Fill every boundary from the model, as the viewer does from the SDK
+/// </summary>
+static void Calibrate(RegistrationTable& table)
+{
+    CHECK(SUCCEEDED(table.Initialize(NUI_IMAGE_RESOLUTION_640x480, NUI_IMAGE_RESOLUTION_640x480)));
+    CHECK(!table.IsValid());
+
+    std::vector<LONG> coordinates(WIDTH * HEIGHT * 2);
+    for (UINT boundary = 0; boundary < REGISTRATION_BOUNDARY_COUNT; boundary++)
+    {
+        FLOAT depth = table.GetBoundaryDepth(boundary);
+        for (UINT y = 0; y < HEIGHT; y++)
+        {
+            for (UINT x = 0; x < WIDTH; x++)
+            {
+                FLOAT colorX, colorY;
+                ModelMapping(x, y, depth, colorX, colorY);
+                coordinates[2 * (y * WIDTH + x)]     = (LONG)floorf(colorX + 0.5f);
+                coordinates[2 * (y * WIDTH + x) + 1] = (LONG)floorf(colorY + 0.5f);
+            }
+        }
+        CHECK(SUCCEEDED(table.SetBoundaryMapping(boundary, &coordinates[0])));
+    }
+
+    CHECK(table.IsValid());
+}
+
+/// <summary>
+/// Mapping between the boundaries follows the model, and the table survives a save and load
+/// </summary>
+static void TestMapping(const RegistrationTable& calibrated)
+{
+    CHECK(SUCCEEDED(calibrated.Save(TABLE_FILE)));
+
+    RegistrationTable table;
+    CHECK(SUCCEEDED(table.Load(TABLE_FILE)));
+    remove(TABLE_FILE);
+
+    CHECK(table.Matches(NUI_IMAGE_RESOLUTION_640x480, NUI_IMAGE_RESOLUTION_640x480));
+    CHECK(!table.Matches(NUI_IMAGE_RESOLUTION_320x240, NUI_IMAGE_RESOLUTION_640x480));
+
+    for (UINT depth = 500; depth < 4000; depth += 137)
+    {
+        for (UINT y = 10; y < HEIGHT; y += 37)
+        {
+            for (UINT x = 5; x < WIDTH; x += 41)
+            {
+                FLOAT colorX, colorY, expectedX, expectedY;
+                if (table.MapPixel(x, y, (USHORT)depth, colorX, colorY))
+                {
+                    ModelMapping(x, y, (FLOAT)depth, expectedX, expectedY);
+                    CHECK_NEAR(colorX, expectedX, MAP_TOLERANCE);
+                    CHECK_NEAR(colorY, expectedY, MAP_TOLERANCE);
+                }
+            }
+        }
+    }
+
+    FLOAT colorX, colorY;
+    CHECK(!table.MapPixel(WIDTH / 2, HEIGHT / 2, 0, colorX, colorY));
+    CHECK(!table.MapPixel(WIDTH, HEIGHT / 2, 2000, colorX, colorY));
+}
+
+/// <summary>
+/// Gathering a patch picks the same color pixels as mapping each pixel on its own
+/// </summary>
+static void TestGather(const RegistrationTable& table)
+{
+    std::vector<UINT> color(WIDTH * HEIGHT);
+    for (UINT i = 0; i < color.size(); i++)
+    {
+        // Black pixels must stay apart from unmapped ones
+        color[i] = 0 == i % 5 ? 0 : i * 2654435761u;
+    }
+
+    std::vector<NUI_DEPTH_IMAGE_PIXEL> depth(WIDTH * HEIGHT);
+    for (UINT i = 0; i < depth.size(); i++)
+    {
+        depth[i].playerIndex = 0;
+        depth[i].depth       = (0 == i % 97) ? 0 : (USHORT)(2000 + i % 50);
+    }
+
+    const UINT patchWidth = PATCH_RIGHT - PATCH_LEFT + 1;
+    std::vector<UINT> patch(patchWidth * (PATCH_BOTTOM - PATCH_TOP + 1));
+    UINT mapped = table.GatherColor(&depth[0], &color[0], PATCH_LEFT, PATCH_TOP, PATCH_RIGHT, PATCH_BOTTOM, PATCH_DEPTH, &patch[0]);
+
+    UINT expectedMapped = 0;
+    for (UINT y = PATCH_TOP; y <= PATCH_BOTTOM; y++)
+    {
+        for (UINT x = PATCH_LEFT; x <= PATCH_RIGHT; x++)
+        {
+            UINT   expected = REGISTRATION_UNMAPPED;
+            USHORT d        = depth[y * WIDTH + x].depth;
+            FLOAT  colorX, colorY;
+            if (table.MapPixel(x, y, d, colorX, colorY))
+            {
+                expected = color[(UINT)(colorY + 0.5f) * WIDTH + (UINT)(colorX + 0.5f)] | REGISTRATION_MAPPED;
+                expectedMapped++;
+            }
+            CHECK(expected == patch[(y - PATCH_TOP) * patchWidth + (x - PATCH_LEFT)]);
+        }
+    }
+    CHECK(expectedMapped == mapped);
+}
+
+int main()
+{
+    RegistrationTable table;
+    Calibrate(table);
+
+    TestMapping(table);
+    TestGather(table);
+
+    return TestResult("RegistrationTableTest");
+}
@@ -0,0 +1,59 @@
+//------------------------------------------------------------------------------
+// <copyright file="TestCheck.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+
+/// <summary>
+/// Number of failed checks of the running test
+/// </summary>
+static int g_testFailures = 0;
+
+/// <summary>
+/// Report a failed check and keep running, so one run lists every failure
+/// </summary>
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            fprintf(stderr, "%s(%d): check failed: %s\n", __FILE__, __LINE__, #condition); \
+            g_testFailures++; \
+        } \
+    } while (0)
+
+/// <summary>
+/// Check that two numbers differ by no more than a tolerance
+/// </summary>
+#define CHECK_NEAR(actual, expected, tolerance) \
+    do \
+    { \
+        double checkActual   = (double)(actual); \
+        double checkExpected = (double)(expected); \
+        if (!(fabs(checkActual - checkExpected) <= (double)(tolerance))) \
+        { \
+            fprintf(stderr, "%s(%d): check failed: %s is %g, expected %g within %g\n", \
+                    __FILE__, __LINE__, #actual, checkActual, checkExpected, (double)(tolerance)); \
+            g_testFailures++; \
+        } \
+    } while (0)
+
+/// <summary>
+/// Print the outcome of the test and get the process exit code
+/// </summary>
+inline int TestResult(const char* name)
+{
+    if (g_testFailures)
+    {
+        fprintf(stderr, "%s: %d check(s) failed\n", name, g_testFailures);
+        return 1;
+    }
+
+    printf("%s: passed\n", name);
+    return 0;
+}
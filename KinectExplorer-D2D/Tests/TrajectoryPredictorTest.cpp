@@ -0,0 +1,250 @@
+//------------------------------------------------------------------------------
+// <copyright file="TrajectoryPredictorTest.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include "TestCheck.h"
+#include "TrajectoryPredictor.h"
+#include <random>
+#include <string.h>
+#include <vector>
+
+#define GRAVITY             9.80665f
+#define FLOOR_DISTANCE      1.0f        // Meters below the camera
+#define BALL_RADIUS         0.3175f
+#define RESTITUTION         0.7f
+#define FRAME_INTERVAL      (1.0 / 30.0)
+#define START_TIME          1000        // Milliseconds
+#define TRACK_ID            7
+#define MEASUREMENT_NOISE   0.01f       // Meters
+
+/// <summary>
+/// Ball thrown from (-1, 0.5, 3) with velocity (2, 3, 0.5) in a level frame, bouncing once
+/// </summary>
+struct Throw
+{
+    double landing;     // Seconds until the center is one radius above the floor
+    double bounce;      // Upward speed after the bounce
+
+    Throw()
+    {
+        // 0.5 + 3t - g/2 t^2 = radius - floor
+        double a = -GRAVITY / 2.0, b = 3.0, c = 0.5 - (BALL_RADIUS - FLOOR_DISTANCE);
+        landing = (-b - sqrt(b * b - 4.0 * a * c)) / (2.0 * a);
+        bounce  = -(b - GRAVITY * landing) * RESTITUTION;
+    }
+
+    /// <summary>
+    /// Level frame position at a time
+    /// </summary>
+    Vector4 Position(double t) const
+    {
+        Vector4 p = { (FLOAT)(-1.0 + 2.0 * t), 0.0f, (FLOAT)(3.0 + 0.5 * t), 1.0f };
+        if (t < landing)
+        {
+            p.y = (FLOAT)(0.5 + 3.0 * t - GRAVITY / 2.0 * t * t);
+        }
+        else
+        {
+            double s = t - landing;
+            p.y = (FLOAT)(BALL_RADIUS - FLOOR_DISTANCE + bounce * s - GRAVITY / 2.0 * s * s);
+        }
+        return p;
+    }
+
+    /// <summary>
+    /// Time of the landing after the bounce
+    /// </summary>
+    double SecondLanding() const
+    {
+        return landing + 2.0 * bounce / GRAVITY;
+    }
+};
+
+/// <summary>
+/// Camera pitch rotation, camera = rotation * level
+/// </summary>
+static Vector4 Rotate(const FLOAT rotation[3][3], const Vector4& p)
+{
+    Vector4 r;
+    r.x = rotation[0][0] * p.x + rotation[0][1] * p.y + rotation[0][2] * p.z;
+    r.y = rotation[1][0] * p.x + rotation[1][1] * p.y + rotation[1][2] * p.z;
+    r.z = rotation[2][0] * p.x + rotation[2][1] * p.y + rotation[2][2] * p.z;
+    r.w = p.w;
+    return r;
+}
+
+/// <summary>
+/// Feed the throw to a predictor frame by frame until a time
+/// </summary>
+static void Feed(TrajectoryPredictor& predictor, const Throw& path, const FLOAT rotation[3][3], double until, FLOAT noise)
+{
+    std::mt19937 random(5);
+    std::normal_distribution<FLOAT> error(0.0f, noise > 0.0f ? noise : 1.0f);
+
+    std::vector<BallTrack> tracks(1);
+    BallTrack& track = tracks[0];
+    memset(&track, 0, sizeof(track));
+    track.id        = TRACK_ID;
+    track.confirmed = true;
+    track.updated   = true;
+
+    for (UINT frame = 0; frame * FRAME_INTERVAL <= until; frame++)
+    {
+        double t = frame * FRAME_INTERVAL;
+        track.measurement = Rotate(rotation, path.Position(t));
+        if (noise > 0.0f)
+        {
+            track.measurement.x += error(random);
+            track.measurement.y += error(random);
+            track.measurement.z += error(random);
+        }
+        predictor.Update(tracks, START_TIME + (LONGLONG)(t * 1000.0 + 0.5));
+    }
+}
+
+/// <summary>
+/// Check a landing prediction made at a time against the true landing
+/// </summary>
+static void CheckLanding(const BallTrajectory* pTrajectory, const Throw& path, const FLOAT rotation[3][3], double now, double landing, FLOAT pointTolerance, FLOAT timeTolerance)
+{
+    CHECK(nullptr != pTrajectory);
+    if (nullptr == pTrajectory)
+    {
+        return;
+    }
+
+    CHECK(pTrajectory->valid);
+    CHECK(pTrajectory->landing.valid);
+
+    Vector4 expected = Rotate(rotation, path.Position(landing));
+    CHECK_NEAR(pTrajectory->landing.timeToImpact, landing - now, timeTolerance);
+    CHECK_NEAR(pTrajectory->landing.point.x, expected.x, pointTolerance);
+    CHECK_NEAR(pTrajectory->landing.point.y, expected.y, pointTolerance);
+    CHECK_NEAR(pTrajectory->landing.point.z, expected.z, pointTolerance);
+}
+
+/// <summary>
+/// Exact samples give the exact parabola
+/// </summary>
+static void TestExact()
+{
+    const FLOAT level[3][3] = { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } };
+    Throw path;
+    double now = 10 * FRAME_INTERVAL;
+
+    TrajectoryPredictor predictor;
+    Feed(predictor, path, level, now, 0.0f);
+
+    const BallTrajectory* pTrajectory = predictor.Find(TRACK_ID);
+    CheckLanding(pTrajectory, path, level, now, path.landing, 0.01f, 0.005f);
+
+    if (pTrajectory)
+    {
+        double  later     = now + 0.2;
+        Vector4 predicted = predictor.PredictPosition(*pTrajectory, START_TIME + (LONGLONG)(later * 1000.0 + 0.5));
+        Vector4 expected  = path.Position(later);
+        CHECK_NEAR(predicted.x, expected.x, 0.01f);
+        CHECK_NEAR(predicted.y, expected.y, 0.01f);
+        CHECK_NEAR(predicted.z, expected.z, 0.01f);
+        CHECK(0 == pTrajectory->bounceCount);
+    }
+}
+
+/// <summary>
+/// Noisy samples converge, and the reported spread covers the error
+/// </summary>
+static void TestNoisy()
+{
+    const FLOAT level[3][3] = { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } };
+    Throw path;
+    double now = 16 * FRAME_INTERVAL;
+
+    TrajectoryPredictor predictor;
+    Feed(predictor, path, level, now, MEASUREMENT_NOISE);
+
+    const BallTrajectory* pTrajectory = predictor.Find(TRACK_ID);
+    CheckLanding(pTrajectory, path, level, now, path.landing, 0.05f, 0.02f);
+
+    if (pTrajectory)
+    {
+        Vector4 expected = path.Position(path.landing);
+        FLOAT   spread   = sqrtf(pTrajectory->landing.pointCovariance[0][0]);
+        CHECK(spread > 0.0f);
+        CHECK(fabs(pTrajectory->landing.point.x - expected.x) < 4.0f * spread);
+    }
+}
+
+/// <summary>
+/// A bounce restarts the fit and the next landing is predicted
+/// </summary>
+static void TestBounce()
+{
+    const FLOAT level[3][3] = { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } };
+    Throw path;
+    double now = path.landing + 12 * FRAME_INTERVAL;
+
+    TrajectoryPredictor predictor;
+    Feed(predictor, path, level, now, 0.0f);
+
+    const BallTrajectory* pTrajectory = predictor.Find(TRACK_ID);
+    CHECK(nullptr != pTrajectory && 1 == pTrajectory->bounceCount);
+
+    // Sample times are rounded to frames, so the bounce point is known to a frame
+    double sampled = floor(now / FRAME_INTERVAL) * FRAME_INTERVAL;
+    CheckLanding(pTrajectory, path, level, sampled, path.SecondLanding(), 0.05f, 0.02f);
+}
+
+/// <summary>
+/// A pitched camera sees gravity and the floor rotated, the prediction follows them
+/// </summary>
+static void TestPitched()
+{
+    const FLOAT c = 0.9063078f, s = -0.4226183f;   // 25 degrees down
+    const FLOAT pitch[3][3] = { { 1.0f, 0.0f, 0.0f }, { 0.0f, c, -s }, { 0.0f, s, c } };
+    Throw path;
+    double now = 10 * FRAME_INTERVAL;
+
+    Vector4 down  = { 0.0f, -GRAVITY, 0.0f, 0.0f };
+    Vector4 up    = { 0.0f, 1.0f, 0.0f, 0.0f };
+    Vector4 plane = Rotate(pitch, up);
+    plane.w = FLOOR_DISTANCE;
+
+    TrajectoryPredictor predictor;
+    predictor.SetGravity(Rotate(pitch, down));
+    predictor.SetFloorPlane(plane);
+    predictor.SetBallRadius(BALL_RADIUS);
+    Feed(predictor, path, pitch, now, 0.0f);
+
+    CheckLanding(predictor.Find(TRACK_ID), path, pitch, now, path.landing, 0.01f, 0.005f);
+}
+
+/// <summary>
+/// Trajectories of dropped tracks are forgotten
+/// </summary>
+static void TestDropped()
+{
+    const FLOAT level[3][3] = { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } };
+    Throw path;
+
+    TrajectoryPredictor predictor;
+    Feed(predictor, path, level, 5 * FRAME_INTERVAL, 0.0f);
+    CHECK(nullptr != predictor.Find(TRACK_ID));
+
+    std::vector<BallTrack> none;
+    predictor.Update(none, START_TIME + 200);
+    CHECK(nullptr == predictor.Find(TRACK_ID));
+    CHECK(predictor.GetTrajectories().empty());
+}
+
+int main()
+{
+    TestExact();
+    TestNoisy();
+    TestBounce();
+    TestPitched();
+    TestDropped();
+
+    return TestResult("TrajectoryPredictorTest");
+}
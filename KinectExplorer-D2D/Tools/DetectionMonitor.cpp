@@ -0,0 +1,57 @@
+//------------------------------------------------------------------------------
+// <copyright file="DetectionMonitor.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+// Receives detection packets and prints, once a second, the packets received, lost
+// and malformed so far, the balls of the last packet and the send to receive latency.
+// Run on the machine of the publisher, against the loopback address, so both read
+// the same steady clock.
+//
+//   DetectionMonitor [port] [seconds]
+
+#include "DetectionReceiver.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define DEFAULT_PORT        5800
+#define DEFAULT_SECONDS     30
+#define REPORT_INTERVAL     1000000     // Microseconds
+#define RECEIVE_TIMEOUT     100         // Milliseconds
+
+int main(int argc, char* argv[])
+{
+    USHORT port    = (USHORT)(argc > 1 ? atoi(argv[1]) : DEFAULT_PORT);
+    int    seconds = argc > 2 ? atoi(argv[2]) : DEFAULT_SECONDS;
+
+    DetectionReceiver receiver;
+    if (FAILED(receiver.Open(port)))
+    {
+        fprintf(stderr, "Cannot listen on port %u\n", port);
+        return 1;
+    }
+
+    LONGLONG end    = GetDetectionPacketTime() + (LONGLONG)seconds * 1000000;
+    LONGLONG report = GetDetectionPacketTime() + REPORT_INTERVAL;
+    while (GetDetectionPacketTime() < end)
+    {
+        receiver.Receive(RECEIVE_TIMEOUT);
+
+        if (GetDetectionPacketTime() < report)
+        {
+            continue;
+        }
+
+        const DetectionReceiverStats& stats = receiver.GetStats();
+        printf("received %3u  lost %u  malformed %u  balls %u  latency mean %.1f us max %.1f us\n",
+            stats.received, stats.lost, stats.malformed,
+            stats.received ? (UINT)receiver.GetPacket().header.ballCount : 0,
+            stats.meanLatency, stats.maxLatency);
+
+        report += REPORT_INTERVAL;
+    }
+
+    printf("Received %u packets\n", receiver.GetStats().received);
+    return 0;
+}
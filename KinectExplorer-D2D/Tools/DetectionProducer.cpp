@@ -0,0 +1,86 @@
+//------------------------------------------------------------------------------
+// <copyright file="DetectionProducer.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+// Stands in for the explorer started with -publish: sends detection packets of a
+// few synthetic confirmed tracks at the sensor frame rate, for DetectionMonitor
+// or a controller to receive.
+//
+//   DetectionProducer [address] [port] [seconds]
+
+#include "DetectionPublisher.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+
+#define DEFAULT_ADDRESS     "127.0.0.1"
+#define DEFAULT_PORT        5800
+#define DEFAULT_SECONDS     30
+#define TRACK_COUNT         3
+#define FRAME_INTERVAL      33          // Milliseconds
+
+/// <summary>
+/// Move the tracks along a throw, each a little behind the one before
+/// </summary>
+static void UpdateTracks(std::vector<BallTrack>& tracks, FLOAT seconds)
+{
+    for (UINT i = 0; i < tracks.size(); i++)
+    {
+        BallTrack& track = tracks[i];
+        FLOAT      t     = seconds - 0.2f * i;
+
+        track.state[0][0] = -1.2f + 1.6f * t;
+        track.state[0][1] = 1.6f;
+        track.state[1][0] = 0.6f + 1.0f * t - 4.9f * t * t;
+        track.state[1][1] = 1.0f - 9.8f * t;
+        track.state[2][0] = 3.0f;
+        track.state[2][1] = 0.0f;
+        track.age++;
+        track.hits++;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const char* address = argc > 1 ? argv[1] : DEFAULT_ADDRESS;
+    USHORT      port    = (USHORT)(argc > 2 ? atoi(argv[2]) : DEFAULT_PORT);
+    int         seconds = argc > 3 ? atoi(argv[3]) : DEFAULT_SECONDS;
+
+    DetectionPublisher publisher;
+    if (FAILED(publisher.Open(address, port)))
+    {
+        fprintf(stderr, "Cannot send to %s:%u\n", address, port);
+        return 1;
+    }
+
+    std::vector<BallTrack> tracks(TRACK_COUNT);
+    for (UINT i = 0; i < tracks.size(); i++)
+    {
+        ZeroMemory(&tracks[i], sizeof(BallTrack));
+        tracks[i].id        = i + 1;
+        tracks[i].confirmed = true;
+        tracks[i].updated   = true;
+    }
+
+    printf("Sending to %s:%u for %d seconds\n", address, port, seconds);
+
+    UINT frameCount = seconds * 1000 / FRAME_INTERVAL;
+    auto start      = std::chrono::steady_clock::now();
+    auto next       = start;
+    for (UINT frameNumber = 1; frameNumber <= frameCount; frameNumber++)
+    {
+        FLOAT elapsed = std::chrono::duration<FLOAT>(std::chrono::steady_clock::now() - start).count();
+
+        // The throw repeats every second so the positions stay in view
+        UpdateTracks(tracks, elapsed - (int)elapsed);
+        publisher.Publish(tracks, frameNumber, (LONGLONG)(elapsed * 1000));
+
+        next += std::chrono::milliseconds(FRAME_INTERVAL);
+        std::this_thread::sleep_until(next);
+    }
+
+    printf("Sent %u packets, %u dropped\n", frameCount, publisher.GetDroppedCount());
+    return 0;
+}
@@ -0,0 +1,106 @@
+//------------------------------------------------------------------------------
+// <copyright file="FrameBusMonitor.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+// Reads every frame from a frame bus and prints, once a second, the frames taken
+// of each type, the lag behind the writer, the frames lost to overwriting and the
+// latency from the frame timestamp. The latency only means something for frames
+// stamped with the steady clock, as FrameBusProducer does.
+//
+//   FrameBusMonitor [name] [seconds]
+
+#include "FrameBus.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+
+#define DEFAULT_BUS_NAME    "KinectFrameBus0"   // The first sensor of the explorer
+#define DEFAULT_SECONDS     30
+#define REPORT_INTERVAL     1000                // Milliseconds
+#define POLL_INTERVAL       1                   // Milliseconds
+#define OPEN_RETRIES        100                 // Polls for the bus before giving up
+
+/// <summary>
+/// Get the steady clock in milliseconds, the producer stamps frames with the same clock
+/// </summary>
+static LONGLONG GetMilliseconds()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int main(int argc, char* argv[])
+{
+    const char* name    = argc > 1 ? argv[1] : DEFAULT_BUS_NAME;
+    int         seconds = argc > 2 ? atoi(argv[2]) : DEFAULT_SECONDS;
+
+    // The producer may still be starting
+    FrameBusReader bus;
+    HRESULT hr = E_FAIL;
+    for (UINT i = 0; i < OPEN_RETRIES && FAILED(hr); i++)
+    {
+        hr = bus.Open(name);
+        if (FAILED(hr))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL * 10));
+        }
+    }
+
+    if (FAILED(hr))
+    {
+        fprintf(stderr, "Cannot open frame bus %s\n", name);
+        return 1;
+    }
+
+    UINT      counts[4]    = {0};
+    UINT      torn         = 0;
+    LONGLONG  latencySum   = 0;
+    LONGLONG  latencyMax   = 0;
+    UINT      latencyCount = 0;
+    ULONGLONG total        = 0;
+
+    LONGLONG end    = GetMilliseconds() + seconds * 1000;
+    LONGLONG report = GetMilliseconds() + REPORT_INTERVAL;
+    while (GetMilliseconds() < end)
+    {
+        FrameBusFrame frame;
+        hr = bus.Acquire(frame);
+        if (S_OK != hr)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL));
+        }
+        else
+        {
+            LONGLONG latency = GetMilliseconds() - frame.info.timestamp;
+            latencySum += latency;
+            latencyMax  = latency > latencyMax ? latency : latencyMax;
+            ++latencyCount;
+
+            counts[frame.info.type < 4 ? frame.info.type : 0]++;
+            ++total;
+
+            // A real consumer would read the data here, Release tells if it changed underneath
+            torn += !bus.Release(frame);
+        }
+
+        if (GetMilliseconds() >= report)
+        {
+            printf("depth %3u  color %3u  skeleton %3u  lag %llu  overwritten %llu  torn %u  latency mean %.2f ms max %lld ms\n",
+                counts[FrameBusDepth], counts[FrameBusColor], counts[FrameBusSkeleton],
+                (unsigned long long)bus.GetLag(), (unsigned long long)bus.GetOverwrittenCount(), torn,
+                latencyCount ? (double)latencySum / latencyCount : 0.0, (long long)latencyMax);
+
+            counts[0] = counts[1] = counts[2] = counts[3] = 0;
+            torn         = 0;
+            latencySum   = 0;
+            latencyMax   = 0;
+            latencyCount = 0;
+            report      += REPORT_INTERVAL;
+        }
+    }
+
+    printf("Read %llu frames\n", (unsigned long long)total);
+    return 0;
+}
@@ -0,0 +1,105 @@
+//------------------------------------------------------------------------------
+// <copyright file="FrameBusProducer.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+// Stands in for the explorer started with -framebus: publishes synthetic depth,
+// color and skeleton frames to a frame bus at the sensor frame rate, stamped with
+// the steady clock in milliseconds so FrameBusMonitor can measure the latency.
+//
+//   FrameBusProducer [name] [seconds]
+
+#include "FrameBus.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+#define DEFAULT_BUS_NAME    "KinectFrameBus0"   // The first sensor of the explorer
+#define DEFAULT_SECONDS     30
+#define SLOT_COUNT          8
+#define WIDTH               640
+#define HEIGHT              480
+#define FRAME_INTERVAL      33                  // Milliseconds
+#define BALL_RADIUS         40                  // Pixels
+#define BALL_DEPTH          2000                // Millimeters
+#define BACKGROUND_DEPTH    4000                // Millimeters
+
+/// <summary>
+/// Get the steady clock in milliseconds, the monitor reads the same clock
+/// </summary>
+static LONGLONG GetMilliseconds()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// <summary>
+/// Draw a ball moving across the background into the depth and color frames
+/// </summary>
+static void DrawFrames(UINT frameNumber, NUI_DEPTH_IMAGE_PIXEL* pDepth, UINT* pColor)
+{
+    int centerX = (int)(frameNumber * 8 % WIDTH);
+    int centerY = HEIGHT / 2;
+
+    for (int y = 0; y < HEIGHT; y++)
+    {
+        for (int x = 0; x < WIDTH; x++)
+        {
+            int  dx   = x - centerX;
+            int  dy   = y - centerY;
+            bool ball = dx * dx + dy * dy <= BALL_RADIUS * BALL_RADIUS;
+
+            pDepth[y * WIDTH + x].depth       = (USHORT)(ball ? BALL_DEPTH : BACKGROUND_DEPTH);
+            pDepth[y * WIDTH + x].playerIndex = 0;
+            pColor[y * WIDTH + x]             = ball ? 0xFFE02020 : 0xFF000000 | (x * 255 / WIDTH) << 8;
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const char* name    = argc > 1 ? argv[1] : DEFAULT_BUS_NAME;
+    int         seconds = argc > 2 ? atoi(argv[2]) : DEFAULT_SECONDS;
+
+    FrameBusWriter bus;
+    if (FAILED(bus.Create(name, SLOT_COUNT, WIDTH * HEIGHT * sizeof(UINT))))
+    {
+        fprintf(stderr, "Cannot create frame bus %s\n", name);
+        return 1;
+    }
+
+    std::vector<NUI_DEPTH_IMAGE_PIXEL> depth(WIDTH * HEIGHT);
+    std::vector<UINT>                  color(WIDTH * HEIGHT);
+    NUI_SKELETON_FRAME                 skeletons;
+    ZeroMemory(&skeletons, sizeof(skeletons));
+
+    printf("Publishing to %s for %d seconds\n", name, seconds);
+
+    UINT frameCount = seconds * 1000 / FRAME_INTERVAL;
+    UINT published  = 0;
+    auto next       = std::chrono::steady_clock::now();
+    for (UINT frameNumber = 1; frameNumber <= frameCount; frameNumber++)
+    {
+        DrawFrames(frameNumber, depth.data(), color.data());
+
+        // Frames are stamped when published, so the monitor sees the bus latency alone
+        FrameBusFrameInfo depthInfo = {FrameBusDepth, WIDTH, HEIGHT, WIDTH * sizeof(NUI_DEPTH_IMAGE_PIXEL), WIDTH * HEIGHT * sizeof(NUI_DEPTH_IMAGE_PIXEL), frameNumber, GetMilliseconds()};
+        published += S_OK == bus.Publish(depthInfo, depth.data());
+
+        FrameBusFrameInfo colorInfo = {FrameBusColor, WIDTH, HEIGHT, WIDTH * sizeof(UINT), WIDTH * HEIGHT * sizeof(UINT), frameNumber, GetMilliseconds()};
+        published += S_OK == bus.Publish(colorInfo, color.data());
+
+        skeletons.dwFrameNumber = frameNumber;
+        FrameBusFrameInfo skeletonInfo = {FrameBusSkeleton, 0, 0, 0, sizeof(skeletons), frameNumber, GetMilliseconds()};
+        published += S_OK == bus.Publish(skeletonInfo, &skeletons);
+
+        next += std::chrono::milliseconds(FRAME_INTERVAL);
+        std::this_thread::sleep_until(next);
+    }
+
+    // Frames offered while no reader was registered are not copied
+    printf("Published %u of %u frames\n", published, frameCount * 3);
+    return 0;
+}
@@ -0,0 +1,370 @@
+//------------------------------------------------------------------------------
+// <copyright file="TrajectoryPredictor.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#include <cmath>
+#include "TrajectoryPredictor.h"
+#include "SphereFitter.h"
+
+#define STANDARD_GRAVITY            9.80665f
+#define DEFAULT_FLOOR_DISTANCE      1.0f    // Meters below a level camera until a floor is estimated
+#define FORGETTING_FACTOR           0.9     // Weight kept by older samples at each new one
+#define MINIMUM_SAMPLES             3
+#define MEASUREMENT_VARIANCE        4.0e-4  // Square meters, 2 cm
+#define RESTART_DISTANCE            0.25f   // Meters off the path, ball was caught or hit
+#define BOUNCE_HEIGHT               0.1f    // Meters above the floor where a bounce can happen
+#define BOUNCE_DISTANCE             0.05f   // Meters above the path that mark a bounce
+#define MAX_SAMPLE_GAP              500     // Milliseconds, longer gaps restart the fit
+
+/// <summary>
+/// Constructor
+/// </summary>
+TrajectoryPredictor::TrajectoryPredictor()
+    : m_ballRadius(DEFAULT_BALL_RADIUS)
+{
+    m_gravity[0] = 0.0f;
+    m_gravity[1] = -STANDARD_GRAVITY;
+    m_gravity[2] = 0.0f;
+
+    m_floorPlane.x = 0.0f;
+    m_floorPlane.y = 1.0f;
+    m_floorPlane.z = 0.0f;
+    m_floorPlane.w = DEFAULT_FLOOR_DISTANCE;
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+TrajectoryPredictor::~TrajectoryPredictor()
+{
+}
+
+/// <summary>
+/// Drop all trajectories
+/// </summary>
+void TrajectoryPredictor::Reset()
+{
+    m_trajectories.clear();
+}
+
+/// <summary>
+/// Set gravity in camera space
+/// </summary>
+/// <param name="gravity">Acceleration in meters per second squared</param>
+void TrajectoryPredictor::SetGravity(const Vector4& gravity)
+{
+    m_gravity[0] = gravity.x;
+    m_gravity[1] = gravity.y;
+    m_gravity[2] = gravity.z;
+}
+
+/// <summary>
+/// Set the floor plane
+/// </summary>
+/// <param name="plane">Plane Ax + By + Cz + D = 0 with unit normal (A, B, C) pointing up, as the skeleton floor clip plane</param>
+void TrajectoryPredictor::SetFloorPlane(const Vector4& plane)
+{
+    m_floorPlane = plane;
+}
+
+/// <summary>
+/// Set the ball radius
+/// </summary>
+/// <param name="radius">Radius in meters</param>
+void TrajectoryPredictor::SetBallRadius(FLOAT radius)
+{
+    m_ballRadius = radius;
+}
+
+/// <summary>
+/// Find the trajectory of a track
+/// </summary>
+/// <param name="trackId">Stable track ID</param>
+/// <returns>Trajectory, or nullptr if there is none</returns>
+const BallTrajectory* TrajectoryPredictor::Find(UINT trackId) const
+{
+    for (size_t i = 0; i < m_trajectories.size(); i++)
+    {
+        if (m_trajectories[i].trackId == trackId)
+        {
+            return &m_trajectories[i];
+        }
+    }
+    return nullptr;
+}
+
+/// <summary>
+/// Add the measurements of a frame and update landing predictions
+/// </summary>
+/// <param name="tracks">Current ball tracks</param>
+/// <param name="timestamp">Frame time in milliseconds</param>
+void TrajectoryPredictor::Update(const std::vector<BallTrack>& tracks, LONGLONG timestamp)
+{
+    // Forget trajectories of tracks that were dropped
+    for (size_t i = m_trajectories.size(); i-- > 0;)
+    {
+        bool alive = false;
+        for (size_t t = 0; t < tracks.size() && !alive; t++)
+        {
+            alive = tracks[t].confirmed && tracks[t].id == m_trajectories[i].trackId;
+        }
+
+        if (!alive)
+        {
+            m_trajectories.erase(m_trajectories.begin() + i);
+        }
+    }
+
+    for (size_t t = 0; t < tracks.size(); t++)
+    {
+        const BallTrack& track = tracks[t];
+        if (!track.confirmed || !track.updated)
+        {
+            continue;
+        }
+
+        size_t index = 0;
+        while (index < m_trajectories.size() && m_trajectories[index].trackId != track.id)
+        {
+            ++index;
+        }
+
+        if (index == m_trajectories.size())
+        {
+            BallTrajectory fresh;
+            ZeroMemory(&fresh, sizeof(fresh));
+            fresh.trackId = track.id;
+            fresh.origin  = timestamp;
+
+            m_trajectories.push_back(fresh);
+        }
+
+        AddSample(m_trajectories[index], track.measurement, timestamp);
+    }
+}
+
+/// <summary>
+/// Restart a trajectory at a sample
+/// </summary>
+void TrajectoryPredictor::Restart(BallTrajectory& trajectory, LONGLONG timestamp)
+{
+    UINT id      = trajectory.trackId;
+    UINT bounces = trajectory.bounceCount;
+
+    ZeroMemory(&trajectory, sizeof(trajectory));
+
+    trajectory.trackId     = id;
+    trajectory.bounceCount = bounces;
+    trajectory.origin      = timestamp;
+}
+
+/// <summary>
+/// Height of the ball bottom above the floor
+/// </summary>
+FLOAT TrajectoryPredictor::HeightAboveFloor(const FLOAT position[3]) const
+{
+    return m_floorPlane.x * position[0] + m_floorPlane.y * position[1] + m_floorPlane.z * position[2] + m_floorPlane.w - m_ballRadius;
+}
+
+/// <summary>
+/// Predict the position of a ball along its fitted path
+/// </summary>
+/// <param name="trajectory">Fitted trajectory</param>
+/// <param name="timestamp">Time in milliseconds</param>
+/// <returns>Ball center, meters</returns>
+Vector4 TrajectoryPredictor::PredictPosition(const BallTrajectory& trajectory, LONGLONG timestamp) const
+{
+    FLOAT t = (timestamp - trajectory.origin) / 1000.0f;
+
+    Vector4 position;
+    position.x = trajectory.position[0] + trajectory.velocity[0] * t + 0.5f * m_gravity[0] * t * t;
+    position.y = trajectory.position[1] + trajectory.velocity[1] * t + 0.5f * m_gravity[1] * t * t;
+    position.z = trajectory.position[2] + trajectory.velocity[2] * t + 0.5f * m_gravity[2] * t * t;
+    position.w = 1.0f;
+    return position;
+}
+
+/// <summary>
+/// Add one measured position to a trajectory
+/// </summary>
+void TrajectoryPredictor::AddSample(BallTrajectory& trajectory, const Vector4& measured, LONGLONG timestamp)
+{
+    const FLOAT sample[3] = {measured.x, measured.y, measured.z};
+
+    trajectory.bounced = false;
+
+    if (trajectory.sampleCount > 0 && timestamp - trajectory.lastTimestamp > MAX_SAMPLE_GAP)
+    {
+        Restart(trajectory, timestamp);
+    }
+    else if (trajectory.valid)
+    {
+        // Compare the sample with the fitted path before it joins the fit
+        Vector4 predicted       = PredictPosition(trajectory, timestamp);
+        const FLOAT expected[3] = {predicted.x, predicted.y, predicted.z};
+
+        FLOAT dx = sample[0] - expected[0];
+        FLOAT dy = sample[1] - expected[1];
+        FLOAT dz = sample[2] - expected[2];
+
+        FLOAT above = HeightAboveFloor(sample) - HeightAboveFloor(expected);
+
+        if (HeightAboveFloor(expected) < BOUNCE_HEIGHT && above > BOUNCE_DISTANCE)
+        {
+            // Path went into the floor but the ball is above it
+            ++trajectory.bounceCount;
+            Restart(trajectory, timestamp);
+            trajectory.bounced = true;
+        }
+        else if (dx * dx + dy * dy + dz * dz > RESTART_DISTANCE * RESTART_DISTANCE)
+        {
+            Restart(trajectory, timestamp);
+        }
+    }
+
+    // Fade older samples, then add this one with the gravity term removed
+    double t  = (timestamp - trajectory.origin) / 1000.0;
+    double tt = t * t;
+
+    trajectory.sumW  = trajectory.sumW  * FORGETTING_FACTOR + 1.0;
+    trajectory.sumT  = trajectory.sumT  * FORGETTING_FACTOR + t;
+    trajectory.sumTT = trajectory.sumTT * FORGETTING_FACTOR + tt;
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        double y = sample[axis] - 0.5 * m_gravity[axis] * tt;
+
+        trajectory.sumY[axis]  = trajectory.sumY[axis]  * FORGETTING_FACTOR + y;
+        trajectory.sumTY[axis] = trajectory.sumTY[axis] * FORGETTING_FACTOR + t * y;
+        trajectory.sumYY[axis] = trajectory.sumYY[axis] * FORGETTING_FACTOR + y * y;
+    }
+
+    trajectory.lastTimestamp = timestamp;
+    ++trajectory.sampleCount;
+
+    Solve(trajectory);
+    PredictLanding(trajectory);
+}
+
+/// <summary>
+/// Solve the weighted line fit of every axis
+/// </summary>
+void TrajectoryPredictor::Solve(BallTrajectory& trajectory) const
+{
+    trajectory.valid = false;
+
+    double det = trajectory.sumW * trajectory.sumTT - trajectory.sumT * trajectory.sumT;
+    if (trajectory.sampleCount < MINIMUM_SAMPLES || det < 1.0e-12)
+    {
+        return;
+    }
+
+    // Inverse of the normal matrix [sumW sumT; sumT sumTT]
+    double inv00 =  trajectory.sumTT / det;
+    double inv01 = -trajectory.sumT  / det;
+    double inv11 =  trajectory.sumW  / det;
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        double p = inv00 * trajectory.sumY[axis] + inv01 * trajectory.sumTY[axis];
+        double v = inv01 * trajectory.sumY[axis] + inv11 * trajectory.sumTY[axis];
+
+        // Weighted residual sum of squares from the same sums
+        double rss = trajectory.sumYY[axis] - p * trajectory.sumY[axis] - v * trajectory.sumTY[axis];
+        double variance = (trajectory.sumW > 2.0) ? rss / (trajectory.sumW - 2.0) : MEASUREMENT_VARIANCE;
+        if (variance < MEASUREMENT_VARIANCE)
+        {
+            variance = MEASUREMENT_VARIANCE;
+        }
+
+        trajectory.position[axis]      = (FLOAT)p;
+        trajectory.velocity[axis]      = (FLOAT)v;
+        trajectory.covariance[axis][0] = (FLOAT)(variance * inv00);
+        trajectory.covariance[axis][1] = (FLOAT)(variance * inv01);
+        trajectory.covariance[axis][2] = (FLOAT)(variance * inv11);
+    }
+
+    trajectory.valid = true;
+}
+
+/// <summary>
+/// Predict where the ball reaches the floor
+/// </summary>
+void TrajectoryPredictor::PredictLanding(BallTrajectory& trajectory) const
+{
+    LandingPrediction& landing = trajectory.landing;
+    landing.valid = false;
+
+    if (!trajectory.valid)
+    {
+        return;
+    }
+
+    const FLOAT normal[3] = {m_floorPlane.x, m_floorPlane.y, m_floorPlane.z};
+
+    // Height above the floor from the last sample on: a s^2 + b s + c
+    FLOAT now = (trajectory.lastTimestamp - trajectory.origin) / 1000.0f;
+    FLOAT position[3], velocity[3];
+    for (int axis = 0; axis < 3; axis++)
+    {
+        position[axis] = trajectory.position[axis] + trajectory.velocity[axis] * now + 0.5f * m_gravity[axis] * now * now;
+        velocity[axis] = trajectory.velocity[axis] + m_gravity[axis] * now;
+    }
+
+    FLOAT a = 0.5f * (normal[0] * m_gravity[0] + normal[1] * m_gravity[1] + normal[2] * m_gravity[2]);
+    FLOAT b = normal[0] * velocity[0] + normal[1] * velocity[1] + normal[2] * velocity[2];
+    FLOAT c = HeightAboveFloor(position);
+
+    if (a >= 0.0f || c < 0.0f)
+    {
+        return;     // Gravity does not pull toward the floor, or the ball is already on it
+    }
+
+    FLOAT discriminant = b * b - 4.0f * a * c;
+    FLOAT s            = (-b - sqrtf(discriminant)) / (2.0f * a);
+
+    // Ball position, velocity and position covariance at impact
+    FLOAT impact = now + s;
+    FLOAT impactVelocity[3];
+    FLOAT variance[3];
+    for (int axis = 0; axis < 3; axis++)
+    {
+        const FLOAT* cov = trajectory.covariance[axis];
+
+        impactVelocity[axis] = trajectory.velocity[axis] + m_gravity[axis] * impact;
+        variance[axis]       = cov[0] + 2.0f * impact * cov[1] + impact * impact * cov[2];
+    }
+
+    Vector4 point = PredictPosition(trajectory, trajectory.origin + (LONGLONG)(impact * 1000.0f));
+
+    // Impact time moves by the height error over the vertical speed: dt = -(n . dp) / (n . v)
+    FLOAT verticalSpeed = normal[0] * impactVelocity[0] + normal[1] * impactVelocity[1] + normal[2] * impactVelocity[2];
+    if (verticalSpeed > -1.0e-3f)
+    {
+        return;
+    }
+
+    landing.valid        = true;
+    landing.point        = point;
+    landing.timeToImpact = s;
+    landing.timeVariance = (normal[0] * normal[0] * variance[0] + normal[1] * normal[1] * variance[1] + normal[2] * normal[2] * variance[2]) /
+                           (verticalSpeed * verticalSpeed);
+
+    // Landing point moves by A dp with A = I - v n' / (n . v)
+    for (int r = 0; r < 3; r++)
+    {
+        for (int col = 0; col < 3; col++)
+        {
+            FLOAT sum = 0.0f;
+            for (int k = 0; k < 3; k++)
+            {
+                FLOAT ark = (r == k ? 1.0f : 0.0f) - impactVelocity[r] * normal[k] / verticalSpeed;
+                FLOAT ack = (col == k ? 1.0f : 0.0f) - impactVelocity[col] * normal[k] / verticalSpeed;
+                sum += ark * variance[k] * ack;
+            }
+            landing.pointCovariance[r][col] = sum;
+        }
+    }
+}
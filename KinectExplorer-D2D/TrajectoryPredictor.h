@@ -0,0 +1,157 @@
+//------------------------------------------------------------------------------
+// <copyright file="TrajectoryPredictor.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include "NuiTypes.h"
+#include "BallTracker.h"
+
+/// <summary>
+/// Where and when a ball is expected to hit the floor
+/// </summary>
+struct LandingPrediction
+{
+    bool    valid;
+    Vector4 point;                  // Ball center at impact, meters
+    FLOAT   timeToImpact;           // Seconds after the last sample
+    FLOAT   timeVariance;           // Square seconds
+    FLOAT   pointCovariance[3][3];  // Square meters
+};
+
+/// <summary>
+/// Ballistic fit of one tracked ball. Positions follow p(t) = p0 + v0 t + g t^2 / 2
+/// with known gravity g, so each axis is a straight line fit of p(t) - g t^2 / 2.
+/// The fit keeps weighted sums that are updated per sample, older samples fading
+/// by a forgetting factor.
+/// </summary>
+struct BallTrajectory
+{
+    UINT        trackId;
+    LONGLONG    origin;             // Time zero of the fit, milliseconds
+    LONGLONG    lastTimestamp;      // Milliseconds
+    double      sumW;               // Weighted sums of the samples since the last restart
+    double      sumT;
+    double      sumTT;
+    double      sumY[3];
+    double      sumTY[3];
+    double      sumYY[3];
+    FLOAT       position[3];        // Fitted position at time zero, meters
+    FLOAT       velocity[3];        // Fitted velocity at time zero, meters per second
+    FLOAT       covariance[3][3];   // Per axis variance of position, covariance, variance of velocity
+    UINT        sampleCount;        // Samples since the last restart
+    UINT        bounceCount;
+    bool        valid;              // True once enough samples were fitted
+    bool        bounced;            // True if the last sample was a bounce
+    LandingPrediction landing;
+};
+
+/// <summary>
+/// Fits gravity constrained parabolas to the measured positions of confirmed ball
+/// tracks and predicts where and when they land. A bounce is detected when a ball
+/// predicted to be at the floor is measured above its fitted path, and the fit
+/// restarts from the bounce. Updating a trajectory costs a few dozen operations.
+/// </summary>
+class TrajectoryPredictor
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    TrajectoryPredictor();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~TrajectoryPredictor();
+
+public:
+    /// <summary>
+    /// Add the measurements of a frame and update landing predictions
+    /// </summary>
+    /// <param name="tracks">Current ball tracks</param>
+    /// <param name="timestamp">Frame time in milliseconds</param>
+    void Update(const std::vector<BallTrack>& tracks, LONGLONG timestamp);
+
+    /// <summary>
+    /// Drop all trajectories
+    /// </summary>
+    void Reset();
+
+    /// <summary>
+    /// Set gravity in camera space
+    /// </summary>
+    /// <param name="gravity">Acceleration in meters per second squared</param>
+    void SetGravity(const Vector4& gravity);
+
+    /// <summary>
+    /// Set the floor plane
+    /// </summary>
+    /// <param name="plane">Plane Ax + By + Cz + D = 0 with unit normal (A, B, C) pointing up, as the skeleton floor clip plane</param>
+    void SetFloorPlane(const Vector4& plane);
+
+    /// <summary>
+    /// Set the ball radius
+    /// </summary>
+    /// <param name="radius">Radius in meters</param>
+    void SetBallRadius(FLOAT radius);
+
+    /// <summary>
+    /// Get the trajectories of the current tracks
+    /// </summary>
+    const std::vector<BallTrajectory>& GetTrajectories() const
+    {
+        return m_trajectories;
+    }
+
+    /// <summary>
+    /// Find the trajectory of a track
+    /// </summary>
+    /// <param name="trackId">Stable track ID</param>
+    /// <returns>Trajectory, or nullptr if there is none</returns>
+    const BallTrajectory* Find(UINT trackId) const;
+
+    /// <summary>
+    /// Predict the position of a ball along its fitted path
+    /// </summary>
+    /// <param name="trajectory">Fitted trajectory</param>
+    /// <param name="timestamp">Time in milliseconds</param>
+    /// <returns>Ball center, meters</returns>
+    Vector4 PredictPosition(const BallTrajectory& trajectory, LONGLONG timestamp) const;
+
+private:
+    /// <summary>
+    /// Add one measured position to a trajectory
+    /// </summary>
+    void AddSample(BallTrajectory& trajectory, const Vector4& measured, LONGLONG timestamp);
+
+    /// <summary>
+    /// Restart a trajectory at a sample
+    /// </summary>
+    void Restart(BallTrajectory& trajectory, LONGLONG timestamp);
+
+    /// <summary>
+    /// Solve the weighted line fit of every axis
+    /// </summary>
+    void Solve(BallTrajectory& trajectory) const;
+
+    /// <summary>
+    /// Predict where the ball reaches the floor
+    /// </summary>
+    void PredictLanding(BallTrajectory& trajectory) const;
+
+    /// <summary>
+    /// Height of the ball bottom above the floor
+    /// </summary>
+    FLOAT HeightAboveFloor(const FLOAT position[3]) const;
+
+private:
+    std::vector<BallTrajectory> m_trajectories;
+
+    FLOAT   m_gravity[3];
+    Vector4 m_floorPlane;
+    FLOAT   m_ballRadius;
+};
@@ -0,0 +1,245 @@
+//------------------------------------------------------------------------------
+// <copyright file="UdpSocket.cpp" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+// Winsock 2 must come before anything that pulls in windows.h and with it winsock 1
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#define CloseSocket         closesocket
+#define SOCKET_WOULD_BLOCK  (WSAEWOULDBLOCK == WSAGetLastError())
+typedef SOCKET NativeSocket;
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define CloseSocket         close
+#define SOCKET_WOULD_BLOCK  (EAGAIN == errno || EWOULDBLOCK == errno)
+typedef int NativeSocket;
+#endif
+
+#include "UdpSocket.h"
+
+#define INVALID_SOCKET_VALUE    ((intptr_t)-1)
+
+static_assert(sizeof(sockaddr_in) <= 4 * sizeof(UINT), "Destination storage is too small for sockaddr_in");
+
+/// <summary>
+/// Constructor
+/// </summary>
+UdpSocket::UdpSocket()
+    : m_socket(INVALID_SOCKET_VALUE)
+    , m_open(false)
+    , m_started(false)
+{
+    ZeroMemory(m_destination, sizeof(m_destination));
+}
+
+/// <summary>
+/// Destructor
+/// </summary>
+UdpSocket::~UdpSocket()
+{
+    Close();
+}
+
+/// <summary>
+/// Create the non-blocking socket
+/// </summary>
+HRESULT UdpSocket::Create()
+{
+    Close();
+
+#ifdef _WIN32
+    WSADATA data;
+    if (0 != WSAStartup(MAKEWORD(2, 2), &data))
+    {
+        return E_FAIL;
+    }
+    m_started = true;
+
+    SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (INVALID_SOCKET == s)
+    {
+        Close();
+        return E_FAIL;
+    }
+    m_socket = (intptr_t)s;
+
+    u_long nonBlocking = 1;
+    if (0 != ioctlsocket(s, FIONBIO, &nonBlocking))
+    {
+        Close();
+        return E_FAIL;
+    }
+#else
+    int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s < 0)
+    {
+        return E_FAIL;
+    }
+    m_socket = s;
+
+    if (fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK) < 0)
+    {
+        Close();
+        return E_FAIL;
+    }
+#endif
+
+    m_open = true;
+    return S_OK;
+}
+
+/// <summary>
+/// Create a socket which sends to one destination
+/// </summary>
+/// <param name="address">Destination IPv4 address in dotted form</param>
+/// <param name="port">Destination port</param>
+/// <returns>Indicates success or failure</returns>
+HRESULT UdpSocket::OpenSender(const char* address, USHORT port)
+{
+    if (!address)
+    {
+        return E_INVALIDARG;
+    }
+
+    HRESULT hr = Create();
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    sockaddr_in* pDestination = (sockaddr_in*)m_destination;
+    pDestination->sin_family = AF_INET;
+    pDestination->sin_port   = htons(port);
+    if (1 != inet_pton(AF_INET, address, &pDestination->sin_addr))
+    {
+        Close();
+        return E_INVALIDARG;
+    }
+
+    return S_OK;
+}
+
+/// <summary>
+/// Create a socket which receives on a local port
+/// </summary>
+/// <param name="port">Local port</param>
+/// <returns>Indicates success or failure</returns>
+HRESULT UdpSocket::OpenReceiver(USHORT port)
+{
+    HRESULT hr = Create();
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    sockaddr_in local;
+    ZeroMemory(&local, sizeof(local));
+    local.sin_family      = AF_INET;
+    local.sin_port        = htons(port);
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    if (0 != bind((NativeSocket)m_socket, (const sockaddr*)&local, sizeof(local)))
+    {
+        Close();
+        return E_FAIL;
+    }
+
+    return S_OK;
+}
+
+/// <summary>
+/// Close the socket
+/// </summary>
+void UdpSocket::Close()
+{
+    if (INVALID_SOCKET_VALUE != m_socket)
+    {
+        CloseSocket((NativeSocket)m_socket);
+        m_socket = INVALID_SOCKET_VALUE;
+    }
+
+#ifdef _WIN32
+    if (m_started)
+    {
+        WSACleanup();
+    }
+#endif
+
+    m_started = false;
+    m_open    = false;
+}
+
+/// <summary>
+/// Send a datagram to the destination without waiting
+/// </summary>
+/// <param name="pData">The pointer to datagram bytes</param>
+/// <param name="size">Size of the datagram in bytes</param>
+/// <returns>S_OK if sent, S_FALSE if the stack was busy and the datagram dropped, or a failure code</returns>
+HRESULT UdpSocket::Send(const void* pData, UINT size)
+{
+    if (!m_open)
+    {
+        return E_FAIL;
+    }
+
+    if (sendto((NativeSocket)m_socket, (const char*)pData, size, 0, (const sockaddr*)m_destination, sizeof(sockaddr_in)) < 0)
+    {
+        return SOCKET_WOULD_BLOCK ? S_FALSE : E_FAIL;
+    }
+
+    return S_OK;
+}
+
+/// <summary>
+/// Receive one datagram
+/// </summary>
+/// <param name="pBuffer">The pointer to buffer receiving the datagram</param>
+/// <param name="capacity">Size of the buffer in bytes</param>
+/// <param name="timeout">Longest wait in milliseconds</param>
+/// <param name="size">Receives size of the datagram in bytes</param>
+/// <returns>S_OK if a datagram arrived, S_FALSE on timeout, or a failure code</returns>
+HRESULT UdpSocket::Receive(void* pBuffer, UINT capacity, UINT timeout, UINT& size)
+{
+    size = 0;
+
+    if (!m_open)
+    {
+        return E_FAIL;
+    }
+
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET((NativeSocket)m_socket, &readable);
+
+    timeval wait;
+    wait.tv_sec  = timeout / 1000;
+    wait.tv_usec = (timeout % 1000) * 1000;
+
+    int ready = select((int)m_socket + 1, &readable, nullptr, nullptr, &wait);
+    if (ready < 0)
+    {
+        return E_FAIL;
+    }
+    if (0 == ready)
+    {
+        return S_FALSE;
+    }
+
+    int received = (int)recvfrom((NativeSocket)m_socket, (char*)pBuffer, capacity, 0, nullptr, nullptr);
+    if (received < 0)
+    {
+        return SOCKET_WOULD_BLOCK ? S_FALSE : E_FAIL;
+    }
+
+    size = (UINT)received;
+    return S_OK;
+}
@@ -0,0 +1,88 @@
+//------------------------------------------------------------------------------
+// <copyright file="UdpSocket.h" company="Microsoft">
+//     Copyright (c) Microsoft Corporation.  All rights reserved.
+// </copyright>
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include "NuiTypes.h"
+
+/// <summary>
+/// Non-blocking IPv4 UDP socket on Winsock or BSD sockets. Sending never waits, a
+/// datagram the stack cannot take right away is dropped, which is what a stream of
+/// per-frame results wants. Receiving waits up to a timeout.
+/// </summary>
+class UdpSocket
+{
+public:
+    /// <summary>
+    /// Constructor
+    /// </summary>
+    UdpSocket();
+
+    /// <summary>
+    /// Destructor
+    /// </summary>
+   ~UdpSocket();
+
+public:
+    /// <summary>
+    /// Create a socket which sends to one destination
+    /// </summary>
+    /// <param name="address">Destination IPv4 address in dotted form</param>
+    /// <param name="port">Destination port</param>
+    /// <returns>Indicates success or failure</returns>
+    HRESULT OpenSender(const char* address, USHORT port);
+
+    /// <summary>
+    /// Create a socket which receives on a local port
+    /// </summary>
+    /// <param name="port">Local port</param>
+    /// <returns>Indicates success or failure</returns>
+    HRESULT OpenReceiver(USHORT port);
+
+    /// <summary>
+    /// Close the socket
+    /// </summary>
+    void Close();
+
+    /// <summary>
+    /// Indicates whether the socket is open
+    /// </summary>
+    bool IsOpen() const
+    {
+        return m_open;
+    }
+
+    /// <summary>
+    /// Send a datagram to the destination without waiting
+    /// </summary>
+    /// <param name="pData">The pointer to datagram bytes</param>
+    /// <param name="size">Size of the datagram in bytes</param>
+    /// <returns>S_OK if sent, S_FALSE if the stack was busy and the datagram dropped, or a failure code</returns>
+    HRESULT Send(const void* pData, UINT size);
+
+    /// <summary>
+    /// Receive one datagram
+    /// </summary>
+    /// <param name="pBuffer">The pointer to buffer receiving the datagram</param>
+    /// <param name="capacity">Size of the buffer in bytes</param>
+    /// <param name="timeout">Longest wait in milliseconds</param>
+    /// <param name="size">Receives size of the datagram in bytes</param>
+    /// <returns>S_OK if a datagram arrived, S_FALSE on timeout, or a failure code</returns>
+    HRESULT Receive(void* pBuffer, UINT capacity, UINT timeout, UINT& size);
+
+private:
+    /// <summary>
+    /// Create the non-blocking socket
+    /// </summary>
+    HRESULT Create();
+
+private:
+    intptr_t    m_socket;           // SOCKET on Windows, file descriptor elsewhere
+    bool        m_open;
+    bool        m_started;          // True if Winsock was started for this socket
+    UINT        m_destination[4];   // sockaddr_in of the destination
+};
@@ -26,6 +26,7 @@
 #define WM_STREAMEVENT                  WM_USER + 3
 #define WM_TIMEREVENT                   WM_USER + 4
 #define WM_SHOWKINECTWINDOW             WM_USER + 5
+#define WM_PRESENTEVENT                 WM_USER + 6
 
 static const UINT MaxStringChars = 256;
 